@@ -1327,6 +1327,132 @@ free_cpu_caches:
 #endif
 }
 
+#if defined(__linux__)
+/*
+ *  stress_cpu_topology_get_id()
+ *	read a CPU topology id from sysfs, -1 if unknown
+ */
+static int32_t stress_cpu_topology_get_id(const uint32_t cpu, const char *name)
+{
+	char path[PATH_MAX];
+	char tmp[64];
+
+	(void)snprintf(path, sizeof(path), "%s/cpu%" PRIu32 "/topology/%s",
+		stress_sys_cpu_prefix, cpu, name);
+	if (stress_get_string_from_file(path, tmp, sizeof(tmp)) < 0)
+		return -1;
+	return (int32_t)atoi(tmp);
+}
+
+/*
+ *  stress_cpu_topology_get_llc_id()
+ *	identify the last level cache of a CPU by the lowest
+ *	numbered CPU that shares it, -1 if unknown
+ */
+static int32_t stress_cpu_topology_get_llc_id(const uint32_t cpu)
+{
+	int i, max_level = 0;
+	int32_t llc_id = -1;
+
+	for (i = 0; i < 16; i++) {
+		char path[PATH_MAX];
+		char tmp[256];
+		int level;
+
+		(void)snprintf(path, sizeof(path), "%s/cpu%" PRIu32 "/%s/index%d/level",
+			stress_sys_cpu_prefix, cpu, stress_cpu_cache_dir, i);
+		if (stress_get_string_from_file(path, tmp, sizeof(tmp)) < 0)
+			break;
+		level = atoi(tmp);
+		if (level <= max_level)
+			continue;
+		(void)snprintf(path, sizeof(path), "%s/cpu%" PRIu32 "/%s/index%d/type",
+			stress_sys_cpu_prefix, cpu, stress_cpu_cache_dir, i);
+		if ((stress_get_string_from_file(path, tmp, sizeof(tmp)) == 0) &&
+		    (stress_cpu_cache_get_type(tmp) == CACHE_TYPE_INSTRUCTION))
+			continue;
+		(void)snprintf(path, sizeof(path), "%s/cpu%" PRIu32 "/%s/index%d/shared_cpu_list",
+			stress_sys_cpu_prefix, cpu, stress_cpu_cache_dir, i);
+		if (stress_get_string_from_file(path, tmp, sizeof(tmp)) < 0)
+			continue;
+		if (!isdigit((unsigned char)tmp[0]))
+			continue;
+		max_level = level;
+		llc_id = (int32_t)atoi(tmp);
+	}
+	return llc_id;
+}
+#endif
+
+/*
+ *  stress_cpu_topology_get()
+ *	get the package, die, cluster, core and last level cache
+ *	placement of a CPU, ids that cannot be determined are -1
+ */
+void stress_cpu_topology_get(const uint32_t cpu, stress_cpu_topology_t *topology)
+{
+	topology->cpu = cpu;
+#if defined(__linux__)
+	topology->core_id = stress_cpu_topology_get_id(cpu, "core_id");
+	topology->cluster_id = stress_cpu_topology_get_id(cpu, "cluster_id");
+	topology->die_id = stress_cpu_topology_get_id(cpu, "die_id");
+	topology->package_id = stress_cpu_topology_get_id(cpu, "physical_package_id");
+	topology->llc_id = stress_cpu_topology_get_llc_id(cpu);
+#else
+	topology->core_id = -1;
+	topology->cluster_id = -1;
+	topology->die_id = -1;
+	topology->package_id = -1;
+	topology->llc_id = -1;
+#endif
+}
+
+/*
+ *  stress_cpu_topology_rel()
+ *	closest topology relationship between two CPUs, CPUs with
+ *	unknown packages are assumed to be in the same package
+ */
+stress_cpu_topology_rel_t stress_cpu_topology_rel(
+	const stress_cpu_topology_t *t1,
+	const stress_cpu_topology_t *t2)
+{
+	const bool same_package = (t1->package_id == t2->package_id);
+
+	if (t1->cpu == t2->cpu)
+		return STRESS_CPU_REL_SAME;
+	if (same_package && (t1->die_id == t2->die_id) &&
+	    (t1->core_id >= 0) && (t1->core_id == t2->core_id))
+		return STRESS_CPU_REL_SMT;
+	if (same_package && (t1->cluster_id >= 0) && (t1->cluster_id == t2->cluster_id))
+		return STRESS_CPU_REL_CLUSTER;
+	if ((t1->llc_id >= 0) && (t1->llc_id == t2->llc_id))
+		return STRESS_CPU_REL_LLC;
+	if (same_package && (t1->die_id >= 0) && (t1->die_id == t2->die_id))
+		return STRESS_CPU_REL_DIE;
+	if (same_package || (t1->package_id < 0) || (t2->package_id < 0))
+		return STRESS_CPU_REL_PACKAGE;
+	return STRESS_CPU_REL_REMOTE;
+}
+
+/*
+ *  stress_cpu_topology_rel_name()
+ *	name of a CPU topology relationship
+ */
+const char *stress_cpu_topology_rel_name(const stress_cpu_topology_rel_t rel)
+{
+	static const char * const names[] = {
+		"same CPU",
+		"SMT sibling",
+		"same cluster",
+		"same LLC",
+		"same die",
+		"same package",
+		"cross package",
+	};
+
+	return ((size_t)rel < SIZEOF_ARRAY(names)) ? names[rel] : "unknown";
+}
+
 /*
  *  stress_cpu_data_cache_flush()
  *	flush data cache, optimal down to more generic
@@ -60,6 +60,28 @@ typedef struct stress_cpus {
 	uint8_t		padding[4];	/* padding */
 } stress_cpu_cache_cpus_t;
 
+/* Relationship between two CPUs, closest first */
+typedef enum stress_cpu_topology_rel {
+	STRESS_CPU_REL_SAME = 0,	/* same CPU */
+	STRESS_CPU_REL_SMT,		/* SMT siblings on the same core */
+	STRESS_CPU_REL_CLUSTER,		/* same core cluster */
+	STRESS_CPU_REL_LLC,		/* share the last level cache */
+	STRESS_CPU_REL_DIE,		/* same die */
+	STRESS_CPU_REL_PACKAGE,		/* same package (socket) */
+	STRESS_CPU_REL_REMOTE,		/* different packages */
+	STRESS_CPU_REL_MAX,
+} stress_cpu_topology_rel_t;
+
+/* CPU topology placement, ids are -1 if unknown */
+typedef struct stress_cpu_topology {
+	uint32_t	cpu;		/* CPU number */
+	int32_t		core_id;	/* core id in the package */
+	int32_t		cluster_id;	/* core cluster id */
+	int32_t		die_id;		/* die id in the package */
+	int32_t		package_id;	/* physical package (socket) id */
+	int32_t		llc_id;		/* lowest CPU sharing the last level cache */
+} stress_cpu_topology_t;
+
 /* CPU cache helpers */
 extern stress_cpu_cache_cpus_t *stress_cpu_cache_get_all_details(void);
 extern uint16_t stress_cpu_cache_get_max_level(const stress_cpu_cache_cpus_t *cpus);
@@ -70,6 +92,10 @@ extern void stress_cpu_cache_get_llc_size(size_t *llc_size, size_t *cache_line_s
 extern void stress_cpu_cache_get_level_size(const uint16_t cache_level,
 	size_t *cache_size, size_t *cache_line_size);
 extern void stress_cpu_data_cache_flush(void *addr, const size_t len);
+extern void stress_cpu_topology_get(const uint32_t cpu, stress_cpu_topology_t *topology);
+extern stress_cpu_topology_rel_t stress_cpu_topology_rel(const stress_cpu_topology_t *t1,
+	const stress_cpu_topology_t *t2);
+extern const char *stress_cpu_topology_rel_name(const stress_cpu_topology_rel_t rel);
 
 /*
  *  cacheflush(2) cache options
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef CORE_CPU_RELAX_H
+#define CORE_CPU_RELAX_H
+
+#include "core-arch.h"
+#include "core-asm-arm.h"
+#include "core-asm-loong64.h"
+#include "core-asm-ppc64.h"
+#include "core-asm-riscv.h"
+#include "core-asm-x86.h"
+
+#define STRESS_CPU_RELAX_SPIN_YIELD	(1024)	/* yield after this many spins */
+
+/*
+ *  stress_cpu_relax()
+ *	spin wait hint to the CPU
+ */
+static inline void ALWAYS_INLINE stress_cpu_relax(void)
+{
+#if defined(HAVE_ASM_X86_PAUSE)
+	stress_asm_x86_pause();
+#elif defined(HAVE_ASM_ARM_YIELD)
+	stress_asm_arm_yield();
+#elif defined(HAVE_ASM_LOONG64_DBAR)
+	stress_asm_loong64_dbar();
+#elif defined(STRESS_ARCH_PPC64)
+	stress_asm_ppc64_yield();
+#elif defined(STRESS_ARCH_PPC)
+	stress_asm_ppc_yield();
+#elif defined(STRESS_ARCH_RISCV)
+	stress_asm_riscv_pause();
+#endif
+}
+
+/*
+ *  stress_cpu_relax_yield()
+ *	spin wait hint, yield the CPU every STRESS_CPU_RELAX_SPIN_YIELD
+ *	spins so that spinners on oversubscribed CPUs let a preempted
+ *	lock holder or peer make progress, returns true if it yielded
+ */
+static inline bool ALWAYS_INLINE stress_cpu_relax_yield(uint32_t *spins)
+{
+	(*spins)++;
+	if (UNLIKELY((*spins & (STRESS_CPU_RELAX_SPIN_YIELD - 1)) == 0)) {
+		(void)shim_sched_yield();
+		return true;
+	}
+	stress_cpu_relax();
+	return false;
+}
+
+#endif
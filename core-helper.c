@@ -5473,3 +5473,43 @@ PRAGMA_UNROLL_N(8)
 	}
 	return false;
 }
+
+/*
+ *  stress_percentile_cmp()
+ *	compare samples for qsort
+ */
+static int stress_percentile_cmp(const void *p1, const void *p2)
+{
+	const double d1 = *(const double *)p1;
+	const double d2 = *(const double *)p2;
+
+	if (d1 > d2)
+		return 1;
+	else if (d1 < d2)
+		return -1;
+	return 0;
+}
+
+/*
+ *  stress_percentile_sort()
+ *	sort n samples into ascending order for stress_percentile()
+ */
+void stress_percentile_sort(double *samples, const size_t n)
+{
+	qsort(samples, n, sizeof(*samples), stress_percentile_cmp);
+}
+
+/*
+ *  stress_percentile()
+ *	the given percentile (0.0..100.0) of n samples that have been
+ *	sorted by stress_percentile_sort(), 0.0 if there are no samples
+ */
+double stress_percentile(const double *samples, const size_t n, const double percent)
+{
+	size_t i;
+
+	if (n == 0)
+		return 0.0;
+	i = (size_t)(((double)n * percent) / 100.0);
+	return samples[(i < n) ? i : n - 1];
+}
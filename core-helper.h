@@ -206,5 +206,8 @@ extern uint64_t stress_get_machine_id(void);
 extern void stress_zero_metrics(stress_metrics_t *metrics, const size_t n);
 extern void stress_backtrace(void);
 extern bool OPTIMIZE3 stress_data_is_not_zero(uint64_t *buffer, const size_t len);
+extern void stress_percentile_sort(double *samples, const size_t n);
+extern WARN_UNUSED double stress_percentile(const double *samples, const size_t n,
+	const double percent);
 
 #endif
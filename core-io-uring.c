@@ -17,9 +17,110 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  *
  */
-#include "config.h"
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-io-uring.h"
 
-#if defined(__linux__) &&	\
-    defined(HAVE_LINUX_IO_URING_H)
-#include <linux/io_uring.h>
+#if defined(HAVE_STRESS_IO_URING_RING)
+/*
+ *  Avoid GCCism of void * pointer arithmetic by casting to
+ *  uint8_t *, doing the offset and then casting back to void *
+ */
+#define VOID_ADDR_OFFSET(addr, offset)	\
+	((void *)(((uint8_t *)addr) + offset))
+
+/*
+ *  stress_io_uring_ring_close()
+ *	unmap and close a ring setup by stress_io_uring_ring_setup()
+ */
+void stress_io_uring_ring_close(stress_io_uring_ring_t *ring)
+{
+	if (ring->sqes && (ring->sqes != MAP_FAILED))
+		(void)munmap((void *)ring->sqes, ring->sqes_size);
+	if (ring->cq_mmap && (ring->cq_mmap != MAP_FAILED) &&
+	    (ring->cq_mmap != ring->sq_mmap))
+		(void)munmap(ring->cq_mmap, ring->cq_size);
+	if (ring->sq_mmap && (ring->sq_mmap != MAP_FAILED))
+		(void)munmap(ring->sq_mmap, ring->sq_size);
+	if (ring->fd >= 0)
+		(void)close(ring->fd);
+	(void)shim_memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+}
+
+/*
+ *  stress_io_uring_ring_setup()
+ *	setup an io-uring of at least entries submission queue entries
+ *	using the caller's setup flags in p and mmap the rings, returns
+ *	0 on success or -errno on failure
+ */
+int stress_io_uring_ring_setup(
+	stress_io_uring_ring_t *ring,
+	const unsigned entries,
+	struct io_uring_params *p)
+{
+	int err;
+
+	(void)shim_memset(ring, 0, sizeof(*ring));
+	ring->fd = (int)syscall(__NR_io_uring_setup, entries, p);
+	if (ring->fd < 0) {
+		err = errno;
+		ring->fd = -1;
+		return -err;
+	}
+
+	ring->sq_entries = p->sq_entries;
+	ring->cq_entries = p->cq_entries;
+	ring->sq_size = p->sq_off.array + p->sq_entries * sizeof(unsigned);
+	ring->cq_size = p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe);
+	if (p->features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_size > ring->sq_size)
+			ring->sq_size = ring->cq_size;
+		ring->cq_size = ring->sq_size;
+	}
+	ring->sq_mmap = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_mmap == MAP_FAILED)
+		goto err;
+	if (p->features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_mmap = ring->sq_mmap;
+	} else {
+		ring->cq_mmap = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+		if (ring->cq_mmap == MAP_FAILED)
+			goto err;
+	}
+	ring->sqes_size = p->sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+		goto err;
+
+	ring->sq_tail = VOID_ADDR_OFFSET(ring->sq_mmap, p->sq_off.tail);
+	ring->sq_mask = VOID_ADDR_OFFSET(ring->sq_mmap, p->sq_off.ring_mask);
+	ring->sq_array = VOID_ADDR_OFFSET(ring->sq_mmap, p->sq_off.array);
+	ring->cq_head = VOID_ADDR_OFFSET(ring->cq_mmap, p->cq_off.head);
+	ring->cq_tail = VOID_ADDR_OFFSET(ring->cq_mmap, p->cq_off.tail);
+	ring->cq_mask = VOID_ADDR_OFFSET(ring->cq_mmap, p->cq_off.ring_mask);
+	ring->cqes = VOID_ADDR_OFFSET(ring->cq_mmap, p->cq_off.cqes);
+	return 0;
+err:
+	err = errno;
+	stress_io_uring_ring_close(ring);
+	return -err;
+}
+
+/*
+ *  stress_io_uring_ring_enter()
+ *	submit and/or wait for completions on a ring
+ */
+int stress_io_uring_ring_enter(
+	const stress_io_uring_ring_t *ring,
+	const unsigned to_submit,
+	const unsigned min_complete,
+	const unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, ring->fd, to_submit,
+		min_complete, flags, NULL, 0);
+}
 #endif
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef CORE_IO_URING_H
+#define CORE_IO_URING_H
+
+#if defined(__linux__) &&	\
+    defined(HAVE_LINUX_IO_URING_H)
+#include <linux/io_uring.h>
+#endif
+
+#if defined(__linux__) &&		\
+    defined(HAVE_LINUX_IO_URING_H) &&	\
+    defined(HAVE_SYSCALL) &&		\
+    defined(__NR_io_uring_enter) &&	\
+    defined(__NR_io_uring_setup) &&	\
+    defined(IORING_OFF_SQ_RING) &&	\
+    defined(IORING_OFF_CQ_RING) &&	\
+    defined(IORING_OFF_SQES) &&		\
+    defined(IORING_FEAT_SINGLE_MMAP)
+#define HAVE_STRESS_IO_URING_RING
+
+/*
+ *  minimal raw io-uring, the mmap'd submission and completion
+ *  rings and the submission queue entries
+ */
+typedef struct {
+	int fd;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_mmap;
+	void *cq_mmap;
+	size_t sq_size;
+	size_t cq_size;
+	size_t sqes_size;
+	unsigned sq_entries;
+	unsigned cq_entries;
+} stress_io_uring_ring_t;
+
+extern int stress_io_uring_ring_setup(stress_io_uring_ring_t *ring,
+	const unsigned entries, struct io_uring_params *p);
+extern void stress_io_uring_ring_close(stress_io_uring_ring_t *ring);
+extern int stress_io_uring_ring_enter(const stress_io_uring_ring_t *ring,
+	const unsigned to_submit, const unsigned min_complete,
+	const unsigned flags);
+#endif
+
+#endif
@@ -23,6 +23,12 @@
  */
 const struct option stress_long_options[] = {
 	{ "abort",		0,	0,	OPT_abort },
+	{ "accept",		1,	0,	OPT_accept },
+	{ "accept-acceptors",	1,	0,	OPT_accept_acceptors },
+	{ "accept-clients",	1,	0,	OPT_accept_clients },
+	{ "accept-method",	1,	0,	OPT_accept_method },
+	{ "accept-ops",		1,	0,	OPT_accept_ops },
+	{ "accept-port",	1,	0,	OPT_accept_port },
 	{ "access",		1,	0,	OPT_access },
 	{ "access-ops",		1,	0,	OPT_access_ops },
 	{ "acl",		1,	0,	OPT_acl },
@@ -91,6 +97,11 @@ const struct option stress_long_options[] = {
 	{ "bubblesort-ops",	1,	0,	OPT_bubblesort_ops },
 	{ "bubblesort-size",	1,	0,	OPT_bubblesort_size },
 	{ "buildinfo",		0,	0,	OPT_buildinfo },
+	{ "busypoll",		1,	0,	OPT_busypoll },
+	{ "busypoll-method",	1,	0,	OPT_busypoll_method },
+	{ "busypoll-ops",	1,	0,	OPT_busypoll_ops },
+	{ "busypoll-port",	1,	0,	OPT_busypoll_port },
+	{ "busypoll-usec",	1,	0,	OPT_busypoll_usec },
 	{ "c-states",		0,	0,	OPT_c_states },
 	{ "cache",		1,	0, 	OPT_cache },
 	{ "cache-size",		1,	0, 	OPT_cache_size},
@@ -113,6 +124,8 @@ const struct option stress_long_options[] = {
 	{ "cachehammer-ops",	1,	0,	OPT_cachehammer_ops },
 	{ "cacheline",		1,	0, 	OPT_cacheline },
 	{ "cacheline-affinity",	0,	0,	OPT_cacheline_affinity },
+	{ "cacheline-matrix",	0,	0,	OPT_cacheline_matrix },
+	{ "cacheline-matrix-cas",0,	0,	OPT_cacheline_matrix_cas },
 	{ "cacheline-method",	1,	0,	OPT_cacheline_method },
 	{ "cacheline-ops",	1,	0,	OPT_cacheline_ops },
 	{ "cap",		1,	0, 	OPT_cap },
@@ -131,6 +144,13 @@ const struct option stress_long_options[] = {
 	{ "chroot-ops",		1,	0,	OPT_chroot_ops },
 	{ "cgroup",		1,	0,	OPT_cgroup },
 	{ "cgroup-ops",		1,	0,	OPT_cgroup_ops },
+	{ "churn",		1,	0,	OPT_churn },
+	{ "churn-clients",	1,	0,	OPT_churn_clients },
+	{ "churn-close",	1,	0,	OPT_churn_close },
+	{ "churn-ops",		1,	0,	OPT_churn_ops },
+	{ "churn-port",		1,	0,	OPT_churn_port },
+	{ "churn-ports",	1,	0,	OPT_churn_ports },
+	{ "churn-rate",		1,	0,	OPT_churn_rate },
 	{ "class",		1,	0,	OPT_class },
 	{ "clock",		1,	0,	OPT_clock },
 	{ "clock-ops",		1,	0,	OPT_clock_ops },
@@ -230,6 +250,12 @@ const struct option stress_long_options[] = {
 	{ "eventfd",		1,	0,	OPT_eventfd },
 	{ "eventfd-nonblock",	0,	0,	OPT_eventfd_nonblock },
 	{ "eventfd-ops",	1,	0,	OPT_eventfd_ops },
+	{ "eventloop",		1,	0,	OPT_eventloop },
+	{ "eventloop-active",	1,	0,	OPT_eventloop_active },
+	{ "eventloop-conns",	1,	0,	OPT_eventloop_conns },
+	{ "eventloop-method",	1,	0,	OPT_eventloop_method },
+	{ "eventloop-ops",	1,	0,	OPT_eventloop_ops },
+	{ "eventloop-port",	1,	0,	OPT_eventloop_port },
 	{ "exclude",		1,	0,	OPT_exclude },
 	{ "exec",		1,	0,	OPT_exec },
 	{ "exec-fork-method",	1,	0,	OPT_exec_fork_method },
@@ -338,7 +364,9 @@ const struct option stress_long_options[] = {
 	{ "funcret-method",	1,	0,	OPT_funcret_method },
 	{ "funcret-ops",	1,	0,	OPT_funcret_ops },
 	{ "futex",		1,	0,	OPT_futex },
+	{ "futex-method",	1,	0,	OPT_futex_method },
 	{ "futex-ops",		1,	0,	OPT_futex_ops },
+	{ "futex-waiters",	1,	0,	OPT_futex_waiters },
 	{ "get",		1,	0,	OPT_get },
 	{ "get-ops",		1,	0,	OPT_get_ops },
 	{ "get-slow-sync",	0,	0,	OPT_get_slow_sync },
@@ -364,6 +392,7 @@ const struct option stress_long_options[] = {
 	{ "hash-ops",		1,	0,	OPT_hash_ops },
 	{ "hdd",		1,	0,	OPT_hdd },
 	{ "hdd-bytes",		1,	0,	OPT_hdd_bytes },
+	{ "hdd-dio-sweep",	0,	0,	OPT_hdd_dio_sweep },
 	{ "hdd-ops",		1,	0,	OPT_hdd_ops },
 	{ "hdd-opts",		1,	0,	OPT_hdd_opts },
 	{ "hdd-write-size", 	1,	0,	OPT_hdd_write_size },
@@ -450,6 +479,11 @@ const struct option stress_long_options[] = {
 	{ "klog-check",		0,	0,	OPT_klog_check },
 	{ "klog-ops",		1,	0,	OPT_klog_ops },
 	{ "ksm",		0,	0,	OPT_ksm },
+	{ "ktls",		1,	0,	OPT_ktls },
+	{ "ktls-cipher",	1,	0,	OPT_ktls_cipher },
+	{ "ktls-ops",		1,	0,	OPT_ktls_ops },
+	{ "ktls-port",		1,	0,	OPT_ktls_port },
+	{ "ktls-sendfile",	0,	0,	OPT_ktls_sendfile },
 	{ "kvm",		1,	0,	OPT_kvm },
 	{ "kvm-ops",		1,	0,	OPT_kvm_ops },
 	{ "l1cache",		1,	0, 	OPT_l1cache },
@@ -484,12 +518,23 @@ const struct option stress_long_options[] = {
 	{ "loadavg-max",	1,	0,	OPT_loadavg_max },
 	{ "locka",		1,	0,	OPT_locka },
 	{ "locka-ops",		1,	0,	OPT_locka_ops },
+	{ "lockalgo",		1,	0,	OPT_lockalgo },
+	{ "lockalgo-cs",	1,	0,	OPT_lockalgo_cs },
+	{ "lockalgo-method",	1,	0,	OPT_lockalgo_method },
+	{ "lockalgo-ops",	1,	0,	OPT_lockalgo_ops },
+	{ "lockalgo-readers",	1,	0,	OPT_lockalgo_readers },
+	{ "lockalgo-threads",	1,	0,	OPT_lockalgo_threads },
 	{ "lockbus",		1,	0,	OPT_lockbus },
 	{ "lockbus-ops",	1,	0,	OPT_lockbus_ops },
 	{ "lockbus-nosplit",	0,	0,	OPT_lockbus_nosplit },
 	{ "lockf",		1,	0,	OPT_lockf },
 	{ "lockf-nonblock", 	0,	0,	OPT_lockf_nonblock },
 	{ "lockf-ops",		1,	0,	OPT_lockf_ops },
+	{ "lockfree",		1,	0,	OPT_lockfree },
+	{ "lockfree-method",	1,	0,	OPT_lockfree_method },
+	{ "lockfree-ops",	1,	0,	OPT_lockfree_ops },
+	{ "lockfree-placement",	1,	0,	OPT_lockfree_placement },
+	{ "lockfree-threads",	1,	0,	OPT_lockfree_threads },
 	{ "lockmix",		1,	0,	OPT_lockmix },
 	{ "lockmix-ops",	1,	0,	OPT_lockmix_ops },
 	{ "lockofd",		1,	0,	OPT_lockofd },
@@ -863,6 +908,13 @@ const struct option stress_long_options[] = {
 	{ "readahead",		1,	0,	OPT_readahead },
 	{ "readahead-bytes",	1,	0,	OPT_readahead_bytes },
 	{ "readahead-ops",	1,	0,	OPT_readahead_ops },
+	{ "readahead-sweep",	0,	0,	OPT_readahead_sweep },
+	{ "readahead-window",	1,	0,	OPT_readahead_window },
+	{ "readmostly",		1,	0,	OPT_readmostly },
+	{ "readmostly-method",	1,	0,	OPT_readmostly_method },
+	{ "readmostly-ops",	1,	0,	OPT_readmostly_ops },
+	{ "readmostly-readers",	1,	0,	OPT_readmostly_readers },
+	{ "readmostly-writers",	1,	0,	OPT_readmostly_writers },
 	{ "reboot",		1,	0,	OPT_reboot },
 	{ "reboot-ops",		1,	0,	OPT_reboot_ops },
 	{ "regex",		1,	0,	OPT_regex },
@@ -897,9 +949,16 @@ const struct option stress_long_options[] = {
 	{ "rotate-method",	1,	0,	OPT_rotate_method },
 	{ "rotate-ops",		1,	0,	OPT_rotate_ops },
 	{ "rseq",		1,	0,	OPT_rseq },
+	{ "rseq-method",	1,	0,	OPT_rseq_method },
 	{ "rseq-ops",		1,	0,	OPT_rseq_ops },
+	{ "rseq-threads",	1,	0,	OPT_rseq_threads },
 	{ "rtc",		1,	0,	OPT_rtc },
 	{ "rtc-ops",		1,	0,	OPT_rtc_ops },
+	{ "schbench",		1,	0,	OPT_schbench },
+	{ "schbench-burst",	1,	0,	OPT_schbench_burst },
+	{ "schbench-msg-threads",	1,	0,	OPT_schbench_msg_threads },
+	{ "schbench-ops",	1,	0,	OPT_schbench_ops },
+	{ "schbench-policy",	1,	0,	OPT_schbench_policy },
 	{ "sched",		1,	0,	OPT_sched },
 	{ "sched-deadline",	1,	0,	OPT_sched_deadline },
 	{ "sched-period",	1,	0,	OPT_sched_period },
@@ -950,6 +1009,11 @@ const struct option stress_long_options[] = {
 	{ "shellsort-ops",	1,	0,	OPT_shellsort_ops },
 	{ "shellsort-size",	1,	0,	OPT_shellsort_size },
 	{ "shm",		1,	0,	OPT_shm },
+	{ "shm-backing",	1,	0,	OPT_shm_backing },
+	{ "shm-backing-bytes",	1,	0,	OPT_shm_backing_bytes },
+	{ "shm-backing-huge",	0,	0,	OPT_shm_backing_huge },
+	{ "shm-backing-method",	1,	0,	OPT_shm_backing_method },
+	{ "shm-backing-ops",	1,	0,	OPT_shm_backing_ops },
 	{ "shm-bytes",		1,	0,	OPT_shm_bytes },
 	{ "shm-mlock",		0,	0,	OPT_shm_mlock },
 	{ "shm-objs",		1,	0,	OPT_shm_objs },
@@ -1011,16 +1075,23 @@ const struct option stress_long_options[] = {
 	{ "smart",		0,	0,	OPT_smart },
 	{ "smi",		1,	0,	OPT_smi },
 	{ "smi-ops",		1,	0,	OPT_smi_ops },
+	{ "smt",		1,	0,	OPT_smt },
+	{ "smt-aggressor",	1,	0,	OPT_smt_aggressor },
+	{ "smt-ops",		1,	0,	OPT_smt_ops },
+	{ "smt-victim",		1,	0,	OPT_smt_victim },
 	{ "sn",			0,	0,	OPT_sn },
 	{ "sock",		1,	0,	OPT_sock },
 	{ "sock-domain",	1,	0,	OPT_sock_domain },
 	{ "sock-if",		1,	0,	OPT_sock_if },
+	{ "sock-mode",		1,	0,	OPT_sock_mode },
 	{ "sock-msgs",		1,	0,	OPT_sock_msgs },
 	{ "sock-nodelay",	0,	0,	OPT_sock_nodelay },
 	{ "sock-ops",		1,	0,	OPT_sock_ops },
 	{ "sock-opts",		1,	0,	OPT_sock_opts },
 	{ "sock-port",		1,	0,	OPT_sock_port },
 	{ "sock-protocol",	1,	0,	OPT_sock_protocol },
+	{ "sock-rr-conns",	1,	0,	OPT_sock_rr_conns },
+	{ "sock-rr-size",	1,	0,	OPT_sock_rr_size },
 	{ "sock-type",		1,	0,	OPT_sock_type },
 	{ "sock-zerocopy", 	0,	0,	OPT_sock_zerocopy },
 	{ "sockabuse",		1,	0,	OPT_sockabuse },
@@ -1167,6 +1238,7 @@ const struct option stress_long_options[] = {
 	{ "udp-gro",		0,	0,	OPT_udp_gro },
 	{ "udp-if",		1,	0,	OPT_udp_if },
 	{ "udp-lite",		0,	0,	OPT_udp_lite },
+	{ "udp-mode",		1,	0,	OPT_udp_mode },
 	{ "udp-ops",		1,	0,	OPT_udp_ops },
 	{ "udp-port",		1,	0,	OPT_udp_port },
 	{ "udp-flood",		1,	0,	OPT_udp_flood },
@@ -1177,6 +1249,9 @@ const struct option stress_long_options[] = {
 	{ "umask-ops",		1,	0,	OPT_umask_ops },
 	{ "umount",		1,	0,	OPT_umount },
 	{ "umount-ops",		1,	0,	OPT_umount_ops },
+	{ "unixipc",		1,	0,	OPT_unixipc },
+	{ "unixipc-ops",	1,	0,	OPT_unixipc_ops },
+	{ "unixipc-type",	1,	0,	OPT_unixipc_type },
 	{ "unlink",		1,	0,	OPT_unlink },
 	{ "unlink-ops",		1,	0,	OPT_unlink_ops },
 	{ "unshare",		1,	0,	OPT_unshare },
@@ -1261,6 +1336,16 @@ const struct option stress_long_options[] = {
 	{ "wait-ops",		1,	0,	OPT_wait_ops },
 	{ "waitcpu",		1,	0,	OPT_waitcpu },
 	{ "waitcpu-ops",	1,	0,	OPT_waitcpu_ops },
+	{ "wakelat",		1,	0,	OPT_wakelat },
+	{ "wakelat-method",	1,	0,	OPT_wakelat_method },
+	{ "wakelat-ops",	1,	0,	OPT_wakelat_ops },
+	{ "wakelat-placement",	1,	0,	OPT_wakelat_placement },
+	{ "wal",		1,	0,	OPT_wal },
+	{ "wal-bytes",		1,	0,	OPT_wal_bytes },
+	{ "wal-method",		1,	0,	OPT_wal_method },
+	{ "wal-ops",		1,	0,	OPT_wal_ops },
+	{ "wal-record-size",	1,	0,	OPT_wal_record_size },
+	{ "wal-writers",	1,	0,	OPT_wal_writers },
 	{ "watchdog",		1,	0,	OPT_watchdog },
 	{ "watchdog-ops",	1,	0,	OPT_watchdog_ops },
 	{ "with",		1,	0,	OPT_with },
@@ -1276,6 +1361,15 @@ const struct option stress_long_options[] = {
 	{ "workload-sched",	1,	0,	OPT_workload_sched },
 	{ "workload-slice-us",	1,	0,	OPT_workload_slice_us },
 	{ "workload-threads",	1,	0,	OPT_workload_threads },
+	{ "worksteal",		1,	0,	OPT_worksteal },
+	{ "worksteal-method",	1,	0,	OPT_worksteal_method },
+	{ "worksteal-ops",	1,	0,	OPT_worksteal_ops },
+	{ "worksteal-threads",	1,	0,	OPT_worksteal_threads },
+	{ "writeback",		1,	0,	OPT_writeback },
+	{ "writeback-bytes",	1,	0,	OPT_writeback_bytes },
+	{ "writeback-ops",	1,	0,	OPT_writeback_ops },
+	{ "writeback-rate",	1,	0,	OPT_writeback_rate },
+	{ "writeback-write-size",	1,	0,	OPT_writeback_write_size },
 	{ "x86cpuid",		1,	0,	OPT_x86cpuid },
 	{ "x86cpuid-ops",	1,	0,	OPT_x86cpuid_ops },
 	{ "x86syscall",		1,	0,	OPT_x86syscall },
@@ -149,6 +149,13 @@ typedef enum {
 
 	OPT_abort,
 
+	OPT_accept,
+	OPT_accept_ops,
+	OPT_accept_acceptors,
+	OPT_accept_clients,
+	OPT_accept_method,
+	OPT_accept_port,
+
 	OPT_access,
 	OPT_access_ops,
 
@@ -237,8 +244,22 @@ typedef enum {
 
 	OPT_buildinfo,
 
+	OPT_busypoll,
+	OPT_busypoll_ops,
+	OPT_busypoll_method,
+	OPT_busypoll_usec,
+	OPT_busypoll_port,
+
 	OPT_c_states,
 
+	OPT_churn,
+	OPT_churn_ops,
+	OPT_churn_clients,
+	OPT_churn_close,
+	OPT_churn_port,
+	OPT_churn_ports,
+	OPT_churn_rate,
+
 	OPT_class,
 
 	OPT_cache_ops,
@@ -264,6 +285,8 @@ typedef enum {
 	OPT_cacheline,
 	OPT_cacheline_ops,
 	OPT_cacheline_affinity,
+	OPT_cacheline_matrix,
+	OPT_cacheline_matrix_cas,
 	OPT_cacheline_method,
 
 	OPT_cap,
@@ -416,6 +439,13 @@ typedef enum {
 	OPT_eventfd_ops,
 	OPT_eventfd_nonblock,
 
+	OPT_eventloop,
+	OPT_eventloop_ops,
+	OPT_eventloop_active,
+	OPT_eventloop_conns,
+	OPT_eventloop_method,
+	OPT_eventloop_port,
+
 	OPT_exec,
 	OPT_exec_ops,
 	OPT_exec_max,
@@ -555,7 +585,9 @@ typedef enum {
 	OPT_funcret_method,
 
 	OPT_futex,
+	OPT_futex_method,
 	OPT_futex_ops,
+	OPT_futex_waiters,
 
 	OPT_get,
 	OPT_get_ops,
@@ -588,6 +620,7 @@ typedef enum {
 	OPT_hash_method,
 
 	OPT_hdd_bytes,
+	OPT_hdd_dio_sweep,
 	OPT_hdd_write_size,
 	OPT_hdd_ops,
 	OPT_hdd_opts,
@@ -700,6 +733,12 @@ typedef enum {
 
 	OPT_ksm,
 
+	OPT_ktls,
+	OPT_ktls_ops,
+	OPT_ktls_cipher,
+	OPT_ktls_port,
+	OPT_ktls_sendfile,
+
 	OPT_kvm,
 	OPT_kvm_ops,
 
@@ -741,6 +780,13 @@ typedef enum {
 	OPT_loadavg_ops,
 	OPT_loadavg_max,
 
+	OPT_lockalgo,
+	OPT_lockalgo_ops,
+	OPT_lockalgo_cs,
+	OPT_lockalgo_method,
+	OPT_lockalgo_readers,
+	OPT_lockalgo_threads,
+
 	OPT_lockbus,
 	OPT_lockbus_ops,
 	OPT_lockbus_nosplit,
@@ -752,6 +798,12 @@ typedef enum {
 	OPT_lockf_ops,
 	OPT_lockf_nonblock,
 
+	OPT_lockfree,
+	OPT_lockfree_ops,
+	OPT_lockfree_method,
+	OPT_lockfree_placement,
+	OPT_lockfree_threads,
+
 	OPT_lockmix,
 	OPT_lockmix_ops,
 
@@ -1223,6 +1275,14 @@ typedef enum {
 	OPT_readahead,
 	OPT_readahead_ops,
 	OPT_readahead_bytes,
+	OPT_readahead_sweep,
+	OPT_readahead_window,
+
+	OPT_readmostly,
+	OPT_readmostly_ops,
+	OPT_readmostly_method,
+	OPT_readmostly_readers,
+	OPT_readmostly_writers,
 
 	OPT_reboot,
 	OPT_reboot_ops,
@@ -1269,11 +1329,19 @@ typedef enum {
 	OPT_rotate_ops,
 
 	OPT_rseq,
+	OPT_rseq_method,
 	OPT_rseq_ops,
+	OPT_rseq_threads,
 
 	OPT_rtc,
 	OPT_rtc_ops,
 
+	OPT_schbench,
+	OPT_schbench_ops,
+	OPT_schbench_burst,
+	OPT_schbench_msg_threads,
+	OPT_schbench_policy,
+
 	OPT_sched,
 	OPT_sched_prio,
 
@@ -1345,6 +1413,12 @@ typedef enum {
 	OPT_shm_ops,
 	OPT_shm_objs,
 
+	OPT_shm_backing,
+	OPT_shm_backing_ops,
+	OPT_shm_backing_bytes,
+	OPT_shm_backing_huge,
+	OPT_shm_backing_method,
+
 	OPT_shm_sysv,
 	OPT_shm_sysv_bytes,
 	OPT_shm_sysv_mlock,
@@ -1431,16 +1505,24 @@ typedef enum {
 	OPT_smi,
 	OPT_smi_ops,
 
+	OPT_smt,
+	OPT_smt_ops,
+	OPT_smt_aggressor,
+	OPT_smt_victim,
+
 	OPT_sn,
 
 	OPT_sock_ops,
 	OPT_sock_domain,
 	OPT_sock_if,
+	OPT_sock_mode,
 	OPT_sock_msgs,
 	OPT_sock_nodelay,
 	OPT_sock_opts,
 	OPT_sock_port,
 	OPT_sock_protocol,
+	OPT_sock_rr_conns,
+	OPT_sock_rr_size,
 	OPT_sock_type,
 	OPT_sock_zerocopy,
 
@@ -1636,6 +1718,7 @@ typedef enum {
 	OPT_udp_lite,
 	OPT_udp_gro,
 	OPT_udp_if,
+	OPT_udp_mode,
 
 	OPT_udp_flood,
 	OPT_udp_flood_ops,
@@ -1648,6 +1731,10 @@ typedef enum {
 	OPT_umount,
 	OPT_umount_ops,
 
+	OPT_unixipc,
+	OPT_unixipc_ops,
+	OPT_unixipc_type,
+
 	OPT_unlink,
 	OPT_unlink_ops,
 
@@ -1751,6 +1838,18 @@ typedef enum {
 	OPT_waitcpu,
 	OPT_waitcpu_ops,
 
+	OPT_wakelat,
+	OPT_wakelat_ops,
+	OPT_wakelat_method,
+	OPT_wakelat_placement,
+
+	OPT_wal,
+	OPT_wal_ops,
+	OPT_wal_bytes,
+	OPT_wal_method,
+	OPT_wal_record_size,
+	OPT_wal_writers,
+
 	OPT_watchdog,
 	OPT_watchdog_ops,
 
@@ -1768,6 +1867,17 @@ typedef enum {
 	OPT_workload_slice_us,
 	OPT_workload_threads,
 
+	OPT_worksteal,
+	OPT_worksteal_ops,
+	OPT_worksteal_method,
+	OPT_worksteal_threads,
+
+	OPT_writeback,
+	OPT_writeback_ops,
+	OPT_writeback_bytes,
+	OPT_writeback_rate,
+	OPT_writeback_write_size,
+
 	OPT_x86cpuid,
 	OPT_x86cpuid_ops,
 
@@ -0,0 +1,39 @@
+#define STRESS_PERF_COUNT_HW_CPU_CYCLES (1)
+#define STRESS_PERF_COUNT_HW_INSTRUCTIONS (1)
+#define STRESS_PERF_COUNT_HW_CACHE_REFERENCES (1)
+#define STRESS_PERF_COUNT_HW_CACHE_MISSES (1)
+#define STRESS_PERF_COUNT_HW_BRANCH_INSTRUCTIONS (1)
+#define STRESS_PERF_COUNT_HW_BRANCH_MISSES (1)
+#define STRESS_PERF_COUNT_HW_BUS_CYCLES (1)
+#define STRESS_PERF_COUNT_HW_STALLED_CYCLES_FRONTEND (1)
+#define STRESS_PERF_COUNT_HW_STALLED_CYCLES_BACKEND (1)
+#define STRESS_PERF_COUNT_HW_REF_CPU_CYCLES (1)
+#define STRESS_PERF_COUNT_HW_MAX (1)
+#define STRESS_PERF_COUNT_HW_CACHE_L1D (1)
+#define STRESS_PERF_COUNT_HW_CACHE_L1I (1)
+#define STRESS_PERF_COUNT_HW_CACHE_LL (1)
+#define STRESS_PERF_COUNT_HW_CACHE_DTLB (1)
+#define STRESS_PERF_COUNT_HW_CACHE_ITLB (1)
+#define STRESS_PERF_COUNT_HW_CACHE_BPU (1)
+#define STRESS_PERF_COUNT_HW_CACHE_NODE (1)
+#define STRESS_PERF_COUNT_HW_CACHE_MAX (1)
+#define STRESS_PERF_COUNT_HW_CACHE_OP_READ (1)
+#define STRESS_PERF_COUNT_HW_CACHE_OP_WRITE (1)
+#define STRESS_PERF_COUNT_HW_CACHE_OP_PREFETCH (1)
+#define STRESS_PERF_COUNT_HW_CACHE_OP_MAX (1)
+#define STRESS_PERF_COUNT_HW_CACHE_RESULT_ACCESS (1)
+#define STRESS_PERF_COUNT_HW_CACHE_RESULT_MISS (1)
+#define STRESS_PERF_COUNT_HW_CACHE_RESULT_MAX (1)
+#define STRESS_PERF_COUNT_SW_CPU_CLOCK (1)
+#define STRESS_PERF_COUNT_SW_TASK_CLOCK (1)
+#define STRESS_PERF_COUNT_SW_PAGE_FAULTS (1)
+#define STRESS_PERF_COUNT_SW_CONTEXT_SWITCHES (1)
+#define STRESS_PERF_COUNT_SW_CPU_MIGRATIONS (1)
+#define STRESS_PERF_COUNT_SW_PAGE_FAULTS_MIN (1)
+#define STRESS_PERF_COUNT_SW_PAGE_FAULTS_MAJ (1)
+#define STRESS_PERF_COUNT_SW_ALIGNMENT_FAULTS (1)
+#define STRESS_PERF_COUNT_SW_EMULATION_FAULTS (1)
+#define STRESS_PERF_COUNT_SW_DUMMY (1)
+#define STRESS_PERF_COUNT_SW_BPF_OUTPUT (1)
+#define STRESS_PERF_COUNT_SW_CGROUP_SWITCHES (1)
+#define STRESS_PERF_COUNT_SW_MAX (1)
@@ -25,6 +25,7 @@
  */
 
 #define STRESSORS(MACRO)	\
+	MACRO(accept)		\
 	MACRO(access) 		\
 	MACRO(acl)		\
 	MACRO(af_alg) 		\
@@ -46,6 +47,7 @@
 	MACRO(brk)		\
 	MACRO(bsearch)		\
 	MACRO(bubblesort)	\
+	MACRO(busypoll)		\
 	MACRO(cache)		\
 	MACRO(cachehammer)	\
 	MACRO(cacheline)	\
@@ -56,6 +58,7 @@
 	MACRO(chmod)		\
 	MACRO(chown)		\
 	MACRO(chroot)		\
+	MACRO(churn)		\
 	MACRO(clock)		\
 	MACRO(clone)		\
 	MACRO(close)		\
@@ -86,6 +89,7 @@
 	MACRO(env)		\
 	MACRO(epoll)		\
 	MACRO(eventfd) 		\
+	MACRO(eventloop)	\
 	MACRO(exec)		\
 	MACRO(exit_group)	\
 	MACRO(expmath)		\
@@ -152,6 +156,7 @@
 	MACRO(key)		\
 	MACRO(kill)		\
 	MACRO(klog)		\
+	MACRO(ktls)		\
 	MACRO(kvm)		\
 	MACRO(l1cache)		\
 	MACRO(landlock)		\
@@ -162,8 +167,10 @@
 	MACRO(llc_affinity)	\
 	MACRO(loadavg)		\
 	MACRO(locka)		\
+	MACRO(lockalgo)		\
 	MACRO(lockbus)		\
 	MACRO(lockf)		\
+	MACRO(lockfree)		\
 	MACRO(lockmix)		\
 	MACRO(lockofd)		\
 	MACRO(logmath)		\
@@ -261,6 +268,7 @@
 	MACRO(rawudp)		\
 	MACRO(rdrand)		\
 	MACRO(readahead)	\
+	MACRO(readmostly)	\
 	MACRO(reboot)		\
 	MACRO(regex)		\
 	MACRO(regs)		\
@@ -275,6 +283,7 @@
 	MACRO(rotate)		\
 	MACRO(rseq)		\
 	MACRO(rtc)		\
+	MACRO(schbench)		\
 	MACRO(schedmix)		\
 	MACRO(schedpolicy)	\
 	MACRO(sctp)		\
@@ -289,6 +298,7 @@
 	MACRO(set)		\
 	MACRO(shellsort)	\
 	MACRO(shm)		\
+	MACRO(shm_backing)	\
 	MACRO(shm_sysv)		\
 	MACRO(sigabrt)		\
 	MACRO(sigbus)		\
@@ -314,6 +324,7 @@
 	MACRO(skiplist)		\
 	MACRO(sleep)		\
 	MACRO(smi)		\
+	MACRO(smt)		\
 	MACRO(sock)		\
 	MACRO(sockabuse)	\
 	MACRO(sockdiag)		\
@@ -356,6 +367,7 @@
 	MACRO(udp_flood)	\
 	MACRO(umask)		\
 	MACRO(umount)		\
+	MACRO(unixipc)		\
 	MACRO(unlink)		\
 	MACRO(unshare)		\
 	MACRO(uprobe)		\
@@ -381,9 +393,13 @@
 	MACRO(vnni)		\
 	MACRO(wait)		\
 	MACRO(waitcpu)		\
+	MACRO(wakelat)		\
+	MACRO(wal)		\
 	MACRO(watchdog)		\
 	MACRO(wcs)		\
 	MACRO(workload)		\
+	MACRO(worksteal)	\
+	MACRO(writeback)	\
 	MACRO(x86cpuid)		\
 	MACRO(x86syscall)	\
 	MACRO(xattr)		\
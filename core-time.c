@@ -20,6 +20,7 @@
 #include "stress-ng.h"
 #include "core-attribute.h"
 
+#include <sys/resource.h>
 #include <time.h>
 
 #define SECONDS_IN_MINUTE	(60.0)
@@ -102,6 +103,21 @@ double OPTIMIZE3 stress_time_now(void)
 	return -1.0;
 }
 
+/*
+ *  stress_time_cpu_self()
+ *	user + system CPU time of the calling process in seconds,
+ *	0.0 if it cannot be fetched
+ */
+double stress_time_cpu_self(void)
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+		return 0.0;
+	return stress_timeval_to_double(&usage.ru_utime) +
+	       stress_timeval_to_double(&usage.ru_stime);
+}
+
 /*
  *  stress_format_time()
  *	format a unit of time into human readable format
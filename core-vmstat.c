@@ -912,6 +912,59 @@ static void stress_read_vmstat(stress_vmstat_t *vmstat)
 }
 #endif
 
+/*
+ *  stress_read_proc_fields()
+ *	read the values of the named fields from a /proc file with
+ *	"name value" or "name: value kB" lines such as /proc/vmstat
+ *	and /proc/meminfo, values of fields not found are left
+ *	untouched. Returns the number of fields found.
+ */
+size_t stress_read_proc_fields(
+	const char *filename,
+	const char * const *names,
+	uint64_t *values,
+	const size_t n)
+{
+#if defined(__linux__)
+	FILE *fp;
+	char buffer[256];
+	size_t found = 0;
+
+	fp = fopen(filename, "r");
+	if (!fp)
+		return 0;
+
+	while ((found < n) && fgets(buffer, sizeof(buffer), fp)) {
+		size_t i;
+
+		for (i = 0; i < n; i++) {
+			const size_t len = strlen(names[i]);
+			char *ptr = buffer;
+
+			if (strncmp(buffer, names[i], len))
+				continue;
+			if ((buffer[len] != ':') && (buffer[len] != ' '))
+				continue;
+			if (!stress_next_field(&ptr))
+				break;
+			values[i] = (uint64_t)atoll(ptr);
+			found++;
+			break;
+		}
+	}
+	(void)fclose(fp);
+
+	return found;
+#else
+	(void)filename;
+	(void)names;
+	(void)values;
+	(void)n;
+
+	return 0;
+#endif
+}
+
 #define STRESS_VMSTAT_COPY(field)	vmstat->field = (vmstat_current.field)
 #define STRESS_VMSTAT_DELTA(field)					\
 	vmstat->field = ((vmstat_current.field > vmstat_prev.field) ?	\
@@ -30,5 +30,7 @@ extern WARN_UNUSED char *stress_find_mount_dev(const char *name);
 extern void stress_set_vmstat_units(const char *const opt);
 extern void stress_vmstat_start(void);
 extern void stress_vmstat_stop(void);
+extern size_t stress_read_proc_fields(const char *filename,
+	const char * const *names, uint64_t *values, const size_t n);
 
 #endif
@@ -0,0 +1 @@
+#define STRESS_GIT_COMMIT_ID "bad2e9cff02b1da7f6a75553ce6dd516f4ff88ad"
@@ -400,6 +400,8 @@ do
 		echo "Filesystem: $FS"
 		do_stress --hdd -1 --hdd-ops 50000 --hdd-opts fadv-dontneed --temp-path $MNT --iostat 1
 		echo "Filesystem: $FS"
+		do_stress --hdd -1 --hdd-ops 200 --hdd-dio-sweep --temp-path $MNT --iostat 1
+		echo "Filesystem: $FS"
 		do_stress --verity -1 --temp-path $MNT --iostat 1
 		echo "Filesystem: $FS"
 		do_stress --utime -1 --utime-fsync --temp-path $MNT --iostat 1
@@ -460,6 +462,9 @@ do_stress --all 1
 #
 #  Exercise various stressor options
 #
+do_stress --accept -1 --accept-acceptors 16 --accept-clients 4
+do_stress --accept -1 --accept-method reuseport
+
 do_stress --acl -1 --acl-rand
 
 do_stress --affinity -1 --affinity-pin
@@ -472,7 +477,15 @@ do_stress --brk -1 --brk-notouch --vmstat 1
 do_stress --brk -1 --brk-mlock
 do_stress --brk -1 --thrash
 
+do_stress --busypoll -1
+do_stress --busypoll -1 --busypoll-method epoll-busy-poll
+
 do_stress --cacheline 32 --cacheline-affinity
+do_stress --cacheline 1 --cacheline-matrix
+do_stress --cacheline 1 --cacheline-matrix-cas
+
+do_stress --churn -1
+do_stress --churn -1 --churn-close client --churn-rate 5000
 
 do_stress --cpu -1 --sched batch --thermalstat 1
 do_stress --cpu -1 --taskset 0,2 --ignite-cpu
@@ -514,6 +527,9 @@ do_stress --dentry -1 --dentry-order random
 
 do_stress --eventfd -1 --eventfd-nonblock
 
+do_stress --eventloop -1 --eventloop-conns 16384
+do_stress --eventloop -1 --eventloop-method io-uring --eventloop-active 10
+
 do_stress --exec -1 --exec-no-pthread
 do_stress --exec -1 --exec-fork-method clone
 do_stress --exec -1 --exec-fork-method fork
@@ -531,6 +547,9 @@ do_stress --fork -1 --fork-pageout
 
 do_stress --forkheavy -1 --forkheavy-mlock
 
+do_stress --futex -1 --futex-method all
+do_stress --futex -1 --futex-method requeue --futex-waiters 64
+
 do_stress --get -1 --get-slow-sync
 
 do_stress --goto -1 --goto-direction forward
@@ -543,6 +562,9 @@ do_stress --icmp-flood -1 --icmp-flood-max-size
 do_stress --itimer -1 --itimer-rand
 do_stress --itimer -1 --itimer-freq 1000
 
+do_stress --ktls -1
+do_stress --ktls -1 --ktls-sendfile --ktls-cipher chacha20-poly1305
+
 do_stress --l1cache -1 --l1cache-mlock
 
 do_stress --link -1 --link-sync
@@ -555,6 +577,11 @@ do_stress --llc-affinity -1 --llc-affinity-numa
 
 do_stress --lockf -1 --lockf-nonblock
 
+do_stress --lockalgo -1
+do_stress --lockalgo -1 --lockalgo-method qrwlock --lockalgo-threads 8 --lockalgo-readers 50
+do_stress --lockfree -1
+do_stress --lockfree -1 --lockfree-method lcrq --lockfree-threads 16 --lockfree-placement spread
+
 do_stress --lockbus -1 --lockbus-nosplit
 
 do_stress --madvise -1 --madvise-hwpoison
@@ -672,6 +699,12 @@ do_stress --randlist -1 --randist-compact
 do_stress --ramfs -1 --ramfs-fill
 do_stress --ramfs -1 --ramfs-size 16M
 
+do_stress --readahead -1 --readahead-sweep
+do_stress --readahead -1 --readahead-sweep --readahead-window 2M
+
+do_stress --readmostly -1 --readmostly-readers 4
+do_stress --readmostly -1 --readmostly-method rcu --readmostly-writers 2
+
 
 do_stress --rawpkt -1 --rawpkt-rxring 2
 do_stress --rawpkt -1 --rawpkt-rxring 16
@@ -687,17 +720,26 @@ do_stress --ring-pipe -1 --ring-pipe-splice
 do_stress --ring-pipe -1 --ring-pipe-num 1024
 do_stress --ring-pipe -1 --ring-pipe-size 37
 
+do_stress --rseq -1 --rseq-method all --rseq-threads 4
+
 do_stress --sctp -1 --sctp-domain ipv4
 do_stress --sctp -1 --sctp-domain ipv6
 do_stress --sctp -1 --sctp-domain ipv4 --sctp-sched fcfs
 do_stress --sctp -1 --sctp-domain ipv4 --sctp-sched prio
 do_stress --sctp -1 --sctp-domain ipv4 --sctp-sched rr
 
+do_stress --schbench -1
+do_stress --schbench -1 --schbench-msg-threads 8 --schbench-burst 500 --schbench-policy batch
+
 do_stress --schedmix -1 --schedmix-procs 64
 
 do_stress --shm -1 --shm-objs 100000
 do_stress --shm -1 --shm-mlock
 
+do_stress --shm-backing -1
+do_stress --shm-backing -1 --shm-backing-huge
+do_stress --shm-backing -1 --shm-backing-method memfd --shm-backing-bytes 256M
+
 do_stress --shm-sysv -1 --shm-sysv-segs 128
 do_stress --shm-sysv -1 --shm-sysv-mlock
 do_stress --shm-sysv -1 --sem-sysv-setall
@@ -709,6 +751,9 @@ do_stress --sem -1 --sem-shared
 
 do_stress --sleep -1 --sleep-max 4096
 
+do_stress --smt -1 --smt-victim memory
+do_stress --smt -1 --smt-aggressor branch
+
 do_stress --sock -1 --sock-nodelay
 do_stress --sock -1 --sock-domain ipv4
 do_stress --sock -1 --sock-domain ipv6
@@ -718,6 +763,12 @@ do_stress --sock -1 --sock-type seqpacket
 do_stress --sock -1 --sock-protocol mptcp
 do_stress --sock -1 --sock-opts random
 do_stress --sock -1 --sock-opts send --sock-zerocopy
+do_stress --sock -1 --sock-mode rr --sock-rr-conns 8
+do_stress --sock -1 --sock-mode crr --sock-rr-size 4K
+do_stress --sock -1 --sock-mode rr --sock-domain unix
+do_stress --sock -1 --sock-mode zerocopy
+do_stress --sock -1 --sock-mode zerocopy --sock-domain ipv6
+do_stress --sock -1 --sock-mode bufsize
 
 do_stress --sockfd -1 --sockfd-reuse
 
@@ -770,10 +821,15 @@ do_stress --udp -1 --udp-domain ipv6
 do_stress --udp -1 --udp-lite --udp-domain ipv4
 do_stress --udp -1 --udp-lite --udp-domain ipv6
 do_stress --udp -1 --udp-gro
+do_stress --udp -1 --udp-mode bulk --udp-domain ipv4
+do_stress --udp -1 --udp-mode bulk --udp-domain ipv6
 
 do_stress --udp-flood -1 --udp-flood-domain ipv4
 do_stress --udp-flood -1 --udp-flood-domain ipv6
 
+do_stress --unixipc -1
+do_stress --unixipc -1 --unixipc-type seqpacket
+
 do_stress --utime -1 --utime-fsync
 
 do_stress --vfork 1 --vfork-max 64
@@ -800,12 +856,25 @@ do_stress --vm -1 --vm-populate --ksm
 do_stress --vm-addr -1 --vm-addr-mlock
 do_stress --vm-addr -1 --vm-addr-numa
 
+do_stress --wakelat -1
+do_stress --wakelat -1 --wakelat-method msg-ring --wakelat-placement unpinned
+do_stress --wal -1 --wal-method fsync --wal-writers 4
+do_stress --wal -1 --wal-method odsync --wal-record-size 4K
+do_stress --wal -1 --wal-method rwf-dsync
+do_stress --wal -1 --wal-method io-uring --wal-writers 16
+
 do_stress --workload -1 --workload-sched idle --workload-load 90
 do_stress --workload -1 --workload-sched other --workload-load 90
 do_stress --workload -1 --workload-sched batch --workload-load 90
 do_stress --workload -1 --workload-sched deadline --workload-load 90
 do_stress --workload -1 --workload-threads 8
 
+do_stress --worksteal -1
+do_stress --worksteal -1 --worksteal-method uts --worksteal-threads 8
+
+do_stress --writeback -1
+do_stress --writeback -1 --writeback-rate 50 --writeback-write-size 4K
+
 do_stress --yield -1 --yield-sched deadline
 do_stress --yield -1 --yield-sched idle
 do_stress --yield -1 --yield-sched fifo
@@ -0,0 +1,701 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-killpid.h"
+#include "core-net.h"
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#if defined(HAVE_NETINET_TCP_H)
+#include <netinet/tcp.h>
+#endif
+
+#if defined(HAVE_POLL_H)
+#include <poll.h>
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#endif
+
+#include <sys/resource.h>
+
+#define DEFAULT_ACCEPT_PORT		(18000)
+
+#define MIN_ACCEPT_ACCEPTORS		(1)
+#define MAX_ACCEPT_ACCEPTORS		(64)
+#define DEFAULT_ACCEPT_ACCEPTORS	(4)
+
+#define MIN_ACCEPT_CLIENTS		(1)
+#define MAX_ACCEPT_CLIENTS		(256)
+#define DEFAULT_ACCEPT_CLIENTS		(8)
+
+#define ACCEPT_MAX_SAMPLES		(4096)	/* latency samples per acceptor */
+#define ACCEPT_SLICE			(0.5)	/* seconds per method */
+#define ACCEPT_WAIT_MS			(10)	/* acceptor epoll_wait timeout */
+#define ACCEPT_IO_TIMEOUT_USEC		(100000)	/* client connect/read timeout */
+#define ACCEPT_READY_TIMEOUT		(5.0)	/* seconds to wait for acceptors */
+
+static const stress_help_t help[] = {
+	{ NULL,	"accept N",		"start N workers exercising concurrent accept on a listener" },
+	{ NULL,	"accept-acceptors M",	"number of acceptor processes per worker" },
+	{ NULL,	"accept-clients K",	"number of connecting client processes per worker" },
+	{ NULL,	"accept-method M",	"accept method: all, epoll, epoll-exclusive, reuseport" },
+	{ NULL,	"accept-ops N",		"stop after N accepted connections" },
+	{ NULL,	"accept-port P",	"use socket ports P to P + number of workers - 1" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef enum {
+	ACCEPT_METHOD_ALL,
+	ACCEPT_METHOD_EPOLL,
+	ACCEPT_METHOD_EPOLL_EXCLUSIVE,
+	ACCEPT_METHOD_REUSEPORT,
+} stress_accept_method_t;
+
+typedef struct {
+	const char *name;
+	const stress_accept_method_t method;
+} stress_accept_method_info_t;
+
+static const stress_accept_method_info_t stress_accept_methods[] = {
+	{ "all",		ACCEPT_METHOD_ALL },
+	{ "epoll",		ACCEPT_METHOD_EPOLL },
+	{ "epoll-exclusive",	ACCEPT_METHOD_EPOLL_EXCLUSIVE },
+	{ "reuseport",		ACCEPT_METHOD_REUSEPORT },
+};
+
+static const char *stress_accept_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_accept_methods)) ? stress_accept_methods[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_accept_acceptors,	"accept-acceptors", TYPE_ID_UINT32, MIN_ACCEPT_ACCEPTORS, MAX_ACCEPT_ACCEPTORS, NULL },
+	{ OPT_accept_clients,	"accept-clients",   TYPE_ID_UINT32, MIN_ACCEPT_CLIENTS, MAX_ACCEPT_CLIENTS, NULL },
+	{ OPT_accept_method,	"accept-method",    TYPE_ID_SIZE_T_METHOD, 0, 0, stress_accept_method },
+	{ OPT_accept_port,	"accept-port",      TYPE_ID_INT_PORT, MIN_PORT, MAX_PORT, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_SYS_EPOLL_H) &&	\
+    defined(HAVE_POLL_H) &&		\
+    defined(AF_INET) &&			\
+    defined(SOCK_STREAM)
+
+/*
+ *  per acceptor results, shared with the acceptor processes
+ */
+typedef struct {
+	uint64_t accepts;		/* connections accepted */
+	uint64_t nvcsw;			/* voluntary context switches */
+	uint64_t index;			/* next latency sample */
+	int err;			/* errno of a failed setup, 0 if OK */
+	bool ready;			/* listening and waiting for connections */
+	double samples[ACCEPT_MAX_SAMPLES];	/* accept latencies (seconds) */
+} stress_accept_worker_t;
+
+/*
+ *  per method results
+ */
+typedef struct {
+	stress_accept_method_t method;
+	bool unsupported;		/* method could not be used */
+	double duration;		/* time spent in this method */
+	stress_accept_worker_t *workers;	/* one per acceptor */
+} stress_accept_config_t;
+
+/*
+ *  state shared between the parent, acceptors and clients
+ */
+typedef struct {
+	double t_end;			/* clients stop connecting at this time */
+	bool stop;			/* acceptors stop when set */
+} stress_accept_shared_t;
+
+static const char *stress_accept_method_name(const stress_accept_method_t method)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(stress_accept_methods); i++) {
+		if (stress_accept_methods[i].method == method)
+			return stress_accept_methods[i].name;
+	}
+	return "unknown";
+}
+
+/*
+ *  stress_accept_set_addr()
+ *	loopback address of the given port
+ */
+static void stress_accept_set_addr(struct sockaddr_in *addr, const int port)
+{
+	(void)shim_memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr->sin_port = htons((uint16_t)port);
+}
+
+/*
+ *  stress_accept_listen()
+ *	create a non-blocking listening socket, optionally with
+ *	SO_REUSEPORT set, returns the fd or -1 with errno set
+ */
+static int stress_accept_listen(const int port, const bool reuseport)
+{
+	struct sockaddr_in addr;
+	int fd, one = 1, err;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0)
+		goto err;
+	if (reuseport) {
+#if defined(SO_REUSEPORT)
+		if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0)
+			goto err;
+#else
+		errno = ENOSYS;
+		goto err;
+#endif
+	}
+	stress_accept_set_addr(&addr, port);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+		goto err;
+	if (listen(fd, SOMAXCONN) < 0)
+		goto err;
+	if (fcntl(fd, F_SETFL, O_NONBLOCK) < 0)
+		goto err;
+	return fd;
+err:
+	err = errno;
+	(void)close(fd);
+	errno = err;
+	return -1;
+}
+
+/*
+ *  stress_accept_epoll()
+ *	create an epoll instance watching the listener, returns
+ *	the epoll fd or -1 with errno set
+ */
+static int stress_accept_epoll(const int lfd, const bool exclusive)
+{
+	struct epoll_event ev;
+	int efd, err;
+
+	efd = epoll_create1(0);
+	if (efd < 0)
+		return -1;
+	(void)shim_memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	if (exclusive) {
+#if defined(EPOLLEXCLUSIVE)
+		ev.events |= EPOLLEXCLUSIVE;
+#else
+		(void)close(efd);
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, lfd, &ev) < 0) {
+		err = errno;
+		(void)close(efd);
+		errno = err;
+		return -1;
+	}
+	return efd;
+}
+
+/*
+ *  stress_accept_method_check()
+ *	check the method can be used, returns 0 if OK or -1
+ *	with errno set
+ */
+static int stress_accept_method_check(const stress_accept_method_t method, const int port)
+{
+	int lfd, efd;
+
+	lfd = stress_accept_listen(port, method == ACCEPT_METHOD_REUSEPORT);
+	if (lfd < 0)
+		return -1;
+	efd = stress_accept_epoll(lfd, method == ACCEPT_METHOD_EPOLL_EXCLUSIVE);
+	(void)close(lfd);
+	if (efd < 0)
+		return -1;
+	(void)close(efd);
+	return 0;
+}
+
+/*
+ *  stress_accept_acceptor()
+ *	acceptor process, wait for the listener to become ready, accept
+ *	one connection per wake-up, read the client's connect timestamp,
+ *	reply and close
+ */
+static int stress_accept_acceptor(
+	stress_accept_worker_t *worker,
+	const stress_accept_shared_t *shared,
+	const stress_accept_method_t method,
+	int lfd,
+	const int port)
+{
+	struct rusage usage;
+	int efd;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	if (method == ACCEPT_METHOD_REUSEPORT) {
+		/* each acceptor has its own listener in the port's reuseport group */
+		lfd = stress_accept_listen(port, true);
+		if (lfd < 0) {
+			worker->err = errno;
+			worker->ready = true;
+			return EXIT_FAILURE;
+		}
+	}
+	efd = stress_accept_epoll(lfd, method == ACCEPT_METHOD_EPOLL_EXCLUSIVE);
+	if (efd < 0) {
+		worker->err = errno;
+		worker->ready = true;
+		return EXIT_FAILURE;
+	}
+	(void)shim_memset(&usage, 0, sizeof(usage));
+	(void)getrusage(RUSAGE_SELF, &usage);
+	worker->nvcsw -= (uint64_t)usage.ru_nvcsw;
+	worker->ready = true;
+
+	while (!shared->stop && stress_continue_flag()) {
+		struct epoll_event ev;
+		struct pollfd pfd;
+		double t_accept, t_connect;
+		const uint8_t reply = 0;
+		int fd;
+
+		if (epoll_wait(efd, &ev, 1, ACCEPT_WAIT_MS) <= 0)
+			continue;
+		fd = accept(lfd, NULL, NULL);
+		if (fd < 0)
+			continue;	/* another acceptor got it first */
+		t_accept = stress_time_now();
+		worker->accepts++;
+
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if ((poll(&pfd, 1, ACCEPT_IO_TIMEOUT_USEC / 1000) == 1) &&
+		    (recv(fd, &t_connect, sizeof(t_connect), 0) == (ssize_t)sizeof(t_connect))) {
+			worker->samples[worker->index % ACCEPT_MAX_SAMPLES] = t_accept - t_connect;
+			worker->index++;
+			VOID_RET(ssize_t, send(fd, &reply, sizeof(reply), 0));
+		}
+		(void)close(fd);
+	}
+	/*
+	 *  every wake-up of a sleeping acceptor is a voluntary context
+	 *  switch, including the thundering herd wake-ups that epoll_wait
+	 *  absorbs when another acceptor has already taken the connection
+	 */
+	(void)getrusage(RUSAGE_SELF, &usage);
+	worker->nvcsw += (uint64_t)usage.ru_nvcsw;
+	(void)close(efd);
+	if (method == ACCEPT_METHOD_REUSEPORT)
+		(void)close(lfd);
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_accept_client()
+ *	client process, connect, send the connect timestamp, wait for
+ *	the reply and close with a reset so that no TIME_WAIT sockets
+ *	pile up, until the end of the time slice
+ */
+static int stress_accept_client(const stress_accept_shared_t *shared, const int port)
+{
+	struct sockaddr_in addr;
+	struct timeval tv;
+	struct linger lng;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	stress_accept_set_addr(&addr, port);
+	tv.tv_sec = 0;
+	tv.tv_usec = ACCEPT_IO_TIMEOUT_USEC;
+	lng.l_onoff = 1;
+	lng.l_linger = 0;
+
+	while (!shared->stop && stress_continue_flag() && (stress_time_now() < shared->t_end)) {
+		double t_connect;
+		uint8_t reply;
+		int fd;
+
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0)
+			return EXIT_NO_RESOURCE;
+		/* SO_SNDTIMEO also bounds a blocking connect */
+		(void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+		(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+#if defined(HAVE_NETINET_TCP_H) &&	\
+    defined(TCP_NODELAY)
+		{
+			int one = 1;
+
+			(void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		}
+#endif
+		t_connect = stress_time_now();
+		if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+			if (send(fd, &t_connect, sizeof(t_connect), 0) == (ssize_t)sizeof(t_connect))
+				VOID_RET(ssize_t, recv(fd, &reply, sizeof(reply), 0));
+		}
+		(void)setsockopt(fd, SOL_SOCKET, SO_LINGER, &lng, sizeof(lng));
+		(void)close(fd);
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_accept_wait()
+ *	wait for n child processes to exit, on a stop request
+ *	tell the acceptors to stop
+ */
+static void stress_accept_wait(stress_accept_shared_t *shared, const pid_t *pids, const size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		int status;
+
+		if (pids[i] <= 0)
+			continue;
+		if (!stress_continue_flag())
+			shared->stop = true;
+		(void)shim_waitpid(pids[i], &status, 0);
+	}
+}
+
+/*
+ *  stress_accept_run()
+ *	run one time slice of a method, returns the number of
+ *	connections accepted
+ */
+static uint64_t stress_accept_run(
+	stress_args_t *args,
+	stress_accept_config_t *cfg,
+	stress_accept_shared_t *shared,
+	pid_t *pids,
+	const uint32_t acceptors,
+	const uint32_t clients,
+	const int port)
+{
+	const bool shared_listener = (cfg->method != ACCEPT_METHOD_REUSEPORT);
+	uint64_t accepts = 0;
+	size_t i, n_acceptors = 0, n_clients = 0;
+	double t_start, t_timeout;
+	int lfd = -1;
+
+	shared->stop = false;
+	for (i = 0; i < acceptors; i++) {
+		cfg->workers[i].ready = false;
+		cfg->workers[i].err = 0;
+		accepts -= cfg->workers[i].accepts;
+	}
+
+	if (shared_listener) {
+		lfd = stress_accept_listen(port, false);
+		if (lfd < 0) {
+			pr_fail("%s: %s listen on port %d failed, errno=%d (%s)\n",
+				args->name, stress_accept_method_name(cfg->method),
+				port, errno, strerror(errno));
+			cfg->unsupported = true;
+			return 0;
+		}
+	}
+
+	for (n_acceptors = 0; n_acceptors < acceptors; n_acceptors++) {
+		pid_t pid;
+again_acceptor:
+		pid = fork();
+		if (pid < 0) {
+			if (stress_redo_fork(args, errno))
+				goto again_acceptor;
+			break;
+		} else if (pid == 0) {
+			_exit(stress_accept_acceptor(&cfg->workers[n_acceptors], shared,
+				cfg->method, lfd, port));
+		}
+		pids[n_acceptors] = pid;
+	}
+	if (lfd >= 0)
+		(void)close(lfd);
+
+	/* all the acceptors must be listening before the clients connect */
+	t_timeout = stress_time_now() + ACCEPT_READY_TIMEOUT;
+	for (i = 0; (i < n_acceptors) && stress_continue(args); ) {
+		if (cfg->workers[i].ready) {
+			if (cfg->workers[i].err) {
+				pr_fail("%s: %s acceptor setup failed, errno=%d (%s)\n",
+					args->name, stress_accept_method_name(cfg->method),
+					cfg->workers[i].err, strerror(cfg->workers[i].err));
+				cfg->unsupported = true;
+				break;
+			}
+			i++;
+			continue;
+		}
+		if (stress_time_now() > t_timeout)
+			break;
+		(void)shim_usleep(1000);
+	}
+
+	t_start = stress_time_now();
+	shared->t_end = t_start + ACCEPT_SLICE;
+	if ((n_acceptors > 0) && (i == n_acceptors)) {
+		for (n_clients = 0; n_clients < clients; n_clients++) {
+			pid_t pid;
+again_client:
+			pid = fork();
+			if (pid < 0) {
+				if (stress_redo_fork(args, errno))
+					goto again_client;
+				break;
+			} else if (pid == 0) {
+				_exit(stress_accept_client(shared, port));
+			}
+			pids[acceptors + n_clients] = pid;
+		}
+	}
+	stress_accept_wait(shared, pids + acceptors, n_clients);
+	cfg->duration += stress_time_now() - t_start;
+
+	shared->stop = true;
+	stress_accept_wait(shared, pids, n_acceptors);
+
+	for (i = 0; i < acceptors; i++)
+		accepts += cfg->workers[i].accepts;
+	return accepts;
+}
+
+/*
+ *  stress_accept_metrics()
+ *	report connections/sec, accept latency, the imbalance of
+ *	accepts across the acceptors and acceptor context switches
+ *	per accept
+ */
+static void stress_accept_metrics(
+	stress_args_t *args,
+	stress_accept_config_t *configs,
+	const size_t n_configs,
+	const uint32_t acceptors)
+{
+	size_t i, idx = 0;
+	double *samples;
+
+	samples = (double *)calloc((size_t)acceptors * ACCEPT_MAX_SAMPLES, sizeof(*samples));
+	if (!samples)
+		return;
+
+	for (i = 0; i < n_configs; i++) {
+		const stress_accept_config_t *cfg = &configs[i];
+		const char *name = stress_accept_method_name(cfg->method);
+		uint64_t accepts = 0, nvcsw = 0, max_accepts = 0;
+		size_t j, n_samples = 0;
+		char msg[64];
+
+		if (cfg->unsupported)
+			continue;
+		for (j = 0; j < acceptors; j++) {
+			const stress_accept_worker_t *worker = &cfg->workers[j];
+			const size_t n = (size_t)STRESS_MINIMUM(worker->index, ACCEPT_MAX_SAMPLES);
+
+			accepts += worker->accepts;
+			nvcsw += worker->nvcsw;
+			max_accepts = STRESS_MAXIMUM(max_accepts, worker->accepts);
+			(void)shim_memcpy(samples + n_samples, worker->samples, n * sizeof(*samples));
+			n_samples += n;
+		}
+		if ((accepts == 0) || (n_samples == 0))
+			continue;
+		stress_percentile_sort(samples, n_samples);
+
+		(void)snprintf(msg, sizeof(msg), "connections/sec %s", name);
+		stress_metrics_set(args, idx++, msg,
+			(cfg->duration > 0.0) ? (double)accepts / cfg->duration : 0.0,
+			STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p50 accept latency %s", name);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(samples, n_samples, 50.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99 accept latency %s", name);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(samples, n_samples, 99.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99.9 accept latency %s", name);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(samples, n_samples, 99.9),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		/* 1.0 is perfectly balanced, acceptors is all on one acceptor */
+		(void)snprintf(msg, sizeof(msg), "imbalance (max/mean accepts) %s", name);
+		stress_metrics_set(args, idx++, msg,
+			((double)max_accepts * (double)acceptors) / (double)accepts,
+			STRESS_METRIC_MAXIMUM);
+		(void)snprintf(msg, sizeof(msg), "context switches per accept %s", name);
+		stress_metrics_set(args, idx++, msg,
+			(double)nvcsw / (double)accepts,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+	free(samples);
+}
+
+/*
+ *  stress_accept
+ *	stress accept scaling with a shared listener and with
+ *	per acceptor SO_REUSEPORT listeners
+ */
+static int stress_accept(stress_args_t *args)
+{
+	int accept_port = DEFAULT_ACCEPT_PORT, reserved_port;
+	uint32_t accept_acceptors = DEFAULT_ACCEPT_ACCEPTORS;
+	uint32_t accept_clients = DEFAULT_ACCEPT_CLIENTS;
+	size_t accept_method = 0;
+	size_t i, n_configs = 0, mmap_size, workers_size;
+	stress_accept_method_t method;
+	stress_accept_config_t configs[SIZEOF_ARRAY(stress_accept_methods)];
+	stress_accept_shared_t *shared;
+	uint8_t *mapping;
+	pid_t *pids;
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("accept-acceptors", &accept_acceptors);
+	(void)stress_get_setting("accept-clients", &accept_clients);
+	(void)stress_get_setting("accept-method", &accept_method);
+	(void)stress_get_setting("accept-port", &accept_port);
+	method = stress_accept_methods[accept_method].method;
+
+	accept_port += args->instance;
+	if (accept_port > MAX_PORT)
+		accept_port -= (MAX_PORT - MIN_PORT + 1);
+	reserved_port = stress_net_reserve_ports(accept_port, accept_port);
+	if (reserved_port < 0) {
+		pr_inf_skip("%s: cannot reserve port %d, skipping stressor\n",
+			args->name, accept_port);
+		return EXIT_NO_RESOURCE;
+	}
+	accept_port = reserved_port;
+
+	(void)shim_memset(configs, 0, sizeof(configs));
+	for (i = 0; i < SIZEOF_ARRAY(stress_accept_methods); i++) {
+		const stress_accept_method_t m = stress_accept_methods[i].method;
+
+		if ((m == ACCEPT_METHOD_ALL) || ((method != ACCEPT_METHOD_ALL) && (method != m)))
+			continue;
+		if (stress_accept_method_check(m, accept_port) < 0) {
+			if (stress_instance_zero(args))
+				pr_inf("%s: cannot use %s, errno=%d (%s), skipping it\n",
+					args->name, stress_accept_method_name(m),
+					errno, strerror(errno));
+			continue;
+		}
+		configs[n_configs++].method = m;
+	}
+	if (n_configs == 0) {
+		pr_inf_skip("%s: no accept methods can be used, skipping stressor\n", args->name);
+		stress_net_release_ports(accept_port, accept_port);
+		return EXIT_NOT_IMPLEMENTED;
+	}
+
+	pids = (pid_t *)calloc((size_t)accept_acceptors + accept_clients, sizeof(*pids));
+	if (!pids) {
+		pr_inf_skip("%s: cannot allocate process table%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		stress_net_release_ports(accept_port, accept_port);
+		return EXIT_NO_RESOURCE;
+	}
+	workers_size = (size_t)accept_acceptors * sizeof(stress_accept_worker_t);
+	mmap_size = sizeof(*shared) + n_configs * workers_size;
+	mapping = (uint8_t *)stress_mmap_populate(NULL, mmap_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for results%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, mmap_size,
+			stress_get_memfree_str(), errno, strerror(errno));
+		free(pids);
+		stress_net_release_ports(accept_port, accept_port);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(mapping, mmap_size, "accept-results");
+	shared = (stress_accept_shared_t *)mapping;
+	for (i = 0; i < n_configs; i++)
+		configs[i].workers = (stress_accept_worker_t *)(mapping + sizeof(*shared) + i * workers_size);
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %" PRIu32 " acceptors, %" PRIu32 " clients\n",
+			args->name, accept_acceptors, accept_clients);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	do {
+		bool all_unsupported = true;
+
+		for (i = 0; (i < n_configs) && stress_continue(args); i++) {
+			if (configs[i].unsupported)
+				continue;
+			stress_bogo_add(args, stress_accept_run(args, &configs[i], shared,
+				pids, accept_acceptors, accept_clients, accept_port));
+			if (configs[i].unsupported)
+				rc = EXIT_FAILURE;
+			else
+				all_unsupported = false;
+		}
+		if (all_unsupported)
+			break;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	stress_accept_metrics(args, configs, n_configs, accept_acceptors);
+
+	(void)munmap((void *)mapping, mmap_size);
+	free(pids);
+	stress_net_release_ports(accept_port, accept_port);
+
+	return rc;
+}
+
+const stressor_info_t stress_accept_info = {
+	.stressor = stress_accept,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_accept_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without sys/epoll.h, poll.h or AF_INET socket support"
+};
+#endif
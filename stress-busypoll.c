@@ -0,0 +1,952 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-capabilities.h"
+#include "core-killpid.h"
+#include "core-net.h"
+
+#include <sys/ioctl.h>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#if defined(HAVE_NET_IF_H)
+#include <net/if.h>
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#endif
+
+#if defined(HAVE_LINUX_SOCKIOS_H)
+#include <linux/sockios.h>
+#endif
+
+#if defined(HAVE_LINUX_NETLINK_H)
+#include <linux/netlink.h>
+#endif
+
+#if defined(HAVE_LINUX_RTNETLINK_H)
+#include <linux/rtnetlink.h>
+#endif
+
+#if defined(HAVE_LINUX_ETHTOOL_H)
+#include <linux/ethtool.h>
+#endif
+
+#define DEFAULT_BUSYPOLL_PORT	(19000)
+
+#define MIN_BUSYPOLL_USEC	(1)
+#define MAX_BUSYPOLL_USEC	(1000000)
+#define DEFAULT_BUSYPOLL_USEC	(50)
+
+#define BUSYPOLL_SLICE		(0.25)	/* seconds per configuration */
+#define BUSYPOLL_MAX_SAMPLES	(8192)	/* round trip samples per configuration */
+#define BUSYPOLL_MSG_SIZE	(64)	/* ping-pong message size */
+#define BUSYPOLL_END_SIZE	(1)	/* end of configuration marker size */
+#define BUSYPOLL_TIMEOUT_USEC	(100000)	/* lost packet timeout */
+#define BUSYPOLL_BUDGET		(8)	/* packets per busy poll */
+
+/* veth pair, private to the stressor's network namespaces */
+#define BUSYPOLL_VETH_CLIENT	"sngbp0"
+#define BUSYPOLL_VETH_SERVER	"sngbp1"
+#define BUSYPOLL_VETH_NET	(0x0afe0000)	/* 10.254.0.0/24 */
+
+static const stress_help_t help[] = {
+	{ NULL,	"busypoll N",		"start N workers comparing busy polling and interrupt driven receives" },
+	{ NULL,	"busypoll-method M",	"method: all, interrupt, busy-poll, prefer-busy-poll, epoll-busy-poll, spin" },
+	{ NULL,	"busypoll-ops N",	"stop after N round trips" },
+	{ NULL,	"busypoll-port P",	"use socket ports P to P + number of workers - 1" },
+	{ NULL,	"busypoll-usec N",	"busy poll for up to N microseconds" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef enum {
+	BUSYPOLL_METHOD_ALL,
+	BUSYPOLL_METHOD_INTERRUPT,
+	BUSYPOLL_METHOD_BUSY_POLL,
+	BUSYPOLL_METHOD_PREFER_BUSY_POLL,
+	BUSYPOLL_METHOD_EPOLL_BUSY_POLL,
+	BUSYPOLL_METHOD_SPIN,
+} stress_busypoll_method_t;
+
+typedef struct {
+	const char *name;
+	const stress_busypoll_method_t method;
+} stress_busypoll_method_info_t;
+
+static const stress_busypoll_method_info_t stress_busypoll_methods[] = {
+	{ "all",		BUSYPOLL_METHOD_ALL },
+	{ "interrupt",		BUSYPOLL_METHOD_INTERRUPT },
+	{ "busy-poll",		BUSYPOLL_METHOD_BUSY_POLL },
+	{ "prefer-busy-poll",	BUSYPOLL_METHOD_PREFER_BUSY_POLL },
+	{ "epoll-busy-poll",	BUSYPOLL_METHOD_EPOLL_BUSY_POLL },
+	{ "spin",		BUSYPOLL_METHOD_SPIN },
+};
+
+static const char *stress_busypoll_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_busypoll_methods)) ? stress_busypoll_methods[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_busypoll_method,	"busypoll-method", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_busypoll_method },
+	{ OPT_busypoll_port,	"busypoll-port",   TYPE_ID_INT_PORT, MIN_PORT, MAX_PORT, NULL },
+	{ OPT_busypoll_usec,	"busypoll-usec",   TYPE_ID_UINT32, MIN_BUSYPOLL_USEC, MAX_BUSYPOLL_USEC, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_SYS_EPOLL_H) &&	\
+    defined(AF_INET) &&			\
+    defined(SOCK_DGRAM) &&		\
+    defined(SO_BUSY_POLL)
+
+/*
+ *  epoll busy poll parameters, from Linux 6.9 linux/eventpoll.h
+ */
+typedef struct {
+	uint32_t busy_poll_usecs;
+	uint16_t busy_poll_budget;
+	uint8_t prefer_busy_poll;
+	uint8_t pad;
+} stress_epoll_params_t;
+
+#if defined(EPIOCSPARAMS)
+#define STRESS_EPIOCSPARAMS	EPIOCSPARAMS
+#elif defined(_IOW)
+#define STRESS_EPIOCSPARAMS	_IOW(0x8A, 0x01, stress_epoll_params_t)
+#endif
+
+#if defined(__linux__) &&		\
+    defined(HAVE_LINUX_NETLINK_H) &&	\
+    defined(HAVE_LINUX_RTNETLINK_H) &&	\
+    defined(HAVE_LINUX_SOCKIOS_H) &&	\
+    defined(HAVE_NET_IF_H) &&		\
+    defined(CLONE_NEWNET) &&		\
+    defined(SIOCSIFADDR) &&		\
+    defined(SIOCSIFNETMASK) &&		\
+    defined(SIOCSIFFLAGS) &&		\
+    defined(SIOCGIFFLAGS) &&		\
+    defined(IFLA_LINKINFO)
+#define HAVE_BUSYPOLL_VETH
+#endif
+
+#define VETH_INFO_PEER_ATTR	(1)	/* VETH_INFO_PEER, linux/veth.h */
+
+typedef enum {
+	BUSYPOLL_TRANSPORT_LOOPBACK,
+	BUSYPOLL_TRANSPORT_VETH,
+	BUSYPOLL_TRANSPORT_MAX,
+} stress_busypoll_transport_t;
+
+static const char * const stress_busypoll_transports[] = {
+	"loopback",
+	"veth",
+};
+
+#define BUSYPOLL_MAX_CONFIGS	\
+	(BUSYPOLL_TRANSPORT_MAX * SIZEOF_ARRAY(stress_busypoll_methods))
+
+/*
+ *  per transport and method results
+ */
+typedef struct {
+	stress_busypoll_transport_t transport;
+	stress_busypoll_method_t method;
+	bool unsupported;		/* method could not be setup */
+	bool napi;			/* socket had a NAPI ID to busy poll */
+	double duration;		/* time spent in ping-pong */
+	double cpu_client;		/* client user + system time */
+	double cpu_server;		/* server user + system time */
+	uint64_t round_trips;
+	uint64_t index;			/* next sample */
+	double samples[BUSYPOLL_MAX_SAMPLES];	/* round trip times */
+} stress_busypoll_config_t;
+
+/*
+ *  a socket and how it waits for data
+ */
+typedef struct {
+	int fd;
+	int epoll_fd;
+	stress_busypoll_method_t method;
+} stress_busypoll_sock_t;
+
+static const char *stress_busypoll_method_name(const stress_busypoll_method_t method)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(stress_busypoll_methods); i++) {
+		if (stress_busypoll_methods[i].method == method)
+			return stress_busypoll_methods[i].name;
+	}
+	return "unknown";
+}
+
+/*
+ *  stress_busypoll_set_addr()
+ *	set address for the transport, the server is .2 on veth
+ */
+static void stress_busypoll_set_addr(
+	struct sockaddr_in *addr,
+	const stress_busypoll_transport_t transport,
+	const bool server,
+	const int port)
+{
+	(void)shim_memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons((uint16_t)port);
+	if (transport == BUSYPOLL_TRANSPORT_VETH)
+		addr->sin_addr.s_addr = htonl(BUSYPOLL_VETH_NET + (server ? 2 : 1));
+	else
+		addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+/*
+ *  stress_busypoll_sock_close()
+ *	close a socket and any epoll fd
+ */
+static void stress_busypoll_sock_close(stress_busypoll_sock_t *s)
+{
+	if (s->epoll_fd >= 0)
+		(void)close(s->epoll_fd);
+	if (s->fd >= 0)
+		(void)close(s->fd);
+	s->fd = -1;
+	s->epoll_fd = -1;
+}
+
+/*
+ *  stress_busypoll_sock_open()
+ *	create a UDP socket bound to addr and setup the wait method,
+ *	returns 0 on success, -1 with errno set on failure
+ */
+static int stress_busypoll_sock_open(
+	stress_busypoll_sock_t *s,
+	const stress_busypoll_method_t method,
+	const struct sockaddr_in *addr,
+	const int usec)
+{
+	struct timeval tv;
+	int one = 1, err;
+
+	s->method = method;
+	s->epoll_fd = -1;
+	s->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (s->fd < 0)
+		return -1;
+	(void)setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	tv.tv_sec = 0;
+	tv.tv_usec = BUSYPOLL_TIMEOUT_USEC;
+	(void)setsockopt(s->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	if (addr && (bind(s->fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0))
+		goto err;
+
+	switch (method) {
+	case BUSYPOLL_METHOD_PREFER_BUSY_POLL:
+#if defined(SO_PREFER_BUSY_POLL)
+		if (setsockopt(s->fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one)) < 0)
+			goto err;
+#if defined(SO_BUSY_POLL_BUDGET)
+		{
+			const int budget = BUSYPOLL_BUDGET;
+
+			(void)setsockopt(s->fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget));
+		}
+#endif
+#else
+		errno = ENOSYS;
+		goto err;
+#endif
+		goto busy_poll;
+	case BUSYPOLL_METHOD_BUSY_POLL:
+busy_poll:
+		/* values above net.core.busy_read need CAP_NET_ADMIN */
+		if (setsockopt(s->fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) < 0)
+			goto err;
+		break;
+	case BUSYPOLL_METHOD_EPOLL_BUSY_POLL: {
+#if defined(STRESS_EPIOCSPARAMS)
+		stress_epoll_params_t params;
+		struct epoll_event ev;
+
+		s->epoll_fd = epoll_create1(0);
+		if (s->epoll_fd < 0)
+			goto err;
+		(void)shim_memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		if (epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, s->fd, &ev) < 0)
+			goto err;
+		(void)shim_memset(&params, 0, sizeof(params));
+		params.busy_poll_usecs = (uint32_t)usec;
+		params.busy_poll_budget = BUSYPOLL_BUDGET;
+		if (ioctl(s->epoll_fd, STRESS_EPIOCSPARAMS, &params) < 0)
+			goto err;
+		break;
+#else
+		errno = ENOSYS;
+		goto err;
+#endif
+	}
+	case BUSYPOLL_METHOD_SPIN:
+		if (fcntl(s->fd, F_SETFL, O_NONBLOCK) < 0)
+			goto err;
+		break;
+	default:
+		break;
+	}
+	return 0;
+err:
+	err = errno;
+	stress_busypoll_sock_close(s);
+	errno = err;
+	return -1;
+}
+
+/*
+ *  stress_busypoll_recv()
+ *	wait for and receive a datagram using the socket's method,
+ *	returns the size received, -1 with errno EAGAIN on a timeout
+ */
+static ssize_t stress_busypoll_recv(
+	const stress_busypoll_sock_t *s,
+	void *buf,
+	const size_t len,
+	struct sockaddr_in *from)
+{
+	socklen_t from_len = sizeof(*from);
+
+	switch (s->method) {
+	case BUSYPOLL_METHOD_EPOLL_BUSY_POLL: {
+		struct epoll_event ev;
+		int ret;
+
+		ret = epoll_wait(s->epoll_fd, &ev, 1, BUSYPOLL_TIMEOUT_USEC / 1000);
+		if (ret <= 0) {
+			if (ret == 0)
+				errno = EAGAIN;
+			return -1;
+		}
+		return recvfrom(s->fd, buf, len, MSG_DONTWAIT, (struct sockaddr *)from, &from_len);
+	}
+	case BUSYPOLL_METHOD_SPIN: {
+		const double t_end = stress_time_now() + ((double)BUSYPOLL_TIMEOUT_USEC / 1000000.0);
+		uint32_t spins = 0;
+
+		for (;;) {
+			const ssize_t ret = recvfrom(s->fd, buf, len, MSG_DONTWAIT,
+						(struct sockaddr *)from, &from_len);
+
+			if ((ret >= 0) || (errno != EAGAIN))
+				return ret;
+			/* yield now and then, the peer may be sharing this CPU */
+			if ((++spins & 63) == 0) {
+				if (!stress_continue_flag() || (stress_time_now() > t_end))
+					return -1;
+				(void)shim_sched_yield();
+			}
+		}
+	}
+	default:
+		/* interrupt driven or SO_BUSY_POLL busy polling in recvfrom */
+		return recvfrom(s->fd, buf, len, 0, (struct sockaddr *)from, &from_len);
+	}
+}
+
+#if defined(HAVE_BUSYPOLL_VETH)
+/*
+ *  stress_busypoll_rta_add()
+ *	append a netlink attribute to a message
+ */
+static struct rtattr *stress_busypoll_rta_add(
+	struct nlmsghdr *nh,
+	const size_t max_len,
+	const unsigned short int type,
+	const void *data,
+	const size_t len)
+{
+	struct rtattr *rta;
+	const size_t offset = NLMSG_ALIGN(nh->nlmsg_len);
+
+	if (offset + RTA_SPACE(len) > max_len)
+		return NULL;
+	rta = (struct rtattr *)(((uint8_t *)nh) + offset);
+	rta->rta_type = type;
+	rta->rta_len = (unsigned short int)RTA_LENGTH(len);
+	if (data)
+		(void)shim_memcpy(RTA_DATA(rta), data, len);
+	else
+		(void)shim_memset(RTA_DATA(rta), 0, len);
+	nh->nlmsg_len = (uint32_t)(offset + RTA_ALIGN(rta->rta_len));
+	return rta;
+}
+
+/*
+ *  stress_busypoll_rta_nest_end()
+ *	fix up the size of a nested attribute
+ */
+static void stress_busypoll_rta_nest_end(struct nlmsghdr *nh, struct rtattr *nest)
+{
+	nest->rta_len = (unsigned short int)((((uint8_t *)nh) + nh->nlmsg_len) - (uint8_t *)nest);
+}
+
+/*
+ *  stress_busypoll_veth_create()
+ *	create a veth pair with the server end in the network namespace
+ *	of process server_pid, returns 0 on success or -errno
+ */
+static int stress_busypoll_veth_create(const pid_t server_pid)
+{
+	struct {
+		struct nlmsghdr nh;
+		struct ifinfomsg ifi;
+		uint8_t attrs[512];
+	} req;
+	struct {
+		struct nlmsghdr nh;
+		struct nlmsgerr err;
+		uint8_t pad[256];
+	} resp;
+	struct sockaddr_nl sa;
+	struct rtattr *linkinfo, *data, *peer;
+	struct ifinfomsg *peer_ifi;
+	const uint32_t pid = (uint32_t)server_pid;
+	const size_t max_len = sizeof(req);
+	int fd, ret = 0;
+	ssize_t n;
+
+	(void)shim_memset(&req, 0, sizeof(req));
+	req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(req.ifi));
+	req.nh.nlmsg_type = RTM_NEWLINK;
+	req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_CREATE | NLM_F_EXCL | NLM_F_ACK;
+	req.nh.nlmsg_seq = 1;
+	req.ifi.ifi_family = AF_UNSPEC;
+
+	if (!stress_busypoll_rta_add(&req.nh, max_len, IFLA_IFNAME,
+			BUSYPOLL_VETH_CLIENT, sizeof(BUSYPOLL_VETH_CLIENT)))
+		return -ENOSPC;
+	linkinfo = stress_busypoll_rta_add(&req.nh, max_len, IFLA_LINKINFO, NULL, 0);
+	if (!linkinfo ||
+	    !stress_busypoll_rta_add(&req.nh, max_len, IFLA_INFO_KIND, "veth", sizeof("veth")))
+		return -ENOSPC;
+	data = stress_busypoll_rta_add(&req.nh, max_len, IFLA_INFO_DATA, NULL, 0);
+	if (!data)
+		return -ENOSPC;
+	/* the peer attribute is an ifinfomsg followed by the peer's attributes */
+	peer = stress_busypoll_rta_add(&req.nh, max_len, VETH_INFO_PEER_ATTR, NULL, sizeof(*peer_ifi));
+	if (!peer)
+		return -ENOSPC;
+	peer_ifi = (struct ifinfomsg *)RTA_DATA(peer);
+	peer_ifi->ifi_family = AF_UNSPEC;
+	if (!stress_busypoll_rta_add(&req.nh, max_len, IFLA_IFNAME,
+			BUSYPOLL_VETH_SERVER, sizeof(BUSYPOLL_VETH_SERVER)) ||
+	    !stress_busypoll_rta_add(&req.nh, max_len, IFLA_NET_NS_PID, &pid, sizeof(pid)))
+		return -ENOSPC;
+	stress_busypoll_rta_nest_end(&req.nh, peer);
+	stress_busypoll_rta_nest_end(&req.nh, data);
+	stress_busypoll_rta_nest_end(&req.nh, linkinfo);
+
+	fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+	if (fd < 0)
+		return -errno;
+	(void)shim_memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+	if (sendto(fd, &req, req.nh.nlmsg_len, 0, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+		ret = -errno;
+		goto close_fd;
+	}
+	n = recv(fd, &resp, sizeof(resp), 0);
+	if (n < 0) {
+		ret = -errno;
+		goto close_fd;
+	}
+	if ((n >= (ssize_t)NLMSG_LENGTH(sizeof(resp.err))) &&
+	    (resp.nh.nlmsg_type == NLMSG_ERROR))
+		ret = resp.err.error;	/* zero or -errno */
+close_fd:
+	(void)close(fd);
+	return ret;
+}
+
+/*
+ *  stress_busypoll_if_up()
+ *	optionally set an IPv4 /24 address, enable GRO (which gives veth
+ *	a NAPI context that can be busy polled) and bring an interface up
+ */
+static int stress_busypoll_if_up(const char *name, const uint32_t ip)
+{
+	struct ifreq ifr;
+	struct sockaddr_in *sin;
+	int fd, ret = -1;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		return -1;
+	(void)shim_memset(&ifr, 0, sizeof(ifr));
+	(void)shim_strscpy(ifr.ifr_name, name, sizeof(ifr.ifr_name));
+	if (ip) {
+		sin = (struct sockaddr_in *)&ifr.ifr_addr;
+		sin->sin_family = AF_INET;
+		sin->sin_addr.s_addr = htonl(ip);
+		if (ioctl(fd, SIOCSIFADDR, &ifr) < 0)
+			goto close_fd;
+		sin = (struct sockaddr_in *)&ifr.ifr_netmask;
+		sin->sin_family = AF_INET;
+		sin->sin_addr.s_addr = htonl(0xffffff00);
+		if (ioctl(fd, SIOCSIFNETMASK, &ifr) < 0)
+			goto close_fd;
+	}
+#if defined(HAVE_LINUX_ETHTOOL_H) &&	\
+    defined(SIOCETHTOOL) &&		\
+    defined(ETHTOOL_SGRO)
+	if (ip) {
+		struct ethtool_value ev;
+
+		ev.cmd = ETHTOOL_SGRO;
+		ev.data = 1;
+		ifr.ifr_data = (void *)&ev;
+		VOID_RET(int, ioctl(fd, SIOCETHTOOL, &ifr));
+	}
+#endif
+	if (ioctl(fd, SIOCGIFFLAGS, &ifr) < 0)
+		goto close_fd;
+	ifr.ifr_flags |= IFF_UP;
+	if (ioctl(fd, SIOCSIFFLAGS, &ifr) < 0)
+		goto close_fd;
+	ret = 0;
+close_fd:
+	(void)close(fd);
+	return ret;
+}
+#endif
+
+/*
+ *  stress_busypoll_server()
+ *	echo datagrams back to the client with the same wait method as the
+ *	client, one configuration at a time as requested on ctrl_fd
+ */
+static int stress_busypoll_server(
+	stress_busypoll_config_t *configs,
+	const stress_busypoll_transport_t transport,
+	const int ctrl_fd,
+	const int port,
+	const int usec)
+{
+	uint32_t idx;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+#if defined(HAVE_BUSYPOLL_VETH)
+	if (transport == BUSYPOLL_TRANSPORT_VETH) {
+		uint8_t ready = 1;
+
+		/* a network namespace of our own to be the far end of the veth */
+		if (unshare(CLONE_NEWNET) < 0)
+			ready = 0;
+		if (write(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready))
+			return EXIT_FAILURE;
+		if ((read(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready)) || !ready)
+			return EXIT_SUCCESS;
+		if (stress_busypoll_if_up(BUSYPOLL_VETH_SERVER, BUSYPOLL_VETH_NET + 2) < 0)
+			ready = 0;
+		if (write(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready))
+			return EXIT_FAILURE;
+		if (!ready)
+			return EXIT_SUCCESS;
+	}
+#endif
+
+	while (read(ctrl_fd, &idx, sizeof(idx)) == (ssize_t)sizeof(idx)) {
+		stress_busypoll_config_t *cfg = &configs[idx];
+		stress_busypoll_sock_t s;
+		struct sockaddr_in addr;
+		double cpu;
+		uint8_t ack = 1;
+
+		stress_busypoll_set_addr(&addr, transport, true, port);
+		if (stress_busypoll_sock_open(&s, cfg->method, &addr, usec) < 0)
+			ack = 0;
+		if (write(ctrl_fd, &ack, sizeof(ack)) != (ssize_t)sizeof(ack))
+			break;
+		if (!ack)
+			continue;
+
+		cpu = stress_time_cpu_self();
+		while (stress_continue_flag()) {
+			uint8_t buf[BUSYPOLL_MSG_SIZE];
+			struct sockaddr_in from;
+			const ssize_t n = stress_busypoll_recv(&s, buf, sizeof(buf), &from);
+
+			if (n < 0)
+				continue;
+			VOID_RET(ssize_t, sendto(s.fd, buf, (size_t)n, 0,
+				(struct sockaddr *)&from, sizeof(from)));
+			if (n == BUSYPOLL_END_SIZE)
+				break;
+		}
+		cfg->cpu_server += stress_time_cpu_self() - cpu;
+#if defined(SO_INCOMING_NAPI_ID)
+		{
+			unsigned int napi_id = 0;
+			socklen_t len = sizeof(napi_id);
+
+			if ((getsockopt(s.fd, SOL_SOCKET, SO_INCOMING_NAPI_ID, &napi_id, &len) == 0) &&
+			    (napi_id != 0))
+				cfg->napi = true;
+		}
+#endif
+		stress_busypoll_sock_close(&s);
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_busypoll_client()
+ *	ping-pong datagrams with the server for a time slice
+ */
+static void stress_busypoll_client(
+	stress_args_t *args,
+	stress_busypoll_config_t *cfg,
+	const int port,
+	const int usec)
+{
+	stress_busypoll_sock_t s;
+	struct sockaddr_in addr, from;
+	uint8_t buf[BUSYPOLL_MSG_SIZE];
+	double t_start, t_end, cpu;
+	uint64_t round_trips = 0;
+	int i;
+
+	if (stress_busypoll_sock_open(&s, cfg->method, NULL, usec) < 0) {
+		cfg->unsupported = true;
+		return;
+	}
+	stress_busypoll_set_addr(&addr, cfg->transport, true, port);
+	if (connect(s.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		cfg->unsupported = true;
+		stress_busypoll_sock_close(&s);
+		return;
+	}
+	(void)shim_memset(buf, 0xa5, sizeof(buf));
+
+	cpu = stress_time_cpu_self();
+	t_start = stress_time_now();
+	t_end = t_start + BUSYPOLL_SLICE;
+	do {
+		const double t = stress_time_now();
+
+		if (send(s.fd, buf, sizeof(buf), 0) < 0)
+			continue;
+		/* a timeout is a lost datagram, send another one */
+		if (stress_busypoll_recv(&s, buf, sizeof(buf), &from) != (ssize_t)sizeof(buf))
+			continue;
+		cfg->samples[cfg->index % BUSYPOLL_MAX_SAMPLES] = stress_time_now() - t;
+		cfg->index++;
+		round_trips++;
+	} while (stress_continue_flag() && (stress_time_now() < t_end));
+	cfg->duration += stress_time_now() - t_start;
+	cfg->cpu_client += stress_time_cpu_self() - cpu;
+	cfg->round_trips += round_trips;
+	stress_bogo_add(args, round_trips);
+
+	/* tell the server this configuration has finished */
+	for (i = 0; i < 10; i++) {
+		const uint8_t end = 0;
+
+		if (send(s.fd, &end, sizeof(end), 0) < 0)
+			break;
+		if (stress_busypoll_recv(&s, buf, sizeof(buf), &from) == BUSYPOLL_END_SIZE)
+			break;
+	}
+	stress_busypoll_sock_close(&s);
+}
+
+/*
+ *  stress_busypoll_metrics()
+ *	report round trip percentiles and CPU cost per round trip
+ */
+static void stress_busypoll_metrics(
+	stress_args_t *args,
+	stress_busypoll_config_t *configs,
+	const size_t n_configs)
+{
+	bool napi_warned[BUSYPOLL_TRANSPORT_MAX];
+	size_t i, idx = 0;
+
+	(void)shim_memset(napi_warned, 0, sizeof(napi_warned));
+	for (i = 0; i < n_configs; i++) {
+		stress_busypoll_config_t *cfg = &configs[i];
+		const size_t n = (size_t)STRESS_MINIMUM(cfg->index, BUSYPOLL_MAX_SAMPLES);
+		const char *transport = stress_busypoll_transports[cfg->transport];
+		const char *method = stress_busypoll_method_name(cfg->method);
+		char msg[64];
+
+		if (cfg->unsupported || (n == 0))
+			continue;
+		if ((cfg->method != BUSYPOLL_METHOD_INTERRUPT) &&
+		    (cfg->method != BUSYPOLL_METHOD_SPIN) &&
+		    !cfg->napi && !napi_warned[cfg->transport] &&
+		    stress_instance_zero(args)) {
+			pr_inf("%s: %s sockets have no NAPI ID, kernel busy polling has no effect on them\n",
+				args->name, transport);
+			napi_warned[cfg->transport] = true;
+		}
+		stress_percentile_sort(cfg->samples, n);
+
+		(void)snprintf(msg, sizeof(msg), "usec p50 round trip %s %s", transport, method);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(cfg->samples, n, 50.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99 round trip %s %s", transport, method);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(cfg->samples, n, 99.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99.9 round trip %s %s", transport, method);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(cfg->samples, n, 99.9),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "CPU usec per round trip %s %s", transport, method);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * (cfg->cpu_client + cfg->cpu_server) / (double)cfg->round_trips,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_busypoll_veth_setup()
+ *	move into a private network namespace with loopback up and
+ *	create a veth pair to the server's private network namespace,
+ *	returns true if the veth can be used
+ */
+static bool stress_busypoll_veth_setup(
+	stress_args_t *args,
+	const pid_t server_pid,
+	const int ctrl_fd)
+{
+#if defined(HAVE_BUSYPOLL_VETH)
+	uint8_t ready = 0;
+	int ret;
+
+	if ((read(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready)) || !ready)
+		return false;
+	ret = stress_busypoll_veth_create(server_pid);
+	if (ret < 0) {
+		if (stress_instance_zero(args))
+			pr_inf("%s: cannot create veth pair, errno=%d (%s), using loopback only\n",
+				args->name, -ret, strerror(-ret));
+		ready = 0;
+	} else if (stress_busypoll_if_up(BUSYPOLL_VETH_CLIENT, BUSYPOLL_VETH_NET + 1) < 0) {
+		ready = 0;
+	} else {
+		ready = 1;
+	}
+	if (write(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready))
+		return false;
+	if (!ready)
+		return false;
+	/* server has configured its end of the veth */
+	if ((read(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready)) || !ready)
+		return false;
+	return true;
+#else
+	(void)args;
+	(void)server_pid;
+	(void)ctrl_fd;
+
+	return false;
+#endif
+}
+
+/*
+ *  stress_busypoll
+ *	compare interrupt driven, busy polling and spinning datagram
+ *	ping-pong latency and CPU cost over loopback and veth
+ */
+static int stress_busypoll(stress_args_t *args)
+{
+	int busypoll_port = DEFAULT_BUSYPOLL_PORT, reserved_port;
+	uint32_t busypoll_usec = DEFAULT_BUSYPOLL_USEC;
+	size_t busypoll_method = 0;
+	size_t i, j, n_configs = 0, configs_size;
+	stress_busypoll_config_t *configs;
+	stress_busypoll_method_t method;
+	int ctrl[BUSYPOLL_TRANSPORT_MAX][2];
+	pid_t pids[BUSYPOLL_TRANSPORT_MAX];
+	bool transports[BUSYPOLL_TRANSPORT_MAX];
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("busypoll-method", &busypoll_method);
+	(void)stress_get_setting("busypoll-port", &busypoll_port);
+	(void)stress_get_setting("busypoll-usec", &busypoll_usec);
+	method = stress_busypoll_methods[busypoll_method].method;
+
+	busypoll_port += args->instance;
+	if (busypoll_port > MAX_PORT)
+		busypoll_port -= (MAX_PORT - MIN_PORT + 1);
+	reserved_port = stress_net_reserve_ports(busypoll_port, busypoll_port);
+	if (reserved_port < 0) {
+		pr_inf_skip("%s: cannot reserve port %d, skipping stressor\n",
+			args->name, busypoll_port);
+		return EXIT_NO_RESOURCE;
+	}
+	busypoll_port = reserved_port;
+
+	configs_size = BUSYPOLL_MAX_CONFIGS * sizeof(*configs);
+	configs = (stress_busypoll_config_t *)stress_mmap_populate(NULL, configs_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (configs == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for results%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, configs_size,
+			stress_get_memfree_str(), errno, strerror(errno));
+		stress_net_release_ports(busypoll_port, busypoll_port);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(configs, configs_size, "busypoll-results");
+
+	/*
+	 *  the veth pair lives in private network namespaces so that
+	 *  the host's interfaces and routes are never modified
+	 */
+	transports[BUSYPOLL_TRANSPORT_LOOPBACK] = true;
+	transports[BUSYPOLL_TRANSPORT_VETH] = false;
+#if defined(HAVE_BUSYPOLL_VETH)
+	if (stress_check_capability(SHIM_CAP_NET_ADMIN) &&
+	    stress_check_capability(SHIM_CAP_SYS_ADMIN) &&
+	    (unshare(CLONE_NEWNET) == 0)) {
+		if (stress_busypoll_if_up("lo", 0) == 0)
+			transports[BUSYPOLL_TRANSPORT_VETH] = true;
+	} else if (stress_instance_zero(args)) {
+		pr_inf("%s: veth needs CAP_NET_ADMIN and CAP_SYS_ADMIN, using loopback only\n",
+			args->name);
+	}
+#endif
+
+	for (i = 0; i < BUSYPOLL_TRANSPORT_MAX; i++) {
+		pids[i] = -1;
+		ctrl[i][0] = -1;
+		ctrl[i][1] = -1;
+	}
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	for (i = 0; i < BUSYPOLL_TRANSPORT_MAX; i++) {
+		const stress_busypoll_transport_t transport = (stress_busypoll_transport_t)i;
+
+		if (!transports[i])
+			continue;
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctrl[i]) < 0) {
+			transports[i] = false;
+			continue;
+		}
+again:
+		pids[i] = fork();
+		if (pids[i] < 0) {
+			if (stress_redo_fork(args, errno))
+				goto again;
+			transports[i] = false;
+			continue;
+		} else if (pids[i] == 0) {
+			(void)close(ctrl[i][1]);
+			_exit(stress_busypoll_server(configs, transport, ctrl[i][0],
+				busypoll_port, (int)busypoll_usec));
+		}
+		(void)close(ctrl[i][0]);
+		ctrl[i][0] = -1;
+		if ((transport == BUSYPOLL_TRANSPORT_VETH) &&
+		    !stress_busypoll_veth_setup(args, pids[i], ctrl[i][1]))
+			transports[i] = false;
+	}
+
+	for (i = 0; i < BUSYPOLL_TRANSPORT_MAX; i++) {
+		if (!transports[i])
+			continue;
+		for (j = 0; j < SIZEOF_ARRAY(stress_busypoll_methods); j++) {
+			const stress_busypoll_method_t m = stress_busypoll_methods[j].method;
+
+			if ((m == BUSYPOLL_METHOD_ALL) || ((method != BUSYPOLL_METHOD_ALL) && (method != m)))
+				continue;
+			configs[n_configs].transport = (stress_busypoll_transport_t)i;
+			configs[n_configs].method = m;
+			n_configs++;
+		}
+	}
+	if (n_configs == 0) {
+		pr_inf_skip("%s: no transports could be setup, skipping stressor\n", args->name);
+		rc = EXIT_NO_RESOURCE;
+		goto reap;
+	}
+
+	i = 0;
+	do {
+		stress_busypoll_config_t *cfg = &configs[i];
+		const int fd = ctrl[cfg->transport][1];
+		const uint32_t idx = (uint32_t)i;
+		uint8_t ack;
+
+		if (!cfg->unsupported) {
+			if (write(fd, &idx, sizeof(idx)) != (ssize_t)sizeof(idx))
+				break;
+			if (read(fd, &ack, sizeof(ack)) != (ssize_t)sizeof(ack))
+				break;
+			if (ack) {
+				stress_busypoll_client(args, cfg, busypoll_port, (int)busypoll_usec);
+			} else {
+				if (stress_instance_zero(args))
+					pr_inf("%s: cannot use %s on %s, skipping it\n",
+						args->name, stress_busypoll_method_name(cfg->method),
+						stress_busypoll_transports[cfg->transport]);
+				cfg->unsupported = true;
+			}
+		}
+		i = (i + 1) % n_configs;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	stress_busypoll_metrics(args, configs, n_configs);
+reap:
+	for (i = 0; i < BUSYPOLL_TRANSPORT_MAX; i++) {
+		if (ctrl[i][1] >= 0)
+			(void)close(ctrl[i][1]);
+		if (pids[i] > 0)
+			(void)stress_kill_pid_wait(pids[i], NULL);
+	}
+	(void)munmap((void *)configs, configs_size);
+	stress_net_release_ports(busypoll_port, busypoll_port);
+
+	return rc;
+}
+
+const stressor_info_t stress_busypoll_info = {
+	.stressor = stress_busypoll,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_busypoll_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without sys/epoll.h, AF_INET or SO_BUSY_POLL support"
+};
+#endif
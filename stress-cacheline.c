@@ -20,6 +20,7 @@
 #include "core-affinity.h"
 #include "core-builtin.h"
 #include "core-cpu-cache.h"
+#include "core-cpu-relax.h"
 #include "core-killpid.h"
 #include "core-lock.h"
 #include "core-pragma.h"
@@ -47,6 +48,8 @@ do {				\
 static const stress_help_t help[] = {
 	{ NULL,	"cacheline N",		"start N workers that exercise cachelines" },
 	{ NULL,	"cacheline-affinity",	"modify CPU affinity" },
+	{ NULL,	"cacheline-matrix",	"measure the cache line ping-pong latency between all CPU pairs" },
+	{ NULL,	"cacheline-matrix-cas",	"use compare and swap rather than stores for the latency matrix" },
 	{ NULL,	"cacheline-method M",	"use cacheline stressing method M" },
 	{ NULL,	"cacheline-ops N",	"stop after N cacheline bogo operations" },
 	{ NULL,	NULL,			NULL }
@@ -658,6 +661,357 @@ static int stress_cacheline_child(
 	return rc;
 }
 
+#if defined(HAVE_SCHED_GETAFFINITY) &&		\
+    defined(HAVE_SCHED_SETAFFINITY) &&		\
+    defined(HAVE_ATOMIC_COMPARE_EXCHANGE) &&	\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+#define HAVE_CACHELINE_MATRIX
+
+#define CACHELINE_MATRIX_BATCHES	(16)	/* batches per CPU pair, fastest is used */
+#define CACHELINE_MATRIX_ROUNDS		(64)	/* round trips per batch */
+#define CACHELINE_MATRIX_STOP		(~0ULL)	/* end of ping-pong for a CPU pair */
+
+/*
+ *  state shared between the parent and child, the ping-pong line
+ *  is kept away from the control fields
+ */
+typedef struct {
+	uint64_t line ALIGN64;		/* odd: child's turn, even: parent's turn */
+	uint64_t cmd ALIGN64;		/* CPU pair sequence number */
+	uint64_t ack;			/* child has pinned itself for cmd */
+	uint64_t done;			/* child has finished with cmd */
+	uint32_t cpu;			/* CPU for the child to pin itself to */
+	bool quit;			/* child should exit */
+} stress_cacheline_matrix_t;
+
+/*
+ *  stress_cacheline_matrix_relax()
+ *	spin wait hint, yield every so often in case both ends share
+ *	a CPU, returns false if the stressor should stop
+ */
+static inline bool stress_cacheline_matrix_relax(uint32_t *spins)
+{
+	if (stress_cpu_relax_yield(spins))
+		return stress_continue_flag();
+	return true;
+}
+
+static inline void stress_cacheline_matrix_pin(const uint32_t cpu)
+{
+	cpu_set_t mask;
+
+	CPU_ZERO(&mask);
+	CPU_SET((int)cpu, &mask);
+	VOID_RET(int, sched_setaffinity(0, sizeof(mask), &mask));
+}
+
+/*
+ *  stress_cacheline_matrix_child()
+ *	pin to the requested CPU and bounce the line back to the parent
+ *	by incrementing odd values until the parent stops the pair
+ */
+static void stress_cacheline_matrix_child(
+	stress_cacheline_matrix_t *matrix,
+	const bool matrix_cas)
+{
+	uint64_t seq = 0;
+	uint32_t spins = 0;
+
+	for (;;) {
+		uint64_t cmd;
+
+		while ((cmd = __atomic_load_n(&matrix->cmd, __ATOMIC_ACQUIRE)) == seq) {
+			if (__atomic_load_n(&matrix->quit, __ATOMIC_ACQUIRE) ||
+			    !stress_continue_flag())
+				return;
+			(void)shim_sched_yield();
+		}
+		seq = cmd;
+		stress_cacheline_matrix_pin(matrix->cpu);
+		__atomic_store_n(&matrix->ack, seq, __ATOMIC_RELEASE);
+
+		for (;;) {
+			uint64_t val = __atomic_load_n(&matrix->line, __ATOMIC_ACQUIRE);
+
+			if (val == CACHELINE_MATRIX_STOP) {
+				__atomic_store_n(&matrix->done, seq, __ATOMIC_RELEASE);
+				break;
+			}
+			if (val & 1) {
+				if (matrix_cas)
+					(void)__atomic_compare_exchange_n(&matrix->line, &val, val + 1,
+						false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+				else
+					__atomic_store_n(&matrix->line, val + 1, __ATOMIC_RELEASE);
+			} else if (!stress_cacheline_matrix_relax(&spins)) {
+				return;
+			}
+		}
+	}
+}
+
+/*
+ *  stress_cacheline_matrix_pair()
+ *	measure the one way latency of handing a cache line from
+ *	CPU cpu_i to CPU cpu_j and back, returns -1 if interrupted
+ */
+static int stress_cacheline_matrix_pair(
+	stress_cacheline_matrix_t *matrix,
+	const uint32_t cpu_i,
+	const uint32_t cpu_j,
+	const bool matrix_cas,
+	uint64_t *seq,
+	double *latency)
+{
+	uint64_t val = 0;
+	uint32_t spins = 0;
+	double best = -1.0;
+	int i;
+
+	/* wait for the child to finish the previous pair */
+	while (__atomic_load_n(&matrix->done, __ATOMIC_ACQUIRE) != *seq) {
+		if (!stress_cacheline_matrix_relax(&spins))
+			return -1;
+	}
+
+	/* pin the child to cpu_j, then this process to cpu_i */
+	__atomic_store_n(&matrix->line, 0, __ATOMIC_RELAXED);
+	matrix->cpu = cpu_j;
+	(*seq)++;
+	__atomic_store_n(&matrix->cmd, *seq, __ATOMIC_RELEASE);
+	stress_cacheline_matrix_pin(cpu_i);
+	while (__atomic_load_n(&matrix->ack, __ATOMIC_ACQUIRE) != *seq) {
+		if (!stress_cacheline_matrix_relax(&spins))
+			return -1;
+	}
+
+	for (i = 0; i < CACHELINE_MATRIX_BATCHES; i++) {
+		double t;
+		int j;
+
+		t = stress_time_now();
+		for (j = 0; j < CACHELINE_MATRIX_ROUNDS; j++) {
+			if (matrix_cas) {
+				uint64_t expected = val;
+
+				while (!__atomic_compare_exchange_n(&matrix->line, &expected, val + 1,
+						false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+					expected = val;
+					if (!stress_cacheline_matrix_relax(&spins))
+						goto stop;
+				}
+			} else {
+				__atomic_store_n(&matrix->line, val + 1, __ATOMIC_RELEASE);
+			}
+			val += 2;
+			while (__atomic_load_n(&matrix->line, __ATOMIC_ACQUIRE) != val) {
+				if (!stress_cacheline_matrix_relax(&spins))
+					goto stop;
+			}
+		}
+		t = stress_time_now() - t;
+		if ((best < 0.0) || (t < best))
+			best = t;
+	}
+	__atomic_store_n(&matrix->line, CACHELINE_MATRIX_STOP, __ATOMIC_RELEASE);
+	*latency = best / (double)(CACHELINE_MATRIX_ROUNDS * 2);
+	return 0;
+
+stop:
+	__atomic_store_n(&matrix->line, CACHELINE_MATRIX_STOP, __ATOMIC_RELEASE);
+	return -1;
+}
+
+/*
+ *  stress_cacheline_matrix_report()
+ *	dump the NxN one way latency matrix in nanoseconds and report
+ *	the mean latency of each CPU topology relationship
+ */
+static void stress_cacheline_matrix_report(
+	stress_args_t *args,
+	const uint32_t n_cpus,
+	const stress_cpu_topology_t *topology,
+	const double *latencies)
+{
+	double sum[STRESS_CPU_REL_MAX];
+	uint64_t count[STRESS_CPU_REL_MAX];
+	uint64_t measured = 0;
+	const size_t buf_len = ((size_t)n_cpus + 1) * 8;
+	char *buf;
+	uint32_t i, j;
+	size_t idx = 0;
+	int r;
+
+	(void)shim_memset(sum, 0, sizeof(sum));
+	(void)shim_memset(count, 0, sizeof(count));
+	for (i = 0; i < n_cpus; i++) {
+		for (j = 0; j < n_cpus; j++) {
+			const double latency = latencies[(i * n_cpus) + j];
+
+			if (latency > 0.0) {
+				const stress_cpu_topology_rel_t rel =
+					stress_cpu_topology_rel(&topology[i], &topology[j]);
+
+				sum[rel] += latency;
+				count[rel]++;
+				measured++;
+			}
+		}
+	}
+
+	if (stress_instance_zero(args)) {
+		if (measured < (uint64_t)n_cpus * (n_cpus - 1))
+			pr_inf("%s: only measured %" PRIu64 " of %" PRIu64 " CPU pairs, "
+				"use a longer run time to measure all pairs\n", args->name,
+				measured, (uint64_t)n_cpus * (n_cpus - 1));
+
+		buf = (char *)malloc(buf_len);
+		if (buf) {
+			size_t len;
+
+			len = (size_t)snprintf(buf, buf_len, "%8s", "CPU");
+			for (j = 0; (j < n_cpus) && (len < buf_len); j++)
+				len += (size_t)snprintf(buf + len, buf_len - len, " %6" PRIu32, topology[j].cpu);
+			pr_inf("%s: cache line one way latency (ns)\n", args->name);
+			pr_inf("%s: %s\n", args->name, buf);
+			for (i = 0; i < n_cpus; i++) {
+				len = (size_t)snprintf(buf, buf_len, "%8" PRIu32, topology[i].cpu);
+				for (j = 0; (j < n_cpus) && (len < buf_len); j++) {
+					const double latency = latencies[(i * n_cpus) + j];
+
+					if (latency > 0.0)
+						len += (size_t)snprintf(buf + len, buf_len - len, " %6.1f",
+							latency * STRESS_DBL_NANOSECOND);
+					else
+						len += (size_t)snprintf(buf + len, buf_len - len, " %6s", "-");
+				}
+				pr_inf("%s: %s\n", args->name, buf);
+			}
+			free(buf);
+		}
+	}
+
+	for (r = STRESS_CPU_REL_SMT; r < STRESS_CPU_REL_MAX; r++) {
+		char msg[64];
+
+		if (count[r] == 0)
+			continue;
+		(void)snprintf(msg, sizeof(msg), "nanosec one way latency, %s",
+			stress_cpu_topology_rel_name((stress_cpu_topology_rel_t)r));
+		stress_metrics_set(args, idx++, msg,
+			(sum[r] / (double)count[r]) * STRESS_DBL_NANOSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_cacheline_matrix()
+ *	pin a parent and child process to every pair of CPUs in turn and
+ *	bounce a cache line between them to build a core to core latency map
+ */
+static int stress_cacheline_matrix(stress_args_t *args, const bool matrix_cas)
+{
+	uint32_t *cpus, n_cpus, i, j;
+	stress_cpu_topology_t *topology;
+	stress_cacheline_matrix_t *matrix;
+	double *latencies;
+	uint64_t seq = 0;
+	pid_t pid;
+	int rc = EXIT_SUCCESS;
+
+	n_cpus = stress_get_usable_cpus(&cpus, true);
+	if (n_cpus < 2) {
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: cache line latency matrix requires at least 2 usable CPUs, "
+				"skipping stressor\n", args->name);
+		stress_free_usable_cpus(&cpus);
+		return EXIT_NO_RESOURCE;
+	}
+	topology = (stress_cpu_topology_t *)calloc(n_cpus, sizeof(*topology));
+	latencies = (double *)calloc((size_t)n_cpus * n_cpus, sizeof(*latencies));
+	if (!topology || !latencies) {
+		pr_inf_skip("%s: cannot allocate %" PRIu32 "x%" PRIu32 " latency matrix%s, "
+			"skipping stressor\n", args->name, n_cpus, n_cpus,
+			stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_cpus;
+	}
+	for (i = 0; i < n_cpus; i++)
+		stress_cpu_topology_get(cpus[i], &topology[i]);
+
+	matrix = (stress_cacheline_matrix_t *)stress_mmap_populate(NULL, sizeof(*matrix),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (matrix == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes%s, skipping stressor\n",
+			args->name, sizeof(*matrix), stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_cpus;
+	}
+	stress_set_vma_anon_name(matrix, sizeof(*matrix), "cacheline-matrix");
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: measuring %" PRIu32 " CPU pairs using %s\n", args->name,
+			n_cpus * (n_cpus - 1), matrix_cas ? "compare and swap" : "load and store");
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+again:
+	pid = fork();
+	if (pid < 0) {
+		if (stress_redo_fork(args, errno))
+			goto again;
+		if (UNLIKELY(!stress_continue(args)))
+			goto finish;
+		pr_err("%s: fork failed, errno=%d: (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto finish;
+	} else if (pid == 0) {
+		stress_cacheline_matrix_child(matrix, matrix_cas);
+		_exit(EXIT_SUCCESS);
+	}
+
+	i = 0;
+	j = 1;
+	do {
+		double latency;
+		double *cell = &latencies[(i * n_cpus) + j];
+
+		if (stress_cacheline_matrix_pair(matrix, cpus[i], cpus[j],
+				matrix_cas, &seq, &latency) < 0)
+			break;
+		if ((*cell <= 0.0) || (latency < *cell))
+			*cell = latency;
+		stress_bogo_inc(args);
+
+		/* next off diagonal pair */
+		j++;
+		if (j == i)
+			j++;
+		if (j >= n_cpus) {
+			i = (i + 1) % n_cpus;
+			j = (i == 0) ? 1 : 0;
+		}
+	} while (stress_continue(args));
+
+	__atomic_store_n(&matrix->quit, true, __ATOMIC_RELEASE);
+	if (stress_kill_and_wait(args, pid, SIGALRM, false) != EXIT_SUCCESS)
+		rc = EXIT_FAILURE;
+
+	stress_cacheline_matrix_report(args, n_cpus, topology, latencies);
+finish:
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	(void)munmap((void *)matrix, sizeof(*matrix));
+free_cpus:
+	free(latencies);
+	free(topology);
+	stress_free_usable_cpus(&cpus);
+	return rc;
+}
+#endif
+
 /*
  *  stress_cacheline_init()
  *	called once by stress-ng, so we can set idx to 0
@@ -712,10 +1066,25 @@ static int stress_cacheline(stress_args_t *args)
 	size_t cacheline_method = 0;
 	stress_cacheline_func func;
 	bool cacheline_affinity = false;
+	bool cacheline_matrix = false;
+	bool cacheline_matrix_cas = false;
 
 	if (stress_sigchld_set_handler(args) < 0)
 		return EXIT_NO_RESOURCE;
 
+	(void)stress_get_setting("cacheline-matrix", &cacheline_matrix);
+	(void)stress_get_setting("cacheline-matrix-cas", &cacheline_matrix_cas);
+	if (cacheline_matrix || cacheline_matrix_cas) {
+#if defined(HAVE_CACHELINE_MATRIX)
+		return stress_cacheline_matrix(args, cacheline_matrix_cas);
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: cache line latency matrix requires CPU affinity and "
+				"atomic compare and swap support, skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+#endif
+	}
+
 	if (!g_shared->cacheline.lock) {
 		pr_inf("%s: failed to initialized cacheline lock, skipping stressor\n", args->name);
 		return EXIT_NO_RESOURCE;
@@ -772,6 +1141,8 @@ finish:
 
 static const stress_opt_t opts[] = {
 	{ OPT_cacheline_affinity, "cacheline-affinity", TYPE_ID_BOOL, 0, 1, NULL },
+	{ OPT_cacheline_matrix,   "cacheline-matrix",   TYPE_ID_BOOL, 0, 1, NULL },
+	{ OPT_cacheline_matrix_cas, "cacheline-matrix-cas", TYPE_ID_BOOL, 0, 1, NULL },
 	{ OPT_cacheline_method,   "cacheline-method",   TYPE_ID_SIZE_T_METHOD, 0, 0, stress_cacheline_method },
 	END_OPT,
 };
@@ -0,0 +1,606 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-killpid.h"
+#include "core-net.h"
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#if defined(HAVE_NETINET_TCP_H)
+#include <netinet/tcp.h>
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#endif
+
+#define DEFAULT_CHURN_PORT	(21000)
+
+#define MIN_CHURN_CLIENTS	(1)
+#define MAX_CHURN_CLIENTS	(256)
+#define DEFAULT_CHURN_CLIENTS	(4)
+
+#define MIN_CHURN_PORTS		(1)
+#define MAX_CHURN_PORTS		(1024)
+#define DEFAULT_CHURN_PORTS	(16)
+
+#define MIN_CHURN_RATE		(0)
+#define MAX_CHURN_RATE		(10000000)
+#define DEFAULT_CHURN_RATE	(0)	/* as fast as possible */
+
+#define CHURN_MAX_SAMPLES	(8192)	/* connect latency samples per client */
+#define CHURN_TW_SAMPLE		(0.25)	/* seconds between TIME_WAIT samples */
+#define CHURN_IO_TIMEOUT_USEC	(1000000)
+#define CHURN_MAX_EVENTS	(64)
+
+#define CHURN_CLOSE_SERVER	(0)
+#define CHURN_CLOSE_CLIENT	(1)
+
+/* epoll data tags, the fd is in the low 32 bits */
+#define CHURN_TAG_LISTEN	(1ULL << 32)
+#define CHURN_TAG_REQUEST	(2ULL << 32)
+#define CHURN_TAG_CLOSE		(3ULL << 32)
+#define CHURN_TAG_MASK		(0xffffffffULL << 32)
+
+static const char churn_request[] = "GET / HTTP/1.0\r\n\r\n";
+static const char churn_response[] = "HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+static const stress_help_t help[] = {
+	{ NULL,	"churn N",		"start N workers opening and closing short lived connections" },
+	{ NULL,	"churn-clients N",	"number of connecting client processes per worker" },
+	{ NULL,	"churn-close S",	"side that closes first: server or client" },
+	{ NULL,	"churn-ops N",		"stop after N connections" },
+	{ NULL,	"churn-port P",		"use listening ports starting at port P" },
+	{ NULL,	"churn-ports N",	"number of listening ports per worker" },
+	{ NULL,	"churn-rate R",		"target rate of R connections per second per worker, 0 = maximum" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef struct {
+	const char *name;
+	const int close;
+} stress_churn_close_t;
+
+static const stress_churn_close_t stress_churn_closes[] = {
+	{ "server",	CHURN_CLOSE_SERVER },
+	{ "client",	CHURN_CLOSE_CLIENT },
+};
+
+static const char *stress_churn_close(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_churn_closes)) ? stress_churn_closes[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_churn_clients,	"churn-clients", TYPE_ID_UINT32, MIN_CHURN_CLIENTS, MAX_CHURN_CLIENTS, NULL },
+	{ OPT_churn_close,	"churn-close",   TYPE_ID_SIZE_T_METHOD, 0, 0, stress_churn_close },
+	{ OPT_churn_port,	"churn-port",    TYPE_ID_INT_PORT, MIN_PORT, MAX_PORT, NULL },
+	{ OPT_churn_ports,	"churn-ports",   TYPE_ID_UINT32, MIN_CHURN_PORTS, MAX_CHURN_PORTS, NULL },
+	{ OPT_churn_rate,	"churn-rate",    TYPE_ID_UINT32, MIN_CHURN_RATE, MAX_CHURN_RATE, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_SYS_EPOLL_H) &&	\
+    defined(AF_INET) &&			\
+    defined(SOCK_STREAM) &&		\
+    defined(SOCK_NONBLOCK) &&		\
+    defined(HAVE_ACCEPT4)
+
+/*
+ *  per client results, shared with the client processes
+ */
+typedef struct {
+	uint64_t conns;			/* completed connections */
+	uint64_t exhausted;		/* connects failed with EADDRNOTAVAIL */
+	uint64_t failed;		/* other connect or I/O failures */
+	uint64_t index;			/* next latency sample */
+	double samples[CHURN_MAX_SAMPLES];	/* connect latencies (seconds) */
+} stress_churn_client_t;
+
+/*
+ *  state shared between the parent, server and clients
+ */
+typedef struct {
+	bool stop;			/* clients and server stop when set */
+} stress_churn_shared_t;
+
+/*
+ *  stress_churn_set_addr()
+ *	loopback address of the given port
+ */
+static void stress_churn_set_addr(struct sockaddr_in *addr, const int port)
+{
+	(void)shim_memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr->sin_port = htons((uint16_t)port);
+}
+
+/*
+ *  stress_churn_time_wait()
+ *	number of TIME_WAIT TCP sockets from /proc/net/sockstat,
+ *	returns -1 if it cannot be read
+ */
+static int64_t stress_churn_time_wait(void)
+{
+	char buf[1024];
+	const char *ptr;
+	int64_t tw;
+
+	if (stress_system_read("/proc/net/sockstat", buf, sizeof(buf)) <= 0)
+		return -1;
+	ptr = strstr(buf, " tw ");
+	if (!ptr)
+		return -1;
+	if (sscanf(ptr + 4, "%" SCNd64, &tw) != 1)
+		return -1;
+	return tw;
+}
+
+/*
+ *  stress_churn_server()
+ *	accept connections on all the listeners, read each request,
+ *	reply and close first (HTTP/1.0 style) or wait for the client
+ *	to close first
+ */
+static int stress_churn_server(
+	stress_churn_shared_t *shared,
+	const int *lfds,
+	const uint32_t n_ports,
+	const int churn_close)
+{
+	struct epoll_event events[CHURN_MAX_EVENTS];
+	uint32_t i;
+	int efd;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	efd = epoll_create1(0);
+	if (efd < 0)
+		return EXIT_NO_RESOURCE;
+	for (i = 0; i < n_ports; i++) {
+		struct epoll_event ev;
+
+		(void)shim_memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.u64 = CHURN_TAG_LISTEN | (uint32_t)lfds[i];
+		if (epoll_ctl(efd, EPOLL_CTL_ADD, lfds[i], &ev) < 0) {
+			(void)close(efd);
+			return EXIT_NO_RESOURCE;
+		}
+	}
+
+	while (!shared->stop && stress_continue_flag()) {
+		int j, n;
+
+		n = epoll_wait(efd, events, CHURN_MAX_EVENTS, 100);
+		for (j = 0; j < n; j++) {
+			const uint64_t tag = events[j].data.u64 & CHURN_TAG_MASK;
+			const int fd = (int)(events[j].data.u64 & 0xffffffffULL);
+			char buf[256];
+			ssize_t ret;
+
+			if (tag == CHURN_TAG_LISTEN) {
+				/* drain the accept queue */
+				for (;;) {
+					struct epoll_event ev;
+					const int sfd = accept4(fd, NULL, NULL, SOCK_NONBLOCK);
+
+					if (sfd < 0)
+						break;
+					(void)shim_memset(&ev, 0, sizeof(ev));
+					ev.events = EPOLLIN;
+					ev.data.u64 = CHURN_TAG_REQUEST | (uint32_t)sfd;
+					if (epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &ev) < 0)
+						(void)close(sfd);
+				}
+				continue;
+			}
+
+			ret = recv(fd, buf, sizeof(buf), 0);
+			if ((ret < 0) && (errno == EAGAIN))
+				continue;
+			if ((tag == CHURN_TAG_REQUEST) && (ret > 0)) {
+				VOID_RET(ssize_t, send(fd, churn_response, sizeof(churn_response) - 1, MSG_NOSIGNAL));
+				if (churn_close == CHURN_CLOSE_CLIENT) {
+					struct epoll_event ev;
+
+					/* wait for the client to close first */
+					(void)shim_memset(&ev, 0, sizeof(ev));
+					ev.events = EPOLLIN;
+					ev.data.u64 = CHURN_TAG_CLOSE | (uint32_t)fd;
+					if (epoll_ctl(efd, EPOLL_CTL_MOD, fd, &ev) == 0)
+						continue;
+				}
+			}
+			/* close also removes the fd from the epoll set */
+			(void)close(fd);
+		}
+	}
+	(void)close(efd);
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_churn_client()
+ *	open a connection, send a request, read the response and close,
+ *	cycling over the listening ports, optionally at a target rate
+ */
+static int stress_churn_client(
+	stress_churn_shared_t *shared,
+	stress_churn_client_t *client,
+	const int port,
+	const uint32_t n_ports,
+	const uint32_t offset,
+	const double interval,
+	const int churn_close)
+{
+	struct timeval tv;
+	double t_next;
+	uint32_t p = offset;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	tv.tv_sec = CHURN_IO_TIMEOUT_USEC / 1000000;
+	tv.tv_usec = CHURN_IO_TIMEOUT_USEC % 1000000;
+	t_next = stress_time_now();
+
+	while (!shared->stop && stress_continue_flag()) {
+		struct sockaddr_in addr;
+		char buf[256];
+		double t_connect;
+		size_t got = 0;
+		int fd;
+
+		if (interval > 0.0) {
+			const double now = stress_time_now();
+
+			t_next += interval;
+			if (t_next > now)
+				(void)shim_nanosleep_uint64((uint64_t)((t_next - now) * STRESS_DBL_NANOSECOND));
+			else if (now - t_next > 1.0)
+				t_next = now;	/* too far behind, do not burst to catch up */
+		}
+
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0) {
+			client->failed++;
+			(void)shim_usleep(1000);
+			continue;
+		}
+		/* SO_SNDTIMEO also bounds a blocking connect */
+		(void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+		(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+#if defined(HAVE_NETINET_TCP_H) &&	\
+    defined(TCP_NODELAY)
+		{
+			int one = 1;
+
+			(void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		}
+#endif
+		stress_churn_set_addr(&addr, port + (int)p);
+		p = (p + 1) % n_ports;
+
+		t_connect = stress_time_now();
+		if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+			if (errno == EADDRNOTAVAIL) {
+				/* out of ephemeral ports for this destination */
+				client->exhausted++;
+				(void)shim_usleep(1000);
+			} else if (errno != EINTR) {
+				client->failed++;
+			}
+			(void)close(fd);
+			continue;
+		}
+		client->samples[client->index % CHURN_MAX_SAMPLES] = stress_time_now() - t_connect;
+		client->index++;
+
+		if (send(fd, churn_request, sizeof(churn_request) - 1, MSG_NOSIGNAL) < 0) {
+			client->failed++;
+			(void)close(fd);
+			continue;
+		}
+		while (got < sizeof(churn_response) - 1) {
+			const ssize_t ret = recv(fd, buf, sizeof(buf), 0);
+
+			if (ret <= 0)
+				break;
+			got += (size_t)ret;
+		}
+		if (churn_close == CHURN_CLOSE_SERVER) {
+			/* wait for the server to close first */
+			while (recv(fd, buf, sizeof(buf), 0) > 0)
+				;
+		}
+		(void)close(fd);
+		if (got >= sizeof(churn_response) - 1)
+			client->conns++;
+		else
+			client->failed++;
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_churn_metrics()
+ *	report connections/sec, connect latency percentiles and
+ *	TIME_WAIT socket counts
+ */
+static void stress_churn_metrics(
+	stress_args_t *args,
+	const stress_churn_client_t *clients,
+	const uint32_t n_clients,
+	const double duration,
+	const double tw_mean,
+	const double tw_max)
+{
+	uint64_t conns = 0, exhausted = 0, failed = 0;
+	size_t i, n_samples = 0;
+	double *samples;
+
+	samples = (double *)calloc((size_t)n_clients * CHURN_MAX_SAMPLES, sizeof(*samples));
+	if (!samples)
+		return;
+	for (i = 0; i < n_clients; i++) {
+		const size_t n = (size_t)STRESS_MINIMUM(clients[i].index, CHURN_MAX_SAMPLES);
+
+		conns += clients[i].conns;
+		exhausted += clients[i].exhausted;
+		failed += clients[i].failed;
+		(void)shim_memcpy(samples + n_samples, clients[i].samples, n * sizeof(*samples));
+		n_samples += n;
+	}
+
+	stress_metrics_set(args, 0, "connections/sec",
+		(duration > 0.0) ? (double)conns / duration : 0.0,
+		STRESS_METRIC_HARMONIC_MEAN);
+	if (n_samples > 0) {
+		stress_percentile_sort(samples, n_samples);
+		stress_metrics_set(args, 1, "usec p50 connect latency",
+			STRESS_DBL_MICROSECOND * stress_percentile(samples, n_samples, 50.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		stress_metrics_set(args, 2, "usec p99 connect latency",
+			STRESS_DBL_MICROSECOND * stress_percentile(samples, n_samples, 99.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		stress_metrics_set(args, 3, "usec p99.9 connect latency",
+			STRESS_DBL_MICROSECOND * stress_percentile(samples, n_samples, 99.9),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+	stress_metrics_set(args, 4, "TIME_WAIT sockets mean (system wide)",
+		tw_mean, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, 5, "TIME_WAIT sockets peak (system wide)",
+		tw_max, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, 6, "ephemeral port exhausted connects/sec",
+		(duration > 0.0) ? (double)exhausted / duration : 0.0,
+		STRESS_METRIC_GEOMETRIC_MEAN);
+	stress_metrics_set(args, 7, "failed connections/sec",
+		(duration > 0.0) ? (double)failed / duration : 0.0,
+		STRESS_METRIC_GEOMETRIC_MEAN);
+	free(samples);
+}
+
+/*
+ *  stress_churn
+ *	churn short lived loopback connections across a range of
+ *	listening ports and measure the setup and teardown cost
+ */
+static int stress_churn(stress_args_t *args)
+{
+	int churn_port = DEFAULT_CHURN_PORT, reserved_port;
+	uint32_t churn_clients = DEFAULT_CHURN_CLIENTS;
+	uint32_t churn_ports = DEFAULT_CHURN_PORTS;
+	uint32_t churn_rate = DEFAULT_CHURN_RATE;
+	size_t churn_close = 0, mmap_size;
+	stress_churn_shared_t *shared;
+	stress_churn_client_t *clients;
+	uint8_t *mapping;
+	pid_t server_pid = -1, *pids;
+	int *lfds;
+	uint32_t i, n_listen = 0, n_clients = 0;
+	double t_start, t_sample, duration, interval, tw_sum = 0.0, tw_max = 0.0, tw_n = 0.0;
+	int rc = EXIT_SUCCESS, close_side;
+
+	(void)stress_get_setting("churn-clients", &churn_clients);
+	(void)stress_get_setting("churn-close", &churn_close);
+	(void)stress_get_setting("churn-port", &churn_port);
+	(void)stress_get_setting("churn-ports", &churn_ports);
+	(void)stress_get_setting("churn-rate", &churn_rate);
+	close_side = stress_churn_closes[churn_close].close;
+	/* per client time between connections to meet the target rate */
+	interval = churn_rate ? (double)churn_clients / (double)churn_rate : 0.0;
+
+	churn_port += (int)(args->instance * churn_ports);
+	if (churn_port + (int)churn_ports - 1 > MAX_PORT)
+		churn_port = MIN_PORT + (churn_port % (MAX_PORT - MIN_PORT - (int)churn_ports));
+	reserved_port = stress_net_reserve_ports(churn_port, churn_port + (int)churn_ports - 1);
+	if (reserved_port < 0) {
+		pr_inf_skip("%s: cannot reserve %" PRIu32 " ports from port %d, skipping stressor\n",
+			args->name, churn_ports, churn_port);
+		return EXIT_NO_RESOURCE;
+	}
+	churn_port = reserved_port;
+
+	lfds = (int *)calloc(churn_ports, sizeof(*lfds));
+	pids = (pid_t *)calloc(churn_clients, sizeof(*pids));
+	if (!lfds || !pids) {
+		pr_inf_skip("%s: cannot allocate listener and process tables%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_tables;
+	}
+	mmap_size = sizeof(*shared) + (size_t)churn_clients * sizeof(*clients);
+	mapping = (uint8_t *)stress_mmap_populate(NULL, mmap_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for results%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, mmap_size,
+			stress_get_memfree_str(), errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto free_tables;
+	}
+	stress_set_vma_anon_name(mapping, mmap_size, "churn-results");
+	shared = (stress_churn_shared_t *)mapping;
+	clients = (stress_churn_client_t *)(mapping + sizeof(*shared));
+
+	/* listeners are ready before the server and clients start */
+	for (n_listen = 0; n_listen < churn_ports; n_listen++) {
+		struct sockaddr_in addr;
+		const int one = 1;
+		int fd;
+
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+		if (fd < 0)
+			break;
+		(void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		stress_churn_set_addr(&addr, churn_port + (int)n_listen);
+		if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+		    (listen(fd, SOMAXCONN) < 0)) {
+			pr_inf_skip("%s: cannot listen on port %d, errno=%d (%s), skipping stressor\n",
+				args->name, churn_port + (int)n_listen, errno, strerror(errno));
+			(void)close(fd);
+			rc = EXIT_NO_RESOURCE;
+			goto close_listeners;
+		}
+		lfds[n_listen] = fd;
+	}
+	if (n_listen < churn_ports) {
+		pr_inf_skip("%s: cannot create listening sockets, errno=%d (%s), skipping stressor\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto close_listeners;
+	}
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %" PRIu32 " clients, ports %d..%d, %s closes first, %s\n",
+			args->name, churn_clients, churn_port, churn_port + (int)churn_ports - 1,
+			stress_churn_closes[churn_close].name,
+			churn_rate ? "rate limited" : "maximum rate");
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+again_server:
+	server_pid = fork();
+	if (server_pid < 0) {
+		if (stress_redo_fork(args, errno))
+			goto again_server;
+		if (!stress_continue(args))
+			goto close_listeners;
+		pr_fail("%s: fork failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_FAILURE;
+		goto close_listeners;
+	} else if (server_pid == 0) {
+		_exit(stress_churn_server(shared, lfds, churn_ports, close_side));
+	}
+	for (i = 0; i < n_listen; i++)
+		(void)close(lfds[i]);
+	n_listen = 0;
+
+	for (n_clients = 0; n_clients < churn_clients; n_clients++) {
+		pid_t pid;
+again_client:
+		pid = fork();
+		if (pid < 0) {
+			if (stress_redo_fork(args, errno))
+				goto again_client;
+			break;
+		} else if (pid == 0) {
+			_exit(stress_churn_client(shared, &clients[n_clients], churn_port,
+				churn_ports, n_clients % churn_ports, interval, close_side));
+		}
+		pids[n_clients] = pid;
+	}
+	if (n_clients == 0) {
+		pr_inf_skip("%s: cannot fork any clients, skipping stressor\n", args->name);
+		rc = EXIT_NO_RESOURCE;
+		goto reap;
+	}
+
+	t_start = stress_time_now();
+	t_sample = t_start;
+	do {
+		uint64_t conns = 0;
+		double now;
+
+		(void)shim_usleep(50000);
+		for (i = 0; i < n_clients; i++)
+			conns += clients[i].conns;
+		stress_bogo_set(args, conns);
+
+		now = stress_time_now();
+		if (now - t_sample >= CHURN_TW_SAMPLE) {
+			const int64_t tw = stress_churn_time_wait();
+
+			if (tw >= 0) {
+				tw_sum += (double)tw;
+				tw_n += 1.0;
+				if ((double)tw > tw_max)
+					tw_max = (double)tw;
+				pr_dbg("%s: %.2f secs: %" PRIu64 " connections, %" PRId64 " TIME_WAIT sockets\n",
+					args->name, now - t_start, conns, tw);
+			}
+			t_sample = now;
+		}
+	} while (stress_continue(args));
+	duration = stress_time_now() - t_start;
+
+reap:
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	shared->stop = true;
+	for (i = 0; i < n_clients; i++)
+		(void)stress_kill_pid_wait(pids[i], NULL);
+	(void)stress_kill_pid_wait(server_pid, NULL);
+	if (n_clients > 0)
+		stress_churn_metrics(args, clients, n_clients, duration,
+			(tw_n > 0.0) ? tw_sum / tw_n : 0.0, tw_max);
+close_listeners:
+	for (i = 0; i < n_listen; i++)
+		(void)close(lfds[i]);
+	(void)munmap((void *)mapping, mmap_size);
+free_tables:
+	free(pids);
+	free(lfds);
+	stress_net_release_ports(churn_port, churn_port + (int)churn_ports - 1);
+
+	return rc;
+}
+
+const stressor_info_t stress_churn_info = {
+	.stressor = stress_churn,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_churn_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without sys/epoll.h, accept4() or AF_INET socket support"
+};
+#endif
@@ -0,0 +1,989 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-io-uring.h"
+#include "core-killpid.h"
+#include "core-net.h"
+#include "io-uring.h"
+
+#include <sys/resource.h>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#if defined(HAVE_NETINET_TCP_H)
+#include <netinet/tcp.h>
+#endif
+
+#if defined(HAVE_POLL_H)
+#include <poll.h>
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#endif
+
+#if defined(HAVE_SYS_SELECT_H)
+#include <sys/select.h>
+#endif
+
+#define DEFAULT_EVENTLOOP_PORT		(17000)
+
+#define MIN_EVENTLOOP_CONNS		(16)
+#define MAX_EVENTLOOP_CONNS		(100000)
+#define DEFAULT_EVENTLOOP_CONNS		(4096)
+
+#define MIN_EVENTLOOP_ACTIVE		(1)
+#define MAX_EVENTLOOP_ACTIVE		(100)
+#define DEFAULT_EVENTLOOP_ACTIVE	(1)
+
+#define EVENTLOOP_MIN_STEP_CONNS	(1024)	/* first sweep step */
+#define EVENTLOOP_MAX_STEPS		(8)	/* 1K, 4K, 16K, 64K, .. */
+#define EVENTLOOP_MAX_SAMPLES		(4096)	/* latency samples per config */
+#define EVENTLOOP_SLICE			(0.25)	/* seconds per config */
+#define EVENTLOOP_MAX_EVENTS		(1024)	/* epoll_wait events */
+#define EVENTLOOP_URING_ENTRIES		(4096)
+#define EVENTLOOP_URING_MAX_CQ_ENTRIES	(65536)
+#define EVENTLOOP_ADDRS_PORTS		(16384)	/* connections per source address */
+
+#define EVENTLOOP_ACK_OK		(1)
+#define EVENTLOOP_ACK_UNSUPPORTED	(0)
+
+static const stress_help_t help[] = {
+	{ NULL,	"eventloop N",		"start N workers multiplexing many mostly idle connections" },
+	{ NULL,	"eventloop-active P",	"percentage of connections active in each burst" },
+	{ NULL,	"eventloop-conns N",	"sweep the number of connections from 1K up to N" },
+	{ NULL,	"eventloop-method M",	"event method: all, epoll, poll, select, io-uring" },
+	{ NULL,	"eventloop-ops N",	"stop after N connection events" },
+	{ NULL,	"eventloop-port P",	"use socket ports P to P + number of workers - 1" },
+	{ NULL,	NULL,			NULL }
+};
+
+#if defined(HAVE_STRESS_IO_URING_RING) &&	\
+    defined(IORING_SETUP_CQSIZE) &&	\
+    defined(IORING_POLL_ADD_MULTI) &&	\
+    defined(IORING_CQE_F_MORE) &&	\
+    defined(HAVE_IORING_OP_POLL_ADD)
+#define HAVE_EVENTLOOP_IO_URING
+#endif
+
+typedef enum {
+	EVENTLOOP_METHOD_ALL,
+	EVENTLOOP_METHOD_EPOLL,
+	EVENTLOOP_METHOD_POLL,
+	EVENTLOOP_METHOD_SELECT,
+	EVENTLOOP_METHOD_IO_URING,
+} stress_eventloop_method_t;
+
+typedef struct {
+	const char *name;
+	const stress_eventloop_method_t method;
+} stress_eventloop_method_info_t;
+
+static const stress_eventloop_method_info_t stress_eventloop_methods[] = {
+	{ "all",	EVENTLOOP_METHOD_ALL },
+	{ "epoll",	EVENTLOOP_METHOD_EPOLL },
+	{ "poll",	EVENTLOOP_METHOD_POLL },
+	{ "select",	EVENTLOOP_METHOD_SELECT },
+	{ "io-uring",	EVENTLOOP_METHOD_IO_URING },
+};
+
+static const char *stress_eventloop_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_eventloop_methods)) ? stress_eventloop_methods[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_eventloop_active,	"eventloop-active", TYPE_ID_UINT32, MIN_EVENTLOOP_ACTIVE, MAX_EVENTLOOP_ACTIVE, NULL },
+	{ OPT_eventloop_conns,	"eventloop-conns",  TYPE_ID_SIZE_T, MIN_EVENTLOOP_CONNS, MAX_EVENTLOOP_CONNS, NULL },
+	{ OPT_eventloop_method,	"eventloop-method", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_eventloop_method },
+	{ OPT_eventloop_port,	"eventloop-port",   TYPE_ID_INT_PORT, MIN_PORT, MAX_PORT, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_POLL_H) &&	\
+    defined(AF_INET) &&		\
+    defined(SOCK_STREAM)
+
+#if defined(HAVE_EVENTLOOP_IO_URING)
+/*
+ *  minimal io-uring, just enough for multishot poll
+ */
+typedef struct {
+	stress_io_uring_ring_t ring;
+	unsigned to_submit;	/* queued but not yet submitted sqes */
+} stress_eventloop_uring_t;
+#endif
+
+/*
+ *  per sweep configuration results, one per method and connection count
+ */
+typedef struct {
+	stress_eventloop_method_t method;
+	size_t conns;			/* connections being multiplexed */
+	uint64_t events;		/* connection events handled */
+	uint64_t index;			/* next latency sample */
+	double duration;		/* time spent in this config */
+	bool unsupported;		/* method could not be setup */
+	double samples[EVENTLOOP_MAX_SAMPLES];	/* wake-up latencies (seconds) */
+} stress_eventloop_config_t;
+
+/*
+ *  event loop state for the method being exercised
+ */
+typedef struct {
+	const int *conn_fds;		/* server side fds of all the connections */
+	int *fds;			/* watched fds, fds[n] is the control fd */
+	size_t n;			/* number of connections being watched */
+	size_t *ready;			/* indices of ready fds */
+	int epoll_fd;
+#if defined(HAVE_SYS_EPOLL_H)
+	struct epoll_event *events;
+#endif
+	struct pollfd *pfds;
+	fd_set *rset;			/* select read set */
+	fd_set *rset_copy;		/* select read set to be modified */
+	size_t set_size;		/* size of select sets in bytes */
+	int max_fd;
+#if defined(HAVE_EVENTLOOP_IO_URING)
+	stress_eventloop_uring_t uring;
+#endif
+} stress_eventloop_t;
+
+/*
+ *  stress_eventloop_method_supported()
+ *	true if the method has been built in
+ */
+static bool stress_eventloop_method_supported(const stress_eventloop_method_t method)
+{
+	switch (method) {
+#if defined(HAVE_SYS_EPOLL_H)
+	case EVENTLOOP_METHOD_EPOLL:
+		return true;
+#endif
+	case EVENTLOOP_METHOD_POLL:
+		return true;
+#if defined(HAVE_SYS_SELECT_H)
+	case EVENTLOOP_METHOD_SELECT:
+		return true;
+#endif
+#if defined(HAVE_EVENTLOOP_IO_URING)
+	case EVENTLOOP_METHOD_IO_URING:
+		return true;
+#endif
+	default:
+		break;
+	}
+	return false;
+}
+
+static const char *stress_eventloop_method_name(const stress_eventloop_method_t method)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(stress_eventloop_methods); i++) {
+		if (stress_eventloop_methods[i].method == method)
+			return stress_eventloop_methods[i].name;
+	}
+	return "unknown";
+}
+
+#if defined(HAVE_EVENTLOOP_IO_URING)
+/*
+ *  stress_eventloop_uring_setup()
+ *	setup an io-uring with a completion queue large enough
+ *	for a burst of events, returns -errno on failure
+ */
+static int stress_eventloop_uring_setup(stress_eventloop_uring_t *uring, const size_t n)
+{
+	struct io_uring_params p;
+
+	(void)shim_memset(&p, 0, sizeof(p));
+	p.flags = IORING_SETUP_CQSIZE;
+#if defined(IORING_SETUP_CLAMP)
+	p.flags |= IORING_SETUP_CLAMP;
+#endif
+	p.cq_entries = (uint32_t)STRESS_MAXIMUM((size_t)(2 * EVENTLOOP_URING_ENTRIES), 2 * n);
+	/* the kernel rejects larger completion queues without IORING_SETUP_CLAMP */
+	if (p.cq_entries > EVENTLOOP_URING_MAX_CQ_ENTRIES)
+		p.cq_entries = EVENTLOOP_URING_MAX_CQ_ENTRIES;
+	uring->to_submit = 0;
+
+	return stress_io_uring_ring_setup(&uring->ring, EVENTLOOP_URING_ENTRIES, &p);
+}
+
+/*
+ *  stress_eventloop_uring_submit()
+ *	submit queued sqes, optionally waiting for at least one completion
+ */
+static int stress_eventloop_uring_submit(stress_eventloop_uring_t *uring, const unsigned wait)
+{
+	int ret;
+
+	ret = stress_io_uring_ring_enter(&uring->ring, uring->to_submit,
+			wait, wait ? IORING_ENTER_GETEVENTS : 0);
+	if (ret < 0)
+		return -1;
+	uring->to_submit -= (unsigned)ret;
+	return 0;
+}
+
+/*
+ *  stress_eventloop_uring_poll()
+ *	queue a multishot poll on fd, the connection index is the user data
+ */
+static int stress_eventloop_uring_poll(
+	stress_eventloop_uring_t *uring,
+	const int fd,
+	const size_t index)
+{
+	unsigned tail, idx;
+	struct io_uring_sqe *sqe;
+
+	/* flush when the submission queue is full */
+	if ((uring->to_submit >= uring->ring.sq_entries) &&
+	    (stress_eventloop_uring_submit(uring, 0) < 0))
+		return -1;
+
+	tail = *uring->ring.sq_tail;
+	idx = tail & *uring->ring.sq_mask;
+	sqe = &uring->ring.sqes[idx];
+	(void)shim_memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->poll32_events = POLLIN;
+	sqe->user_data = (uint64_t)index;
+	uring->ring.sq_array[idx] = idx;
+	stress_asm_mb();
+	*uring->ring.sq_tail = tail + 1;
+	stress_asm_mb();
+	uring->to_submit++;
+	return 0;
+}
+#endif
+
+/*
+ *  stress_eventloop_teardown()
+ *	free resources used by the current method
+ */
+static void stress_eventloop_teardown(stress_eventloop_t *el)
+{
+	if (el->epoll_fd >= 0) {
+		(void)close(el->epoll_fd);
+		el->epoll_fd = -1;
+	}
+#if defined(HAVE_EVENTLOOP_IO_URING)
+	if (el->uring.ring.fd >= 0)
+		stress_io_uring_ring_close(&el->uring.ring);
+#endif
+}
+
+/*
+ *  stress_eventloop_setup()
+ *	register the first n connections and the control fd with
+ *	the given method, returns 0 on success, -1 if not supported
+ */
+static int stress_eventloop_setup(
+	stress_eventloop_t *el,
+	const stress_eventloop_method_t method,
+	const size_t n,
+	const int ctrl_fd)
+{
+	size_t i;
+
+	el->n = n;
+	(void)shim_memcpy(el->fds, el->conn_fds, n * sizeof(*el->fds));
+	el->fds[n] = ctrl_fd;
+
+	switch (method) {
+#if defined(HAVE_SYS_EPOLL_H)
+	case EVENTLOOP_METHOD_EPOLL:
+		el->epoll_fd = epoll_create1(0);
+		if (el->epoll_fd < 0)
+			return -1;
+		for (i = 0; i <= n; i++) {
+			struct epoll_event ev;
+
+			(void)shim_memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.u64 = (uint64_t)i;
+			if (epoll_ctl(el->epoll_fd, EPOLL_CTL_ADD, el->fds[i], &ev) < 0) {
+				stress_eventloop_teardown(el);
+				return -1;
+			}
+		}
+		return 0;
+#endif
+	case EVENTLOOP_METHOD_POLL:
+		for (i = 0; i <= n; i++) {
+			el->pfds[i].fd = el->fds[i];
+			el->pfds[i].events = POLLIN;
+			el->pfds[i].revents = 0;
+		}
+		return 0;
+#if defined(HAVE_SYS_SELECT_H)
+	case EVENTLOOP_METHOD_SELECT:
+		(void)shim_memset(el->rset, 0, el->set_size);
+		el->max_fd = -1;
+		for (i = 0; i <= n; i++) {
+			const int fd = el->fds[i];
+			unsigned long int *bits = (unsigned long int *)el->rset;
+			const size_t nbits = sizeof(*bits) * 8;
+
+			/* FD_SET() cannot be used above FD_SETSIZE */
+			bits[(size_t)fd / nbits] |= 1UL << ((size_t)fd % nbits);
+			if (fd > el->max_fd)
+				el->max_fd = fd;
+		}
+		return 0;
+#endif
+#if defined(HAVE_EVENTLOOP_IO_URING)
+	case EVENTLOOP_METHOD_IO_URING:
+		if (stress_eventloop_uring_setup(&el->uring, n + 1) < 0)
+			return -1;
+		for (i = 0; i <= n; i++) {
+			if (stress_eventloop_uring_poll(&el->uring, el->fds[i], i) < 0) {
+				stress_eventloop_teardown(el);
+				return -1;
+			}
+		}
+		if (stress_eventloop_uring_submit(&el->uring, 0) < 0) {
+			stress_eventloop_teardown(el);
+			return -1;
+		}
+		return 0;
+#endif
+	default:
+		break;
+	}
+	return -1;
+}
+
+/*
+ *  stress_eventloop_wait()
+ *	wait for events, fill el->ready with the indices of
+ *	ready fds, returns the number of ready fds or -1 on error
+ */
+static ssize_t stress_eventloop_wait(
+	stress_eventloop_t *el,
+	const stress_eventloop_method_t method)
+{
+	size_t i, n_ready = 0;
+	int ret;
+
+	switch (method) {
+#if defined(HAVE_SYS_EPOLL_H)
+	case EVENTLOOP_METHOD_EPOLL:
+		ret = epoll_wait(el->epoll_fd, el->events, EVENTLOOP_MAX_EVENTS, -1);
+		if (ret < 0)
+			return -1;
+		for (i = 0; i < (size_t)ret; i++)
+			el->ready[n_ready++] = (size_t)el->events[i].data.u64;
+		return (ssize_t)n_ready;
+#endif
+	case EVENTLOOP_METHOD_POLL:
+		ret = poll(el->pfds, (nfds_t)(el->n + 1), -1);
+		if (ret < 0)
+			return -1;
+		/* poll must scan all the fds to find the ready ones */
+		for (i = 0; (i <= el->n) && (n_ready < (size_t)ret); i++) {
+			if (el->pfds[i].revents) {
+				el->ready[n_ready++] = i;
+				el->pfds[i].revents = 0;
+			}
+		}
+		return (ssize_t)n_ready;
+#if defined(HAVE_SYS_SELECT_H)
+	case EVENTLOOP_METHOD_SELECT: {
+		const unsigned long int *bits = (unsigned long int *)el->rset_copy;
+		const size_t nbits = sizeof(*bits) * 8;
+
+		(void)shim_memcpy(el->rset_copy, el->rset, el->set_size);
+		ret = select(el->max_fd + 1, el->rset_copy, NULL, NULL, NULL);
+		if (ret < 0)
+			return -1;
+		for (i = 0; (i <= el->n) && (n_ready < (size_t)ret); i++) {
+			const size_t fd = (size_t)el->fds[i];
+
+			if (bits[fd / nbits] & (1UL << (fd % nbits)))
+				el->ready[n_ready++] = i;
+		}
+		return (ssize_t)n_ready;
+	}
+#endif
+#if defined(HAVE_EVENTLOOP_IO_URING)
+	case EVENTLOOP_METHOD_IO_URING: {
+		stress_eventloop_uring_t *uring = &el->uring;
+		unsigned head;
+
+		stress_asm_mb();
+		if (*uring->ring.cq_head == *uring->ring.cq_tail) {
+			if (stress_eventloop_uring_submit(uring, 1) < 0)
+				return -1;
+		}
+		head = *uring->ring.cq_head;
+		for (;;) {
+			const struct io_uring_cqe *cqe;
+			size_t index;
+
+			stress_asm_mb();
+			if (head == *uring->ring.cq_tail)
+				break;
+			cqe = &uring->ring.cqes[head & *uring->ring.cq_mask];
+			index = (size_t)cqe->user_data;
+			head++;
+			if (index > el->n)
+				continue;
+			if (cqe->res > 0)
+				el->ready[n_ready++] = index;
+			/* multishot poll terminated, re-arm it */
+			if (!(cqe->flags & IORING_CQE_F_MORE))
+				(void)stress_eventloop_uring_poll(uring, el->fds[index], index);
+		}
+		*uring->ring.cq_head = head;
+		stress_asm_mb();
+		return (ssize_t)n_ready;
+	}
+#endif
+	default:
+		break;
+	}
+	errno = ENOSYS;
+	return -1;
+}
+
+/*
+ *  stress_eventloop_connect()
+ *	create n loopback TCP connections, client ends in cfds and
+ *	server ends in sfds, returns the number created
+ */
+static size_t stress_eventloop_connect(
+	stress_args_t *args,
+	const int port,
+	int *cfds,
+	int *sfds,
+	const size_t n)
+{
+	struct sockaddr_in addr;
+	int lfd, one = 1;
+	size_t i;
+
+	lfd = socket(AF_INET, SOCK_STREAM, 0);
+	if (lfd < 0) {
+		pr_fail("%s: socket failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		return 0;
+	}
+	(void)setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	(void)shim_memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons((uint16_t)port);
+	if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		pr_inf_skip("%s: bind failed on port %d, errno=%d (%s)\n",
+			args->name, port, errno, strerror(errno));
+		(void)close(lfd);
+		return 0;
+	}
+	if (listen(lfd, SOMAXCONN) < 0) {
+		pr_fail("%s: listen failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		(void)close(lfd);
+		return 0;
+	}
+
+	for (i = 0; (i < n) && stress_continue_flag(); i++) {
+		struct sockaddr_in src;
+		int cfd, sfd;
+
+		cfd = socket(AF_INET, SOCK_STREAM, 0);
+		if (cfd < 0)
+			break;
+		/*
+		 *  spread the client ends over several loopback source
+		 *  addresses so that large connection counts do not run
+		 *  out of ephemeral ports
+		 */
+		(void)shim_memset(&src, 0, sizeof(src));
+		src.sin_family = AF_INET;
+		src.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + (uint32_t)(i / EVENTLOOP_ADDRS_PORTS));
+#if defined(IP_BIND_ADDRESS_NO_PORT)
+		(void)setsockopt(cfd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+#endif
+		if ((bind(cfd, (struct sockaddr *)&src, sizeof(src)) < 0) ||
+		    (connect(cfd, (struct sockaddr *)&addr, sizeof(addr)) < 0)) {
+			(void)close(cfd);
+			break;
+		}
+		sfd = accept(lfd, NULL, NULL);
+		if (sfd < 0) {
+			(void)close(cfd);
+			break;
+		}
+#if defined(HAVE_NETINET_TCP_H) &&	\
+    defined(TCP_NODELAY)
+		(void)setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		(void)setsockopt(sfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#endif
+		cfds[i] = cfd;
+		sfds[i] = sfd;
+	}
+	(void)close(lfd);
+	return i;
+}
+
+/*
+ *  stress_eventloop_close_fds()
+ *	close an array of fds
+ */
+static void stress_eventloop_close_fds(int *fds, const size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		if (fds[i] >= 0) {
+			(void)close(fds[i]);
+			fds[i] = -1;
+		}
+	}
+}
+
+/*
+ *  stress_eventloop_driver()
+ *	child process, for each configuration wait for the server to
+ *	be ready then send bursts of timestamped messages to a fraction
+ *	of the connections and wait for their echoes
+ */
+static int stress_eventloop_driver(
+	const int *cfds,
+	const int ctrl_fd,
+	const stress_eventloop_config_t *configs,
+	const size_t n_configs,
+	const uint32_t active)
+{
+	uint32_t config = 0;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	while (stress_continue_flag()) {
+		const size_t n = configs[config].conns;
+		const size_t k = STRESS_MAXIMUM((size_t)1, (n * active) / 100);
+		const size_t step = n / k;
+		uint8_t ack;
+		double t_end;
+
+		if (read(ctrl_fd, &ack, sizeof(ack)) != (ssize_t)sizeof(ack))
+			break;
+		if (ack == EVENTLOOP_ACK_OK) {
+			t_end = stress_time_now() + EVENTLOOP_SLICE;
+			do {
+				const size_t start = stress_mwc32modn((uint32_t)n);
+				size_t j;
+
+				for (j = 0; j < k; j++) {
+					const size_t idx = (start + (j * step)) % n;
+					const double t = stress_time_now();
+
+					if (write(cfds[idx], &t, sizeof(t)) != (ssize_t)sizeof(t))
+						return EXIT_SUCCESS;
+				}
+				for (j = 0; j < k; j++) {
+					const size_t idx = (start + (j * step)) % n;
+					double t;
+
+					if (read(cfds[idx], &t, sizeof(t)) != (ssize_t)sizeof(t))
+						return EXIT_SUCCESS;
+				}
+			} while (stress_continue_flag() && (stress_time_now() < t_end));
+		}
+		config = (config + 1) % (uint32_t)n_configs;
+		if (write(ctrl_fd, &config, sizeof(config)) != (ssize_t)sizeof(config))
+			break;
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_eventloop_server()
+ *	parent process, multiplex the connections with each method
+ *	in turn, timestamp the messages on wake-up and echo them back
+ */
+static int stress_eventloop_server(
+	stress_args_t *args,
+	stress_eventloop_t *el,
+	const int ctrl_fd,
+	stress_eventloop_config_t *configs,
+	const size_t n_configs)
+{
+	uint32_t config = 0;
+	int rc = EXIT_SUCCESS;
+
+	while (stress_continue(args)) {
+		stress_eventloop_config_t *cfg = &configs[config];
+		const stress_eventloop_method_t method = cfg->method;
+		uint8_t ack = EVENTLOOP_ACK_OK;
+		bool switched = false;
+		double t_start;
+
+		if (cfg->unsupported || (stress_eventloop_setup(el, method, cfg->conns, ctrl_fd) < 0)) {
+			if (!cfg->unsupported && stress_instance_zero(args))
+				pr_inf("%s: cannot use %s with %zu connections, errno=%d (%s), skipping it\n",
+					args->name, stress_eventloop_method_name(method),
+					cfg->conns, errno, strerror(errno));
+			cfg->unsupported = true;
+			ack = EVENTLOOP_ACK_UNSUPPORTED;
+		}
+		if (write(ctrl_fd, &ack, sizeof(ack)) != (ssize_t)sizeof(ack))
+			break;
+
+		t_start = stress_time_now();
+		while (!switched && stress_continue(args)) {
+			ssize_t i, n_ready;
+
+			if (ack == EVENTLOOP_ACK_UNSUPPORTED) {
+				/* no method, just wait for the next config */
+				if (read(ctrl_fd, &config, sizeof(config)) != (ssize_t)sizeof(config))
+					goto done;
+				break;
+			}
+			n_ready = stress_eventloop_wait(el, method);
+			if (n_ready < 0) {
+				if (errno == EINTR)
+					continue;
+				pr_fail("%s: %s wait failed, errno=%d (%s)\n",
+					args->name, stress_eventloop_method_name(method),
+					errno, strerror(errno));
+				rc = EXIT_FAILURE;
+				goto done;
+			}
+			for (i = 0; i < n_ready; i++) {
+				const size_t index = el->ready[i];
+				double buf[8], t_now;
+				ssize_t ret, j;
+
+				if (index == el->n) {
+					if (read(ctrl_fd, &config, sizeof(config)) != (ssize_t)sizeof(config))
+						goto done;
+					switched = true;
+					continue;
+				}
+				ret = recv(el->fds[index], buf, sizeof(buf), MSG_DONTWAIT);
+				if (ret <= 0)
+					continue;
+				t_now = stress_time_now();
+				for (j = 0; j < ret / (ssize_t)sizeof(buf[0]); j++) {
+					cfg->samples[cfg->index % EVENTLOOP_MAX_SAMPLES] = t_now - buf[j];
+					cfg->index++;
+					cfg->events++;
+					stress_bogo_inc(args);
+				}
+				VOID_RET(ssize_t, send(el->fds[index], buf, (size_t)ret, 0));
+			}
+		}
+		if (ack == EVENTLOOP_ACK_OK) {
+			cfg->duration += stress_time_now() - t_start;
+			stress_eventloop_teardown(el);
+		}
+		if (config >= n_configs)
+			break;
+	}
+done:
+	stress_eventloop_teardown(el);
+	return rc;
+}
+
+/*
+ *  stress_eventloop_metrics()
+ *	report events/sec and wake-up latency per configuration
+ */
+static void stress_eventloop_metrics(
+	stress_args_t *args,
+	stress_eventloop_config_t *configs,
+	const size_t n_configs)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_configs; i++) {
+		stress_eventloop_config_t *cfg = &configs[i];
+		const char *name = stress_eventloop_method_name(cfg->method);
+		const size_t n_samples = (size_t)STRESS_MINIMUM(cfg->index, EVENTLOOP_MAX_SAMPLES);
+		char msg[64];
+
+		if (cfg->unsupported || (n_samples == 0))
+			continue;
+		stress_percentile_sort(cfg->samples, n_samples);
+
+		(void)snprintf(msg, sizeof(msg), "events/sec %s %zu conns", name, cfg->conns);
+		stress_metrics_set(args, idx++, msg,
+			(cfg->duration > 0.0) ? (double)cfg->events / cfg->duration : 0.0,
+			STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p50 wake-up latency %s %zu conns", name, cfg->conns);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(cfg->samples, n_samples, 50.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99 wake-up latency %s %zu conns", name, cfg->conns);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_MICROSECOND * stress_percentile(cfg->samples, n_samples, 99.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_eventloop_steps()
+ *	connection counts to sweep, 1K, 4K, 16K .. up to conns
+ */
+static size_t stress_eventloop_steps(const size_t conns, size_t *steps)
+{
+	size_t n_steps = 0, n;
+
+	for (n = EVENTLOOP_MIN_STEP_CONNS; (n < conns) && (n_steps < EVENTLOOP_MAX_STEPS - 1); n *= 4)
+		steps[n_steps++] = n;
+	steps[n_steps++] = conns;
+	return n_steps;
+}
+
+/*
+ *  stress_eventloop
+ *	stress event loop scalability over many mostly idle connections
+ */
+static int stress_eventloop(stress_args_t *args)
+{
+	int eventloop_port = DEFAULT_EVENTLOOP_PORT;
+	size_t eventloop_conns = DEFAULT_EVENTLOOP_CONNS;
+	size_t eventloop_method = 0;
+	uint32_t eventloop_active = DEFAULT_EVENTLOOP_ACTIVE;
+	size_t i, j, n_conns = 0, n_steps, n_configs = 0, max_files, configs_size;
+	size_t steps[EVENTLOOP_MAX_STEPS];
+	int *cfds = NULL, *sfds = NULL, ctrl[2], reserved_port;
+	int rc = EXIT_NO_RESOURCE;
+	stress_eventloop_config_t *configs;
+	stress_eventloop_t el;
+	stress_eventloop_method_t method;
+	pid_t pid;
+#if defined(RLIMIT_NOFILE)
+	struct rlimit rlim;
+#endif
+
+	(void)stress_get_setting("eventloop-active", &eventloop_active);
+	(void)stress_get_setting("eventloop-conns", &eventloop_conns);
+	(void)stress_get_setting("eventloop-method", &eventloop_method);
+	(void)stress_get_setting("eventloop-port", &eventloop_port);
+	method = stress_eventloop_methods[eventloop_method].method;
+
+	if ((method != EVENTLOOP_METHOD_ALL) && !stress_eventloop_method_supported(method)) {
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: eventloop-method %s is not supported, skipping stressor\n",
+				args->name, stress_eventloop_method_name(method));
+		return EXIT_NOT_IMPLEMENTED;
+	}
+
+#if defined(RLIMIT_NOFILE)
+	/* both ends of all the connections are opened before forking */
+	if (getrlimit(RLIMIT_NOFILE, &rlim) == 0) {
+		rlim.rlim_cur = rlim.rlim_max;
+		(void)setrlimit(RLIMIT_NOFILE, &rlim);
+	}
+#endif
+	max_files = stress_get_max_file_limit();
+	if (max_files < 2 * MIN_EVENTLOOP_CONNS + 64) {
+		pr_inf_skip("%s: file descriptor limit of %zu is too low, skipping stressor\n",
+			args->name, max_files);
+		return EXIT_NO_RESOURCE;
+	}
+	if (2 * eventloop_conns + 64 > max_files) {
+		eventloop_conns = (max_files - 64) / 2;
+		if (stress_instance_zero(args))
+			pr_inf("%s: file descriptor limit of %zu reduces connections to %zu\n",
+				args->name, max_files, eventloop_conns);
+	}
+
+	eventloop_port += args->instance;
+	if (eventloop_port > MAX_PORT)
+		eventloop_port -= (MAX_PORT - MIN_PORT + 1);
+	reserved_port = stress_net_reserve_ports(eventloop_port, eventloop_port);
+	if (reserved_port < 0) {
+		pr_inf_skip("%s: cannot reserve port %d, skipping stressor\n",
+			args->name, eventloop_port);
+		return EXIT_NO_RESOURCE;
+	}
+	eventloop_port = reserved_port;
+
+	(void)shim_memset(&el, 0, sizeof(el));
+	el.epoll_fd = -1;
+#if defined(HAVE_EVENTLOOP_IO_URING)
+	el.uring.ring.fd = -1;
+#endif
+	cfds = (int *)calloc(eventloop_conns, sizeof(*cfds));
+	sfds = (int *)calloc(eventloop_conns, sizeof(*sfds));
+	el.fds = (int *)calloc(eventloop_conns + 1, sizeof(*el.fds));
+	el.ready = (size_t *)calloc(eventloop_conns + 1, sizeof(*el.ready));
+	el.pfds = (struct pollfd *)calloc(eventloop_conns + 1, sizeof(*el.pfds));
+#if defined(HAVE_SYS_EPOLL_H)
+	el.events = (struct epoll_event *)calloc(EVENTLOOP_MAX_EVENTS, sizeof(*el.events));
+	if (!el.events)
+		goto free_fds;
+#endif
+	if (!cfds || !sfds || !el.fds || !el.ready || !el.pfds) {
+		pr_inf_skip("%s: cannot allocate connection state%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		goto free_fds;
+	}
+	for (i = 0; i < eventloop_conns; i++) {
+		cfds[i] = -1;
+		sfds[i] = -1;
+	}
+
+	n_conns = stress_eventloop_connect(args, eventloop_port, cfds, sfds, eventloop_conns);
+	if (n_conns < MIN_EVENTLOOP_CONNS) {
+		if (stress_continue_flag())
+			pr_inf_skip("%s: only managed to create %zu of %zu connections, "
+				"skipping stressor\n", args->name, n_conns, eventloop_conns);
+		goto close_fds;
+	}
+	if ((n_conns < eventloop_conns) && stress_instance_zero(args))
+		pr_inf("%s: only managed to create %zu of %zu connections\n",
+			args->name, n_conns, eventloop_conns);
+
+	n_steps = stress_eventloop_steps(n_conns, steps);
+	configs_size = EVENTLOOP_MAX_STEPS * SIZEOF_ARRAY(stress_eventloop_methods) * sizeof(*configs);
+	configs = (stress_eventloop_config_t *)stress_mmap_populate(NULL, configs_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (configs == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for results%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, configs_size,
+			stress_get_memfree_str(), errno, strerror(errno));
+		goto close_fds;
+	}
+	stress_set_vma_anon_name(configs, configs_size, "eventloop-results");
+	for (i = 0; i < n_steps; i++) {
+		for (j = 0; j < SIZEOF_ARRAY(stress_eventloop_methods); j++) {
+			const stress_eventloop_method_t m = stress_eventloop_methods[j].method;
+
+			if (!stress_eventloop_method_supported(m))
+				continue;
+			if ((method != EVENTLOOP_METHOD_ALL) && (method != m))
+				continue;
+			configs[n_configs].method = m;
+			configs[n_configs].conns = steps[i];
+			n_configs++;
+		}
+	}
+
+	/* select read sets must cover the highest server side fd */
+	{
+		int max_fd = 0;
+		const size_t word_bits = sizeof(unsigned long int) * 8;
+
+		for (i = 0; i < n_conns; i++)
+			max_fd = STRESS_MAXIMUM(max_fd, sfds[i]);
+		el.set_size = ((((size_t)max_fd + 64) / word_bits) + 1) * sizeof(unsigned long int);
+		el.set_size = STRESS_MAXIMUM(el.set_size, sizeof(fd_set));
+	}
+	el.rset = (fd_set *)calloc(1, el.set_size);
+	el.rset_copy = (fd_set *)calloc(1, el.set_size);
+	if (!el.rset || !el.rset_copy) {
+		pr_inf_skip("%s: cannot allocate select sets%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		goto unmap_configs;
+	}
+	el.conn_fds = sfds;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctrl) < 0) {
+		pr_inf_skip("%s: socketpair failed, errno=%d (%s), skipping stressor\n",
+			args->name, errno, strerror(errno));
+		goto unmap_configs;
+	}
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %zu connections, %" PRIu32 "%% active per burst\n",
+			args->name, n_conns, eventloop_active);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+again:
+	pid = fork();
+	if (pid < 0) {
+		if (stress_redo_fork(args, errno))
+			goto again;
+		if (!stress_continue(args)) {
+			rc = EXIT_SUCCESS;
+			goto close_ctrl;
+		}
+		pr_err("%s: fork failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_FAILURE;
+		goto close_ctrl;
+	} else if (pid == 0) {
+		(void)close(ctrl[1]);
+		stress_eventloop_close_fds(sfds, n_conns);
+		rc = stress_eventloop_driver(cfds, ctrl[0], configs, n_configs, eventloop_active);
+		_exit(rc);
+	}
+	(void)close(ctrl[0]);
+	ctrl[0] = -1;
+	stress_eventloop_close_fds(cfds, n_conns);
+
+	rc = stress_eventloop_server(args, &el, ctrl[1], configs, n_configs);
+	(void)stress_kill_pid_wait(pid, NULL);
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_eventloop_metrics(args, configs, n_configs);
+close_ctrl:
+	if (ctrl[0] >= 0)
+		(void)close(ctrl[0]);
+	(void)close(ctrl[1]);
+unmap_configs:
+	free(el.rset_copy);
+	free(el.rset);
+	(void)munmap((void *)configs, configs_size);
+close_fds:
+	stress_eventloop_close_fds(cfds, n_conns);
+	stress_eventloop_close_fds(sfds, n_conns);
+free_fds:
+#if defined(HAVE_SYS_EPOLL_H)
+	free(el.events);
+#endif
+	free(el.pfds);
+	free(el.ready);
+	free(el.fds);
+	free(sfds);
+	free(cfds);
+	stress_net_release_ports(eventloop_port, eventloop_port);
+
+	return rc;
+}
+
+const stressor_info_t stress_eventloop_info = {
+	.stressor = stress_eventloop,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_eventloop_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without poll.h or AF_INET socket support"
+};
+#endif
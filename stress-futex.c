@@ -20,6 +20,8 @@
 #include "stress-ng.h"
 #include "core-affinity.h"
 #include "core-builtin.h"
+#include "core-pthread.h"
+#include "core-put.h"
 
 #include <time.h>
 
@@ -27,10 +29,43 @@
 #include <linux/futex.h>
 #endif
 
+#define MIN_FUTEX_WAITERS	(1)
+#define MAX_FUTEX_WAITERS	(1024)
+#define DEFAULT_FUTEX_WAITERS	(8)
+
+#define FUTEX_METHOD_WAKE	(0)
+#define FUTEX_METHOD_ALL	(1)
+#define FUTEX_METHOD_WAITV	(2)
+#define FUTEX_METHOD_LOCK_PI	(3)
+#define FUTEX_METHOD_REQUEUE	(4)
+#define FUTEX_METHOD_HASH	(5)
+
 static const stress_help_t help[] = {
-	{ NULL,	"futex N",	"start N workers exercising a fast mutex" },
-	{ NULL,	"futex-ops N",	"stop after N fast mutex bogo operations" },
-	{ NULL,	NULL,		NULL }
+	{ NULL,	"futex N",		"start N workers exercising a fast mutex" },
+	{ NULL,	"futex-method M",	"select method: wake, all, waitv, lock-pi, requeue, hash" },
+	{ NULL,	"futex-ops N",		"stop after N fast mutex bogo operations" },
+	{ NULL,	"futex-waiters N",	"maximum number of waiter threads for the threaded methods" },
+	{ NULL,	NULL,			NULL }
+};
+
+static const char * const stress_futex_methods[] = {
+	"wake",
+	"all",
+	"waitv",
+	"lock-pi",
+	"requeue",
+	"hash",
+};
+
+static const char *stress_futex_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_futex_methods)) ? stress_futex_methods[i] : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_futex_method,  "futex-method",  TYPE_ID_SIZE_T_METHOD, 0, 0, stress_futex_method },
+	{ OPT_futex_waiters, "futex-waiters", TYPE_ID_UINT32, MIN_FUTEX_WAITERS, MAX_FUTEX_WAITERS, NULL },
+	END_OPT,
 };
 
 #if defined(HAVE_LINUX_FUTEX_H) &&	\
@@ -88,21 +123,18 @@ static int stress_futex_wait(uint32_t *futex, const int val, const long int nsec
 }
 
 /*
- *  stress_futex()
+ *  stress_futex_wait_wake()
  *	stress system by futex calls. The intention is not to
  * 	efficiently use futex, but to stress the futex system call
  *	by rapidly calling it on wait and wakes
  */
-static int stress_futex(stress_args_t *args)
+static int stress_futex_wait_wake(stress_args_t *args)
 {
 	uint64_t *timeout = &g_shared->futex.timeout[args->instance];
 	uint32_t *futex = &g_shared->futex.futex[args->instance];
 	pid_t pid;
 	int parent_cpu, rc = EXIT_SUCCESS;
 
-	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
-	stress_sync_start_wait(args);
-	stress_set_proc_state(args->name, STRESS_STATE_RUN);
 again:
 	parent_cpu = stress_get_cpu();
 	pid = fork();
@@ -189,10 +221,810 @@ finish:
 	return rc;
 }
 
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_SYSCALL) &&			\
+    defined(FUTEX_PRIVATE_FLAG) &&		\
+    defined(HAVE_CLOCK_GETTIME) &&		\
+    defined(CLOCK_MONOTONIC) &&			\
+    defined(HAVE_ATOMIC_COMPARE_EXCHANGE) &&	\
+    defined(HAVE_ATOMIC_ADD_FETCH) &&		\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+
+#define HAVE_FUTEX_THREADS
+
+#define FUTEX_SLICE_NS		(100000000ULL)	/* 0.1 seconds per configuration */
+#define FUTEX_WAIT_NS		(100000000L)	/* futex wait timeout to check for stop */
+#define FUTEX_WAITV_NR		(8)		/* futexes per futex_waitv waiter */
+#define FUTEX_HASH_WORDS	(1U << 20)	/* distinct futexes for hash method */
+#define FUTEX_HASH_IDLE		(4)		/* wakes on futexes without waiters, per waiter */
+#define FUTEX_PI_SPINS		(64)		/* work in and out of the PI lock */
+
+struct stress_futex_context;
+
+/*
+ *  waiter thread, or lock contender for the lock-pi method
+ */
+typedef struct {
+	uint32_t words[FUTEX_WAITV_NR] ALIGN64;	/* waitv futexes bumped by the waker */
+	uint32_t seen[FUTEX_WAITV_NR];		/* waitv futex values last seen */
+	uint32_t *word;				/* hash futex being waited on */
+	uint32_t which;				/* waitv futex the waker bumped */
+	uint64_t stamp;				/* time of the wake (ns) */
+	struct stress_futex_context *ctx;
+	pthread_t pthread;
+	uint32_t index;
+	uint32_t rnd;
+	uint64_t ops;				/* wakes or lock acquisitions */
+	uint64_t latency;			/* total wake latency (ns) */
+	uint64_t wakeups;			/* wakes with a latency measurement */
+} stress_futex_waiter_t;
+
+typedef struct stress_futex_context {
+	uint32_t acks ALIGN64;			/* waiters ready for the next wake */
+	uint32_t lock ALIGN64;			/* PI lock, requeue mutex */
+	uint32_t cond ALIGN64;			/* requeue condition variable */
+	uint64_t stamp;				/* PI unlock, requeue broadcast time (ns) */
+	uint64_t locked;			/* PI critical section entries */
+	stress_args_t *args;
+	stress_futex_waiter_t *waiters;
+	uint32_t n_waiters;
+	uint32_t *pool;				/* hash method futexes */
+	bool go;				/* start running */
+	bool stop;				/* stop running */
+	bool failed;				/* verification failure */
+} stress_futex_context_t;
+
+/*
+ *  accumulated results for a method and number of waiters
+ */
+typedef struct {
+	size_t method;
+	uint32_t n_waiters;
+	bool skipped;
+	double duration;
+	uint64_t ops;
+	uint64_t latency;
+	uint64_t wakeups;
+} stress_futex_result_t;
+
+static inline uint64_t stress_futex_now(void)
+{
+	struct timespec ts;
+
+	if (UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) < 0))
+		return (uint64_t)(stress_time_now() * STRESS_DBL_NANOSECOND);
+	return ((uint64_t)ts.tv_sec * STRESS_NANOSECOND) + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ *  stress_futex_private()
+ *	process private futex operation, the threads share one mm
+ */
+static inline long int stress_futex_private(
+	uint32_t *uaddr,
+	const int op,
+	const uint32_t val,
+	const struct timespec *timeout,
+	uint32_t *uaddr2,
+	const uint32_t val3)
+{
+	return syscall(__NR_futex, uaddr, op | FUTEX_PRIVATE_FLAG, val, timeout, uaddr2, val3);
+}
+
+static inline long int stress_futex_private_wait(uint32_t *uaddr, const uint32_t val)
+{
+	struct timespec timeout;
+
+	timeout.tv_sec = 0;
+	timeout.tv_nsec = FUTEX_WAIT_NS;
+	return stress_futex_private(uaddr, FUTEX_WAIT, val, &timeout, NULL, 0);
+}
+
+static inline bool stress_futex_stopped(const stress_futex_context_t *ctx)
+{
+	return __atomic_load_n(&ctx->stop, __ATOMIC_SEQ_CST);
+}
+
+static inline void stress_futex_fail(stress_futex_context_t *ctx)
+{
+	__atomic_store_n(&ctx->failed, true, __ATOMIC_RELAXED);
+}
+
+/*
+ *  stress_futex_ready()
+ *	waiter is ready for the next wake, the last one tells the waker
+ */
+static inline void stress_futex_ready(stress_futex_context_t *ctx)
+{
+	if (__atomic_add_fetch(&ctx->acks, 1, __ATOMIC_ACQ_REL) == ctx->n_waiters)
+		(void)stress_futex_private(&ctx->acks, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/*
+ *  stress_futex_wait_ready()
+ *	waker waits for all the waiters to be ready, false if stopped
+ */
+static bool stress_futex_wait_ready(stress_futex_context_t *ctx)
+{
+	uint32_t acks;
+
+	while ((acks = __atomic_load_n(&ctx->acks, __ATOMIC_ACQUIRE)) < ctx->n_waiters) {
+		if (stress_futex_stopped(ctx) || UNLIKELY(!stress_continue_flag()))
+			return false;
+		(void)stress_futex_private_wait(&ctx->acks, acks);
+	}
+	__atomic_store_n(&ctx->acks, 0, __ATOMIC_RELEASE);
+	return true;
+}
+
+static inline void stress_futex_latency(stress_futex_waiter_t *waiter, const uint64_t stamp)
+{
+	const uint64_t now = stress_futex_now();
+
+	if (now > stamp)
+		waiter->latency += now - stamp;
+	waiter->wakeups++;
+}
+
+static inline uint32_t stress_futex_rnd(stress_futex_waiter_t *waiter)
+{
+	waiter->rnd = (waiter->rnd * 1103515245U) + 12345U;
+	return waiter->rnd >> 8;
+}
+
+static void stress_futex_go(const stress_futex_context_t *ctx)
+{
+	while (!__atomic_load_n(&ctx->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+}
+
+#if defined(FUTEX_32) &&	\
+    defined(__NR_futex_waitv)
+/*
+ *  stress_futex_waitv_waiter()
+ *	wait on a vector of futexes with futex_waitv, the waker bumps
+ *	and wakes one of them at random
+ */
+static void *stress_futex_waitv_waiter(void *arg)
+{
+	stress_futex_waiter_t *waiter = (stress_futex_waiter_t *)arg;
+	stress_futex_context_t *ctx = waiter->ctx;
+	struct shim_futex_waitv waitv[FUTEX_WAITV_NR];
+	size_t i;
+
+	(void)shim_memset(waitv, 0, sizeof(waitv));
+	for (i = 0; i < FUTEX_WAITV_NR; i++) {
+		waiter->seen[i] = __atomic_load_n(&waiter->words[i], __ATOMIC_ACQUIRE);
+		waitv[i].uaddr = (uint64_t)(uintptr_t)&waiter->words[i];
+		waitv[i].flags = FUTEX_32 | FUTEX_PRIVATE_FLAG;
+	}
+	stress_futex_go(ctx);
+	stress_futex_ready(ctx);
+
+	while (!stress_futex_stopped(ctx)) {
+		int ret, changed = -1;
+
+		for (i = 0; i < FUTEX_WAITV_NR; i++)
+			waitv[i].val = waiter->seen[i];
+		ret = shim_futex_waitv(waitv, FUTEX_WAITV_NR, 0, NULL, CLOCK_MONOTONIC);
+		for (i = 0; i < FUTEX_WAITV_NR; i++) {
+			const uint32_t val = __atomic_load_n(&waiter->words[i], __ATOMIC_ACQUIRE);
+
+			if (val != waiter->seen[i]) {
+				waiter->seen[i] = val;
+				changed = (int)i;
+			}
+		}
+		if (changed < 0)
+			continue;	/* interrupted or spurious wake */
+		if (stress_futex_stopped(ctx))
+			break;
+		stress_futex_latency(waiter, waiter->stamp);
+		if ((changed != (int)waiter->which) || ((ret >= 0) && (ret != changed))) {
+			pr_fail("%s: futex_waitv woke on futex %d, expected futex %" PRIu32 "\n",
+				ctx->args->name, (ret >= 0) ? ret : changed, waiter->which);
+			stress_futex_fail(ctx);
+		}
+		waiter->ops++;
+		stress_futex_ready(ctx);
+	}
+	return &g_nowt;
+}
+
+static void stress_futex_waitv_wake(stress_futex_context_t *ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < ctx->n_waiters; i++) {
+		stress_futex_waiter_t *waiter = &ctx->waiters[i];
+		const uint32_t which = stress_futex_rnd(waiter) % FUTEX_WAITV_NR;
+
+		waiter->which = which;
+		waiter->stamp = stress_futex_now();
+		(void)__atomic_add_fetch(&waiter->words[which], 1, __ATOMIC_RELEASE);
+		(void)stress_futex_private(&waiter->words[which], FUTEX_WAKE, 1, NULL, NULL, 0);
+	}
+}
+
+static void stress_futex_waitv_stop(stress_futex_context_t *ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < ctx->n_waiters; i++) {
+		stress_futex_waiter_t *waiter = &ctx->waiters[i];
+
+		(void)__atomic_add_fetch(&waiter->words[0], 1, __ATOMIC_RELEASE);
+		(void)stress_futex_private(&waiter->words[0], FUTEX_WAKE, 1, NULL, NULL, 0);
+	}
+}
+
+static bool stress_futex_waitv_supported(void)
+{
+	struct shim_futex_waitv waitv;
+	uint32_t word = 0;
+
+	(void)shim_memset(&waitv, 0, sizeof(waitv));
+	waitv.val = 1;
+	waitv.uaddr = (uint64_t)(uintptr_t)&word;
+	waitv.flags = FUTEX_32 | FUTEX_PRIVATE_FLAG;
+
+	/* value mismatch, a kernel with futex_waitv returns EAGAIN */
+	return !((shim_futex_waitv(&waitv, 1, 0, NULL, CLOCK_MONOTONIC) < 0) && (errno == ENOSYS));
+}
+#endif
+
+#if defined(FUTEX_LOCK_PI) &&	\
+    defined(FUTEX_UNLOCK_PI) &&	\
+    defined(FUTEX_TID_MASK)
+static inline void stress_futex_pi_spin(stress_futex_waiter_t *waiter)
+{
+	int i;
+
+	for (i = 0; i < FUTEX_PI_SPINS; i++)
+		stress_uint32_put(stress_futex_rnd(waiter));
+}
+
+/*
+ *  stress_futex_pi_waiter()
+ *	contend on a priority inheritance futex lock, the uncontended
+ *	lock and unlock are done in user space with the owner's TID
+ */
+static void *stress_futex_pi_waiter(void *arg)
+{
+	stress_futex_waiter_t *waiter = (stress_futex_waiter_t *)arg;
+	stress_futex_context_t *ctx = waiter->ctx;
+	const uint32_t tid = (uint32_t)shim_gettid();
+
+	stress_futex_go(ctx);
+
+	while (!stress_futex_stopped(ctx)) {
+		uint32_t expected = 0;
+		bool slow = false;
+
+		if (!__atomic_compare_exchange_n(&ctx->lock, &expected, tid,
+				false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			if (stress_futex_private(&ctx->lock, FUTEX_LOCK_PI, 0, NULL, NULL, 0) < 0) {
+				if ((errno == EINTR) || (errno == EAGAIN))
+					continue;
+				pr_fail("%s: futex FUTEX_LOCK_PI failed, errno=%d (%s)\n",
+					ctx->args->name, errno, strerror(errno));
+				stress_futex_fail(ctx);
+				break;
+			}
+			slow = true;
+		}
+
+		/* critical section */
+		if ((__atomic_load_n(&ctx->lock, __ATOMIC_RELAXED) & FUTEX_TID_MASK) != tid) {
+			pr_fail("%s: PI futex lock owner is TID %" PRIu32 ", expected TID %" PRIu32 "\n",
+				ctx->args->name, ctx->lock & FUTEX_TID_MASK, tid);
+			stress_futex_fail(ctx);
+		}
+		if (slow)
+			stress_futex_latency(waiter, ctx->stamp);
+		ctx->locked++;
+		waiter->ops++;
+		stress_futex_pi_spin(waiter);
+		ctx->stamp = stress_futex_now();
+
+		expected = tid;
+		if (!__atomic_compare_exchange_n(&ctx->lock, &expected, 0,
+				false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			/* FUTEX_WAITERS is set, the kernel hands over the lock */
+			if (stress_futex_private(&ctx->lock, FUTEX_UNLOCK_PI, 0, NULL, NULL, 0) < 0) {
+				pr_fail("%s: futex FUTEX_UNLOCK_PI failed, errno=%d (%s)\n",
+					ctx->args->name, errno, strerror(errno));
+				stress_futex_fail(ctx);
+				break;
+			}
+		}
+		stress_futex_pi_spin(waiter);
+	}
+	return &g_nowt;
+}
+
+static bool stress_futex_pi_supported(void)
+{
+	uint32_t word = 0;
+
+	/* lock a free lock in the kernel, then unlock it */
+	if (stress_futex_private(&word, FUTEX_LOCK_PI, 0, NULL, NULL, 0) < 0)
+		return false;
+	(void)stress_futex_private(&word, FUTEX_UNLOCK_PI, 0, NULL, NULL, 0);
+	return true;
+}
+#endif
+
+#if defined(FUTEX_CMP_REQUEUE)
+/*
+ *  stress_futex_mutex_lock()
+ *	lock a three state mutex (0 free, 1 locked, 2 contended), always
+ *	marking it contended as a waiter woken from a condition variable
+ *	does so that the unlock wakes the next requeued waiter
+ */
+static inline void stress_futex_mutex_lock(uint32_t *mutex)
+{
+	while (__atomic_exchange_n(mutex, 2, __ATOMIC_ACQUIRE) != 0)
+		(void)stress_futex_private(mutex, FUTEX_WAIT, 2, NULL, NULL, 0);
+}
+
+static inline void stress_futex_mutex_unlock(uint32_t *mutex)
+{
+	if (__atomic_exchange_n(mutex, 0, __ATOMIC_RELEASE) == 2)
+		(void)stress_futex_private(mutex, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/*
+ *  stress_futex_requeue_waiter()
+ *	condition variable waiter, woken by a broadcast that wakes one
+ *	waiter and requeues the rest onto the mutex
+ */
+static void *stress_futex_requeue_waiter(void *arg)
+{
+	stress_futex_waiter_t *waiter = (stress_futex_waiter_t *)arg;
+	stress_futex_context_t *ctx = waiter->ctx;
+	uint32_t seq = 0;
+
+	stress_futex_go(ctx);
+	stress_futex_ready(ctx);
+
+	for (;;) {
+		uint32_t cond;
+
+		while ((cond = __atomic_load_n(&ctx->cond, __ATOMIC_ACQUIRE)) == seq) {
+			if (stress_futex_stopped(ctx))
+				return &g_nowt;
+			(void)stress_futex_private_wait(&ctx->cond, seq);
+		}
+		seq = cond;
+
+		/* no stop checks until the mutex is unlocked to keep the wake chain going */
+		stress_futex_mutex_lock(&ctx->lock);
+		stress_futex_latency(waiter, ctx->stamp);
+		waiter->ops++;
+		stress_futex_mutex_unlock(&ctx->lock);
+
+		if (stress_futex_stopped(ctx))
+			break;
+		stress_futex_ready(ctx);
+	}
+	return &g_nowt;
+}
+
+static void stress_futex_requeue_wake(stress_futex_context_t *ctx)
+{
+	uint32_t cond;
+
+	ctx->stamp = stress_futex_now();
+	cond = __atomic_add_fetch(&ctx->cond, 1, __ATOMIC_ACQ_REL);
+	/* wake one waiter, requeue the rest onto the mutex */
+	if (stress_futex_private(&ctx->cond, FUTEX_CMP_REQUEUE, 1,
+			(const struct timespec *)(uintptr_t)INT_MAX, &ctx->lock, cond) < 0) {
+		if ((errno != EAGAIN) && (errno != EINTR)) {
+			pr_fail("%s: futex FUTEX_CMP_REQUEUE failed, errno=%d (%s)\n",
+				ctx->args->name, errno, strerror(errno));
+			stress_futex_fail(ctx);
+		}
+	}
+}
+
+static void stress_futex_requeue_stop(stress_futex_context_t *ctx)
+{
+	(void)__atomic_add_fetch(&ctx->cond, 1, __ATOMIC_ACQ_REL);
+	(void)stress_futex_private(&ctx->cond, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
+/*
+ *  stress_futex_hash_waiter()
+ *	wait on a different futex from a large pool each time to
+ *	put pressure on the futex hash table
+ */
+static void *stress_futex_hash_waiter(void *arg)
+{
+	stress_futex_waiter_t *waiter = (stress_futex_waiter_t *)arg;
+	stress_futex_context_t *ctx = waiter->ctx;
+	const uint32_t stride = FUTEX_HASH_WORDS / ctx->n_waiters;
+
+	stress_futex_go(ctx);
+
+	while (!stress_futex_stopped(ctx)) {
+		/* distinct from the futexes of the other waiters */
+		uint32_t *word = &ctx->pool[((stress_futex_rnd(waiter) % stride) * ctx->n_waiters) + waiter->index];
+		const uint32_t val = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+
+		__atomic_store_n(&waiter->word, word, __ATOMIC_SEQ_CST);
+		stress_futex_ready(ctx);
+
+		while (__atomic_load_n(word, __ATOMIC_ACQUIRE) == val) {
+			if (stress_futex_stopped(ctx))
+				return &g_nowt;
+			(void)stress_futex_private_wait(word, val);
+		}
+		if (stress_futex_stopped(ctx))
+			break;
+		stress_futex_latency(waiter, waiter->stamp);
+		waiter->ops++;
+	}
+	return &g_nowt;
+}
+
+static void stress_futex_hash_wake(stress_futex_context_t *ctx)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < ctx->n_waiters; i++) {
+		stress_futex_waiter_t *waiter = &ctx->waiters[i];
+		uint32_t *word = __atomic_load_n(&waiter->word, __ATOMIC_SEQ_CST);
+
+		waiter->stamp = stress_futex_now();
+		(void)__atomic_add_fetch(word, 1, __ATOMIC_RELEASE);
+		(void)stress_futex_private(word, FUTEX_WAKE, 1, NULL, NULL, 0);
+
+		/* hash lookups of futexes with no waiters */
+		for (j = 0; j < FUTEX_HASH_IDLE; j++)
+			(void)stress_futex_private(&ctx->pool[stress_mwc32modn(FUTEX_HASH_WORDS)],
+				FUTEX_WAKE, 1, NULL, NULL, 0);
+	}
+}
+
+static void stress_futex_hash_stop(stress_futex_context_t *ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < ctx->n_waiters; i++) {
+		uint32_t *word = __atomic_load_n(&ctx->waiters[i].word, __ATOMIC_SEQ_CST);
+
+		if (word) {
+			(void)__atomic_add_fetch(word, 1, __ATOMIC_RELEASE);
+			(void)stress_futex_private(word, FUTEX_WAKE, 1, NULL, NULL, 0);
+		}
+	}
+}
+
+typedef struct {
+	size_t method;
+	void *(*waiter)(void *arg);
+	void (*wake)(stress_futex_context_t *ctx);	/* NULL, no waker */
+	void (*stop)(stress_futex_context_t *ctx);
+} stress_futex_threaded_t;
+
+static const stress_futex_threaded_t stress_futex_threaded[] = {
+#if defined(FUTEX_32) &&	\
+    defined(__NR_futex_waitv)
+	{ FUTEX_METHOD_WAITV,	stress_futex_waitv_waiter, stress_futex_waitv_wake, stress_futex_waitv_stop },
+#endif
+#if defined(FUTEX_LOCK_PI) &&	\
+    defined(FUTEX_UNLOCK_PI) &&	\
+    defined(FUTEX_TID_MASK)
+	{ FUTEX_METHOD_LOCK_PI,	stress_futex_pi_waiter, NULL, NULL },
+#endif
+#if defined(FUTEX_CMP_REQUEUE)
+	{ FUTEX_METHOD_REQUEUE,	stress_futex_requeue_waiter, stress_futex_requeue_wake, stress_futex_requeue_stop },
+#endif
+	{ FUTEX_METHOD_HASH,	stress_futex_hash_waiter, stress_futex_hash_wake, stress_futex_hash_stop },
+};
+
+static const stress_futex_threaded_t *stress_futex_threaded_find(const size_t method)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(stress_futex_threaded); i++) {
+		if (stress_futex_threaded[i].method == method)
+			return &stress_futex_threaded[i];
+	}
+	return NULL;
+}
+
+/*
+ *  stress_futex_supported()
+ *	check the kernel supports a method
+ */
+static bool stress_futex_supported(const size_t method)
+{
+	if (!stress_futex_threaded_find(method))
+		return false;
+	switch (method) {
+#if defined(FUTEX_32) &&	\
+    defined(__NR_futex_waitv)
+	case FUTEX_METHOD_WAITV:
+		return stress_futex_waitv_supported();
+#endif
+#if defined(FUTEX_LOCK_PI) &&	\
+    defined(FUTEX_UNLOCK_PI) &&	\
+    defined(FUTEX_TID_MASK)
+	case FUTEX_METHOD_LOCK_PI:
+		return stress_futex_pi_supported();
+#endif
+	default:
+		break;
+	}
+	return true;
+}
+
+/*
+ *  stress_futex_run()
+ *	run a method with a number of waiter threads for a time slice
+ */
+static int stress_futex_run(
+	stress_args_t *args,
+	stress_futex_context_t *ctx,
+	stress_futex_result_t *result)
+{
+	const stress_futex_threaded_t *threaded = stress_futex_threaded_find(result->method);
+	const uint32_t n = result->n_waiters;
+	uint64_t ops = 0;
+	uint32_t i, created;
+	double t;
+
+	ctx->n_waiters = n;
+	ctx->acks = 0;
+	ctx->lock = 0;
+	ctx->cond = 0;
+	ctx->stamp = stress_futex_now();
+	ctx->locked = 0;
+	ctx->go = false;
+	ctx->stop = false;
+	for (i = 0; i < n; i++) {
+		stress_futex_waiter_t *waiter = &ctx->waiters[i];
+
+		(void)shim_memset(waiter, 0, sizeof(*waiter));
+		waiter->ctx = ctx;
+		waiter->index = i;
+		waiter->rnd = stress_mwc32();
+	}
+	for (created = 0; created < n; created++) {
+		if (pthread_create(&ctx->waiters[created].pthread, NULL,
+				threaded->waiter, (void *)&ctx->waiters[created]) != 0)
+			break;
+	}
+	if (created < n) {
+		pr_dbg("%s: cannot create %" PRIu32 " threads, skipping %s with %" PRIu32 " waiters\n",
+			args->name, n, stress_futex_methods[result->method], n);
+		result->skipped = true;
+		/* waiters of a partial pool are told to stop, none are waiting on the waker */
+		ctx->n_waiters = created;
+	}
+
+	t = stress_time_now();
+	__atomic_store_n(&ctx->go, true, __ATOMIC_RELEASE);
+	if (!result->skipped) {
+		const uint64_t t_end = stress_futex_now() + FUTEX_SLICE_NS;
+
+		if (threaded->wake) {
+			while ((stress_futex_now() < t_end) && stress_futex_wait_ready(ctx))
+				threaded->wake(ctx);
+		} else {
+			while ((stress_futex_now() < t_end) && stress_continue_flag())
+				(void)shim_usleep(10000);
+		}
+	}
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_SEQ_CST);
+	t = stress_time_now() - t;
+	if (threaded->stop)
+		threaded->stop(ctx);
+	for (i = 0; i < created; i++)
+		VOID_RET(int, pthread_join(ctx->waiters[i].pthread, NULL));
+
+	if (result->skipped)
+		return 0;
+	for (i = 0; i < n; i++) {
+		ops += ctx->waiters[i].ops;
+		result->latency += ctx->waiters[i].latency;
+		result->wakeups += ctx->waiters[i].wakeups;
+	}
+	if ((result->method == FUTEX_METHOD_LOCK_PI) && (ctx->locked != ops)) {
+		pr_fail("%s: PI futex lock was acquired %" PRIu64 " times, critical section was "
+			"entered %" PRIu64 " times\n", args->name, ops, ctx->locked);
+		ctx->failed = true;
+	}
+	result->ops += ops;
+	result->duration += t;
+	stress_bogo_add(args, ops);
+	return ctx->failed ? -1 : 0;
+}
+
+/*
+ *  stress_futex_metrics()
+ *	operations per second and mean wake latency for each method
+ *	and number of waiters
+ */
+static void stress_futex_metrics(
+	stress_args_t *args,
+	const stress_futex_result_t *results,
+	const size_t n_results)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_futex_result_t *r = &results[i];
+		const char *name = stress_futex_methods[r->method];
+		const double rate = (r->duration > 0.0) ? (double)r->ops / r->duration : 0.0;
+		const double latency = (r->wakeups > 0) ? ((double)r->latency / (double)r->wakeups) / 1000.0 : 0.0;
+		char msg[64];
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-8s %4" PRIu32 " waiters %12.0f ops/sec, %10.2f usec mean wake latency "
+				"(%" PRIu64 " wakes)\n", args->name, name, r->n_waiters, rate,
+				latency, r->wakeups);
+
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 " waiters ops/sec", name, r->n_waiters);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+		if (r->wakeups > 0) {
+			(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 " waiters usec wake latency", name, r->n_waiters);
+			stress_metrics_set(args, idx++, msg, latency, STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_futex_threads()
+ *	exercise futex_waitv, PI locks, condition variable requeue and
+ *	futex hashing with waiter threads, sweeping the number of
+ *	waiters in powers of 2 up to the maximum
+ */
+static int stress_futex_threads(stress_args_t *args, const size_t futex_method)
+{
+	uint32_t futex_waiters = DEFAULT_FUTEX_WAITERS;
+	uint32_t levels[16], n_levels = 0, n;
+	size_t method, n_results = 0, i, waiters_size, pool_size;
+	stress_futex_result_t *results = NULL;
+	stress_futex_context_t ctx;
+	int rc = EXIT_SUCCESS;
+
+	if (!stress_get_setting("futex-waiters", &futex_waiters)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			futex_waiters = MAX_FUTEX_WAITERS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			futex_waiters = MIN_FUTEX_WAITERS;
+	}
+	for (n = 1; n < futex_waiters; n <<= 1)
+		levels[n_levels++] = n;
+	levels[n_levels++] = futex_waiters;
+
+	(void)shim_memset(&ctx, 0, sizeof(ctx));
+	ctx.args = args;
+	waiters_size = (size_t)futex_waiters * sizeof(*ctx.waiters);
+	ctx.waiters = (stress_futex_waiter_t *)stress_mmap_populate(NULL, waiters_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ctx.waiters == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for %" PRIu32 " waiters%s, skipping stressor\n",
+			args->name, waiters_size, futex_waiters, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(ctx.waiters, waiters_size, "futex-waiters");
+	pool_size = FUTEX_HASH_WORDS * sizeof(*ctx.pool);
+	ctx.pool = (uint32_t *)stress_mmap_populate(NULL, pool_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ctx.pool == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for futex hash pool%s, skipping stressor\n",
+			args->name, pool_size, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto unmap_waiters;
+	}
+	stress_set_vma_anon_name(ctx.pool, pool_size, "futex-hash-pool");
+
+	results = (stress_futex_result_t *)calloc(SIZEOF_ARRAY(stress_futex_methods) * n_levels, sizeof(*results));
+	if (!results) {
+		pr_inf_skip("%s: cannot allocate result table%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto unmap_pool;
+	}
+	for (method = FUTEX_METHOD_WAITV; method < SIZEOF_ARRAY(stress_futex_methods); method++) {
+		if ((futex_method != FUTEX_METHOD_ALL) && (futex_method != method))
+			continue;
+		if (!stress_futex_supported(method)) {
+			if (stress_instance_zero(args))
+				pr_inf("%s: futex method '%s' is not supported, skipping it\n",
+					args->name, stress_futex_methods[method]);
+			continue;
+		}
+		for (n = 0; n < n_levels; n++) {
+			results[n_results].method = method;
+			results[n_results].n_waiters = levels[n];
+			n_results++;
+		}
+	}
+	if (n_results == 0) {
+		pr_inf_skip("%s: no supported futex methods, skipping stressor\n", args->name);
+		rc = EXIT_NOT_IMPLEMENTED;
+		goto free_results;
+	}
+
+	i = 0;
+	do {
+		bool runnable = false;
+		size_t j;
+
+		if (!results[i].skipped &&
+		    (stress_futex_run(args, &ctx, &results[i]) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		for (j = 0; j < n_results; j++)
+			runnable |= !results[j].skipped;
+		if (!runnable)
+			break;
+		i = (i + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_futex_metrics(args, results, n_results);
+
+free_results:
+	free(results);
+unmap_pool:
+	(void)munmap((void *)ctx.pool, pool_size);
+unmap_waiters:
+	(void)munmap((void *)ctx.waiters, waiters_size);
+	return rc;
+}
+#endif
+
+/*
+ *  stress_futex()
+ *	exercise futex wait and wake between two processes or, for
+ *	the other methods, between threads
+ */
+static int stress_futex(stress_args_t *args)
+{
+	size_t futex_method = FUTEX_METHOD_WAKE;
+	int rc;
+
+	(void)stress_get_setting("futex-method", &futex_method);
+#if !defined(HAVE_FUTEX_THREADS)
+	if (futex_method != FUTEX_METHOD_WAKE) {
+		if (stress_instance_zero(args))
+			pr_inf("%s: futex method '%s' is not supported, using 'wake'\n",
+				args->name, stress_futex_methods[futex_method]);
+		futex_method = FUTEX_METHOD_WAKE;
+	}
+#endif
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+#if defined(HAVE_FUTEX_THREADS)
+	if (futex_method != FUTEX_METHOD_WAKE) {
+		rc = stress_futex_threads(args, futex_method);
+		stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+		return rc;
+	}
+#endif
+	rc = stress_futex_wait_wake(args);
+	return rc;
+}
+
 const stressor_info_t stress_futex_info = {
 	.stressor = stress_futex,
 	.classifier = CLASS_SCHEDULER | CLASS_OS | CLASS_IPC,
 	.verify = VERIFY_OPTIONAL,
+	.opts = opts,
 	.help = help
 };
 #else
@@ -200,6 +1032,7 @@ const stressor_info_t stress_futex_info = {
 	.stressor = stress_unimplemented,
 	.classifier = CLASS_SCHEDULER | CLASS_OS | CLASS_IPC,
 	.verify = VERIFY_OPTIONAL,
+	.opts = opts,
 	.help = help,
 	.unimplemented_reason = "built without linux/futex.h or futex() system call"
 };
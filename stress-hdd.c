@@ -22,6 +22,13 @@
 #include "core-builtin.h"
 #include "core-pragma.h"
 #include "core-target-clones.h"
+#include "core-vmstat.h"
+
+#include <sys/ioctl.h>
+
+#if defined(HAVE_SYS_MOUNT_H)
+#include <sys/mount.h>
+#endif
 
 #if defined(HAVE_SYS_UIO_H)
 #include <sys/uio.h>
@@ -42,6 +49,11 @@
 #define BUF_ALIGNMENT		(4096)
 #define HDD_IO_VEC_MAX		(16)		/* Must be power of 2 */
 
+#define HDD_DIO_MIN_SIZE	(512)		/* Smallest direct I/O sweep size */
+#define HDD_DIO_MAX_SIZE	(1 * MB)	/* Largest direct I/O sweep size */
+#define HDD_DIO_MAX_SIZES	(16)		/* Sizes in the direct I/O sweep */
+#define HDD_DIO_STEP_BYTES	(16 * MB)	/* Bytes per direct I/O sweep step */
+
 /* Write and read stress modes */
 #define HDD_OPT_WR_SEQ		(0x00000001)
 #define HDD_OPT_WR_RND		(0x00000002)
@@ -83,6 +95,7 @@ typedef struct {
 static const stress_help_t help[] = {
 	{ "d N","hdd N",		"start N workers spinning on write()/unlink()" },
 	{ NULL,	"hdd-bytes N",		"write N bytes per hdd worker (default is 1GB)" },
+	{ NULL,	"hdd-dio-sweep",	"sweep O_DIRECT I/O sizes and alignments" },
 	{ NULL,	"hdd-ops N",		"stop after N hdd bogo operations" },
 	{ NULL,	"hdd-opts list",	"specify list of various stressor options" },
 	{ NULL,	"hdd-write-size N",	"set the default write size to N bytes" },
@@ -647,6 +660,340 @@ static void OPTIMIZE3 TARGET_CLONES hdd_fill_buf(
 	}
 }
 
+#if defined(O_DIRECT)
+/*
+ *  per I/O size direct I/O sweep results
+ */
+typedef struct {
+	size_t size;			/* I/O request size */
+	double write_bytes;		/* total bytes written */
+	double write_duration;		/* total time writing */
+	double read_bytes;		/* total bytes read */
+	double read_duration;		/* total time reading */
+} stress_hdd_dio_size_t;
+
+/*
+ *  stress_hdd_dio_detect()
+ *	discover the direct I/O memory and offset alignment using
+ *	statx STATX_DIOALIGN and the logical and physical block sizes
+ *	of the device backing the temp path
+ */
+static void stress_hdd_dio_detect(
+	stress_args_t *args,
+	const char *filename,
+	uint32_t *mem_align,
+	uint32_t *offset_align,
+	uint32_t *lbs,
+	uint32_t *pbs)
+{
+	char *devpath;
+
+	*mem_align = 0;
+	*offset_align = 0;
+	*lbs = 0;
+	*pbs = 0;
+
+#if defined(STATX_DIOALIGN)
+	{
+		shim_statx_t stx;
+
+		if ((shim_statx(AT_FDCWD, filename, 0, STATX_DIOALIGN, &stx) == 0) &&
+		    (stx.stx_mask & STATX_DIOALIGN)) {
+			*mem_align = stx.stx_dio_mem_align;
+			*offset_align = stx.stx_dio_offset_align;
+		}
+	}
+#else
+	(void)filename;
+#endif
+
+	devpath = stress_find_mount_dev(stress_get_temp_path());
+	if (devpath) {
+		const int fd = open(devpath, O_RDONLY | O_NONBLOCK);
+
+		if (fd >= 0) {
+#if defined(BLKSSZGET)
+			int sz = 0;
+
+			if ((ioctl(fd, BLKSSZGET, &sz) == 0) && (sz > 0))
+				*lbs = (uint32_t)sz;
+#endif
+#if defined(BLKPBSZGET)
+			{
+				unsigned int psz = 0;
+
+				if ((ioctl(fd, BLKPBSZGET, &psz) == 0) && (psz > 0))
+					*pbs = (uint32_t)psz;
+			}
+#endif
+			(void)close(fd);
+		}
+	}
+
+	/* Fallbacks, the logical block size is the classic O_DIRECT rule */
+	if (*lbs == 0)
+		*lbs = (*offset_align) ? *offset_align : HDD_DIO_MIN_SIZE;
+	if (*pbs == 0)
+		*pbs = *lbs;
+	if (*offset_align == 0)
+		*offset_align = *lbs;
+	if (*mem_align == 0)
+		*mem_align = *lbs;
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: direct I/O memory alignment %" PRIu32 ", offset alignment %" PRIu32
+			", logical block size %" PRIu32 ", physical block size %" PRIu32 "\n",
+			args->name, *mem_align, *offset_align, *lbs, *pbs);
+}
+
+/*
+ *  stress_hdd_dio_probe()
+ *	write len bytes from buf at offset with O_DIRECT, returns
+ *	0 if direct I/O was used, 1 if the kernel fell back to buffered
+ *	I/O (the written pages are left in the page cache) or -errno
+ */
+static int stress_hdd_dio_probe(
+	const int fd,
+	const uint8_t *buf,
+	const size_t len,
+	const off_t offset,
+	const size_t page_size)
+{
+	const off_t page_offset = offset & ~(off_t)(page_size - 1);
+	const size_t map_len = (size_t)(offset - page_offset) + len;
+	unsigned char vec[16];
+	void *ptr;
+	size_t i, pages;
+	ssize_t ret;
+
+#if defined(HAVE_POSIX_FADVISE) &&	\
+    defined(POSIX_FADV_DONTNEED)
+	(void)posix_fadvise(fd, page_offset, (off_t)map_len, POSIX_FADV_DONTNEED);
+#endif
+	ret = pwrite(fd, buf, len, offset);
+	if (ret < 0)
+		return -errno;
+
+#if defined(HAVE_MINCORE)
+	ptr = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd, page_offset);
+	if (ptr == MAP_FAILED)
+		return 0;
+	pages = (map_len + page_size - 1) / page_size;
+	if (pages > SIZEOF_ARRAY(vec))
+		pages = SIZEOF_ARRAY(vec);
+	(void)shim_memset(vec, 0, sizeof(vec));
+	ret = (ssize_t)shim_mincore(ptr, pages * page_size, vec);
+	(void)munmap(ptr, map_len);
+	if (ret == 0) {
+		for (i = 0; i < pages; i++) {
+			if (vec[i] & 1)
+				return 1;
+		}
+	}
+#else
+	(void)ptr;
+	(void)i;
+	(void)pages;
+	(void)vec;
+	(void)page_size;
+#endif
+	return 0;
+}
+
+/*
+ *  stress_hdd_dio_align()
+ *	find the smallest offset (or memory) alignment that is
+ *	accepted with true direct I/O, report where misalignment
+ *	results in EINVAL or a buffered I/O fallback
+ */
+static uint32_t stress_hdd_dio_align(
+	stress_args_t *args,
+	const int fd,
+	uint8_t *buf,
+	const size_t len,
+	const bool offset_probe,
+	bool *fallback)
+{
+	uint32_t align, best = 0;
+	const off_t base = (off_t)(2 * HDD_DIO_MAX_SIZE);
+	bool page_cache_backed;
+
+	/*
+	 *  File systems such as tmpfs keep the data in the page cache
+	 *  even with O_DIRECT, so page residency after a fully aligned
+	 *  write means a buffered fallback cannot be detected
+	 */
+	page_cache_backed = (stress_hdd_dio_probe(fd, buf, len, base, args->page_size) == 1);
+
+	for (align = 1; align <= BUF_ALIGNMENT; align <<= 1) {
+		const off_t offset = base + (offset_probe ? align : 0);
+		const uint8_t *ptr = buf + (offset_probe ? 0 : align);
+		int ret = stress_hdd_dio_probe(fd, ptr, len, offset, args->page_size);
+
+		if (page_cache_backed && (ret == 1))
+			ret = 0;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %s alignment %" PRIu32 ": %s\n", args->name,
+				offset_probe ? "offset" : "memory", align,
+				(ret < 0) ? strerror(-ret) :
+				((ret == 1) ? "buffered I/O fallback" : "direct I/O"));
+		if (ret == 1)
+			*fallback = true;
+		if ((ret == 0) && (best == 0))
+			best = align;
+	}
+	return best;
+}
+
+/*
+ *  stress_hdd_dio_sweep()
+ *	detect the direct I/O constraints of the temp path file
+ *	system and sweep O_DIRECT request sizes and alignments
+ */
+static int stress_hdd_dio_sweep(stress_args_t *args, const char *filename)
+{
+	stress_hdd_dio_size_t sizes[HDD_DIO_MAX_SIZES];
+	size_t i, n_sizes = 0, best = 0, buf_size, metric = 0;
+	uint32_t mem_align, offset_align, lbs, pbs;
+	uint32_t min_offset_align, min_mem_align;
+	bool fallback = false;
+	uint8_t *buf;
+	int fd, rc = EXIT_SUCCESS;
+	double best_rate = 0.0;
+	char msg[64];
+
+	fd = open(filename, O_CREAT | O_RDWR | O_TRUNC | O_DIRECT, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		if (errno == EINVAL) {
+			if (stress_instance_zero(args))
+				pr_inf_skip("%s: O_DIRECT not supported on file system %s, skipping stressor\n",
+					args->name, stress_get_fs_type(filename));
+			return EXIT_NOT_IMPLEMENTED;
+		}
+		rc = stress_exit_status(errno);
+		pr_fail("%s: open %s failed, errno=%d (%s)\n",
+			args->name, filename, errno, strerror(errno));
+		return rc;
+	}
+
+	stress_hdd_dio_detect(args, filename, &mem_align, &offset_align, &lbs, &pbs);
+	(void)shim_unlink(filename);
+
+	/* I/O buffer, with spare space at the end for misaligned probes */
+	buf_size = HDD_DIO_MAX_SIZE + BUF_ALIGNMENT;
+	buf = (uint8_t *)mmap(NULL, buf_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu byte buffer%s, skipping stressor\n",
+			args->name, buf_size, stress_get_memfree_str());
+		(void)close(fd);
+		return EXIT_NO_RESOURCE;
+	}
+	(void)shim_memset(buf, stress_mwc8(), buf_size);
+
+	for (i = offset_align > HDD_DIO_MIN_SIZE ? offset_align : HDD_DIO_MIN_SIZE;
+	     (i <= HDD_DIO_MAX_SIZE) && (n_sizes < HDD_DIO_MAX_SIZES); i <<= 1) {
+		(void)shim_memset(&sizes[n_sizes], 0, sizeof(sizes[n_sizes]));
+		sizes[n_sizes++].size = i;
+	}
+
+	min_offset_align = stress_hdd_dio_align(args, fd, buf, BUF_ALIGNMENT, true, &fallback);
+	min_mem_align = stress_hdd_dio_align(args, fd, buf, BUF_ALIGNMENT, false, &fallback);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		stress_hdd_dio_size_t *sz = &sizes[i];
+		const size_t n = HDD_DIO_STEP_BYTES / sz->size;
+		size_t j;
+		double t;
+		ssize_t ret;
+
+		t = stress_time_now();
+		for (j = 0; LIKELY((j < n) && stress_continue_flag()); j++) {
+			ret = pwrite(fd, buf, sz->size, (off_t)(j * sz->size));
+			if (UNLIKELY(ret < 0)) {
+				if ((errno == ENOSPC) || (errno == EINTR))
+					break;
+				pr_fail("%s: O_DIRECT write of %zu bytes failed, errno=%d (%s)\n",
+					args->name, sz->size, errno, strerror(errno));
+				rc = EXIT_FAILURE;
+				break;
+			}
+			sz->write_bytes += (double)ret;
+		}
+		sz->write_duration += stress_time_now() - t;
+
+		t = stress_time_now();
+		for (j = 0; LIKELY((j < n) && stress_continue_flag() && (rc == EXIT_SUCCESS)); j++) {
+			ret = pread(fd, buf, sz->size, (off_t)(j * sz->size));
+			if (UNLIKELY(ret < 0)) {
+				if (errno == EINTR)
+					break;
+				pr_fail("%s: O_DIRECT read of %zu bytes failed, errno=%d (%s)\n",
+					args->name, sz->size, errno, strerror(errno));
+				rc = EXIT_FAILURE;
+				break;
+			}
+			if (ret == 0)
+				break;
+			sz->read_bytes += (double)ret;
+		}
+		sz->read_duration += stress_time_now() - t;
+
+		stress_bogo_inc(args);
+		i++;
+		if (i >= n_sizes)
+			i = 0;
+	} while ((rc == EXIT_SUCCESS) && stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_metrics_set(args, metric++, "logical block size",
+		(double)lbs, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, metric++, "physical block size",
+		(double)pbs, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, metric++, "direct I/O memory alignment",
+		(double)mem_align, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, metric++, "direct I/O offset alignment",
+		(double)offset_align, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, metric++, "smallest direct offset alignment accepted",
+		(double)min_offset_align, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, metric++, "smallest direct memory alignment accepted",
+		(double)min_mem_align, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, metric++, "misaligned I/O buffered fallback (1 = yes)",
+		fallback ? 1.0 : 0.0, STRESS_METRIC_MAXIMUM);
+
+	for (i = 0; i < n_sizes; i++) {
+		const stress_hdd_dio_size_t *sz = &sizes[i];
+		const double wr_rate = (sz->write_duration > 0.0) ? sz->write_bytes / sz->write_duration : 0.0;
+		const double rd_rate = (sz->read_duration > 0.0) ? sz->read_bytes / sz->read_duration : 0.0;
+
+		if (sz->write_bytes == 0.0)
+			continue;
+		(void)snprintf(msg, sizeof(msg), "MB/sec direct write (%zu byte I/O)", sz->size);
+		stress_metrics_set(args, metric++, msg, wr_rate / (double)MB, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "MB/sec direct read (%zu byte I/O)", sz->size);
+		stress_metrics_set(args, metric++, msg, rd_rate / (double)MB, STRESS_METRIC_HARMONIC_MEAN);
+		if (wr_rate + rd_rate > best_rate) {
+			best_rate = wr_rate + rd_rate;
+			best = sz->size;
+		}
+	}
+	stress_metrics_set(args, metric, "best direct I/O size",
+		(double)best, STRESS_METRIC_MAXIMUM);
+
+	(void)munmap((void *)buf, buf_size);
+	(void)close(fd);
+
+	return rc;
+}
+#endif
+
 /*
  *  stress_hdd
  *	stress I/O via writes
@@ -665,7 +1012,7 @@ static int stress_hdd(stress_args_t *args)
 	const uint32_t instance = args->instance;
 	int hdd_flags = 0, hdd_oflags = 0;
 	int flags, fadvise_flags;
-	bool opts_set = false;
+	bool opts_set = false, dio_sweep = false;
 	double hdd_read_bytes = 0.0, hdd_read_duration = 0.0;
 	double hdd_write_bytes = 0.0, hdd_write_duration = 0.0;
 	double hdd_rdwr_bytes, hdd_rdwr_duration;
@@ -674,6 +1021,7 @@ static int stress_hdd(stress_args_t *args)
 	(void)stress_get_setting("hdd-flags", &hdd_flags);
 	(void)stress_get_setting("hdd-oflags", &hdd_oflags);
 	(void)stress_get_setting("hdd-opts-set", &opts_set);
+	(void)stress_get_setting("hdd-dio-sweep", &dio_sweep);
 
 	flags = O_CREAT | O_RDWR | O_TRUNC | hdd_oflags;
 	fadvise_flags = hdd_flags & HDD_OPT_FADV_MASK;
@@ -735,6 +1083,21 @@ static int stress_hdd(stress_args_t *args)
 	if (ret < 0)
 		return stress_exit_status((int)-ret);
 
+	if (dio_sweep) {
+#if defined(O_DIRECT)
+		(void)stress_temp_filename_args(args,
+			filename, sizeof(filename), stress_mwc32());
+		rc = stress_hdd_dio_sweep(args, filename);
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: O_DIRECT is not available, skipping stressor\n",
+				args->name);
+		rc = EXIT_NOT_IMPLEMENTED;
+#endif
+		(void)stress_temp_dir_rm_args(args);
+		return rc;
+	}
+
 	/* Must have some write option */
 	if ((hdd_flags & HDD_OPT_WR_MASK) == 0)
 		hdd_flags |= HDD_OPT_WR_SEQ;
@@ -1097,6 +1460,7 @@ finish:
 
 static const stress_opt_t opts[] = {
 	{ OPT_hdd_bytes,      "hdd-bytes",      TYPE_ID_UINT64_BYTES_FS, MIN_HDD_BYTES, MAX_HDD_BYTES, NULL },
+	{ OPT_hdd_dio_sweep,  "hdd-dio-sweep",  TYPE_ID_BOOL, 0, 1, NULL },
 	{ OPT_hdd_opts,       "hdd-opts",       TYPE_ID_CALLBACK, 0, 0, stress_hdd_opts },
 	{ OPT_hdd_write_size, "hdd-write-size", TYPE_ID_UINT64_BYTES_FS, MIN_HDD_WRITE_SIZE, MAX_HDD_WRITE_SIZE, NULL },
 	END_OPT,
@@ -0,0 +1,688 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-killpid.h"
+#include "core-net.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#if defined(HAVE_SYS_SENDFILE_H)
+#include <sys/sendfile.h>
+#endif
+
+#if defined(HAVE_LINUX_TLS_H)
+#include <linux/tls.h>
+#endif
+
+#define DEFAULT_KTLS_PORT	(20000)
+
+#define KTLS_SLICE		(0.25)		/* seconds per configuration */
+#define KTLS_BUF_SIZE		(64 * KB)	/* size of each write or sendfile */
+#define KTLS_FILE_SIZE		(4 * MB)	/* sendfile source file size */
+#define KTLS_RECV_SIZE		(256 * KB)
+
+static const stress_help_t help[] = {
+	{ NULL,	"ktls N",		"start N workers streaming data over kernel TLS sockets" },
+	{ NULL,	"ktls-cipher C",	"cipher: all, none, aes-gcm-128, aes-gcm-256, chacha20-poly1305" },
+	{ NULL,	"ktls-ops N",		"stop after N 64K writes or sendfiles" },
+	{ NULL,	"ktls-port P",		"use socket ports P to P + number of workers - 1" },
+	{ NULL,	"ktls-sendfile",	"also stream data from a file using sendfile" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef enum {
+	KTLS_CIPHER_ALL,
+	KTLS_CIPHER_NONE,
+	KTLS_CIPHER_AES_GCM_128,
+	KTLS_CIPHER_AES_GCM_256,
+	KTLS_CIPHER_CHACHA20_POLY1305,
+} stress_ktls_cipher_t;
+
+typedef struct {
+	const char *name;
+	const stress_ktls_cipher_t cipher;
+} stress_ktls_cipher_info_t;
+
+static const stress_ktls_cipher_info_t stress_ktls_ciphers[] = {
+	{ "all",		KTLS_CIPHER_ALL },
+	{ "none",		KTLS_CIPHER_NONE },
+	{ "aes-gcm-128",	KTLS_CIPHER_AES_GCM_128 },
+	{ "aes-gcm-256",	KTLS_CIPHER_AES_GCM_256 },
+	{ "chacha20-poly1305",	KTLS_CIPHER_CHACHA20_POLY1305 },
+};
+
+static const char *stress_ktls_cipher(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_ktls_ciphers)) ? stress_ktls_ciphers[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_ktls_cipher,   "ktls-cipher",   TYPE_ID_SIZE_T_METHOD, 0, 0, stress_ktls_cipher },
+	{ OPT_ktls_port,     "ktls-port",     TYPE_ID_INT_PORT, MIN_PORT, MAX_PORT, NULL },
+	{ OPT_ktls_sendfile, "ktls-sendfile", TYPE_ID_BOOL, 0, 1, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_LINUX_TLS_H) &&	\
+    defined(AF_INET) &&			\
+    defined(SOL_TLS) &&			\
+    defined(TCP_ULP) &&			\
+    defined(TLS_TX) &&			\
+    defined(TLS_RX) &&			\
+    defined(TLS_1_2_VERSION)
+
+typedef enum {
+	KTLS_MODE_WRITE,
+	KTLS_MODE_SENDFILE,
+	KTLS_MODE_MAX,
+} stress_ktls_mode_t;
+
+static const char * const stress_ktls_modes[] = {
+	"write",
+	"sendfile",
+};
+
+#define KTLS_MAX_CONFIGS	(KTLS_MODE_MAX * SIZEOF_ARRAY(stress_ktls_ciphers))
+
+/*
+ *  per cipher and mode results
+ */
+typedef struct {
+	stress_ktls_cipher_t cipher;
+	stress_ktls_mode_t mode;
+	bool unsupported;	/* kTLS or cipher not available */
+	double t_start;		/* start of current stream */
+	double duration;	/* sender start to receiver end of stream */
+	double bytes;		/* bytes received */
+	double cpu_tx;		/* sender user + system time */
+	double cpu_rx;		/* receiver user + system time */
+} stress_ktls_config_t;
+
+typedef union {
+	struct tls_crypto_info info;
+#if defined(TLS_CIPHER_AES_GCM_128)
+	struct tls12_crypto_info_aes_gcm_128 aes_gcm_128;
+#endif
+#if defined(TLS_CIPHER_AES_GCM_256)
+	struct tls12_crypto_info_aes_gcm_256 aes_gcm_256;
+#endif
+#if defined(TLS_CIPHER_CHACHA20_POLY1305)
+	struct tls12_crypto_info_chacha20_poly1305 chacha20_poly1305;
+#endif
+} stress_ktls_crypto_info_t;
+
+static const char *stress_ktls_cipher_name(const stress_ktls_cipher_t cipher)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(stress_ktls_ciphers); i++) {
+		if (stress_ktls_ciphers[i].cipher == cipher)
+			return stress_ktls_ciphers[i].name;
+	}
+	return "unknown";
+}
+
+/*
+ *  stress_ktls_fill()
+ *	fill in static test key material, both ends use the same values
+ */
+static void stress_ktls_fill(
+	unsigned char *iv, const size_t iv_len,
+	unsigned char *key, const size_t key_len,
+	unsigned char *salt, const size_t salt_len)
+{
+	size_t i;
+
+	for (i = 0; i < iv_len; i++)
+		iv[i] = (unsigned char)(0x10 + i);
+	for (i = 0; i < key_len; i++)
+		key[i] = (unsigned char)(0x5a ^ (i * 7));
+	for (i = 0; i < salt_len; i++)
+		salt[i] = (unsigned char)(0xc0 + i);
+}
+
+/*
+ *  stress_ktls_set_key()
+ *	attach the TLS ULP and install TX or RX keys for the cipher,
+ *	returns 0 on success, -1 with errno set on failure
+ */
+static int stress_ktls_set_key(
+	const int fd,
+	const stress_ktls_cipher_t cipher,
+	const int direction)
+{
+	stress_ktls_crypto_info_t ci;
+	size_t len;
+
+	(void)shim_memset(&ci, 0, sizeof(ci));
+#if defined(TLS_1_3_VERSION)
+	ci.info.version = TLS_1_3_VERSION;
+#else
+	ci.info.version = TLS_1_2_VERSION;
+#endif
+	switch (cipher) {
+#if defined(TLS_CIPHER_AES_GCM_128)
+	case KTLS_CIPHER_AES_GCM_128:
+		ci.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+		stress_ktls_fill(ci.aes_gcm_128.iv, sizeof(ci.aes_gcm_128.iv),
+				 ci.aes_gcm_128.key, sizeof(ci.aes_gcm_128.key),
+				 ci.aes_gcm_128.salt, sizeof(ci.aes_gcm_128.salt));
+		len = sizeof(ci.aes_gcm_128);
+		break;
+#endif
+#if defined(TLS_CIPHER_AES_GCM_256)
+	case KTLS_CIPHER_AES_GCM_256:
+		ci.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+		stress_ktls_fill(ci.aes_gcm_256.iv, sizeof(ci.aes_gcm_256.iv),
+				 ci.aes_gcm_256.key, sizeof(ci.aes_gcm_256.key),
+				 ci.aes_gcm_256.salt, sizeof(ci.aes_gcm_256.salt));
+		len = sizeof(ci.aes_gcm_256);
+		break;
+#endif
+#if defined(TLS_CIPHER_CHACHA20_POLY1305)
+	case KTLS_CIPHER_CHACHA20_POLY1305:
+		ci.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+		/* chacha20-poly1305 has no salt, the 12 byte IV is the nonce */
+		stress_ktls_fill(ci.chacha20_poly1305.iv, sizeof(ci.chacha20_poly1305.iv),
+				 ci.chacha20_poly1305.key, sizeof(ci.chacha20_poly1305.key),
+				 NULL, 0);
+		len = sizeof(ci.chacha20_poly1305);
+		break;
+#endif
+	case KTLS_CIPHER_NONE:
+		return 0;
+	default:
+		errno = ENOSYS;
+		return -1;
+	}
+	if (setsockopt(fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) < 0)
+		return -1;
+	if (setsockopt(fd, SOL_TLS, direction, &ci, (socklen_t)len) == 0)
+		return 0;
+#if defined(TLS_1_3_VERSION)
+	/*
+	 *  older kernels only support TLS 1.2 for some or all of the
+	 *  ciphers, both ends fall back the same way so they still agree
+	 */
+	if (errno == EINVAL) {
+		ci.info.version = TLS_1_2_VERSION;
+		return setsockopt(fd, SOL_TLS, direction, &ci, (socklen_t)len);
+	}
+#endif
+	return -1;
+}
+
+/*
+ *  stress_ktls_receiver()
+ *	accept a connection per configuration, install the RX key and
+ *	drain the stream until the sender closes it
+ */
+static int stress_ktls_receiver(
+	stress_args_t *args,
+	stress_ktls_config_t *configs,
+	const int listen_fd,
+	const int ctrl_fd)
+{
+	uint8_t *buf;
+	uint32_t idx;
+	int rc = EXIT_SUCCESS;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	buf = (uint8_t *)malloc(KTLS_RECV_SIZE);
+	if (!buf)
+		return EXIT_NO_RESOURCE;
+
+	while (read(ctrl_fd, &idx, sizeof(idx)) == (ssize_t)sizeof(idx)) {
+		stress_ktls_config_t *cfg = &configs[idx];
+		struct timeval tv;
+		double cpu, bytes = 0.0;
+		int fd, err = 0;
+
+		fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0)
+			break;
+		tv.tv_sec = 1;
+		tv.tv_usec = 0;
+		(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		/* tell the sender why kTLS could not be setup */
+		if (stress_ktls_set_key(fd, cfg->cipher, TLS_RX) < 0)
+			err = errno;
+		if (write(ctrl_fd, &err, sizeof(err)) != (ssize_t)sizeof(err)) {
+			(void)close(fd);
+			break;
+		}
+		if (err) {
+			(void)close(fd);
+			continue;
+		}
+
+		cpu = stress_time_cpu_self();
+		for (;;) {
+			const ssize_t n = read(fd, buf, KTLS_RECV_SIZE);
+
+			if (n > 0) {
+				bytes += (double)n;
+				continue;
+			}
+			if (n == 0)
+				break;
+			if ((errno == EINTR) || (errno == EAGAIN)) {
+				if (stress_continue_flag())
+					continue;
+				break;
+			}
+			/* a record that fails to decrypt or authenticate */
+			pr_fail("%s: %s receive failed, errno=%d (%s)\n",
+				args->name, stress_ktls_cipher_name(cfg->cipher),
+				errno, strerror(errno));
+			rc = EXIT_FAILURE;
+			break;
+		}
+		cfg->cpu_rx += stress_time_cpu_self() - cpu;
+		cfg->duration += stress_time_now() - cfg->t_start;
+		cfg->bytes += bytes;
+		(void)close(fd);
+		if (write(ctrl_fd, &err, sizeof(err)) != (ssize_t)sizeof(err))
+			break;
+	}
+	free(buf);
+	return rc;
+}
+
+/*
+ *  stress_ktls_sender()
+ *	connect, install the TX key and stream data for a time slice,
+ *	returns false if the receiver has gone away
+ */
+static bool stress_ktls_sender(
+	stress_args_t *args,
+	stress_ktls_config_t *cfg,
+	const uint32_t idx,
+	const int ctrl_fd,
+	const int port,
+	const uint8_t *buf,
+	const int file_fd,
+	bool *ktls_warned)
+{
+	struct sockaddr_in addr;
+	struct timeval tv;
+	off_t offset = 0;
+	double cpu, t_end;
+	int fd, err;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return true;
+	(void)shim_memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons((uint16_t)port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		(void)close(fd);
+		return true;
+	}
+	tv.tv_sec = 1;
+	tv.tv_usec = 0;
+	(void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	if (write(ctrl_fd, &idx, sizeof(idx)) != (ssize_t)sizeof(idx))
+		goto gone;
+	if (read(ctrl_fd, &err, sizeof(err)) != (ssize_t)sizeof(err))
+		goto gone;
+	if (err || (stress_ktls_set_key(fd, cfg->cipher, TLS_TX) < 0)) {
+		const bool rx_waiting = (err == 0);
+
+		if (!err)
+			err = errno;
+		cfg->unsupported = true;
+		if (stress_instance_zero(args)) {
+			if (err == ENOENT) {
+				/* no tls ULP, all the ciphers will fail the same way */
+				if (!*ktls_warned)
+					pr_inf("%s: kernel TLS is not available (CONFIG_TLS not "
+						"enabled or tls module not loaded), skipping kTLS\n",
+						args->name);
+				*ktls_warned = true;
+			} else {
+				pr_inf("%s: cannot use kernel TLS with %s, errno=%d (%s), "
+					"skipping it\n", args->name,
+					stress_ktls_cipher_name(cfg->cipher), err, strerror(err));
+			}
+		}
+		/* the receiver sees an empty stream if it is waiting */
+		(void)close(fd);
+		if (rx_waiting && (read(ctrl_fd, &err, sizeof(err)) != (ssize_t)sizeof(err)))
+			return false;
+		return true;
+	}
+#if defined(TLS_TX_ZEROCOPY_RO)
+	if (cfg->mode == KTLS_MODE_SENDFILE) {
+		const int one = 1;
+
+		/* the file is not modified while it is sent */
+		(void)setsockopt(fd, SOL_TLS, TLS_TX_ZEROCOPY_RO, &one, sizeof(one));
+	}
+#endif
+
+	cpu = stress_time_cpu_self();
+	cfg->t_start = stress_time_now();
+	t_end = cfg->t_start + KTLS_SLICE;
+	do {
+		ssize_t n;
+
+#if defined(HAVE_SYS_SENDFILE_H)
+		if (cfg->mode == KTLS_MODE_SENDFILE) {
+			if (offset >= (off_t)KTLS_FILE_SIZE)
+				offset = 0;
+			n = sendfile(fd, file_fd, &offset, KTLS_BUF_SIZE);
+		} else
+#endif
+		{
+			n = write(fd, buf, KTLS_BUF_SIZE);
+		}
+		if (n < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			break;
+		}
+		stress_bogo_inc(args);
+	} while (stress_continue(args) && (stress_time_now() < t_end));
+	/* close flushes any pending record */
+	(void)close(fd);
+	cfg->cpu_tx += stress_time_cpu_self() - cpu;
+
+	/* wait for the receiver to drain the stream */
+	if (read(ctrl_fd, &err, sizeof(err)) != (ssize_t)sizeof(err))
+		return false;
+	return true;
+gone:
+	(void)close(fd);
+	return false;
+}
+
+/*
+ *  stress_ktls_metrics()
+ *	report throughput and CPU cost per byte, with throughput
+ *	relative to plain TCP in the same mode
+ */
+static void stress_ktls_metrics(
+	stress_args_t *args,
+	const stress_ktls_config_t *configs,
+	const size_t n_configs)
+{
+	double plain[KTLS_MODE_MAX];
+	size_t i, idx = 0;
+
+	(void)shim_memset(plain, 0, sizeof(plain));
+	for (i = 0; i < n_configs; i++) {
+		const stress_ktls_config_t *cfg = &configs[i];
+
+		if ((cfg->cipher == KTLS_CIPHER_NONE) && (cfg->duration > 0.0))
+			plain[cfg->mode] = cfg->bytes / cfg->duration;
+	}
+
+	for (i = 0; i < n_configs; i++) {
+		const stress_ktls_config_t *cfg = &configs[i];
+		const char *cipher = stress_ktls_cipher_name(cfg->cipher);
+		const char *mode = stress_ktls_modes[cfg->mode];
+		double rate;
+		char msg[64];
+
+		if (cfg->unsupported || (cfg->duration <= 0.0) || (cfg->bytes <= 0.0))
+			continue;
+		rate = cfg->bytes / cfg->duration;
+		(void)snprintf(msg, sizeof(msg), "MB per sec %s %s", cipher, mode);
+		stress_metrics_set(args, idx++, msg,
+			rate / (double)MB, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "CPU nsec per byte %s %s", cipher, mode);
+		stress_metrics_set(args, idx++, msg,
+			STRESS_DBL_NANOSECOND * (cfg->cpu_tx + cfg->cpu_rx) / cfg->bytes,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		if ((cfg->cipher != KTLS_CIPHER_NONE) && (plain[cfg->mode] > 0.0)) {
+			(void)snprintf(msg, sizeof(msg), "%% of plain TCP rate %s %s", cipher, mode);
+			stress_metrics_set(args, idx++, msg,
+				100.0 * rate / plain[cfg->mode], STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_ktls_file()
+ *	create an unlinked temporary file to sendfile from,
+ *	returns the fd or -1 on failure
+ */
+static int stress_ktls_file(stress_args_t *args, const uint8_t *buf)
+{
+	char filename[PATH_MAX];
+	size_t i;
+	int fd, ret;
+
+	ret = stress_temp_dir_mk_args(args);
+	if (ret < 0)
+		return -1;
+	(void)stress_temp_filename_args(args, filename, sizeof(filename), stress_mwc32());
+	fd = open(filename, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		pr_inf("%s: cannot create %s, errno=%d (%s), skipping sendfile\n",
+			args->name, filename, errno, strerror(errno));
+		(void)stress_temp_dir_rm_args(args);
+		return -1;
+	}
+	(void)shim_unlink(filename);
+	(void)stress_temp_dir_rm_args(args);
+
+	for (i = 0; i < KTLS_FILE_SIZE; i += KTLS_BUF_SIZE) {
+		if (write(fd, buf, KTLS_BUF_SIZE) != (ssize_t)KTLS_BUF_SIZE) {
+			pr_inf("%s: cannot write sendfile data, errno=%d (%s), skipping sendfile\n",
+				args->name, errno, strerror(errno));
+			(void)close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
+/*
+ *  stress_ktls
+ *	stream data over loopback TCP with kernel TLS record
+ *	encryption and compare it to plain TCP
+ */
+static int stress_ktls(stress_args_t *args)
+{
+	int ktls_port = DEFAULT_KTLS_PORT, reserved_port;
+	size_t ktls_cipher = 0;
+	bool ktls_sendfile = false, ktls_warned = false;
+	size_t i, j, n_configs = 0, configs_size;
+	stress_ktls_config_t *configs;
+	stress_ktls_cipher_t cipher;
+	struct sockaddr_in addr;
+	uint8_t *buf;
+	int listen_fd, file_fd = -1, ctrl[2], status, rc = EXIT_SUCCESS;
+	const int one = 1;
+	pid_t pid;
+
+	(void)stress_get_setting("ktls-cipher", &ktls_cipher);
+	(void)stress_get_setting("ktls-port", &ktls_port);
+	(void)stress_get_setting("ktls-sendfile", &ktls_sendfile);
+	cipher = stress_ktls_ciphers[ktls_cipher].cipher;
+
+	ktls_port += args->instance;
+	if (ktls_port > MAX_PORT)
+		ktls_port -= (MAX_PORT - MIN_PORT + 1);
+	reserved_port = stress_net_reserve_ports(ktls_port, ktls_port);
+	if (reserved_port < 0) {
+		pr_inf_skip("%s: cannot reserve port %d, skipping stressor\n",
+			args->name, ktls_port);
+		return EXIT_NO_RESOURCE;
+	}
+	ktls_port = reserved_port;
+
+	configs_size = KTLS_MAX_CONFIGS * sizeof(*configs);
+	configs = (stress_ktls_config_t *)stress_mmap_populate(NULL, configs_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (configs == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for results%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, configs_size,
+			stress_get_memfree_str(), errno, strerror(errno));
+		stress_net_release_ports(ktls_port, ktls_port);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(configs, configs_size, "ktls-results");
+
+	buf = (uint8_t *)malloc(KTLS_BUF_SIZE);
+	if (!buf) {
+		pr_inf_skip("%s: cannot allocate %zu byte buffer%s, skipping stressor\n",
+			args->name, (size_t)KTLS_BUF_SIZE, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto unmap;
+	}
+	stress_rndbuf(buf, KTLS_BUF_SIZE);
+
+#if defined(HAVE_SYS_SENDFILE_H)
+	if (ktls_sendfile)
+		file_fd = stress_ktls_file(args, buf);
+#else
+	if (ktls_sendfile && stress_instance_zero(args))
+		pr_inf("%s: sendfile is not available, skipping sendfile\n", args->name);
+#endif
+
+	for (i = 0; i < KTLS_MODE_MAX; i++) {
+		if ((i == KTLS_MODE_SENDFILE) && (file_fd < 0))
+			continue;
+		for (j = 0; j < SIZEOF_ARRAY(stress_ktls_ciphers); j++) {
+			const stress_ktls_cipher_t c = stress_ktls_ciphers[j].cipher;
+
+			if (c == KTLS_CIPHER_ALL)
+				continue;
+			/* plain TCP is always run as the baseline */
+			if ((cipher != KTLS_CIPHER_ALL) && (c != cipher) && (c != KTLS_CIPHER_NONE))
+				continue;
+			configs[n_configs].cipher = c;
+			configs[n_configs].mode = (stress_ktls_mode_t)i;
+			n_configs++;
+		}
+	}
+
+	listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd < 0) {
+		pr_fail("%s: socket failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_FAILURE;
+		goto free_buf;
+	}
+	(void)setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	(void)shim_memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons((uint16_t)ktls_port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+	    (listen(listen_fd, 8) < 0)) {
+		pr_inf_skip("%s: cannot bind and listen on port %d, errno=%d (%s), "
+			"skipping stressor\n", args->name, ktls_port, errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto close_listen;
+	}
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctrl) < 0) {
+		pr_fail("%s: socketpair failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_FAILURE;
+		goto close_listen;
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+again:
+	pid = fork();
+	if (pid < 0) {
+		if (stress_redo_fork(args, errno))
+			goto again;
+		if (!stress_continue(args))
+			goto close_ctrl;
+		pr_fail("%s: fork failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_FAILURE;
+		goto close_ctrl;
+	} else if (pid == 0) {
+		(void)close(ctrl[1]);
+		_exit(stress_ktls_receiver(args, configs, listen_fd, ctrl[0]));
+	}
+	(void)close(ctrl[0]);
+	ctrl[0] = -1;
+
+	i = 0;
+	do {
+		stress_ktls_config_t *cfg = &configs[i];
+
+		if (!cfg->unsupported &&
+		    !stress_ktls_sender(args, cfg, (uint32_t)i, ctrl[1], ktls_port,
+					buf, file_fd, &ktls_warned))
+			break;
+		i = (i + 1) % n_configs;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	(void)close(ctrl[1]);
+	ctrl[1] = -1;
+	/* the receiver exits when the control socket is closed */
+	if (shim_waitpid(pid, &status, 0) == pid) {
+		if (WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_FAILURE))
+			rc = EXIT_FAILURE;
+	} else {
+		(void)stress_kill_pid_wait(pid, NULL);
+	}
+	stress_ktls_metrics(args, configs, n_configs);
+close_ctrl:
+	if (ctrl[0] >= 0)
+		(void)close(ctrl[0]);
+	if (ctrl[1] >= 0)
+		(void)close(ctrl[1]);
+close_listen:
+	(void)close(listen_fd);
+free_buf:
+	if (file_fd >= 0)
+		(void)close(file_fd);
+	free(buf);
+unmap:
+	(void)munmap((void *)configs, configs_size);
+	stress_net_release_ports(ktls_port, ktls_port);
+
+	return rc;
+}
+
+const stressor_info_t stress_ktls_info = {
+	.stressor = stress_ktls,
+	.classifier = CLASS_NETWORK | CLASS_CPU | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_ktls_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_NETWORK | CLASS_CPU | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without linux/tls.h or kernel TLS socket option support"
+};
+#endif
@@ -0,0 +1,939 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-cpu-relax.h"
+#include "core-pthread.h"
+#include "core-put.h"
+
+#define MIN_LOCKALGO_THREADS	(1)
+#define MAX_LOCKALGO_THREADS	(256)
+#define DEFAULT_LOCKALGO_THREADS (4)
+
+#define MIN_LOCKALGO_CS		(0)
+#define MAX_LOCKALGO_CS		(1000000)
+#define DEFAULT_LOCKALGO_CS	(100)
+
+#define MIN_LOCKALGO_READERS	(0)
+#define MAX_LOCKALGO_READERS	(100)
+#define DEFAULT_LOCKALGO_READERS (80)
+
+#define LOCKALGO_SLICE_NS	(100000000ULL)	/* 0.1 seconds per configuration */
+#define LOCKALGO_HANDOFF_SAMPLE	(64)		/* time every 64th release */
+#define LOCKALGO_MAX_SWEEP_THREADS (16)
+#define LOCKALGO_MAX_SWEEP_CS	(2)
+#define LOCKALGO_CS_DATA	(8)
+
+static const stress_help_t help[] = {
+	{ NULL,	"lockalgo N",		"start N workers benchmarking user space lock algorithms" },
+	{ NULL,	"lockalgo-cs N",	"critical section length in loop iterations" },
+	{ NULL,	"lockalgo-method M",	"lock algorithm: all, ticket, mcs, clh, qrwlock, spin-futex, mutex, rwlock" },
+	{ NULL,	"lockalgo-ops N",	"stop after N lock acquisitions" },
+	{ NULL,	"lockalgo-readers P",	"percentage of read acquisitions for reader-writer locks" },
+	{ NULL,	"lockalgo-threads N",	"sweep from 1 up to N contending threads" },
+	{ NULL,	NULL,			NULL }
+};
+
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_PTHREAD_MUTEX_T) &&		\
+    defined(HAVE_PTHREAD_MUTEX_INIT) &&		\
+    defined(HAVE_PTHREAD_MUTEX_DESTROY) &&	\
+    defined(HAVE_ATOMIC_COMPARE_EXCHANGE) &&	\
+    defined(HAVE_ATOMIC_FETCH_ADD) &&		\
+    defined(HAVE_ATOMIC_FETCH_SUB) &&		\
+    defined(HAVE_ATOMIC_FETCH_OR) &&		\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+
+#define HAVE_LOCKALGO
+
+/* qrwlock lock word: writer byte, waiting writer bit, reader count */
+#define QRW_WLOCKED		(0x0ffU)
+#define QRW_WAITING		(0x100U)
+#define QRW_WMASK		(0x1ffU)
+#define QRW_RBIAS		(0x200U)
+
+/*
+ *  MCS and CLH queue node, one per thread, each on its own cache line
+ */
+typedef struct stress_lockalgo_node {
+	struct stress_lockalgo_node *next;	/* MCS successor */
+	uint32_t locked;			/* spun on by waiter */
+	uint8_t pad[64 - sizeof(void *) - sizeof(uint32_t)];
+} stress_lockalgo_node_t;
+
+typedef struct {
+	uint32_t next;				/* next ticket to hand out */
+	uint32_t owner;				/* ticket being served */
+} stress_lockalgo_ticket_t;
+
+typedef union {
+	stress_lockalgo_ticket_t ticket;	/* ticket lock */
+	stress_lockalgo_node_t *tail;		/* MCS and CLH queue tail */
+	struct {
+		uint32_t cnts;			/* reader count and writer state */
+		stress_lockalgo_ticket_t wait;	/* queue for slow path */
+	} qrw;
+	uint32_t futex;				/* 0 free, 1 locked, 2 contended */
+	pthread_mutex_t mutex;
+#if defined(HAVE_PTHREAD_RWLOCK)
+	pthread_rwlock_t rwlock;
+#endif
+} stress_lockalgo_lock_t;
+
+struct stress_lockalgo_context;
+
+/*
+ *  per thread state, one cache line or more per thread
+ */
+typedef struct {
+	struct stress_lockalgo_context *ctx ALIGN64;	/* shared context */
+	pthread_t pthread;
+	uint32_t id;				/* thread index */
+	uint32_t rnd;				/* read/write selection LCG */
+	uint64_t count;				/* acquisitions */
+	uint64_t handoff_count;			/* handoffs timed */
+	double handoff_sum;			/* total handoff time */
+	stress_lockalgo_node_t *node;		/* MCS/CLH queue node */
+	stress_lockalgo_node_t *pred;		/* CLH predecessor node */
+} stress_lockalgo_thread_t;
+
+typedef struct {
+	const char *name;
+	void (*init)(struct stress_lockalgo_context *ctx, stress_lockalgo_thread_t *threads, const uint32_t n);
+	void (*deinit)(struct stress_lockalgo_context *ctx);
+	void (*acquire)(struct stress_lockalgo_context *ctx, stress_lockalgo_thread_t *thread, const bool write);
+	void (*release)(struct stress_lockalgo_context *ctx, stress_lockalgo_thread_t *thread, const bool write);
+	const bool rw;				/* has shared read mode */
+} stress_lockalgo_method_t;
+
+/*
+ *  state shared by all the contending threads
+ */
+typedef struct stress_lockalgo_context {
+	stress_lockalgo_lock_t lock ALIGN64;
+	stress_lockalgo_node_t *nodes;		/* n threads + 1 CLH dummy */
+	const stress_lockalgo_method_t *method;
+	uint32_t cs;				/* critical section iterations */
+	uint32_t readers;			/* percentage of read acquisitions */
+	bool go;				/* start contending */
+	bool stop;				/* stop contending */
+	/* data protected by the lock */
+	uint32_t writers_inside ALIGN64;
+	uint32_t readers_inside;
+	uint32_t last_owner;			/* thread that set t_release */
+	bool violation;				/* mutual exclusion failed */
+	double t_release;			/* sampled release time */
+	volatile uint64_t data[LOCKALGO_CS_DATA];
+} stress_lockalgo_context_t;
+
+/*
+ *  accumulated results for one method/threads/cs configuration
+ */
+typedef struct {
+	const stress_lockalgo_method_t *method;
+	uint32_t threads;
+	uint32_t cs;
+	bool skipped;				/* could not create threads */
+	uint64_t count;				/* total acquisitions */
+	double duration;			/* total run time */
+	double fairness_sum;			/* sum of max/min per run */
+	double fairness_n;
+	double handoff_sum;			/* handoff time */
+	double handoff_n;
+} stress_lockalgo_result_t;
+
+/*
+ *  Ticket lock, FIFO order, all waiters spin on the owner word
+ */
+static inline void ALWAYS_INLINE stress_lockalgo_ticket_lock(stress_lockalgo_ticket_t *ticket)
+{
+	const uint32_t me = __atomic_fetch_add(&ticket->next, 1, __ATOMIC_RELAXED);
+	uint32_t spins = 0;
+
+	while (__atomic_load_n(&ticket->owner, __ATOMIC_ACQUIRE) != me)
+		(void)stress_cpu_relax_yield(&spins);
+}
+
+static inline void ALWAYS_INLINE stress_lockalgo_ticket_unlock(stress_lockalgo_ticket_t *ticket)
+{
+	__atomic_store_n(&ticket->owner, ticket->owner + 1, __ATOMIC_RELEASE);
+}
+
+static void stress_lockalgo_ticket_init(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	const uint32_t n)
+{
+	(void)threads;
+	(void)n;
+
+	ctx->lock.ticket.next = 0;
+	ctx->lock.ticket.owner = 0;
+}
+
+static void stress_lockalgo_ticket_acquire(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	(void)thread;
+	(void)write;
+
+	stress_lockalgo_ticket_lock(&ctx->lock.ticket);
+}
+
+static void stress_lockalgo_ticket_release(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	(void)thread;
+	(void)write;
+
+	stress_lockalgo_ticket_unlock(&ctx->lock.ticket);
+}
+
+/*
+ *  MCS queue lock, each waiter spins on its own node
+ */
+static void stress_lockalgo_mcs_init(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	const uint32_t n)
+{
+	uint32_t i;
+
+	ctx->lock.tail = NULL;
+	for (i = 0; i < n; i++) {
+		threads[i].node = &ctx->nodes[i];
+		threads[i].node->next = NULL;
+		threads[i].node->locked = 0;
+	}
+}
+
+static void stress_lockalgo_mcs_acquire(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	stress_lockalgo_node_t *node = thread->node, *pred;
+	uint32_t spins = 0;
+
+	(void)write;
+
+	node->next = NULL;
+	node->locked = 1;
+	pred = __atomic_exchange_n(&ctx->lock.tail, node, __ATOMIC_ACQ_REL);
+	if (!pred)
+		return;
+	__atomic_store_n(&pred->next, node, __ATOMIC_RELEASE);
+	while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE))
+		(void)stress_cpu_relax_yield(&spins);
+}
+
+static void stress_lockalgo_mcs_release(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	stress_lockalgo_node_t *node = thread->node, *next;
+	uint32_t spins = 0;
+
+	(void)write;
+
+	next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+	if (!next) {
+		stress_lockalgo_node_t *expected = node;
+
+		/* no known successor, try to mark the lock free */
+		if (__atomic_compare_exchange_n(&ctx->lock.tail, &expected, NULL,
+				false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			return;
+		/* a successor is linking itself in, wait for it */
+		while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)))
+			(void)stress_cpu_relax_yield(&spins);
+	}
+	__atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ *  CLH queue lock, each waiter spins on its predecessor's node and
+ *  takes that node over on release
+ */
+static void stress_lockalgo_clh_init(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	const uint32_t n)
+{
+	uint32_t i;
+
+	for (i = 0; i <= n; i++) {
+		ctx->nodes[i].next = NULL;
+		ctx->nodes[i].locked = 0;
+	}
+	for (i = 0; i < n; i++) {
+		threads[i].node = &ctx->nodes[i];
+		threads[i].pred = NULL;
+	}
+	/* the extra node is the initial unlocked tail */
+	ctx->lock.tail = &ctx->nodes[n];
+}
+
+static void stress_lockalgo_clh_acquire(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	stress_lockalgo_node_t *pred;
+	uint32_t spins = 0;
+
+	(void)write;
+
+	__atomic_store_n(&thread->node->locked, 1, __ATOMIC_RELAXED);
+	pred = __atomic_exchange_n(&ctx->lock.tail, thread->node, __ATOMIC_ACQ_REL);
+	while (__atomic_load_n(&pred->locked, __ATOMIC_ACQUIRE))
+		(void)stress_cpu_relax_yield(&spins);
+	thread->pred = pred;
+}
+
+static void stress_lockalgo_clh_release(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	stress_lockalgo_node_t *node = thread->node;
+
+	(void)ctx;
+	(void)write;
+
+	thread->node = thread->pred;
+	__atomic_store_n(&node->locked, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Queued reader-writer lock in the style of the Linux qrwlock,
+ *  uncontended readers and writers only touch the lock word, any
+ *  contention is queued in FIFO order behind a ticket lock
+ */
+static void stress_lockalgo_qrw_init(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	const uint32_t n)
+{
+	(void)threads;
+	(void)n;
+
+	ctx->lock.qrw.cnts = 0;
+	ctx->lock.qrw.wait.next = 0;
+	ctx->lock.qrw.wait.owner = 0;
+}
+
+static void stress_lockalgo_qrw_acquire(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	uint32_t *cnts = &ctx->lock.qrw.cnts;
+	uint32_t spins = 0;
+
+	(void)thread;
+
+	if (write) {
+		uint32_t expected = 0;
+
+		stress_lockalgo_ticket_lock(&ctx->lock.qrw.wait);
+		if (!__atomic_compare_exchange_n(cnts, &expected, QRW_WLOCKED,
+				false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			/* block new readers, wait for the current ones to drain */
+			(void)__atomic_fetch_or(cnts, QRW_WAITING, __ATOMIC_RELAXED);
+			for (;;) {
+				expected = QRW_WAITING;
+				if (__atomic_compare_exchange_n(cnts, &expected, QRW_WLOCKED,
+						false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+					break;
+				(void)stress_cpu_relax_yield(&spins);
+			}
+		}
+		stress_lockalgo_ticket_unlock(&ctx->lock.qrw.wait);
+		return;
+	}
+
+	if (!(__atomic_fetch_add(cnts, QRW_RBIAS, __ATOMIC_ACQUIRE) & QRW_WMASK))
+		return;
+	/* writer active or waiting, back out and queue up */
+	(void)__atomic_fetch_sub(cnts, QRW_RBIAS, __ATOMIC_RELAXED);
+	stress_lockalgo_ticket_lock(&ctx->lock.qrw.wait);
+	(void)__atomic_fetch_add(cnts, QRW_RBIAS, __ATOMIC_ACQUIRE);
+	while (__atomic_load_n(cnts, __ATOMIC_ACQUIRE) & QRW_WLOCKED)
+		(void)stress_cpu_relax_yield(&spins);
+	stress_lockalgo_ticket_unlock(&ctx->lock.qrw.wait);
+}
+
+static void stress_lockalgo_qrw_release(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	(void)thread;
+
+	(void)__atomic_fetch_sub(&ctx->lock.qrw.cnts,
+		write ? QRW_WLOCKED : QRW_RBIAS, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Adaptive lock, spin briefly then sleep on a futex, the three
+ *  state (free, locked, contended) mutex from "Futexes Are Tricky"
+ */
+#define LOCKALGO_FUTEX_SPINS	(100)
+
+static void stress_lockalgo_futex_init(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	const uint32_t n)
+{
+	(void)threads;
+	(void)n;
+
+	ctx->lock.futex = 0;
+}
+
+static void stress_lockalgo_futex_acquire(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	uint32_t *futex = &ctx->lock.futex;
+	uint32_t c, i, spins = 0;
+
+	(void)thread;
+	(void)write;
+
+	for (i = 0; i < LOCKALGO_FUTEX_SPINS; i++) {
+		c = 0;
+		if (__atomic_compare_exchange_n(futex, &c, 1,
+				false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return;
+		if (c == 2)
+			break;	/* already contended, go straight to sleep */
+		(void)stress_cpu_relax_yield(&spins);
+	}
+	c = __atomic_exchange_n(futex, 2, __ATOMIC_ACQUIRE);
+	while (c != 0) {
+		(void)shim_futex_wait(futex, 2, NULL);
+		c = __atomic_exchange_n(futex, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+static void stress_lockalgo_futex_release(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	uint32_t *futex = &ctx->lock.futex;
+
+	(void)thread;
+	(void)write;
+
+	if (__atomic_fetch_sub(futex, 1, __ATOMIC_RELEASE) != 1) {
+		__atomic_store_n(futex, 0, __ATOMIC_RELEASE);
+		(void)shim_futex_wake(futex, 1);
+	}
+}
+
+/*
+ *  pthread mutex, the baseline
+ */
+static void stress_lockalgo_mutex_init(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	const uint32_t n)
+{
+	(void)threads;
+	(void)n;
+
+	(void)pthread_mutex_init(&ctx->lock.mutex, NULL);
+}
+
+static void stress_lockalgo_mutex_deinit(stress_lockalgo_context_t *ctx)
+{
+	(void)pthread_mutex_destroy(&ctx->lock.mutex);
+}
+
+static void stress_lockalgo_mutex_acquire(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	(void)thread;
+	(void)write;
+
+	(void)pthread_mutex_lock(&ctx->lock.mutex);
+}
+
+static void stress_lockalgo_mutex_release(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	(void)thread;
+	(void)write;
+
+	(void)pthread_mutex_unlock(&ctx->lock.mutex);
+}
+
+#if defined(HAVE_PTHREAD_RWLOCK)
+/*
+ *  pthread reader-writer lock, the reader-writer baseline
+ */
+static void stress_lockalgo_rwlock_init(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	const uint32_t n)
+{
+	(void)threads;
+	(void)n;
+
+	(void)pthread_rwlock_init(&ctx->lock.rwlock, NULL);
+}
+
+static void stress_lockalgo_rwlock_deinit(stress_lockalgo_context_t *ctx)
+{
+	(void)pthread_rwlock_destroy(&ctx->lock.rwlock);
+}
+
+static void stress_lockalgo_rwlock_acquire(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	(void)thread;
+
+	if (write)
+		(void)pthread_rwlock_wrlock(&ctx->lock.rwlock);
+	else
+		(void)pthread_rwlock_rdlock(&ctx->lock.rwlock);
+}
+
+static void stress_lockalgo_rwlock_release(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread,
+	const bool write)
+{
+	(void)thread;
+	(void)write;
+
+	(void)pthread_rwlock_unlock(&ctx->lock.rwlock);
+}
+#endif
+
+static const stress_lockalgo_method_t stress_lockalgo_methods[] = {
+	{ "ticket",	stress_lockalgo_ticket_init, NULL,
+			stress_lockalgo_ticket_acquire, stress_lockalgo_ticket_release, false },
+	{ "mcs",	stress_lockalgo_mcs_init, NULL,
+			stress_lockalgo_mcs_acquire, stress_lockalgo_mcs_release, false },
+	{ "clh",	stress_lockalgo_clh_init, NULL,
+			stress_lockalgo_clh_acquire, stress_lockalgo_clh_release, false },
+	{ "qrwlock",	stress_lockalgo_qrw_init, NULL,
+			stress_lockalgo_qrw_acquire, stress_lockalgo_qrw_release, true },
+	{ "spin-futex",	stress_lockalgo_futex_init, NULL,
+			stress_lockalgo_futex_acquire, stress_lockalgo_futex_release, false },
+	{ "mutex",	stress_lockalgo_mutex_init, stress_lockalgo_mutex_deinit,
+			stress_lockalgo_mutex_acquire, stress_lockalgo_mutex_release, false },
+#if defined(HAVE_PTHREAD_RWLOCK)
+	{ "rwlock",	stress_lockalgo_rwlock_init, stress_lockalgo_rwlock_deinit,
+			stress_lockalgo_rwlock_acquire, stress_lockalgo_rwlock_release, true },
+#endif
+};
+
+#define LOCKALGO_METHODS	SIZEOF_ARRAY(stress_lockalgo_methods)
+
+static const char *stress_lockalgo_method(const size_t i)
+{
+	if (i == 0)
+		return "all";
+	return (i <= LOCKALGO_METHODS) ? stress_lockalgo_methods[i - 1].name : NULL;
+}
+#else
+static const char *stress_lockalgo_method(const size_t i)
+{
+	return (i == 0) ? "all" : NULL;
+}
+#endif
+
+static const stress_opt_t opts[] = {
+	{ OPT_lockalgo_cs,	"lockalgo-cs",      TYPE_ID_UINT32, MIN_LOCKALGO_CS, MAX_LOCKALGO_CS, NULL },
+	{ OPT_lockalgo_method,	"lockalgo-method",  TYPE_ID_SIZE_T_METHOD, 0, 0, stress_lockalgo_method },
+	{ OPT_lockalgo_readers,	"lockalgo-readers", TYPE_ID_UINT32, MIN_LOCKALGO_READERS, MAX_LOCKALGO_READERS, NULL },
+	{ OPT_lockalgo_threads,	"lockalgo-threads", TYPE_ID_UINT32, MIN_LOCKALGO_THREADS, MAX_LOCKALGO_THREADS, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_LOCKALGO)
+
+/*
+ *  stress_lockalgo_cs_write()
+ *	exclusive critical section, check nobody else is inside,
+ *	time the handoff from the previous holder and update the
+ *	protected data
+ */
+static inline void ALWAYS_INLINE stress_lockalgo_cs_write(
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *thread)
+{
+	const uint32_t w = __atomic_load_n(&ctx->writers_inside, __ATOMIC_RELAXED);
+	register uint32_t i;
+
+	__atomic_store_n(&ctx->writers_inside, w + 1, __ATOMIC_RELAXED);
+	if (UNLIKELY(w || __atomic_load_n(&ctx->readers_inside, __ATOMIC_RELAXED)))
+		ctx->violation = true;
+
+	if (ctx->t_release > 0.0) {
+		/* only count the wait if the lock changed hands */
+		if (ctx->last_owner != thread->id) {
+			thread->handoff_sum += stress_time_now() - ctx->t_release;
+			thread->handoff_count++;
+		}
+		ctx->t_release = 0.0;
+	}
+
+	for (i = 0; i < ctx->cs; i++)
+		ctx->data[i & (LOCKALGO_CS_DATA - 1)]++;
+
+	if (UNLIKELY((thread->count & (LOCKALGO_HANDOFF_SAMPLE - 1)) == 0)) {
+		ctx->last_owner = thread->id;
+		ctx->t_release = stress_time_now();
+	}
+	__atomic_store_n(&ctx->writers_inside, w, __ATOMIC_RELAXED);
+}
+
+/*
+ *  stress_lockalgo_cs_read()
+ *	shared critical section, check there is no writer inside
+ *	and read the protected data
+ */
+static inline void ALWAYS_INLINE stress_lockalgo_cs_read(stress_lockalgo_context_t *ctx)
+{
+	register uint32_t i;
+	uint64_t sum = 0;
+
+	(void)__atomic_fetch_add(&ctx->readers_inside, 1, __ATOMIC_RELAXED);
+	if (UNLIKELY(__atomic_load_n(&ctx->writers_inside, __ATOMIC_RELAXED)))
+		ctx->violation = true;
+	for (i = 0; i < ctx->cs; i++)
+		sum += ctx->data[i & (LOCKALGO_CS_DATA - 1)];
+	stress_uint64_put(sum);
+	(void)__atomic_fetch_sub(&ctx->readers_inside, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ *  stress_lockalgo_thread()
+ *	contend on the lock until told to stop
+ */
+static void *stress_lockalgo_thread(void *arg)
+{
+	stress_lockalgo_thread_t *thread = (stress_lockalgo_thread_t *)arg;
+	stress_lockalgo_context_t *ctx = thread->ctx;
+	const stress_lockalgo_method_t *method = ctx->method;
+	const uint32_t readers = method->rw ? ctx->readers : 0;
+
+	while (!__atomic_load_n(&ctx->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)) {
+		bool write = true;
+
+		if (readers) {
+			thread->rnd = (thread->rnd * 1103515245U) + 12345U;
+			write = ((thread->rnd >> 16) % 100) >= readers;
+		}
+		method->acquire(ctx, thread, write);
+		if (write)
+			stress_lockalgo_cs_write(ctx, thread);
+		else
+			stress_lockalgo_cs_read(ctx);
+		method->release(ctx, thread, write);
+		thread->count++;
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_lockalgo_run()
+ *	run one configuration for a time slice and accumulate the results
+ */
+static int stress_lockalgo_run(
+	stress_args_t *args,
+	stress_lockalgo_context_t *ctx,
+	stress_lockalgo_thread_t *threads,
+	stress_lockalgo_result_t *result)
+{
+	const uint32_t n = result->threads;
+	uint64_t count = 0, count_min = ~0ULL, count_max = 0;
+	uint32_t i, created;
+	double t;
+
+	ctx->method = result->method;
+	ctx->cs = result->cs;
+	ctx->go = false;
+	ctx->stop = false;
+	ctx->writers_inside = 0;
+	ctx->readers_inside = 0;
+	ctx->t_release = 0.0;
+	for (i = 0; i < n; i++) {
+		threads[i].ctx = ctx;
+		threads[i].id = i;
+		threads[i].rnd = stress_mwc32();
+		threads[i].count = 0;
+		threads[i].handoff_count = 0;
+		threads[i].handoff_sum = 0.0;
+	}
+	result->method->init(ctx, threads, n);
+
+	for (created = 0; created < n; created++) {
+		if (pthread_create(&threads[created].pthread, NULL,
+				stress_lockalgo_thread, (void *)&threads[created]) != 0)
+			break;
+	}
+	if (created < n) {
+		pr_dbg("%s: only created %" PRIu32 " of %" PRIu32 " threads, skipping "
+			"%" PRIu32 " thread configurations\n", args->name, created, n, n);
+		result->skipped = true;
+	}
+
+	t = stress_time_now();
+	__atomic_store_n(&ctx->go, true, __ATOMIC_RELEASE);
+	if (!result->skipped)
+		(void)shim_nanosleep_uint64(LOCKALGO_SLICE_NS);
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELAXED);
+	t = stress_time_now() - t;
+
+	for (i = 0; i < created; i++)
+		VOID_RET(int, pthread_join(threads[i].pthread, NULL));
+	if (result->method->deinit)
+		result->method->deinit(ctx);
+
+	if (result->skipped)
+		return 0;
+	if (ctx->violation) {
+		pr_fail("%s: %s lock failed to provide mutual exclusion\n",
+			args->name, result->method->name);
+		return -1;
+	}
+
+	for (i = 0; i < n; i++) {
+		count += threads[i].count;
+		if (threads[i].count < count_min)
+			count_min = threads[i].count;
+		if (threads[i].count > count_max)
+			count_max = threads[i].count;
+		result->handoff_sum += threads[i].handoff_sum;
+		result->handoff_n += (double)threads[i].handoff_count;
+	}
+	result->count += count;
+	result->duration += t;
+	/* a starved thread counts as one acquisition to keep the ratio finite */
+	result->fairness_sum += (double)count_max / (double)(count_min ? count_min : 1);
+	result->fairness_n += 1.0;
+	stress_bogo_add(args, count);
+
+	return 0;
+}
+
+/*
+ *  stress_lockalgo_metrics()
+ *	uncontended and most contended acquisition rates, fairness and
+ *	handoff latency for the most contended configurations, the other
+ *	thread counts are only in the debug table to keep within the
+ *	misc metrics limit
+ */
+static void stress_lockalgo_metrics(
+	stress_args_t *args,
+	const stress_lockalgo_result_t *results,
+	const size_t n_results,
+	const uint32_t max_threads)
+{
+	size_t i, idx = 0, dropped = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_lockalgo_result_t *r = &results[i];
+		const double rate = (r->duration > 0.0) ? (double)r->count / r->duration : 0.0;
+		const double fairness = (r->fairness_n > 0.0) ? r->fairness_sum / r->fairness_n : 0.0;
+		const double handoff = (r->handoff_n > 0.0) ? r->handoff_sum / r->handoff_n : 0.0;
+		const size_t n_metrics = (r->threads == max_threads) ? 3 : 1;
+		char msg[64];
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-10s %3" PRIu32 " threads cs %-7" PRIu32
+				" %12.0f acquires/sec, fairness %8.2f, handoff %10.1f ns\n",
+				args->name, r->method->name, r->threads, r->cs, rate,
+				fairness, handoff * STRESS_DBL_NANOSECOND);
+
+		if ((r->threads != 1) && (r->threads != max_threads))
+			continue;
+		if (idx + n_metrics > STRESS_MISC_METRICS_MAX) {
+			dropped += n_metrics;
+			continue;
+		}
+
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 "T cs %" PRIu32 " acquires/sec",
+			r->method->name, r->threads, r->cs);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+		if (r->threads != max_threads)
+			continue;
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 "T cs %" PRIu32 " fairness max/min",
+			r->method->name, r->threads, r->cs);
+		stress_metrics_set(args, idx++, msg, fairness, STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 "T cs %" PRIu32 " nsec handoff",
+			r->method->name, r->threads, r->cs);
+		stress_metrics_set(args, idx++, msg, handoff * STRESS_DBL_NANOSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+	if (dropped && stress_instance_zero(args))
+		pr_inf("%s: %zu metrics exceed the limit of %d and were not reported, "
+			"use -v to see the full table\n", args->name, dropped,
+			STRESS_MISC_METRICS_MAX);
+}
+
+/*
+ *  stress_lockalgo()
+ *	benchmark lock algorithms over a sweep of thread counts
+ *	and critical section lengths
+ */
+static int stress_lockalgo(stress_args_t *args)
+{
+	uint32_t lockalgo_threads = DEFAULT_LOCKALGO_THREADS;
+	uint32_t lockalgo_cs = DEFAULT_LOCKALGO_CS;
+	uint32_t lockalgo_readers = DEFAULT_LOCKALGO_READERS;
+	size_t lockalgo_method = 0;
+	uint32_t sweep_threads[LOCKALGO_MAX_SWEEP_THREADS];
+	uint32_t sweep_cs[LOCKALGO_MAX_SWEEP_CS];
+	size_t n_threads = 0, n_cs = 0, n_results = 0, i, j, k, mmap_size;
+	stress_lockalgo_result_t *results;
+	stress_lockalgo_context_t *ctx;
+	stress_lockalgo_thread_t *threads;
+	uint8_t *mapping;
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("lockalgo-cs", &lockalgo_cs);
+	(void)stress_get_setting("lockalgo-method", &lockalgo_method);
+	(void)stress_get_setting("lockalgo-readers", &lockalgo_readers);
+	if (!stress_get_setting("lockalgo-threads", &lockalgo_threads)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			lockalgo_threads = MAX_LOCKALGO_THREADS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			lockalgo_threads = MIN_LOCKALGO_THREADS;
+	}
+
+	/* 1, 2, 4 .. threads, ending at the maximum */
+	for (i = 1; i < lockalgo_threads; i <<= 1)
+		sweep_threads[n_threads++] = (uint32_t)i;
+	sweep_threads[n_threads++] = lockalgo_threads;
+	/* empty and full length critical sections */
+	sweep_cs[n_cs++] = 0;
+	if (lockalgo_cs > 0)
+		sweep_cs[n_cs++] = lockalgo_cs;
+
+	results = (stress_lockalgo_result_t *)calloc(LOCKALGO_METHODS * n_threads * n_cs, sizeof(*results));
+	if (!results) {
+		pr_inf_skip("%s: cannot allocate results table%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+	for (i = 0; i < LOCKALGO_METHODS; i++) {
+		if (lockalgo_method && (lockalgo_method - 1 != i))
+			continue;
+		for (j = 0; j < n_cs; j++) {
+			for (k = 0; k < n_threads; k++) {
+				results[n_results].method = &stress_lockalgo_methods[i];
+				results[n_results].threads = sweep_threads[k];
+				results[n_results].cs = sweep_cs[j];
+				n_results++;
+			}
+		}
+	}
+
+	/* page aligned so the lock, nodes and threads start on cache lines */
+	mmap_size = sizeof(*ctx) +
+		    ((size_t)lockalgo_threads + 1) * sizeof(stress_lockalgo_node_t) +
+		    (size_t)lockalgo_threads * sizeof(*threads);
+	mapping = (uint8_t *)stress_mmap_populate(NULL, mmap_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for lock state%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, mmap_size,
+			stress_get_memfree_str(), errno, strerror(errno));
+		free(results);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(mapping, mmap_size, "lockalgo-state");
+	ctx = (stress_lockalgo_context_t *)mapping;
+	ctx->nodes = (stress_lockalgo_node_t *)(mapping + sizeof(*ctx));
+	threads = (stress_lockalgo_thread_t *)(ctx->nodes + lockalgo_threads + 1);
+	ctx->readers = lockalgo_readers;
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %zu configurations, %.1f seconds per sweep\n",
+			args->name, n_results,
+			(double)n_results * (double)LOCKALGO_SLICE_NS / STRESS_DBL_NANOSECOND);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		if (!results[i].skipped &&
+		    (stress_lockalgo_run(args, ctx, threads, &results[i]) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		i = (i + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_lockalgo_metrics(args, results, n_results, lockalgo_threads);
+
+	(void)munmap((void *)mapping, mmap_size);
+	free(results);
+
+	return rc;
+}
+
+const stressor_info_t stress_lockalgo_info = {
+	.stressor = stress_lockalgo,
+	.classifier = CLASS_CPU_CACHE | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_lockalgo_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_CPU_CACHE | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread or atomic compare/exchange support"
+};
+#endif
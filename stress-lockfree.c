@@ -0,0 +1,1354 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-affinity.h"
+#include "core-builtin.h"
+#include "core-cpu-cache.h"
+#include "core-cpu-relax.h"
+#include "core-pthread.h"
+
+#if defined(HAVE_PTHREAD_NP_H)
+#include <pthread_np.h>
+#endif
+
+#define MIN_LOCKFREE_THREADS	(2)
+#define MAX_LOCKFREE_THREADS	(256)
+#define DEFAULT_LOCKFREE_THREADS (4)
+
+#define LOCKFREE_SLICE_NS	(100000000ULL)	/* 0.1 seconds per configuration */
+#define LOCKFREE_EMPTY		(0xffffffffU)	/* empty queue slot value */
+
+#define LOCKFREE_RING_SIZE	(1024)		/* Vyukov ring cells */
+#define LOCKFREE_CRQ_SIZE	(1024)		/* LCRQ ring segment entries */
+#define LOCKFREE_CRQ_MAX_SEGS	(16)		/* LCRQ live segment limit */
+#define LOCKFREE_CRQ_STARVING	(64)		/* enqueue retries before closing */
+#define LOCKFREE_POOL_SIZE	(4096)		/* Treiber stack nodes */
+#define LOCKFREE_DEQUE_SIZE	(4096)		/* Chase-Lev deque entries */
+#define LOCKFREE_DEQUE_PUSHES	(32)		/* owner pushes per round */
+#define LOCKFREE_DEQUE_ROUND	(48)		/* owner pushes + pops per round */
+
+#define LOCKFREE_HP_SLOTS	(2)		/* hazard pointers per thread */
+
+#define LOCKFREE_PLACEMENT_ALL		(0)
+#define LOCKFREE_PLACEMENT_NONE		(1)
+#define LOCKFREE_PLACEMENT_COMPACT	(2)
+#define LOCKFREE_PLACEMENT_SPREAD	(3)
+
+static const stress_help_t help[] = {
+	{ NULL,	"lockfree N",		"start N workers benchmarking lock-free data structures" },
+	{ NULL,	"lockfree-method M",	"data structure: all, vyukov, lcrq, treiber, chase-lev" },
+	{ NULL,	"lockfree-ops N",	"stop after N data structure operations" },
+	{ NULL,	"lockfree-placement P",	"thread placement: all, none, compact, spread" },
+	{ NULL,	"lockfree-threads N",	"sweep producer/consumer mixes of up to N threads" },
+	{ NULL,	NULL,			NULL }
+};
+
+static const char * const stress_lockfree_placements[] = {
+	"all",
+	"none",
+	"compact",
+	"spread",
+};
+
+static const char *stress_lockfree_placement(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_lockfree_placements)) ? stress_lockfree_placements[i] : NULL;
+}
+
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_POSIX_MEMALIGN) &&		\
+    defined(HAVE_ATOMIC_COMPARE_EXCHANGE) &&	\
+    defined(HAVE_ATOMIC_FETCH_ADD) &&		\
+    defined(HAVE_ATOMIC_FETCH_OR) &&		\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+
+#define HAVE_LOCKFREE
+
+/*
+ *  LCRQ entry: safe bit, 31 bit cycle index, 32 bit value
+ */
+#define CRQ_IDX_MASK		(0x7fffffffU)
+#define CRQ_CLOSED		(1ULL << 63)
+#define CRQ_SAFE(e)		((uint32_t)((e) >> 63))
+#define CRQ_IDX(e)		((uint32_t)((e) >> 32) & CRQ_IDX_MASK)
+#define CRQ_VAL(e)		((uint32_t)(e))
+#define CRQ_ENTRY(s, i, v)	(((uint64_t)(s) << 63) | 		\
+				 ((uint64_t)((i) & CRQ_IDX_MASK) << 32) | \
+				 (uint64_t)(uint32_t)(v))
+
+#define HP_KIND_NODE		(0)
+#define HP_KIND_CRQ		(1)
+
+/* Vyukov bounded MPMC ring cell */
+typedef struct {
+	uint64_t seq;				/* cell sequence number */
+	uint32_t data;				/* queued value */
+} stress_lockfree_cell_t;
+
+/* LCRQ ring segment */
+typedef struct stress_lockfree_crq {
+	uint64_t head ALIGN64;			/* dequeue index */
+	uint64_t tail ALIGN64;			/* enqueue index, top bit closed */
+	struct stress_lockfree_crq *next ALIGN64; /* next segment */
+	int64_t seq;				/* segment number */
+	uint64_t ring[LOCKFREE_CRQ_SIZE] ALIGN64;
+} stress_lockfree_crq_t;
+
+/* Treiber stack node */
+typedef struct stress_lockfree_node {
+	struct stress_lockfree_node *next;
+	uint64_t value;
+} stress_lockfree_node_t;
+
+/* Chase-Lev work stealing deque, fixed size */
+typedef struct {
+	int64_t top ALIGN64;			/* thieves steal from the top */
+	int64_t bottom ALIGN64;			/* owner pushes and pops at the bottom */
+	uint64_t buf[LOCKFREE_DEQUE_SIZE] ALIGN64;
+} stress_lockfree_deque_t;
+
+/* object waiting for hazard pointer reclamation */
+typedef struct {
+	void *ptr;
+	int kind;
+} stress_lockfree_retired_t;
+
+struct stress_lockfree_context;
+
+/*
+ *  per thread state, hazard pointers on their own cache line
+ */
+typedef struct {
+	struct stress_lockfree_context *ctx ALIGN64;
+	pthread_t pthread;
+	uint32_t id;				/* thread index */
+	uint32_t index;				/* producer or consumer index */
+	bool producer;				/* producer or consumer */
+	bool misorder;				/* FIFO order violated */
+	int cpu;				/* CPU to pin to, -1 = none */
+	uint32_t rnd;				/* victim selection LCG */
+	uint32_t seq;				/* producer sequence number */
+	uint32_t phase;				/* deque owner push/pop phase */
+	uint64_t ops;				/* successful operations */
+	uint64_t produced;			/* items inserted */
+	uint64_t consumed;			/* items removed */
+	uint32_t *last_seq;			/* last sequence seen per producer */
+	stress_lockfree_retired_t *retired;	/* objects pending reclamation */
+	size_t n_retired;
+	void *hp[LOCKFREE_HP_SLOTS] ALIGN64;	/* hazard pointers */
+} stress_lockfree_thread_t;
+
+typedef struct {
+	const char *name;
+	int (*init)(struct stress_lockfree_context *ctx);
+	uint64_t (*deinit)(struct stress_lockfree_context *ctx);	/* returns items left */
+	bool (*produce)(struct stress_lockfree_context *ctx, stress_lockfree_thread_t *thread);
+	bool (*consume)(struct stress_lockfree_context *ctx, stress_lockfree_thread_t *thread);
+} stress_lockfree_method_t;
+
+/*
+ *  state shared by all the threads of a run
+ */
+typedef struct stress_lockfree_context {
+	const stress_lockfree_method_t *method;
+	stress_lockfree_thread_t *threads;
+	uint32_t n_threads;
+	uint32_t n_producers;
+	uint32_t n_consumers;
+	size_t retire_threshold;		/* hazard pointer scan threshold */
+	bool go;				/* start running */
+	bool stop;				/* stop running */
+
+	/* Vyukov ring */
+	stress_lockfree_cell_t *cells;
+	uint64_t enq_pos ALIGN64;
+	uint64_t deq_pos ALIGN64;
+
+	/* LCRQ */
+	stress_lockfree_crq_t *crq_head ALIGN64;
+	stress_lockfree_crq_t *crq_tail ALIGN64;
+
+	/* Treiber stacks, items and free nodes */
+	stress_lockfree_node_t *stack ALIGN64;
+	stress_lockfree_node_t *free_stack ALIGN64;
+	stress_lockfree_node_t *pool;
+
+	/* Chase-Lev deques, one per producer */
+	stress_lockfree_deque_t *deques;
+	size_t deques_size;
+} stress_lockfree_context_t;
+
+/*
+ *  accumulated results for a method/producers/consumers/placement
+ */
+typedef struct {
+	const stress_lockfree_method_t *method;
+	uint32_t producers;
+	uint32_t consumers;
+	size_t placement;
+	bool skipped;
+	uint64_t ops;
+	double duration;
+	double thread_time;			/* duration * threads */
+} stress_lockfree_result_t;
+
+/*
+ *  stress_lockfree_value()
+ *	next queue value for a producer, producer index in the top 8 bits
+ *	and a sequence number in the low 24 bits for FIFO checking
+ */
+static inline uint32_t ALWAYS_INLINE stress_lockfree_value(stress_lockfree_thread_t *thread)
+{
+	const uint32_t value = (thread->index << 24) | (thread->seq & 0xffffff);
+
+	thread->seq++;
+	return value;
+}
+
+/*
+ *  stress_lockfree_check()
+ *	each consumer must see the values from any one producer in the
+ *	order they were produced
+ */
+static inline void ALWAYS_INLINE stress_lockfree_check(
+	stress_lockfree_thread_t *thread,
+	const uint32_t value)
+{
+	const uint32_t producer = value >> 24;
+	const uint32_t seq = value & 0xffffff;
+	const uint32_t last = thread->last_seq[producer];
+
+	if (last != LOCKFREE_EMPTY) {
+		const uint32_t diff = (seq - last) & 0xffffff;
+
+		if (UNLIKELY((diff == 0) || (diff >= 0x800000)))
+			thread->misorder = true;
+	}
+	thread->last_seq[producer] = seq;
+}
+
+/*
+ *  Hazard pointers, a thread publishes the shared objects it is about
+ *  to dereference and removed objects are only reclaimed when no
+ *  thread has published them
+ */
+static inline stress_lockfree_node_t * ALWAYS_INLINE stress_lockfree_hp_node(
+	stress_lockfree_thread_t *thread,
+	const int slot,
+	stress_lockfree_node_t **src)
+{
+	stress_lockfree_node_t *p = __atomic_load_n(src, __ATOMIC_ACQUIRE);
+
+	for (;;) {
+		stress_lockfree_node_t *q;
+
+		__atomic_store_n(&thread->hp[slot], (void *)p, __ATOMIC_SEQ_CST);
+		q = __atomic_load_n(src, __ATOMIC_SEQ_CST);
+		if (q == p)
+			return p;
+		p = q;
+	}
+}
+
+static inline stress_lockfree_crq_t * ALWAYS_INLINE stress_lockfree_hp_crq(
+	stress_lockfree_thread_t *thread,
+	const int slot,
+	stress_lockfree_crq_t **src)
+{
+	stress_lockfree_crq_t *p = __atomic_load_n(src, __ATOMIC_ACQUIRE);
+
+	for (;;) {
+		stress_lockfree_crq_t *q;
+
+		__atomic_store_n(&thread->hp[slot], (void *)p, __ATOMIC_SEQ_CST);
+		q = __atomic_load_n(src, __ATOMIC_SEQ_CST);
+		if (q == p)
+			return p;
+		p = q;
+	}
+}
+
+static inline void ALWAYS_INLINE stress_lockfree_hp_clear(
+	stress_lockfree_thread_t *thread,
+	const int slot)
+{
+	__atomic_store_n(&thread->hp[slot], NULL, __ATOMIC_RELEASE);
+}
+
+static inline void ALWAYS_INLINE stress_lockfree_push(
+	stress_lockfree_node_t **stack,
+	stress_lockfree_node_t *node)
+{
+	stress_lockfree_node_t *top = __atomic_load_n(stack, __ATOMIC_RELAXED);
+
+	do {
+		node->next = top;
+	} while (!__atomic_compare_exchange_n(stack, &top, node,
+			false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*
+ *  stress_lockfree_hp_scan()
+ *	reclaim retired objects that no thread has a hazard pointer to,
+ *	stack nodes go back to the free stack, ring segments are freed
+ */
+static void stress_lockfree_hp_scan(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	size_t i, n = 0;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	for (i = 0; i < thread->n_retired; i++) {
+		void *ptr = thread->retired[i].ptr;
+		bool hazard = false;
+		uint32_t j;
+
+		for (j = 0; (j < ctx->n_threads) && !hazard; j++) {
+			int k;
+
+			for (k = 0; k < LOCKFREE_HP_SLOTS; k++) {
+				if (__atomic_load_n(&ctx->threads[j].hp[k], __ATOMIC_ACQUIRE) == ptr) {
+					hazard = true;
+					break;
+				}
+			}
+		}
+		if (hazard) {
+			thread->retired[n++] = thread->retired[i];
+		} else if (thread->retired[i].kind == HP_KIND_NODE) {
+			stress_lockfree_push(&ctx->free_stack, (stress_lockfree_node_t *)ptr);
+		} else {
+			free(ptr);
+		}
+	}
+	thread->n_retired = n;
+}
+
+static inline void ALWAYS_INLINE stress_lockfree_hp_retire(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread,
+	void *ptr,
+	const int kind)
+{
+	thread->retired[thread->n_retired].ptr = ptr;
+	thread->retired[thread->n_retired].kind = kind;
+	thread->n_retired++;
+	if (thread->n_retired >= ctx->retire_threshold)
+		stress_lockfree_hp_scan(ctx, thread);
+}
+
+/*
+ *  Vyukov bounded MPMC ring, each cell has a sequence number that
+ *  tells producers and consumers whose turn it is
+ */
+static int stress_lockfree_vyukov_init(stress_lockfree_context_t *ctx)
+{
+	uint64_t i;
+
+	ctx->cells = (stress_lockfree_cell_t *)calloc(LOCKFREE_RING_SIZE, sizeof(*ctx->cells));
+	if (!ctx->cells)
+		return -1;
+	for (i = 0; i < LOCKFREE_RING_SIZE; i++)
+		ctx->cells[i].seq = i;
+	ctx->enq_pos = 0;
+	ctx->deq_pos = 0;
+	return 0;
+}
+
+static uint64_t stress_lockfree_vyukov_deinit(stress_lockfree_context_t *ctx)
+{
+	const uint64_t left = ctx->enq_pos - ctx->deq_pos;
+
+	free(ctx->cells);
+	ctx->cells = NULL;
+	return left;
+}
+
+static bool stress_lockfree_vyukov_produce(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	uint64_t pos = __atomic_load_n(&ctx->enq_pos, __ATOMIC_RELAXED);
+	stress_lockfree_cell_t *cell;
+
+	for (;;) {
+		int64_t diff;
+
+		cell = &ctx->cells[pos & (LOCKFREE_RING_SIZE - 1)];
+		diff = (int64_t)__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (int64_t)pos;
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&ctx->enq_pos, &pos, pos + 1,
+					true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return false;	/* full */
+		} else {
+			pos = __atomic_load_n(&ctx->enq_pos, __ATOMIC_RELAXED);
+		}
+	}
+	cell->data = stress_lockfree_value(thread);
+	__atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+static bool stress_lockfree_vyukov_consume(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	uint64_t pos = __atomic_load_n(&ctx->deq_pos, __ATOMIC_RELAXED);
+	stress_lockfree_cell_t *cell;
+
+	for (;;) {
+		int64_t diff;
+
+		cell = &ctx->cells[pos & (LOCKFREE_RING_SIZE - 1)];
+		diff = (int64_t)__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (int64_t)(pos + 1);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&ctx->deq_pos, &pos, pos + 1,
+					true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return false;	/* empty */
+		} else {
+			pos = __atomic_load_n(&ctx->deq_pos, __ATOMIC_RELAXED);
+		}
+	}
+	stress_lockfree_check(thread, cell->data);
+	__atomic_store_n(&cell->seq, pos + LOCKFREE_RING_SIZE, __ATOMIC_RELEASE);
+	return true;
+}
+
+/*
+ *  LCRQ, a linked list of concurrent ring queues where enqueuers and
+ *  dequeuers claim slots with fetch-and-add rather than CAS loops. The
+ *  ring entries pack the safe bit, cycle index and value into 64 bits
+ *  so only single width CAS is needed, the cycle indexes wrap and are
+ *  compared with serial number arithmetic
+ */
+static inline int32_t ALWAYS_INLINE stress_lockfree_crq_cmp(const uint32_t a, const uint64_t b)
+{
+	return (int32_t)(((a - (uint32_t)b) & CRQ_IDX_MASK) << 1);
+}
+
+static stress_lockfree_crq_t *stress_lockfree_crq_alloc(const int64_t seq)
+{
+	stress_lockfree_crq_t *crq;
+	uint32_t i;
+
+	if (posix_memalign((void **)&crq, 64, sizeof(*crq)) != 0)
+		return NULL;
+	crq->head = 0;
+	crq->tail = 0;
+	crq->next = NULL;
+	crq->seq = seq;
+	for (i = 0; i < LOCKFREE_CRQ_SIZE; i++)
+		crq->ring[i] = CRQ_ENTRY(1, i, LOCKFREE_EMPTY);
+	return crq;
+}
+
+static void stress_lockfree_crq_fix_state(stress_lockfree_crq_t *crq)
+{
+	for (;;) {
+		uint64_t t = __atomic_load_n(&crq->tail, __ATOMIC_ACQUIRE);
+		const uint64_t h = __atomic_load_n(&crq->head, __ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&crq->tail, __ATOMIC_ACQUIRE) != t)
+			continue;
+		if (h <= t)
+			return;
+		if (__atomic_compare_exchange_n(&crq->tail, &t, h,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+			return;
+	}
+}
+
+static bool stress_lockfree_crq_enqueue(stress_lockfree_crq_t *crq, const uint32_t value)
+{
+	uint32_t tries = 0;
+
+	for (;;) {
+		const uint64_t tc = __atomic_fetch_add(&crq->tail, 1, __ATOMIC_ACQ_REL);
+		const uint64_t t = tc & ~CRQ_CLOSED;
+		uint64_t *slot, e, h;
+
+		if (tc & CRQ_CLOSED)
+			return false;
+		slot = &crq->ring[t & (LOCKFREE_CRQ_SIZE - 1)];
+		e = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+		if ((CRQ_VAL(e) == LOCKFREE_EMPTY) &&
+		    (stress_lockfree_crq_cmp(CRQ_IDX(e), t) <= 0) &&
+		    (CRQ_SAFE(e) || (__atomic_load_n(&crq->head, __ATOMIC_ACQUIRE) <= t))) {
+			if (__atomic_compare_exchange_n(slot, &e, CRQ_ENTRY(1, t, value),
+					false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+				return true;
+		}
+		h = __atomic_load_n(&crq->head, __ATOMIC_ACQUIRE);
+		if (((int64_t)(t - h) >= LOCKFREE_CRQ_SIZE) || (++tries > LOCKFREE_CRQ_STARVING)) {
+			(void)__atomic_fetch_or(&crq->tail, CRQ_CLOSED, __ATOMIC_ACQ_REL);
+			return false;
+		}
+	}
+}
+
+static bool stress_lockfree_crq_dequeue(stress_lockfree_crq_t *crq, uint32_t *value)
+{
+	for (;;) {
+		const uint64_t h = __atomic_fetch_add(&crq->head, 1, __ATOMIC_ACQ_REL);
+		uint64_t *slot = &crq->ring[h & (LOCKFREE_CRQ_SIZE - 1)];
+		uint64_t t;
+
+		for (;;) {
+			uint64_t e = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+			const uint32_t idx = CRQ_IDX(e);
+			const uint32_t val = CRQ_VAL(e);
+
+			if (stress_lockfree_crq_cmp(idx, h) > 0)
+				break;
+			if (val != LOCKFREE_EMPTY) {
+				if (idx == (uint32_t)(h & CRQ_IDX_MASK)) {
+					if (__atomic_compare_exchange_n(slot, &e,
+							CRQ_ENTRY(CRQ_SAFE(e), h + LOCKFREE_CRQ_SIZE, LOCKFREE_EMPTY),
+							false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+						*value = val;
+						return true;
+					}
+				} else {
+					/* an older value is still pending, mark the slot unsafe */
+					if (__atomic_compare_exchange_n(slot, &e, CRQ_ENTRY(0, idx, val),
+							false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+						break;
+				}
+			} else {
+				/* advance the empty slot so a late enqueuer cannot use it */
+				if (__atomic_compare_exchange_n(slot, &e,
+						CRQ_ENTRY(CRQ_SAFE(e), h + LOCKFREE_CRQ_SIZE, LOCKFREE_EMPTY),
+						false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+					break;
+			}
+		}
+		t = __atomic_load_n(&crq->tail, __ATOMIC_ACQUIRE) & ~CRQ_CLOSED;
+		if (t <= h + 1) {
+			stress_lockfree_crq_fix_state(crq);
+			return false;
+		}
+	}
+}
+
+static int stress_lockfree_lcrq_init(stress_lockfree_context_t *ctx)
+{
+	ctx->crq_head = stress_lockfree_crq_alloc(0);
+	if (!ctx->crq_head)
+		return -1;
+	ctx->crq_tail = ctx->crq_head;
+	return 0;
+}
+
+static uint64_t stress_lockfree_lcrq_deinit(stress_lockfree_context_t *ctx)
+{
+	stress_lockfree_crq_t *crq = ctx->crq_head;
+	uint64_t left = 0;
+
+	while (crq) {
+		stress_lockfree_crq_t *next = crq->next;
+		uint32_t value;
+
+		while (stress_lockfree_crq_dequeue(crq, &value))
+			left++;
+		free(crq);
+		crq = next;
+	}
+	ctx->crq_head = NULL;
+	ctx->crq_tail = NULL;
+	return left;
+}
+
+static bool stress_lockfree_lcrq_produce(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	const uint32_t value = stress_lockfree_value(thread);
+
+	for (;;) {
+		stress_lockfree_crq_t *crq = stress_lockfree_hp_crq(thread, 0, &ctx->crq_tail);
+		stress_lockfree_crq_t *next = __atomic_load_n(&crq->next, __ATOMIC_ACQUIRE);
+		const stress_lockfree_crq_t *head;
+		stress_lockfree_crq_t *expected = NULL;
+
+		if (next) {
+			(void)__atomic_compare_exchange_n(&ctx->crq_tail, &crq, next,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (stress_lockfree_crq_enqueue(crq, value))
+			break;
+
+		/* segment closed, bound the number of live segments */
+		head = stress_lockfree_hp_crq(thread, 1, &ctx->crq_head);
+		if (crq->seq - head->seq >= LOCKFREE_CRQ_MAX_SEGS - 1) {
+			stress_lockfree_hp_clear(thread, 0);
+			stress_lockfree_hp_clear(thread, 1);
+			thread->seq--;	/* value was not queued */
+			return false;
+		}
+		next = stress_lockfree_crq_alloc(crq->seq + 1);
+		if (!next) {
+			stress_lockfree_hp_clear(thread, 0);
+			stress_lockfree_hp_clear(thread, 1);
+			thread->seq--;	/* value was not queued */
+			return false;
+		}
+		next->ring[0] = CRQ_ENTRY(1, 0, value);
+		next->tail = 1;
+		if (__atomic_compare_exchange_n(&crq->next, &expected, next,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			(void)__atomic_compare_exchange_n(&ctx->crq_tail, &crq, next,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+			break;
+		}
+		free(next);
+	}
+	stress_lockfree_hp_clear(thread, 0);
+	stress_lockfree_hp_clear(thread, 1);
+	return true;
+}
+
+static bool stress_lockfree_lcrq_consume(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	uint32_t value;
+
+	for (;;) {
+		stress_lockfree_crq_t *crq = stress_lockfree_hp_crq(thread, 0, &ctx->crq_head);
+		stress_lockfree_crq_t *next, *tail;
+
+		if (stress_lockfree_crq_dequeue(crq, &value))
+			break;
+		next = __atomic_load_n(&crq->next, __ATOMIC_ACQUIRE);
+		if (!next) {
+			stress_lockfree_hp_clear(thread, 0);
+			return false;
+		}
+		/* items may have landed before the segment closed */
+		if (stress_lockfree_crq_dequeue(crq, &value))
+			break;
+		/* the tail must move on before the segment can be retired */
+		tail = crq;
+		(void)__atomic_compare_exchange_n(&ctx->crq_tail, &tail, next,
+			false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+		if (__atomic_compare_exchange_n(&ctx->crq_head, &crq, next,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			stress_lockfree_hp_clear(thread, 0);
+			stress_lockfree_hp_retire(ctx, thread, crq, HP_KIND_CRQ);
+		}
+	}
+	stress_lockfree_hp_clear(thread, 0);
+	stress_lockfree_check(thread, value);
+	return true;
+}
+
+/*
+ *  Treiber stack with hazard pointers, producers take nodes from a
+ *  free stack so the number of nodes is bounded, consumers retire
+ *  popped nodes back to the free stack once they are not hazardous
+ */
+static stress_lockfree_node_t *stress_lockfree_pop(
+	stress_lockfree_thread_t *thread,
+	stress_lockfree_node_t **stack)
+{
+	stress_lockfree_node_t *top;
+
+	for (;;) {
+		stress_lockfree_node_t *next;
+
+		top = stress_lockfree_hp_node(thread, 0, stack);
+		if (!top)
+			break;
+		next = __atomic_load_n(&top->next, __ATOMIC_RELAXED);
+		if (__atomic_compare_exchange_n(stack, &top, next,
+				false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			break;
+	}
+	stress_lockfree_hp_clear(thread, 0);
+	return top;
+}
+
+static int stress_lockfree_treiber_init(stress_lockfree_context_t *ctx)
+{
+	size_t i;
+
+	ctx->pool = (stress_lockfree_node_t *)calloc(LOCKFREE_POOL_SIZE, sizeof(*ctx->pool));
+	if (!ctx->pool)
+		return -1;
+	ctx->stack = NULL;
+	ctx->free_stack = NULL;
+	for (i = 0; i < LOCKFREE_POOL_SIZE; i++)
+		stress_lockfree_push(&ctx->free_stack, &ctx->pool[i]);
+	return 0;
+}
+
+static uint64_t stress_lockfree_treiber_deinit(stress_lockfree_context_t *ctx)
+{
+	const stress_lockfree_node_t *node;
+	uint64_t left = 0;
+
+	for (node = ctx->stack; node; node = node->next)
+		left++;
+	free(ctx->pool);
+	ctx->pool = NULL;
+	return left;
+}
+
+static bool stress_lockfree_treiber_produce(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	stress_lockfree_node_t *node = stress_lockfree_pop(thread, &ctx->free_stack);
+
+	if (!node)
+		return false;	/* all nodes in use */
+	node->value = stress_lockfree_value(thread);
+	stress_lockfree_push(&ctx->stack, node);
+	return true;
+}
+
+static bool stress_lockfree_treiber_consume(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	stress_lockfree_node_t *node = stress_lockfree_pop(thread, &ctx->stack);
+
+	if (!node) {
+		/* nothing to pop, hand back any nodes that are now safe */
+		if (thread->n_retired)
+			stress_lockfree_hp_scan(ctx, thread);
+		return false;
+	}
+	if (UNLIKELY((node->value >> 24) >= ctx->n_producers))
+		thread->misorder = true;
+	stress_lockfree_hp_retire(ctx, thread, node, HP_KIND_NODE);
+	return true;
+}
+
+/*
+ *  Chase-Lev work stealing deques (C11 memory model version by Le et al),
+ *  producers own a deque and push and pop at the bottom, consumers
+ *  steal from the top of randomly chosen deques
+ */
+static int stress_lockfree_chase_lev_init(stress_lockfree_context_t *ctx)
+{
+	ctx->deques_size = (size_t)ctx->n_producers * sizeof(*ctx->deques);
+	ctx->deques = (stress_lockfree_deque_t *)mmap(NULL, ctx->deques_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ctx->deques == MAP_FAILED) {
+		ctx->deques = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+static uint64_t stress_lockfree_chase_lev_deinit(stress_lockfree_context_t *ctx)
+{
+	uint64_t left = 0;
+	uint32_t i;
+
+	for (i = 0; i < ctx->n_producers; i++)
+		left += (uint64_t)(ctx->deques[i].bottom - ctx->deques[i].top);
+	(void)munmap((void *)ctx->deques, ctx->deques_size);
+	ctx->deques = NULL;
+	return left;
+}
+
+static bool stress_lockfree_chase_lev_produce(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	stress_lockfree_deque_t *dq = &ctx->deques[thread->index];
+	int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+	int64_t t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+	const bool push = (thread->phase < LOCKFREE_DEQUE_PUSHES);
+
+	thread->phase = (thread->phase + 1) % LOCKFREE_DEQUE_ROUND;
+	if ((push && (b - t < LOCKFREE_DEQUE_SIZE)) || (b - t <= 0)) {
+		__atomic_store_n(&dq->buf[b & (LOCKFREE_DEQUE_SIZE - 1)],
+			(uint64_t)stress_lockfree_value(thread), __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+		thread->produced++;
+		return true;
+	}
+
+	/* pop from the bottom, races with thieves for the last item */
+	b = b - 1;
+	__atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+	if (t <= b) {
+		bool got = true;
+
+		(void)__atomic_load_n(&dq->buf[b & (LOCKFREE_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+		if (t == b) {
+			if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1,
+					false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+				got = false;
+			__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+		}
+		if (got)
+			thread->consumed++;
+		return got;
+	}
+	__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+	return false;
+}
+
+static bool stress_lockfree_chase_lev_consume(
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *thread)
+{
+	stress_lockfree_deque_t *dq;
+	int64_t t, b;
+
+	thread->rnd = (thread->rnd * 1103515245U) + 12345U;
+	dq = &ctx->deques[(thread->rnd >> 16) % ctx->n_producers];
+
+	t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+	if (t < b) {
+		const uint64_t value = __atomic_load_n(&dq->buf[t & (LOCKFREE_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+
+		if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1,
+				false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			return false;	/* lost the race */
+		if (UNLIKELY((value >> 24) != (uint64_t)(dq - ctx->deques)))
+			thread->misorder = true;
+		return true;
+	}
+	return false;
+}
+
+static const stress_lockfree_method_t stress_lockfree_methods[] = {
+	{ "vyukov",	stress_lockfree_vyukov_init, stress_lockfree_vyukov_deinit,
+			stress_lockfree_vyukov_produce, stress_lockfree_vyukov_consume },
+	{ "lcrq",	stress_lockfree_lcrq_init, stress_lockfree_lcrq_deinit,
+			stress_lockfree_lcrq_produce, stress_lockfree_lcrq_consume },
+	{ "treiber",	stress_lockfree_treiber_init, stress_lockfree_treiber_deinit,
+			stress_lockfree_treiber_produce, stress_lockfree_treiber_consume },
+	{ "chase-lev",	stress_lockfree_chase_lev_init, stress_lockfree_chase_lev_deinit,
+			stress_lockfree_chase_lev_produce, stress_lockfree_chase_lev_consume },
+};
+
+#define LOCKFREE_METHODS	SIZEOF_ARRAY(stress_lockfree_methods)
+
+static const char *stress_lockfree_method(const size_t i)
+{
+	if (i == 0)
+		return "all";
+	return (i <= LOCKFREE_METHODS) ? stress_lockfree_methods[i - 1].name : NULL;
+}
+#else
+static const char *stress_lockfree_method(const size_t i)
+{
+	return (i == 0) ? "all" : NULL;
+}
+#endif
+
+static const stress_opt_t opts[] = {
+	{ OPT_lockfree_method,	  "lockfree-method",    TYPE_ID_SIZE_T_METHOD, 0, 0, stress_lockfree_method },
+	{ OPT_lockfree_placement, "lockfree-placement", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_lockfree_placement },
+	{ OPT_lockfree_threads,	  "lockfree-threads",   TYPE_ID_UINT32, MIN_LOCKFREE_THREADS, MAX_LOCKFREE_THREADS, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_LOCKFREE)
+
+/*
+ *  stress_lockfree_thread()
+ *	produce or consume until told to stop
+ */
+static void *stress_lockfree_thread(void *arg)
+{
+	stress_lockfree_thread_t *thread = (stress_lockfree_thread_t *)arg;
+	stress_lockfree_context_t *ctx = thread->ctx;
+	bool (*op)(stress_lockfree_context_t *ctx, stress_lockfree_thread_t *thread) =
+		thread->producer ? ctx->method->produce : ctx->method->consume;
+	uint32_t spins = 0;
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP)
+	if (thread->cpu >= 0) {
+		cpu_set_t cpuset;
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(thread->cpu, &cpuset);
+		(void)pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+	}
+#endif
+	while (!__atomic_load_n(&ctx->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)) {
+		if (op(ctx, thread))
+			thread->ops++;
+		else
+			(void)stress_cpu_relax_yield(&spins);
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_lockfree_run()
+ *	run one configuration for a time slice, check no items were
+ *	lost or reordered and accumulate the results
+ */
+static int stress_lockfree_run(
+	stress_args_t *args,
+	stress_lockfree_context_t *ctx,
+	stress_lockfree_thread_t *threads,
+	uint32_t *last_seq,
+	const uint32_t *order,
+	stress_lockfree_result_t *result)
+{
+	const uint32_t n = result->producers + result->consumers;
+	const uint32_t n_cpus = order[0];
+	uint64_t ops = 0, produced = 0, consumed = 0, left;
+	uint32_t i, p = 0, c = 0, created;
+	bool misorder = false;
+	double t;
+
+	ctx->method = result->method;
+	ctx->threads = threads;
+	ctx->n_threads = n;
+	ctx->n_producers = result->producers;
+	ctx->n_consumers = result->consumers;
+	ctx->retire_threshold = (2 * (size_t)n * LOCKFREE_HP_SLOTS) + 8;
+	ctx->go = false;
+	ctx->stop = false;
+
+	/* alternate producers and consumers so pairs land on adjacent CPUs */
+	for (i = 0; i < n; i++) {
+		stress_lockfree_thread_t *thread = &threads[i];
+		const bool producer = (p < result->producers) &&
+				      (((i & 1) == 0) || (c >= result->consumers));
+
+		thread->ctx = ctx;
+		thread->id = i;
+		thread->producer = producer;
+		thread->index = producer ? p++ : c++;
+		thread->misorder = false;
+		if (result->placement == LOCKFREE_PLACEMENT_COMPACT)
+			thread->cpu = (int)order[1 + (i % n_cpus)];
+		else if (result->placement == LOCKFREE_PLACEMENT_SPREAD)
+			thread->cpu = (int)order[1 + n_cpus + (i % n_cpus)];
+		else
+			thread->cpu = -1;
+		thread->rnd = stress_mwc32();
+		thread->seq = 0;
+		thread->phase = 0;
+		thread->ops = 0;
+		thread->produced = 0;
+		thread->consumed = 0;
+		thread->last_seq = &last_seq[(size_t)i * MAX_LOCKFREE_THREADS];
+		(void)shim_memset(thread->last_seq, 0xff, MAX_LOCKFREE_THREADS * sizeof(*last_seq));
+		thread->n_retired = 0;
+		(void)shim_memset(thread->hp, 0, sizeof(thread->hp));
+	}
+	if (result->method->init(ctx) < 0) {
+		pr_dbg("%s: cannot allocate %s data structure, skipping it\n",
+			args->name, result->method->name);
+		result->skipped = true;
+		return 0;
+	}
+
+	for (created = 0; created < n; created++) {
+		if (pthread_create(&threads[created].pthread, NULL,
+				stress_lockfree_thread, (void *)&threads[created]) != 0)
+			break;
+	}
+	if (created < n) {
+		pr_dbg("%s: only created %" PRIu32 " of %" PRIu32 " threads, skipping "
+			"%" PRIu32 " thread configurations\n", args->name, created, n, n);
+		result->skipped = true;
+	}
+
+	t = stress_time_now();
+	__atomic_store_n(&ctx->go, true, __ATOMIC_RELEASE);
+	if (!result->skipped)
+		(void)shim_nanosleep_uint64(LOCKFREE_SLICE_NS);
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELAXED);
+	t = stress_time_now() - t;
+
+	for (i = 0; i < created; i++)
+		VOID_RET(int, pthread_join(threads[i].pthread, NULL));
+
+	/* threads have gone, nothing is hazardous any more */
+	for (i = 0; i < n; i++) {
+		size_t j;
+
+		for (j = 0; j < threads[i].n_retired; j++) {
+			if (threads[i].retired[j].kind == HP_KIND_CRQ)
+				free(threads[i].retired[j].ptr);
+		}
+		threads[i].n_retired = 0;
+
+		ops += threads[i].ops;
+		misorder |= threads[i].misorder;
+		if (result->method->produce == stress_lockfree_chase_lev_produce) {
+			/* owners both insert and remove items */
+			produced += threads[i].produced;
+			consumed += threads[i].consumed + (threads[i].producer ? 0 : threads[i].ops);
+		} else if (threads[i].producer) {
+			produced += threads[i].ops;
+		} else {
+			consumed += threads[i].ops;
+		}
+	}
+	left = result->method->deinit(ctx);
+
+	if (result->skipped)
+		return 0;
+	if (misorder) {
+		pr_fail("%s: %s returned items out of order or from the wrong producer\n",
+			args->name, result->method->name);
+		return -1;
+	}
+	if (produced != consumed + left) {
+		pr_fail("%s: %s lost items, %" PRIu64 " inserted, %" PRIu64
+			" removed and %" PRIu64 " left\n", args->name,
+			result->method->name, produced, consumed, left);
+		return -1;
+	}
+	result->ops += ops;
+	result->duration += t;
+	result->thread_time += t * (double)n;
+	stress_bogo_add(args, ops);
+	return 0;
+}
+
+/*
+ *  stress_lockfree_topology_cmp()
+ *	sort CPUs so that SMT siblings, then cores sharing a cluster,
+ *	cache, die and package are adjacent
+ */
+static int stress_lockfree_topology_cmp(const void *p1, const void *p2)
+{
+	const stress_cpu_topology_t *t1 = (const stress_cpu_topology_t *)p1;
+	const stress_cpu_topology_t *t2 = (const stress_cpu_topology_t *)p2;
+
+	if (t1->package_id != t2->package_id)
+		return (t1->package_id < t2->package_id) ? -1 : 1;
+	if (t1->die_id != t2->die_id)
+		return (t1->die_id < t2->die_id) ? -1 : 1;
+	if (t1->llc_id != t2->llc_id)
+		return (t1->llc_id < t2->llc_id) ? -1 : 1;
+	if (t1->cluster_id != t2->cluster_id)
+		return (t1->cluster_id < t2->cluster_id) ? -1 : 1;
+	if (t1->core_id != t2->core_id)
+		return (t1->core_id < t2->core_id) ? -1 : 1;
+	if (t1->cpu != t2->cpu)
+		return (t1->cpu < t2->cpu) ? -1 : 1;
+	return 0;
+}
+
+typedef struct {
+	uint32_t cpu;
+	uint32_t sibling;			/* nth SMT thread of its core */
+	uint32_t core;				/* nth core of its package */
+	int32_t package;
+} stress_lockfree_spread_t;
+
+static int stress_lockfree_spread_cmp(const void *p1, const void *p2)
+{
+	const stress_lockfree_spread_t *s1 = (const stress_lockfree_spread_t *)p1;
+	const stress_lockfree_spread_t *s2 = (const stress_lockfree_spread_t *)p2;
+
+	if (s1->sibling != s2->sibling)
+		return (s1->sibling < s2->sibling) ? -1 : 1;
+	if (s1->core != s2->core)
+		return (s1->core < s2->core) ? -1 : 1;
+	if (s1->package != s2->package)
+		return (s1->package < s2->package) ? -1 : 1;
+	return (s1->cpu < s2->cpu) ? -1 : ((s1->cpu > s2->cpu) ? 1 : 0);
+}
+
+/*
+ *  stress_lockfree_cpu_order()
+ *	order[0] is the number of CPUs n, followed by n CPUs in compact
+ *	order (fill SMT siblings and cores of a package first) and n CPUs
+ *	in spread order (one thread per core, round robin over packages,
+ *	SMT siblings last)
+ */
+static uint32_t *stress_lockfree_cpu_order(void)
+{
+	uint32_t *cpus = NULL, *order;
+	uint32_t i, j, n_cpus;
+	stress_cpu_topology_t *topology;
+	stress_lockfree_spread_t *spread;
+
+	n_cpus = stress_get_usable_cpus(&cpus, true);
+	if (n_cpus == 0)
+		return NULL;
+	order = (uint32_t *)calloc(1 + 2 * (size_t)n_cpus, sizeof(*order));
+	topology = (stress_cpu_topology_t *)calloc(n_cpus, sizeof(*topology));
+	spread = (stress_lockfree_spread_t *)calloc(n_cpus, sizeof(*spread));
+	if (!order || !topology || !spread) {
+		free(spread);
+		free(topology);
+		free(order);
+		stress_free_usable_cpus(&cpus);
+		return NULL;
+	}
+	for (i = 0; i < n_cpus; i++)
+		stress_cpu_topology_get(cpus[i], &topology[i]);
+	qsort(topology, n_cpus, sizeof(*topology), stress_lockfree_topology_cmp);
+
+	order[0] = n_cpus;
+	for (i = 0; i < n_cpus; i++) {
+		order[1 + i] = topology[i].cpu;
+		spread[i].cpu = topology[i].cpu;
+		spread[i].package = topology[i].package_id;
+		for (j = 0; j < i; j++) {
+			const stress_cpu_topology_rel_t rel = stress_cpu_topology_rel(&topology[i], &topology[j]);
+
+			if (rel == STRESS_CPU_REL_SMT)
+				spread[i].sibling++;
+			else if ((spread[j].sibling == 0) &&
+				 (topology[i].package_id == topology[j].package_id))
+				spread[i].core++;
+		}
+	}
+	qsort(spread, n_cpus, sizeof(*spread), stress_lockfree_spread_cmp);
+	for (i = 0; i < n_cpus; i++)
+		order[1 + n_cpus + i] = spread[i].cpu;
+
+	free(spread);
+	free(topology);
+	stress_free_usable_cpus(&cpus);
+	return order;
+}
+
+/*
+ *  stress_lockfree_metrics()
+ *	operations per second and mean time per operation per thread
+ */
+static void stress_lockfree_metrics(
+	stress_args_t *args,
+	const stress_lockfree_result_t *results,
+	const size_t n_results)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_lockfree_result_t *r = &results[i];
+		const double rate = (r->duration > 0.0) ? (double)r->ops / r->duration : 0.0;
+		const double per_op = (r->ops > 0) ? r->thread_time / (double)r->ops : 0.0;
+		char msg[64];
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-10s %3" PRIu32 "P %3" PRIu32 "C %-8s %12.0f ops/sec, %10.1f ns per op\n",
+				args->name, r->method->name, r->producers, r->consumers,
+				stress_lockfree_placements[r->placement], rate,
+				per_op * STRESS_DBL_NANOSECOND);
+
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 "P/%" PRIu32 "C %s ops/sec",
+			r->method->name, r->producers, r->consumers,
+			stress_lockfree_placements[r->placement]);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 "P/%" PRIu32 "C %s nsec per op",
+			r->method->name, r->producers, r->consumers,
+			stress_lockfree_placements[r->placement]);
+		stress_metrics_set(args, idx++, msg, per_op * STRESS_DBL_NANOSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_lockfree()
+ *	benchmark lock-free data structures over a sweep of producer
+ *	and consumer mixes and thread placements
+ */
+static int stress_lockfree(stress_args_t *args)
+{
+	uint32_t lockfree_threads = DEFAULT_LOCKFREE_THREADS;
+	size_t lockfree_method = 0, lockfree_placement = LOCKFREE_PLACEMENT_ALL;
+	uint32_t mixes[4][2], *order, *last_seq = NULL;
+	size_t n_mixes = 0, n_placements = 0, n_results = 0, i, j, k, l;
+	size_t placements[2], retired_size;
+	stress_lockfree_result_t *results = NULL;
+	stress_lockfree_context_t *ctx = NULL;
+	stress_lockfree_thread_t *threads = NULL;
+	stress_lockfree_retired_t *retired = NULL;
+	int rc = EXIT_SUCCESS;
+	bool free_order = true;
+
+	(void)stress_get_setting("lockfree-method", &lockfree_method);
+	(void)stress_get_setting("lockfree-placement", &lockfree_placement);
+	if (!stress_get_setting("lockfree-threads", &lockfree_threads)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			lockfree_threads = MAX_LOCKFREE_THREADS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			lockfree_threads = MIN_LOCKFREE_THREADS;
+	}
+
+	/* 1:1, 1:N-1, N-1:1 and N/2:N/2 producers:consumers */
+	{
+		const uint32_t candidates[4][2] = {
+			{ 1, 1 },
+			{ 1, lockfree_threads - 1 },
+			{ lockfree_threads - 1, 1 },
+			{ lockfree_threads / 2, lockfree_threads - (lockfree_threads / 2) },
+		};
+
+		for (i = 0; i < 4; i++) {
+			bool dup = false;
+
+			for (j = 0; j < n_mixes; j++) {
+				if ((mixes[j][0] == candidates[i][0]) &&
+				    (mixes[j][1] == candidates[i][1]))
+					dup = true;
+			}
+			if (!dup) {
+				mixes[n_mixes][0] = candidates[i][0];
+				mixes[n_mixes][1] = candidates[i][1];
+				n_mixes++;
+			}
+		}
+	}
+
+	order = stress_lockfree_cpu_order();
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP)
+	if (order && (order[0] > 1)) {
+		if (lockfree_placement == LOCKFREE_PLACEMENT_ALL) {
+			placements[n_placements++] = LOCKFREE_PLACEMENT_COMPACT;
+			placements[n_placements++] = LOCKFREE_PLACEMENT_SPREAD;
+		} else {
+			placements[n_placements++] = lockfree_placement;
+		}
+	}
+#endif
+	if (n_placements == 0) {
+		if ((lockfree_placement != LOCKFREE_PLACEMENT_ALL) &&
+		    (lockfree_placement != LOCKFREE_PLACEMENT_NONE) &&
+		    stress_instance_zero(args))
+			pr_inf("%s: cannot pin threads to more than one CPU, using no placement\n",
+				args->name);
+		placements[n_placements++] = LOCKFREE_PLACEMENT_NONE;
+	}
+	if (!order) {
+		/* no usable CPU list, threads are not pinned */
+		static uint32_t no_order[3] = { 1, 0, 0 };
+
+		order = no_order;
+		free_order = false;
+		placements[0] = LOCKFREE_PLACEMENT_NONE;
+		n_placements = 1;
+	}
+
+	results = (stress_lockfree_result_t *)calloc(LOCKFREE_METHODS * n_mixes * n_placements, sizeof(*results));
+	ctx = (stress_lockfree_context_t *)calloc(1, sizeof(*ctx));
+	last_seq = (uint32_t *)calloc((size_t)lockfree_threads * MAX_LOCKFREE_THREADS, sizeof(*last_seq));
+	retired_size = (2 * (size_t)lockfree_threads * LOCKFREE_HP_SLOTS) + 8;
+	retired = (stress_lockfree_retired_t *)calloc((size_t)lockfree_threads * retired_size, sizeof(*retired));
+	if (!results || !ctx || !last_seq || !retired) {
+		pr_inf_skip("%s: cannot allocate result and thread tables%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_tables;
+	}
+	if (posix_memalign((void **)&threads, 64, (size_t)lockfree_threads * sizeof(*threads)) != 0) {
+		threads = NULL;
+		pr_inf_skip("%s: cannot allocate thread state%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_tables;
+	}
+	(void)shim_memset(threads, 0, (size_t)lockfree_threads * sizeof(*threads));
+	for (i = 0; i < lockfree_threads; i++)
+		threads[i].retired = &retired[i * retired_size];
+
+	for (i = 0; i < LOCKFREE_METHODS; i++) {
+		if (lockfree_method && (lockfree_method - 1 != i))
+			continue;
+		for (j = 0; j < n_placements; j++) {
+			for (k = 0; k < n_mixes; k++) {
+				stress_lockfree_result_t *r = &results[n_results++];
+
+				r->method = &stress_lockfree_methods[i];
+				r->placement = placements[j];
+				r->producers = mixes[k][0];
+				r->consumers = mixes[k][1];
+			}
+		}
+	}
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %zu configurations, %.1f seconds per sweep\n",
+			args->name, n_results,
+			(double)n_results * (double)LOCKFREE_SLICE_NS / STRESS_DBL_NANOSECOND);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	l = 0;
+	do {
+		if (!results[l].skipped &&
+		    (stress_lockfree_run(args, ctx, threads, last_seq, order, &results[l]) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		l = (l + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_lockfree_metrics(args, results, n_results);
+
+free_tables:
+	free(threads);
+	free(retired);
+	free(last_seq);
+	free(ctx);
+	free(results);
+	if (free_order)
+		free(order);
+	return rc;
+}
+
+const stressor_info_t stress_lockfree_info = {
+	.stressor = stress_lockfree,
+	.classifier = CLASS_CPU_CACHE | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_lockfree_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_CPU_CACHE | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread, posix_memalign() or atomic compare/exchange support"
+};
+#endif
@@ -19,6 +19,8 @@
  */
 #include "stress-ng.h"
 #include "core-pragma.h"
+#include "core-put.h"
+#include "core-vmstat.h"
 
 #define MIN_READAHEAD_BYTES	(1 * MB)
 #define MAX_READAHEAD_BYTES	(MAX_FILE_LIMIT)
@@ -28,15 +30,25 @@
 #define BUF_SIZE		(4096)
 #define MAX_OFFSETS		(16)
 
+#define MIN_READAHEAD_WINDOW	(4 * KB)
+#define MAX_READAHEAD_WINDOW	(64 * MB)
+#define DEFAULT_READAHEAD_WINDOW (512 * KB)
+
+#define READAHEAD_STRIDE_PAGES	(8)	/* stride pattern accesses every 8th page */
+
 static const stress_help_t help[] = {
 	{ NULL,	"readahead N",		"start N workers exercising file readahead" },
 	{ NULL,	"readahead-bytes N",	"size of file to readahead on (default is 1GB)" },
 	{ NULL,	"readahead-ops N",	"stop after N readahead bogo operations" },
+	{ NULL,	"readahead-sweep",	"measure readahead effectiveness over access patterns" },
+	{ NULL,	"readahead-window N",	"explicit readahead window size for readahead-sweep" },
 	{ NULL,	NULL,			NULL }
 };
 
 static const stress_opt_t opts[] = {
-	{ OPT_readahead_bytes, "readahead-bytes", TYPE_ID_UINT64_BYTES_FS, MIN_READAHEAD_BYTES, MAX_READAHEAD_BYTES, NULL },
+	{ OPT_readahead_bytes,  "readahead-bytes",  TYPE_ID_UINT64_BYTES_FS, MIN_READAHEAD_BYTES, MAX_READAHEAD_BYTES, NULL },
+	{ OPT_readahead_sweep,  "readahead-sweep",  TYPE_ID_BOOL, 0, 1, NULL },
+	{ OPT_readahead_window, "readahead-window", TYPE_ID_SIZE_T_BYTES_VM, MIN_READAHEAD_WINDOW, MAX_READAHEAD_WINDOW, NULL },
 	END_OPT,
 };
 
@@ -81,6 +93,238 @@ static int do_readahead(
 	return 0;
 }
 
+#if defined(HAVE_POSIX_FADVISE) &&	\
+    defined(POSIX_FADV_DONTNEED) &&	\
+    defined(POSIX_FADV_NORMAL) &&	\
+    defined(POSIX_FADV_SEQUENTIAL) &&	\
+    defined(POSIX_FADV_RANDOM) &&	\
+    defined(HAVE_MADVISE) &&		\
+    defined(MADV_NORMAL) &&		\
+    defined(MADV_SEQUENTIAL) &&		\
+    defined(MADV_RANDOM) &&		\
+    defined(RUSAGE_SELF)
+#define HAVE_READAHEAD_SWEEP
+#endif
+
+#if defined(HAVE_READAHEAD_SWEEP)
+/*
+ *  page access patterns for the readahead sweep
+ */
+typedef enum {
+	READAHEAD_SEQ,
+	READAHEAD_STRIDE,
+	READAHEAD_REVERSE,
+	READAHEAD_RANDOM,
+} stress_readahead_pattern_t;
+
+static const char * const stress_readahead_patterns[] = {
+	"seq", "stride", "reverse", "random"
+};
+
+typedef struct {
+	const char *name;
+	const int fadvise;
+	const int madvise;
+} stress_readahead_hint_t;
+
+static const stress_readahead_hint_t stress_readahead_hints[] = {
+	{ "normal",	POSIX_FADV_NORMAL,	MADV_NORMAL },
+	{ "sequential",	POSIX_FADV_SEQUENTIAL,	MADV_SEQUENTIAL },
+	{ "random",	POSIX_FADV_RANDOM,	MADV_RANDOM },
+};
+
+#define READAHEAD_PATTERNS	(SIZEOF_ARRAY(stress_readahead_patterns))
+#define READAHEAD_HINTS		(SIZEOF_ARRAY(stress_readahead_hints))
+#define READAHEAD_WINDOWS	(2)	/* kernel heuristics only, explicit window */
+#define READAHEAD_CONFIGS	(READAHEAD_PATTERNS * READAHEAD_HINTS * READAHEAD_WINDOWS)
+
+/*
+ *  per pattern, hint and window results
+ */
+typedef struct {
+	double bytes;		/* bytes accessed */
+	double duration;	/* time accessing pages */
+	uint64_t pages;		/* pages accessed */
+	uint64_t major_faults;	/* major page faults */
+	uint64_t pgpgin;	/* KB paged in from the device */
+} stress_readahead_result_t;
+
+/*
+ *  stress_readahead_page()
+ *	return the index of the i'th page accessed in a pattern
+ */
+static inline size_t stress_readahead_page(
+	const stress_readahead_pattern_t pattern,
+	const size_t i,
+	const size_t n_pages)
+{
+	switch (pattern) {
+	case READAHEAD_STRIDE:
+		return i * READAHEAD_STRIDE_PAGES;
+	case READAHEAD_REVERSE:
+		return n_pages - 1 - i;
+	case READAHEAD_RANDOM:
+		return (size_t)stress_mwc32modn((uint32_t)n_pages);
+	case READAHEAD_SEQ:
+	default:
+		return i;
+	}
+}
+
+/*
+ *  stress_readahead_access()
+ *	access the pages of a cold file via a shared mapping in the
+ *	given pattern, with the given hint and with an explicit
+ *	readahead window (0 = kernel readahead heuristics only)
+ */
+static int stress_readahead_access(
+	stress_args_t *args,
+	const int fd,
+	const uint64_t file_bytes,
+	const stress_readahead_pattern_t pattern,
+	const stress_readahead_hint_t *hint,
+	const size_t window,
+	stress_readahead_result_t *result)
+{
+	static const char * const stress_readahead_vmstat[] = { "pgpgin" };
+	const size_t page_size = args->page_size;
+	const size_t n_pages = (size_t)(file_bytes / page_size);
+	const size_t n_access = ((pattern == READAHEAD_SEQ) || (pattern == READAHEAD_REVERSE)) ?
+		n_pages : n_pages / READAHEAD_STRIDE_PAGES;
+	uint64_t pgpgin_begin = 0, pgpgin_end = 0;
+	off_t ra_lo = 0, ra_hi = 0;
+	struct rusage usage_begin, usage_end;
+	volatile uint8_t *ptr;
+	uint8_t *mapping;
+	uint8_t val = 0;
+	double t;
+	size_t i;
+
+	/* Make the file cold, the pages are clean so they are all dropped */
+	(void)posix_fadvise(fd, 0, (off_t)file_bytes, POSIX_FADV_DONTNEED);
+
+	mapping = (uint8_t *)mmap(NULL, (size_t)file_bytes, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %" PRIu64 " byte file, errno=%d (%s), "
+			"skipping stressor\n", args->name, file_bytes, errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	(void)posix_fadvise(fd, 0, (off_t)file_bytes, hint->fadvise);
+	(void)madvise((void *)mapping, (size_t)file_bytes, hint->madvise);
+	ptr = (volatile uint8_t *)mapping;
+
+	(void)stress_read_proc_fields("/proc/vmstat", stress_readahead_vmstat, &pgpgin_begin, 1);
+	(void)getrusage(RUSAGE_SELF, &usage_begin);
+	t = stress_time_now();
+	for (i = 0; LIKELY((i < n_access) && stress_continue_flag()); i++) {
+		const size_t page = stress_readahead_page(pattern, i, n_pages);
+		const off_t offset = (off_t)(page * page_size);
+
+		/* Explicitly readahead a window in the direction of access */
+		if (window && ((offset < ra_lo) || (offset >= ra_hi))) {
+			if (pattern == READAHEAD_REVERSE) {
+				ra_hi = offset + (off_t)page_size;
+				ra_lo = (ra_hi > (off_t)window) ? ra_hi - (off_t)window : 0;
+			} else {
+				ra_lo = offset;
+				ra_hi = offset + (off_t)window;
+			}
+			VOID_RET(ssize_t, readahead(fd, ra_lo, (size_t)(ra_hi - ra_lo)));
+		}
+		val += ptr[offset];
+	}
+	result->duration += stress_time_now() - t;
+	(void)getrusage(RUSAGE_SELF, &usage_end);
+	(void)stress_read_proc_fields("/proc/vmstat", stress_readahead_vmstat, &pgpgin_end, 1);
+
+	result->pages += i;
+	result->bytes += (double)i * (double)page_size;
+	if (usage_end.ru_majflt > usage_begin.ru_majflt)
+		result->major_faults += (uint64_t)(usage_end.ru_majflt - usage_begin.ru_majflt);
+	if (pgpgin_end > pgpgin_begin)
+		result->pgpgin += pgpgin_end - pgpgin_begin;
+
+	(void)munmap((void *)mapping, (size_t)file_bytes);
+	(void)posix_fadvise(fd, 0, (off_t)file_bytes, POSIX_FADV_NORMAL);
+	stress_uint8_put(val);
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_readahead_sweep()
+ *	measure readahead effectiveness, each bogo op accesses the cold
+ *	file with the next access pattern, hint and readahead window
+ */
+static int stress_readahead_sweep(
+	stress_args_t *args,
+	const int fd,
+	const uint64_t file_bytes,
+	const size_t readahead_window)
+{
+	stress_readahead_result_t *results;
+	const size_t results_size = sizeof(*results) * READAHEAD_CONFIGS;
+	size_t i, idx = 0;
+	int rc = EXIT_SUCCESS;
+
+	results = (stress_readahead_result_t *)calloc(READAHEAD_CONFIGS, sizeof(*results));
+	if (!results) {
+		pr_inf_skip("%s: cannot allocate %zu bytes for results%s, skipping stressor\n",
+			args->name, results_size, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+
+	/* Pages must be clean to be dropped from the page cache */
+	(void)shim_fdatasync(fd);
+
+	i = 0;
+	do {
+		const size_t pattern = i / (READAHEAD_HINTS * READAHEAD_WINDOWS);
+		const size_t hint = (i / READAHEAD_WINDOWS) % READAHEAD_HINTS;
+		const size_t window = (i % READAHEAD_WINDOWS) ? readahead_window : 0;
+
+		rc = stress_readahead_access(args, fd, file_bytes,
+			(stress_readahead_pattern_t)pattern,
+			&stress_readahead_hints[hint], window, &results[i]);
+		if (rc != EXIT_SUCCESS)
+			break;
+		stress_bogo_inc(args);
+		i++;
+		if (i >= READAHEAD_CONFIGS)
+			i = 0;
+	} while (stress_continue(args));
+
+	for (i = 0; i < READAHEAD_CONFIGS; i++) {
+		const stress_readahead_result_t *result = &results[i];
+		const size_t pattern = i / (READAHEAD_HINTS * READAHEAD_WINDOWS);
+		const size_t hint = (i / READAHEAD_WINDOWS) % READAHEAD_HINTS;
+		const size_t window = (i % READAHEAD_WINDOWS) ? readahead_window : 0;
+		const double avoided = (result->pages > result->major_faults) ?
+			(double)(result->pages - result->major_faults) : 0.0;
+		char label[48], msg[80];
+
+		if ((result->pages == 0) || (result->duration <= 0.0))
+			continue;
+
+		(void)snprintf(label, sizeof(label), "%s, %s, %zuK window",
+			stress_readahead_patterns[pattern],
+			stress_readahead_hints[hint].name, window / (size_t)KB);
+		(void)snprintf(msg, sizeof(msg), "MB/sec (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			result->bytes / result->duration / (double)MB, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%% major faults avoided (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			100.0 * avoided / (double)result->pages, STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "page-ins per page accessed (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			((double)result->pgpgin * (double)KB) / result->bytes, STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+	free(results);
+
+	return rc;
+}
+#endif
+
 /*
  *  stress_readahead
  *	stress file system cache via readahead calls
@@ -101,7 +345,11 @@ static int stress_readahead(stress_args_t *args)
 	off_t offsets[MAX_OFFSETS] ALIGN64;
 	int generate_offsets = 0;
 	const bool verify = !!(g_opt_flags & OPT_FLAGS_VERIFY);
+	bool readahead_sweep = false;
+	size_t readahead_window = DEFAULT_READAHEAD_WINDOW;
 
+	(void)stress_get_setting("readahead-sweep", &readahead_sweep);
+	(void)stress_get_setting("readahead-window", &readahead_window);
 	if (!stress_get_setting("readahead-bytes", &readahead_bytes_total)) {
 		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
 			readahead_bytes_total = MAX_32;
@@ -219,6 +467,18 @@ PRAGMA_UNROLL_N(8)
 		goto close_finish;
 	}
 
+	if (readahead_sweep) {
+#if defined(HAVE_READAHEAD_SWEEP)
+		rc = stress_readahead_sweep(args, fd, rounded_readahead_bytes, readahead_window);
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: fadvise, madvise or getrusage not available, "
+				"skipping readahead sweep\n", args->name);
+		rc = EXIT_NOT_IMPLEMENTED;
+#endif
+		goto close_finish;
+	}
+
 	stress_readahead_generate_offsets(offsets, rounded_readahead_bytes);
 
 	do {
@@ -0,0 +1,805 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-cpu-relax.h"
+#include "core-pthread.h"
+
+#if defined(HAVE_LINUX_MEMBARRIER_H)
+#include <linux/membarrier.h>
+#else
+#define MEMBARRIER_CMD_PRIVATE_EXPEDITED		(1 << 3)
+#define MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED	(1 << 4)
+#endif
+
+#if defined(HAVE_LINUX_RSEQ_H)
+#include <linux/rseq.h>
+#endif
+#if defined(HAVE_SYS_RSEQ_H)
+#include <sys/rseq.h>
+#endif
+
+#define MIN_READMOSTLY_READERS	(1)
+#define MAX_READMOSTLY_READERS	(1024)
+
+#define MIN_READMOSTLY_WRITERS	(1)
+#define MAX_READMOSTLY_WRITERS	(16)
+#define DEFAULT_READMOSTLY_WRITERS (1)
+
+#define READMOSTLY_SLICE_NS	(100000000ULL)	/* 0.1 seconds per configuration */
+#define READMOSTLY_WRITE_NS	(100000ULL)	/* delay between updates */
+#define READMOSTLY_ENTRIES	(256)		/* routing table entries */
+#define READMOSTLY_UPDATES	(16)		/* entries changed per update */
+#define READMOSTLY_MAGIC	(0x5a17ab1e0d15ea5eULL)
+
+static const stress_help_t help[] = {
+	{ NULL,	"readmostly N",		  "start N workers with readers and writers sharing a read-mostly table" },
+	{ NULL,	"readmostly-method M",	  "select synchronization: all, rwlock, seqlock, rcu, percpu" },
+	{ NULL,	"readmostly-ops N",	  "stop after N table updates" },
+	{ NULL,	"readmostly-readers N",	  "maximum number of reader threads" },
+	{ NULL,	"readmostly-writers N",	  "number of writer threads" },
+	{ NULL,	NULL,			  NULL }
+};
+
+#define READMOSTLY_METHOD_ALL		(0)
+#define READMOSTLY_METHOD_RWLOCK	(1)
+#define READMOSTLY_METHOD_SEQLOCK	(2)
+#define READMOSTLY_METHOD_RCU		(3)
+#define READMOSTLY_METHOD_PERCPU	(4)
+
+static const char * const stress_readmostly_methods[] = {
+	"all",
+	"rwlock",
+	"seqlock",
+	"rcu",
+	"percpu",
+};
+
+static const char *stress_readmostly_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_readmostly_methods)) ? stress_readmostly_methods[i] : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_readmostly_method,  "readmostly-method",  TYPE_ID_SIZE_T_METHOD, 0, 0, stress_readmostly_method },
+	{ OPT_readmostly_readers, "readmostly-readers", TYPE_ID_UINT32, MIN_READMOSTLY_READERS, MAX_READMOSTLY_READERS, NULL },
+	{ OPT_readmostly_writers, "readmostly-writers", TYPE_ID_UINT32, MIN_READMOSTLY_WRITERS, MAX_READMOSTLY_WRITERS, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_PTHREAD_RWLOCK) &&		\
+    defined(HAVE_CLOCK_GETTIME) &&		\
+    defined(CLOCK_MONOTONIC) &&			\
+    defined(HAVE_ATOMIC_ADD_FETCH) &&		\
+    defined(HAVE_ATOMIC_SUB_FETCH) &&		\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+
+/* the cpu_id of the C library's registered rseq area is the cheapest way to find the CPU */
+#if defined(HAVE_LINUX_RSEQ_H) &&		\
+    defined(HAVE___RSEQ_OFFSET) &&		\
+    defined(HAVE_BUILTIN_THREAD_POINTER) &&	\
+    defined(RSEQ_CPU_ID_REGISTRATION_FAILED)
+#define HAVE_READMOSTLY_RSEQ
+#endif
+
+/* routing table entry, check is derived from the other fields */
+typedef struct {
+	uint64_t gen;
+	uint64_t key;
+	uint64_t nexthop;
+	uint64_t check;
+} stress_readmostly_entry_t;
+
+typedef struct {
+	stress_readmostly_entry_t entries[READMOSTLY_ENTRIES];
+} stress_readmostly_table_t;
+
+/* per-CPU reader count, one cache line each */
+typedef struct {
+	uint32_t readers ALIGN64;
+} stress_readmostly_slot_t;
+
+struct stress_readmostly_context;
+
+typedef struct {
+	uint64_t ctr ALIGN64;			/* RCU grace period the reader is in, 0 when outside */
+	struct stress_readmostly_context *ctx;
+	pthread_t pthread;
+	uint32_t rnd;
+	uint64_t lookups;
+} stress_readmostly_reader_t;
+
+typedef struct {
+	struct stress_readmostly_context *ctx;
+	pthread_t pthread;
+	uint32_t rnd;
+	uint64_t updates;
+	uint64_t latency;			/* total update latency (ns) */
+	uint64_t max_latency;			/* maximum update latency (ns) */
+} stress_readmostly_writer_t;
+
+typedef struct stress_readmostly_context {
+	uint32_t seq ALIGN64;			/* seqlock sequence, odd while writing */
+	uint32_t writing ALIGN64;		/* percpu writer is active */
+	uint64_t gp ALIGN64;			/* RCU grace period */
+	stress_readmostly_table_t *table ALIGN64; /* RCU published table */
+	pthread_rwlock_t rwlock;
+	pthread_mutex_t mutex;			/* serializes writers */
+	stress_args_t *args;
+	size_t method;
+	stress_readmostly_table_t *tables;	/* two tables, RCU alternates them */
+	stress_readmostly_slot_t *slots;	/* percpu reader counts */
+	uint32_t n_slots;
+	stress_readmostly_reader_t *readers;
+	uint32_t n_readers;
+	stress_readmostly_writer_t *writers;
+	uint32_t n_writers;
+	uint64_t gen;				/* update generation */
+	bool membarrier;			/* RCU uses expedited membarrier */
+	bool go;				/* start running */
+	bool stop;				/* stop running */
+	bool failed;				/* torn read seen */
+} stress_readmostly_context_t;
+
+/*
+ *  accumulated results for a method and number of readers
+ */
+typedef struct {
+	size_t method;
+	uint32_t n_readers;
+	bool skipped;
+	double duration;
+	uint64_t lookups;
+	uint64_t updates;
+	uint64_t latency;
+	uint64_t max_latency;
+} stress_readmostly_result_t;
+
+static inline uint64_t stress_readmostly_now(void)
+{
+	struct timespec ts;
+
+	if (UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) < 0))
+		return (uint64_t)(stress_time_now() * STRESS_DBL_NANOSECOND);
+	return ((uint64_t)ts.tv_sec * STRESS_NANOSECOND) + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint32_t stress_readmostly_rnd(uint32_t *rnd)
+{
+	*rnd = (*rnd * 1103515245U) + 12345U;
+	return *rnd >> 8;
+}
+
+/*
+ *  stress_readmostly_cpu()
+ *	CPU the caller is running on, read from the rseq area if the C
+ *	library has registered one
+ */
+static inline unsigned int stress_readmostly_cpu(void)
+{
+#if defined(HAVE_READMOSTLY_RSEQ)
+	const struct rseq *rseq = (const struct rseq *)((ptrdiff_t)__builtin_thread_pointer() + __rseq_offset);
+	const uint32_t cpu = __atomic_load_n(&rseq->cpu_id, __ATOMIC_RELAXED);
+
+	if (LIKELY(cpu != (uint32_t)RSEQ_CPU_ID_REGISTRATION_FAILED))
+		return (unsigned int)cpu;
+#endif
+	return stress_get_cpu();
+}
+
+/*
+ *  table entries are accessed with relaxed atomics so that the
+ *  seqlock readers racing with a writer are well defined
+ */
+static inline void stress_readmostly_entry_read(
+	const stress_readmostly_entry_t *entry,
+	stress_readmostly_entry_t *copy)
+{
+	copy->gen = __atomic_load_n(&entry->gen, __ATOMIC_RELAXED);
+	copy->key = __atomic_load_n(&entry->key, __ATOMIC_RELAXED);
+	copy->nexthop = __atomic_load_n(&entry->nexthop, __ATOMIC_RELAXED);
+	copy->check = __atomic_load_n(&entry->check, __ATOMIC_RELAXED);
+}
+
+static inline void stress_readmostly_entry_write(
+	stress_readmostly_entry_t *entry,
+	const uint64_t gen,
+	const uint64_t key,
+	const uint64_t nexthop)
+{
+	__atomic_store_n(&entry->gen, gen, __ATOMIC_RELAXED);
+	__atomic_store_n(&entry->key, key, __ATOMIC_RELAXED);
+	__atomic_store_n(&entry->nexthop, nexthop, __ATOMIC_RELAXED);
+	__atomic_store_n(&entry->check, gen ^ key ^ nexthop ^ READMOSTLY_MAGIC, __ATOMIC_RELAXED);
+}
+
+static inline bool stress_readmostly_entry_ok(const stress_readmostly_entry_t *entry)
+{
+	return (entry->gen ^ entry->key ^ entry->nexthop ^ READMOSTLY_MAGIC) == entry->check;
+}
+
+/*
+ *  stress_readmostly_update()
+ *	change a few routes of a table, caller has exclusive write access
+ */
+static void stress_readmostly_update(
+	stress_readmostly_context_t *ctx,
+	stress_readmostly_writer_t *writer,
+	stress_readmostly_table_t *table)
+{
+	const uint64_t gen = ++ctx->gen;
+	int i;
+
+	for (i = 0; i < READMOSTLY_UPDATES; i++) {
+		const uint32_t idx = stress_readmostly_rnd(&writer->rnd) % READMOSTLY_ENTRIES;
+
+		stress_readmostly_entry_write(&table->entries[idx], gen,
+			table->entries[idx].key, (uint64_t)stress_readmostly_rnd(&writer->rnd));
+	}
+}
+
+/*
+ *  stress_readmostly_lookup()
+ *	look up a random route, check it is not torn
+ */
+static inline bool stress_readmostly_lookup(
+	const stress_readmostly_table_t *table,
+	stress_readmostly_reader_t *reader,
+	stress_readmostly_entry_t *entry)
+{
+	const uint32_t idx = stress_readmostly_rnd(&reader->rnd) % READMOSTLY_ENTRIES;
+
+	stress_readmostly_entry_read(&table->entries[idx], entry);
+	return entry->key == idx;
+}
+
+static void stress_readmostly_torn(stress_readmostly_context_t *ctx, const stress_readmostly_entry_t *entry)
+{
+	if (!__atomic_load_n(&ctx->failed, __ATOMIC_RELAXED)) {
+		pr_fail("%s: %s reader saw a torn table entry, generation %" PRIu64
+			", key %" PRIu64 ", nexthop 0x%" PRIx64 ", check 0x%" PRIx64 "\n",
+			ctx->args->name, stress_readmostly_methods[ctx->method],
+			entry->gen, entry->key, entry->nexthop, entry->check);
+		__atomic_store_n(&ctx->failed, true, __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ *  rwlock, readers share the lock, writers update in place
+ */
+static bool stress_readmostly_rwlock_read(stress_readmostly_context_t *ctx, stress_readmostly_reader_t *reader)
+{
+	stress_readmostly_entry_t entry;
+	bool ok;
+
+	if (UNLIKELY(pthread_rwlock_rdlock(&ctx->rwlock) != 0))
+		return true;
+	ok = stress_readmostly_lookup(&ctx->tables[0], reader, &entry);
+	(void)pthread_rwlock_unlock(&ctx->rwlock);
+	if (UNLIKELY(!ok || !stress_readmostly_entry_ok(&entry)))
+		stress_readmostly_torn(ctx, &entry);
+	return true;
+}
+
+static void stress_readmostly_rwlock_write(stress_readmostly_context_t *ctx, stress_readmostly_writer_t *writer)
+{
+	if (UNLIKELY(pthread_rwlock_wrlock(&ctx->rwlock) != 0))
+		return;
+	stress_readmostly_update(ctx, writer, &ctx->tables[0]);
+	(void)pthread_rwlock_unlock(&ctx->rwlock);
+}
+
+/*
+ *  seqlock, readers retry if a writer was active, writers update
+ *  in place with the sequence odd
+ */
+static bool stress_readmostly_seqlock_read(stress_readmostly_context_t *ctx, stress_readmostly_reader_t *reader)
+{
+	stress_readmostly_entry_t entry;
+	uint32_t seq1, seq2, spins = 0;
+	bool ok;
+
+	do {
+		seq1 = __atomic_load_n(&ctx->seq, __ATOMIC_ACQUIRE);
+		if (UNLIKELY(seq1 & 1)) {
+			(void)stress_cpu_relax_yield(&spins);
+			continue;
+		}
+		ok = stress_readmostly_lookup(&ctx->tables[0], reader, &entry);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		seq2 = __atomic_load_n(&ctx->seq, __ATOMIC_RELAXED);
+		if (LIKELY(seq1 == seq2))
+			break;
+		if (UNLIKELY(__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)))
+			return false;
+	} while (true);
+
+	if (UNLIKELY(!ok || !stress_readmostly_entry_ok(&entry)))
+		stress_readmostly_torn(ctx, &entry);
+	return true;
+}
+
+static void stress_readmostly_seqlock_write(stress_readmostly_context_t *ctx, stress_readmostly_writer_t *writer)
+{
+	uint32_t seq;
+
+	(void)pthread_mutex_lock(&ctx->mutex);
+	seq = __atomic_load_n(&ctx->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&ctx->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	stress_readmostly_update(ctx, writer, &ctx->tables[0]);
+	__atomic_store_n(&ctx->seq, seq + 2, __ATOMIC_RELEASE);
+	(void)pthread_mutex_unlock(&ctx->mutex);
+}
+
+/*
+ *  userspace RCU, readers publish the grace period they are in
+ *  with a plain store, writers copy the table, publish the copy and
+ *  use an expedited membarrier to order the readers before waiting
+ *  for the readers in older grace periods to leave
+ */
+static inline void stress_readmostly_rcu_barrier(const stress_readmostly_context_t *ctx)
+{
+	if (ctx->membarrier)
+		(void)shim_membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+	else
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static bool stress_readmostly_rcu_read(stress_readmostly_context_t *ctx, stress_readmostly_reader_t *reader)
+{
+	stress_readmostly_entry_t entry;
+	const stress_readmostly_table_t *table;
+	bool ok;
+
+	/* acquire, a reader that sees a new grace period must also see the table it published */
+	__atomic_store_n(&reader->ctr, __atomic_load_n(&ctx->gp, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+	if (ctx->membarrier)
+		__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	else
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	table = __atomic_load_n(&ctx->table, __ATOMIC_ACQUIRE);
+	ok = stress_readmostly_lookup(table, reader, &entry);
+	__atomic_store_n(&reader->ctr, 0, __ATOMIC_RELEASE);
+
+	if (UNLIKELY(!ok || !stress_readmostly_entry_ok(&entry)))
+		stress_readmostly_torn(ctx, &entry);
+	return true;
+}
+
+static void stress_readmostly_rcu_write(stress_readmostly_context_t *ctx, stress_readmostly_writer_t *writer)
+{
+	stress_readmostly_table_t *old, *new;
+	uint64_t gp;
+	uint32_t i;
+
+	(void)pthread_mutex_lock(&ctx->mutex);
+	old = __atomic_load_n(&ctx->table, __ATOMIC_RELAXED);
+	new = (old == &ctx->tables[0]) ? &ctx->tables[1] : &ctx->tables[0];
+	(void)shim_memcpy((void *)new, (void *)old, sizeof(*new));
+	stress_readmostly_update(ctx, writer, new);
+	__atomic_store_n(&ctx->table, new, __ATOMIC_RELEASE);
+
+	/*
+	 *  synchronize, the new table is visible to all readers before
+	 *  the grace period changes, then wait for readers that may
+	 *  still see the old table
+	 */
+	stress_readmostly_rcu_barrier(ctx);
+	gp = __atomic_add_fetch(&ctx->gp, 1, __ATOMIC_SEQ_CST);
+	stress_readmostly_rcu_barrier(ctx);
+	for (i = 0; i < ctx->n_readers; i++) {
+		stress_readmostly_reader_t *reader = &ctx->readers[i];
+		uint32_t spins = 0;
+		uint64_t ctr;
+
+		while (((ctr = __atomic_load_n(&reader->ctr, __ATOMIC_ACQUIRE)) != 0) && (ctr < gp))
+			(void)stress_cpu_relax_yield(&spins);
+	}
+	(void)pthread_mutex_unlock(&ctx->mutex);
+}
+
+/*
+ *  per-CPU reader counts (a big reader lock), readers only touch the
+ *  count of the CPU they are on, writers wait for all the counts to
+ *  drain and update in place
+ */
+static bool stress_readmostly_percpu_read(stress_readmostly_context_t *ctx, stress_readmostly_reader_t *reader)
+{
+	stress_readmostly_entry_t entry;
+	stress_readmostly_slot_t *slot;
+	uint32_t spins = 0;
+	bool ok;
+
+	for (;;) {
+		slot = &ctx->slots[stress_readmostly_cpu() % ctx->n_slots];
+		(void)__atomic_add_fetch(&slot->readers, 1, __ATOMIC_SEQ_CST);
+		if (LIKELY(!__atomic_load_n(&ctx->writing, __ATOMIC_SEQ_CST)))
+			break;
+		(void)__atomic_sub_fetch(&slot->readers, 1, __ATOMIC_RELEASE);
+		while (__atomic_load_n(&ctx->writing, __ATOMIC_ACQUIRE)) {
+			if (UNLIKELY(__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)))
+				return false;
+			(void)stress_cpu_relax_yield(&spins);
+		}
+	}
+	ok = stress_readmostly_lookup(&ctx->tables[0], reader, &entry);
+	/* the count taken is released even if the reader migrated */
+	(void)__atomic_sub_fetch(&slot->readers, 1, __ATOMIC_RELEASE);
+
+	if (UNLIKELY(!ok || !stress_readmostly_entry_ok(&entry)))
+		stress_readmostly_torn(ctx, &entry);
+	return true;
+}
+
+static void stress_readmostly_percpu_write(stress_readmostly_context_t *ctx, stress_readmostly_writer_t *writer)
+{
+	uint32_t i;
+
+	(void)pthread_mutex_lock(&ctx->mutex);
+	__atomic_store_n(&ctx->writing, 1, __ATOMIC_SEQ_CST);
+	for (i = 0; i < ctx->n_slots; i++) {
+		uint32_t spins = 0;
+
+		while (__atomic_load_n(&ctx->slots[i].readers, __ATOMIC_SEQ_CST) != 0)
+			(void)stress_cpu_relax_yield(&spins);
+	}
+	stress_readmostly_update(ctx, writer, &ctx->tables[0]);
+	__atomic_store_n(&ctx->writing, 0, __ATOMIC_RELEASE);
+	(void)pthread_mutex_unlock(&ctx->mutex);
+}
+
+typedef struct {
+	bool (*read)(stress_readmostly_context_t *ctx, stress_readmostly_reader_t *reader);
+	void (*write)(stress_readmostly_context_t *ctx, stress_readmostly_writer_t *writer);
+} stress_readmostly_ops_t;
+
+static const stress_readmostly_ops_t stress_readmostly_ops[] = {
+	{ NULL, NULL },
+	{ stress_readmostly_rwlock_read,  stress_readmostly_rwlock_write },
+	{ stress_readmostly_seqlock_read, stress_readmostly_seqlock_write },
+	{ stress_readmostly_rcu_read,	  stress_readmostly_rcu_write },
+	{ stress_readmostly_percpu_read,  stress_readmostly_percpu_write },
+};
+
+static void stress_readmostly_go(const stress_readmostly_context_t *ctx)
+{
+	while (!__atomic_load_n(&ctx->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+}
+
+static void *stress_readmostly_reader(void *arg)
+{
+	stress_readmostly_reader_t *reader = (stress_readmostly_reader_t *)arg;
+	stress_readmostly_context_t *ctx = reader->ctx;
+	bool (*read)(stress_readmostly_context_t *ctx, stress_readmostly_reader_t *reader) =
+		stress_readmostly_ops[ctx->method].read;
+
+	stress_readmostly_go(ctx);
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)) {
+		if (read(ctx, reader))
+			reader->lookups++;
+	}
+	return &g_nowt;
+}
+
+static void *stress_readmostly_writer(void *arg)
+{
+	stress_readmostly_writer_t *writer = (stress_readmostly_writer_t *)arg;
+	stress_readmostly_context_t *ctx = writer->ctx;
+	void (*write)(stress_readmostly_context_t *ctx, stress_readmostly_writer_t *writer) =
+		stress_readmostly_ops[ctx->method].write;
+
+	stress_readmostly_go(ctx);
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)) {
+		const uint64_t t = stress_readmostly_now();
+		uint64_t latency;
+
+		write(ctx, writer);
+		latency = stress_readmostly_now() - t;
+		writer->latency += latency;
+		if (latency > writer->max_latency)
+			writer->max_latency = latency;
+		writer->updates++;
+		(void)shim_nanosleep_uint64(READMOSTLY_WRITE_NS);
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_readmostly_run()
+ *	run a method with a number of readers and the writers for a
+ *	time slice
+ */
+static int stress_readmostly_run(
+	stress_args_t *args,
+	stress_readmostly_context_t *ctx,
+	stress_readmostly_result_t *result)
+{
+	const uint32_t n_readers = result->n_readers;
+	uint32_t i, readers_created, writers_created = 0;
+	uint64_t lookups = 0, updates = 0;
+	double t;
+
+	ctx->method = result->method;
+	ctx->n_readers = n_readers;
+	ctx->go = false;
+	ctx->stop = false;
+	ctx->seq = 0;
+	ctx->writing = 0;
+	ctx->gp = 1;
+	ctx->table = &ctx->tables[0];
+	for (i = 0; i < READMOSTLY_ENTRIES; i++)
+		stress_readmostly_entry_write(&ctx->tables[0].entries[i], 0, i, i);
+	(void)shim_memset(ctx->slots, 0, ctx->n_slots * sizeof(*ctx->slots));
+
+	for (readers_created = 0; readers_created < n_readers; readers_created++) {
+		stress_readmostly_reader_t *reader = &ctx->readers[readers_created];
+
+		(void)shim_memset(reader, 0, sizeof(*reader));
+		reader->ctx = ctx;
+		reader->rnd = stress_mwc32();
+		if (pthread_create(&reader->pthread, NULL, stress_readmostly_reader, (void *)reader) != 0)
+			break;
+	}
+	if (readers_created == n_readers) {
+		for (writers_created = 0; writers_created < ctx->n_writers; writers_created++) {
+			stress_readmostly_writer_t *writer = &ctx->writers[writers_created];
+
+			(void)shim_memset(writer, 0, sizeof(*writer));
+			writer->ctx = ctx;
+			writer->rnd = stress_mwc32();
+			if (pthread_create(&writer->pthread, NULL, stress_readmostly_writer, (void *)writer) != 0)
+				break;
+		}
+	}
+	if ((readers_created < n_readers) || (writers_created < ctx->n_writers)) {
+		pr_dbg("%s: cannot create %" PRIu32 " threads, skipping %s with %" PRIu32 " readers\n",
+			args->name, n_readers + ctx->n_writers, stress_readmostly_methods[result->method], n_readers);
+		result->skipped = true;
+		/* RCU writers only wait for readers that were created */
+		ctx->n_readers = readers_created;
+	}
+
+	t = stress_time_now();
+	__atomic_store_n(&ctx->go, true, __ATOMIC_RELEASE);
+	if (!result->skipped)
+		(void)shim_nanosleep_uint64(READMOSTLY_SLICE_NS);
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELEASE);
+	t = stress_time_now() - t;
+
+	for (i = 0; i < writers_created; i++)
+		VOID_RET(int, pthread_join(ctx->writers[i].pthread, NULL));
+	for (i = 0; i < readers_created; i++)
+		VOID_RET(int, pthread_join(ctx->readers[i].pthread, NULL));
+
+	if (result->skipped)
+		return 0;
+	for (i = 0; i < n_readers; i++)
+		lookups += ctx->readers[i].lookups;
+	for (i = 0; i < ctx->n_writers; i++) {
+		updates += ctx->writers[i].updates;
+		result->latency += ctx->writers[i].latency;
+		if (ctx->writers[i].max_latency > result->max_latency)
+			result->max_latency = ctx->writers[i].max_latency;
+	}
+	result->lookups += lookups;
+	result->updates += updates;
+	result->duration += t;
+	stress_bogo_add(args, updates);
+	return ctx->failed ? -1 : 0;
+}
+
+/*
+ *  stress_readmostly_metrics()
+ *	reader lookups per second and mean writer update latency for
+ *	each method and number of readers
+ */
+static void stress_readmostly_metrics(
+	stress_args_t *args,
+	const stress_readmostly_result_t *results,
+	const size_t n_results)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_readmostly_result_t *r = &results[i];
+		const char *name = stress_readmostly_methods[r->method];
+		const double rate = (r->duration > 0.0) ? (double)r->lookups / r->duration : 0.0;
+		const double latency = (r->updates > 0) ? ((double)r->latency / (double)r->updates) / 1000.0 : 0.0;
+		char msg[64];
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-7s %4" PRIu32 " readers %12.0f lookups/sec, %10.0f per reader, "
+				"writer latency mean %8.2f max %8.2f usec\n", args->name, name,
+				r->n_readers, rate, rate / (double)r->n_readers, latency,
+				(double)r->max_latency / 1000.0);
+
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 " readers lookups/sec", name, r->n_readers);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+		if (r->updates > 0) {
+			(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 " readers usec writer latency", name, r->n_readers);
+			stress_metrics_set(args, idx++, msg, latency, STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_readmostly()
+ *	readers look up routes in a shared table that a few writers
+ *	update, comparing rwlock, seqlock, RCU and per-CPU reader counts
+ *	as the number of readers is swept in powers of 2
+ */
+static int stress_readmostly(stress_args_t *args)
+{
+	const int32_t n_cpus = stress_get_processors_online();
+	const int32_t n_cpus_configured = stress_get_processors_configured();
+	uint32_t readmostly_readers = (uint32_t)STRESS_MINIMUM(STRESS_MAXIMUM(n_cpus, MIN_READMOSTLY_READERS), MAX_READMOSTLY_READERS);
+	uint32_t readmostly_writers = DEFAULT_READMOSTLY_WRITERS;
+	uint32_t levels[16], n_levels = 0, n;
+	size_t readmostly_method = READMOSTLY_METHOD_ALL, method, n_results = 0, i;
+	size_t tables_size, slots_size;
+	stress_readmostly_result_t *results = NULL;
+	stress_readmostly_context_t *ctx;
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("readmostly-method", &readmostly_method);
+	(void)stress_get_setting("readmostly-writers", &readmostly_writers);
+	if (!stress_get_setting("readmostly-readers", &readmostly_readers)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			readmostly_readers = MAX_READMOSTLY_READERS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			readmostly_readers = MIN_READMOSTLY_READERS;
+	}
+	for (n = 1; n < readmostly_readers; n <<= 1)
+		levels[n_levels++] = n;
+	levels[n_levels++] = readmostly_readers;
+
+	ctx = (stress_readmostly_context_t *)calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		pr_inf_skip("%s: cannot allocate context%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+	ctx->args = args;
+	ctx->n_writers = readmostly_writers;
+	ctx->n_slots = (uint32_t)STRESS_MAXIMUM(n_cpus_configured, 1);
+
+	tables_size = 2 * sizeof(*ctx->tables);
+	ctx->tables = (stress_readmostly_table_t *)stress_mmap_populate(NULL, tables_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ctx->tables == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for tables%s, skipping stressor\n",
+			args->name, tables_size, stress_get_memfree_str());
+		free(ctx);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(ctx->tables, tables_size, "readmostly-tables");
+	slots_size = (size_t)ctx->n_slots * sizeof(*ctx->slots);
+	ctx->slots = (stress_readmostly_slot_t *)stress_mmap_populate(NULL, slots_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ctx->slots == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for per-CPU reader counts%s, skipping stressor\n",
+			args->name, slots_size, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto unmap_tables;
+	}
+	stress_set_vma_anon_name(ctx->slots, slots_size, "readmostly-percpu");
+
+	if (posix_memalign((void **)&ctx->readers, 64, (size_t)readmostly_readers * sizeof(*ctx->readers)) != 0) {
+		ctx->readers = NULL;
+		pr_inf_skip("%s: cannot allocate reader state%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto unmap_slots;
+	}
+	ctx->writers = (stress_readmostly_writer_t *)calloc(readmostly_writers, sizeof(*ctx->writers));
+	results = (stress_readmostly_result_t *)calloc(SIZEOF_ARRAY(stress_readmostly_methods) * n_levels, sizeof(*results));
+	if (!ctx->writers || !results) {
+		pr_inf_skip("%s: cannot allocate writer state and result table%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_state;
+	}
+	if ((pthread_rwlock_init(&ctx->rwlock, NULL) != 0) ||
+	    (pthread_mutex_init(&ctx->mutex, NULL) != 0)) {
+		pr_inf_skip("%s: cannot initialize rwlock or mutex, skipping stressor\n", args->name);
+		rc = EXIT_NO_RESOURCE;
+		goto free_state;
+	}
+
+	/* RCU grace periods use an expedited membarrier if available, else full barriers */
+	ctx->membarrier = (shim_membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0);
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %" PRIu32 " writers, rcu uses %s, percpu uses %" PRIu32 " reader counts\n",
+			args->name, readmostly_writers,
+			ctx->membarrier ? "expedited membarrier" : "reader memory barriers",
+			ctx->n_slots);
+
+	for (method = READMOSTLY_METHOD_RWLOCK; method < SIZEOF_ARRAY(stress_readmostly_methods); method++) {
+		if ((readmostly_method != READMOSTLY_METHOD_ALL) && (readmostly_method != method))
+			continue;
+		for (n = 0; n < n_levels; n++) {
+			results[n_results].method = method;
+			results[n_results].n_readers = levels[n];
+			n_results++;
+		}
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		bool runnable = false;
+		size_t j;
+
+		if (!results[i].skipped &&
+		    (stress_readmostly_run(args, ctx, &results[i]) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		for (j = 0; j < n_results; j++)
+			runnable |= !results[j].skipped;
+		if (!runnable)
+			break;
+		i = (i + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_readmostly_metrics(args, results, n_results);
+
+	(void)pthread_mutex_destroy(&ctx->mutex);
+	(void)pthread_rwlock_destroy(&ctx->rwlock);
+free_state:
+	free(results);
+	free(ctx->writers);
+	free(ctx->readers);
+unmap_slots:
+	(void)munmap((void *)ctx->slots, slots_size);
+unmap_tables:
+	(void)munmap((void *)ctx->tables, tables_size);
+	free(ctx);
+	return rc;
+}
+
+const stressor_info_t stress_readmostly_info = {
+	.stressor = stress_readmostly,
+	.classifier = CLASS_CPU_CACHE | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_readmostly_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_CPU_CACHE | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread rwlock or atomic support"
+};
+#endif
@@ -22,6 +22,7 @@
 #include "core-helper.h"
 #include "core-out-of-memory.h"
 #include "core-pragma.h"
+#include "core-pthread.h"
 
 #if defined(HAVE_LINUX_RSEQ_H)
 #include <linux/rseq.h>
@@ -29,11 +30,42 @@
 #if defined(HAVE_SYS_RSEQ_H)
 #include <sys/rseq.h>
 #endif
+#if defined(HAVE_SYS_AUXV_H)
+#include <sys/auxv.h>
+#endif
+
+#define MIN_RSEQ_THREADS	(1)
+#define MAX_RSEQ_THREADS	(1024)
 
 static const stress_help_t help[] = {
-	{ NULL,	"rseq N",	"start N workers that exercise restartable sequences" },
-	{ NULL,	"rseq-ops N",	"stop after N bogo restartable sequence operations" },
-	{ NULL,	NULL,		NULL }
+	{ NULL,	"rseq N",		"start N workers that exercise restartable sequences" },
+	{ NULL,	"rseq-method M",	"select method: verify, all, counter, freelist" },
+	{ NULL,	"rseq-ops N",		"stop after N bogo restartable sequence operations" },
+	{ NULL,	"rseq-threads N",	"maximum number of threads for the per-CPU methods" },
+	{ NULL,	NULL,			NULL }
+};
+
+#define RSEQ_METHOD_VERIFY	(0)
+#define RSEQ_METHOD_ALL		(1)
+#define RSEQ_METHOD_COUNTER	(2)
+#define RSEQ_METHOD_FREELIST	(3)
+
+static const char * const stress_rseq_methods[] = {
+	"verify",
+	"all",
+	"counter",
+	"freelist",
+};
+
+static const char *stress_rseq_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_rseq_methods)) ? stress_rseq_methods[i] : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_rseq_method,  "rseq-method",  TYPE_ID_SIZE_T_METHOD, 0, 0, stress_rseq_method },
+	{ OPT_rseq_threads, "rseq-threads", TYPE_ID_UINT32, MIN_RSEQ_THREADS, MAX_RSEQ_THREADS, NULL },
+	END_OPT,
 };
 
 #if defined(HAVE_LINUX_RSEQ_H) &&		\
@@ -214,10 +246,763 @@ static int stress_rseq_oomable(stress_args_t *args, void *context)
 	return EXIT_SUCCESS;
 }
 
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_ATOMIC_FETCH_ADD) &&		\
+    defined(HAVE_ATOMIC_COMPARE_EXCHANGE) &&	\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+#define HAVE_RSEQ_BENCH
+#endif
+
+#if defined(HAVE_RSEQ_BENCH)
+
+#define RSEQ_SLICE_NS		(100000000ULL)	/* 0.1 seconds per configuration */
+#define RSEQ_BATCH		(256)		/* operations between stop checks */
+#define RSEQ_OPS_PER_BOGO	(10000)		/* benchmark operations per bogo op */
+#define RSEQ_NODES_PER_SLOT	(64)		/* freelist nodes per CPU */
+#define RSEQ_MM_CID_OFFSET	(24)		/* offset of mm_cid in struct rseq */
+
+#define RSEQ_IMPL_RSEQ		(0)
+#define RSEQ_IMPL_RSEQ_MM_CID	(1)
+#define RSEQ_IMPL_ATOMIC	(2)
+#define RSEQ_IMPL_MUTEX		(3)
+
+static const char * const stress_rseq_impls[] = {
+	"rseq",
+	"rseq-mm_cid",
+	"atomic",
+	"mutex",
+};
+
+/* per-CPU counter and freelist head, one cache line each */
+typedef struct {
+	uint64_t count ALIGN64;
+	uint64_t head;		/* node pointer, or tagged index for atomic */
+	pthread_mutex_t mutex;
+} stress_rseq_slot_t;
+
+typedef struct {
+	uint64_t next;		/* must be first, the rseq pop loads it */
+	uint64_t payload;
+} stress_rseq_node_t;
+
+typedef struct {
+	stress_rseq_slot_t *slots;
+	uint32_t n_slots;
+	stress_rseq_node_t *nodes;
+	uint32_t n_nodes;
+	size_t method;
+	size_t impl;
+	bool go;
+	bool stop;
+} stress_rseq_bench_t;
+
+typedef struct {
+	stress_rseq_bench_t *bench;
+	pthread_t pthread;
+	uint64_t ops;		/* increments or pop/push pairs */
+	uint64_t empty;		/* pops that found the freelist empty */
+	uint64_t aborts;	/* rseq aborts and failed commits */
+} stress_rseq_thread_t;
+
+/*
+ *  accumulated results for a method, implementation and thread count
+ */
+typedef struct {
+	size_t method;
+	size_t impl;
+	uint32_t n_threads;
+	bool skipped;
+	double duration;
+	uint64_t ops;
+	uint64_t aborts;
+} stress_rseq_result_t;
+
+#if defined(STRESS_ARCH_X86_64)
+#define HAVE_RSEQ_BENCH_ASM
+
+#define STRESS_RSEQ_STR_1(x)	#x
+#define STRESS_RSEQ_STR(x)	STRESS_RSEQ_STR_1(x)
+
+/*
+ *  rseq_cs descriptor covering labels 1 (start) to 2 (commit) with the
+ *  abort handler at label 4, the descriptor itself is label 3
+ */
+#define STRESS_RSEQ_ASM_CS						\
+	".pushsection __rseq_cs, \"aw\"\n\t"				\
+	".balign 32\n\t"						\
+	"3:\n\t"							\
+	".long 0x0, 0x0\n\t"						\
+	".quad 1f, 2f - 1f, 4f\n\t"					\
+	".popsection\n\t"						\
+	"leaq 3b(%%rip), %%rax\n\t"					\
+	"movq %%rax, %[rseq_cs]\n\t"					\
+	"1:\n\t"							\
+	"cmpl %[id], %[cur_id]\n\t"					\
+	"jnz 4f\n\t"
+
+/*
+ *  abort handler, the kernel checks the signature that the C library
+ *  registered precedes it, encoded as ud1 <sig>(%rip),%edi
+ */
+#define STRESS_RSEQ_ASM_ABORT						\
+	".pushsection __rseq_failure, \"ax\"\n\t"			\
+	".byte 0x0f, 0xb9, 0x3d\n\t"					\
+	".long " STRESS_RSEQ_STR(RSEQ_SIG) "\n\t"			\
+	"4:\n\t"							\
+	"jmp %l[abort]\n\t"						\
+	".popsection\n\t"
+
+/*
+ *  stress_rseq_addv()
+ *	add 1 to *v if still on CPU (or concurrency id) id, returns 0
+ *	on commit, -1 on abort
+ */
+static inline int ALWAYS_INLINE stress_rseq_addv(
+	struct rseq *rseq,
+	const uint32_t *cur_id,
+	const uint32_t id,
+	uint64_t *v)
+{
+	__asm__ __volatile__ goto (
+		STRESS_RSEQ_ASM_CS
+		"addq $1, %[v]\n\t"
+		"2:\n\t"
+		STRESS_RSEQ_ASM_ABORT
+		:
+		: [rseq_cs] "m" (rseq->rseq_cs),
+		  [cur_id] "m" (*cur_id),
+		  [id] "r" (id),
+		  [v] "m" (*v)
+		: "memory", "cc", "rax"
+		: abort);
+	return 0;
+abort:
+	return -1;
+}
+
+/*
+ *  stress_rseq_pop()
+ *	pop the first node of list *head into *node, returns 0 on
+ *	commit, 1 if the list is empty, -1 on abort
+ */
+static inline int ALWAYS_INLINE stress_rseq_pop(
+	struct rseq *rseq,
+	const uint32_t *cur_id,
+	const uint32_t id,
+	uint64_t *head,
+	uint64_t *node)
+{
+	__asm__ __volatile__ goto (
+		STRESS_RSEQ_ASM_CS
+		"movq %[head], %%rbx\n\t"
+		"testq %%rbx, %%rbx\n\t"
+		"jz %l[empty]\n\t"
+		"movq %%rbx, %[node]\n\t"
+		"movq (%%rbx), %%rbx\n\t"
+		"movq %%rbx, %[head]\n\t"
+		"2:\n\t"
+		STRESS_RSEQ_ASM_ABORT
+		:
+		: [rseq_cs] "m" (rseq->rseq_cs),
+		  [cur_id] "m" (*cur_id),
+		  [id] "r" (id),
+		  [head] "m" (*head),
+		  [node] "m" (*node)
+		: "memory", "cc", "rax", "rbx"
+		: abort, empty);
+	return 0;
+abort:
+	return -1;
+empty:
+	return 1;
+}
+
+/*
+ *  stress_rseq_push()
+ *	store new in *head if *head is still expect, returns 0 on commit,
+ *	1 if *head changed, -1 on abort
+ */
+static inline int ALWAYS_INLINE stress_rseq_push(
+	struct rseq *rseq,
+	const uint32_t *cur_id,
+	const uint32_t id,
+	uint64_t *head,
+	const uint64_t expect,
+	const uint64_t new)
+{
+	__asm__ __volatile__ goto (
+		STRESS_RSEQ_ASM_CS
+		"cmpq %[head], %[expect]\n\t"
+		"jnz %l[changed]\n\t"
+		"movq %[new], %[head]\n\t"
+		"2:\n\t"
+		STRESS_RSEQ_ASM_ABORT
+		:
+		: [rseq_cs] "m" (rseq->rseq_cs),
+		  [cur_id] "m" (*cur_id),
+		  [id] "r" (id),
+		  [head] "m" (*head),
+		  [expect] "r" (expect),
+		  [new] "r" (new)
+		: "memory", "cc", "rax"
+		: abort, changed);
+	return 0;
+abort:
+	return -1;
+changed:
+	return 1;
+}
+#endif
+
+/*
+ *  stress_rseq_id()
+ *	current CPU or concurrency id, waiting for it to be in range of
+ *	the per-CPU slots (it always is unless CPUs were hot added)
+ */
+static inline uint32_t ALWAYS_INLINE stress_rseq_id(
+	const stress_rseq_bench_t *bench,
+	const uint32_t *cur_id)
+{
+	uint32_t id;
+
+	while (UNLIKELY((id = STRESS_ACCESS_ONCE(*cur_id)) >= bench->n_slots))
+		(void)shim_sched_yield();
+	return id;
+}
+
+/*
+ *  stress_rseq_counter()
+ *	increment the counter of the current CPU
+ */
+static void stress_rseq_counter(
+	stress_rseq_thread_t *thread,
+	struct rseq *rseq,
+	const uint32_t *cur_id)
+{
+	const stress_rseq_bench_t *bench = thread->bench;
+	stress_rseq_slot_t *slots = bench->slots;
+	int i;
+
+	(void)rseq;
+
+	switch (bench->impl) {
+#if defined(HAVE_RSEQ_BENCH_ASM)
+	case RSEQ_IMPL_RSEQ:
+	case RSEQ_IMPL_RSEQ_MM_CID:
+		for (i = 0; i < RSEQ_BATCH; i++) {
+			for (;;) {
+				const uint32_t id = stress_rseq_id(bench, cur_id);
+
+				if (LIKELY(stress_rseq_addv(rseq, cur_id, id, &slots[id].count) == 0))
+					break;
+				thread->aborts++;
+			}
+		}
+		break;
+#endif
+	case RSEQ_IMPL_ATOMIC:
+		for (i = 0; i < RSEQ_BATCH; i++)
+			(void)__atomic_fetch_add(&slots[stress_rseq_id(bench, cur_id)].count, 1, __ATOMIC_RELAXED);
+		break;
+	case RSEQ_IMPL_MUTEX:
+	default:
+		for (i = 0; i < RSEQ_BATCH; i++) {
+			stress_rseq_slot_t *slot = &slots[stress_rseq_id(bench, cur_id)];
+
+			(void)pthread_mutex_lock(&slot->mutex);
+			slot->count++;
+			(void)pthread_mutex_unlock(&slot->mutex);
+		}
+		break;
+	}
+	thread->ops += RSEQ_BATCH;
+}
+
+/*
+ *  The atomic freelist heads hold a node index + 1 in the low 32 bits
+ *  and a modification tag in the high 32 bits to avoid ABA on pop,
+ *  the other implementations hold a node pointer
+ */
+#define RSEQ_TAGGED(tag, idx)	((((tag) + 1ULL) << 32) | (uint64_t)(idx))
+#define RSEQ_TAGGED_IDX(head)	((uint32_t)((head) & 0xffffffffULL))
+
+static inline stress_rseq_node_t *stress_rseq_atomic_pop(
+	const stress_rseq_bench_t *bench,
+	stress_rseq_slot_t *slot)
+{
+	uint64_t head = __atomic_load_n(&slot->head, __ATOMIC_ACQUIRE);
+	uint64_t next;
+	uint32_t idx;
+
+	do {
+		idx = RSEQ_TAGGED_IDX(head);
+		if (!idx)
+			return NULL;
+		next = RSEQ_TAGGED(head >> 32, __atomic_load_n(&bench->nodes[idx - 1].next, __ATOMIC_RELAXED));
+	} while (!__atomic_compare_exchange_n(&slot->head, &head, next, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+	return &bench->nodes[idx - 1];
+}
+
+static inline void stress_rseq_atomic_push(
+	const stress_rseq_bench_t *bench,
+	stress_rseq_slot_t *slot,
+	stress_rseq_node_t *node)
+{
+	const uint32_t idx = (uint32_t)(node - bench->nodes) + 1;
+	uint64_t head = __atomic_load_n(&slot->head, __ATOMIC_RELAXED);
+
+	do {
+		__atomic_store_n(&node->next, (uint64_t)RSEQ_TAGGED_IDX(head), __ATOMIC_RELAXED);
+	} while (!__atomic_compare_exchange_n(&slot->head, &head, RSEQ_TAGGED(head >> 32, idx),
+					      false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*
+ *  stress_rseq_freelist()
+ *	pop a node from the freelist of the current CPU, use it and push
+ *	it onto the freelist of the (possibly different) current CPU
+ */
+static void stress_rseq_freelist(
+	stress_rseq_thread_t *thread,
+	struct rseq *rseq,
+	const uint32_t *cur_id)
+{
+	const stress_rseq_bench_t *bench = thread->bench;
+	stress_rseq_slot_t *slots = bench->slots;
+	stress_rseq_node_t *node;
+	int i;
+
+	(void)rseq;
+
+	switch (bench->impl) {
+#if defined(HAVE_RSEQ_BENCH_ASM)
+	case RSEQ_IMPL_RSEQ:
+	case RSEQ_IMPL_RSEQ_MM_CID:
+		for (i = 0; i < RSEQ_BATCH; i++) {
+			uint64_t ptr = 0;
+			int ret;
+
+			for (;;) {
+				const uint32_t id = stress_rseq_id(bench, cur_id);
+
+				ret = stress_rseq_pop(rseq, cur_id, id, &slots[id].head, &ptr);
+				if (LIKELY(ret >= 0))
+					break;
+				thread->aborts++;
+			}
+			if (UNLIKELY(ret > 0)) {
+				thread->empty++;
+				continue;
+			}
+			node = (stress_rseq_node_t *)(uintptr_t)ptr;
+			node->payload++;
+			for (;;) {
+				const uint32_t id = stress_rseq_id(bench, cur_id);
+				const uint64_t head = STRESS_ACCESS_ONCE(slots[id].head);
+
+				node->next = head;
+				if (LIKELY(stress_rseq_push(rseq, cur_id, id, &slots[id].head,
+							    head, (uint64_t)(uintptr_t)node) == 0))
+					break;
+				thread->aborts++;
+			}
+		}
+		break;
+#endif
+	case RSEQ_IMPL_ATOMIC:
+		for (i = 0; i < RSEQ_BATCH; i++) {
+			node = stress_rseq_atomic_pop(bench, &slots[stress_rseq_id(bench, cur_id)]);
+			if (UNLIKELY(!node)) {
+				thread->empty++;
+				continue;
+			}
+			node->payload++;
+			stress_rseq_atomic_push(bench, &slots[stress_rseq_id(bench, cur_id)], node);
+		}
+		break;
+	case RSEQ_IMPL_MUTEX:
+	default:
+		for (i = 0; i < RSEQ_BATCH; i++) {
+			stress_rseq_slot_t *slot = &slots[stress_rseq_id(bench, cur_id)];
+
+			(void)pthread_mutex_lock(&slot->mutex);
+			node = (stress_rseq_node_t *)(uintptr_t)slot->head;
+			if (LIKELY(node != NULL))
+				slot->head = node->next;
+			(void)pthread_mutex_unlock(&slot->mutex);
+			if (UNLIKELY(!node)) {
+				thread->empty++;
+				continue;
+			}
+			node->payload++;
+			slot = &slots[stress_rseq_id(bench, cur_id)];
+			(void)pthread_mutex_lock(&slot->mutex);
+			node->next = slot->head;
+			slot->head = (uint64_t)(uintptr_t)node;
+			(void)pthread_mutex_unlock(&slot->mutex);
+		}
+		break;
+	}
+	thread->ops += RSEQ_BATCH;
+}
+
+static void *stress_rseq_thread(void *arg)
+{
+	stress_rseq_thread_t *thread = (stress_rseq_thread_t *)arg;
+	const stress_rseq_bench_t *bench = thread->bench;
+	struct rseq *rseq = stress_rseq_get_area();
+	const uint32_t *cur_id = (bench->impl == RSEQ_IMPL_RSEQ_MM_CID) ?
+		(const uint32_t *)((uintptr_t)rseq + RSEQ_MM_CID_OFFSET) :
+		(const uint32_t *)&rseq->cpu_id;
+
+	while (!__atomic_load_n(&bench->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+
+	if (bench->method == RSEQ_METHOD_COUNTER) {
+		while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED))
+			stress_rseq_counter(thread, rseq, cur_id);
+	} else {
+		while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED))
+			stress_rseq_freelist(thread, rseq, cur_id);
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_rseq_bench_verify()
+ *	check no counter increments or freelist nodes were lost
+ */
+static int stress_rseq_bench_verify(
+	stress_args_t *args,
+	const stress_rseq_bench_t *bench,
+	const stress_rseq_thread_t *threads,
+	const uint32_t n_threads)
+{
+	const char *impl = stress_rseq_impls[bench->impl];
+	uint64_t ops = 0, used = 0, count = 0;
+	uint32_t i;
+
+	for (i = 0; i < n_threads; i++) {
+		ops += threads[i].ops;
+		used += threads[i].ops - threads[i].empty;
+	}
+
+	if (bench->method == RSEQ_METHOD_COUNTER) {
+		for (i = 0; i < bench->n_slots; i++)
+			count += bench->slots[i].count;
+		if (count != ops) {
+			pr_fail("%s: %s counter total %" PRIu64 " does not match %" PRIu64 " increments\n",
+				args->name, impl, count, ops);
+			return -1;
+		}
+		return 0;
+	}
+
+	for (i = 0; i < bench->n_slots; i++) {
+		uint64_t head = bench->slots[i].head;
+
+		while (head && (count <= bench->n_nodes)) {
+			const stress_rseq_node_t *node;
+
+			if (bench->impl == RSEQ_IMPL_ATOMIC) {
+				const uint32_t idx = RSEQ_TAGGED_IDX(head);
+
+				if (!idx)
+					break;
+				node = &bench->nodes[idx - 1];
+			} else {
+				node = (const stress_rseq_node_t *)(uintptr_t)head;
+			}
+			count++;
+			head = node->next;
+		}
+	}
+	if (count != bench->n_nodes) {
+		pr_fail("%s: %s freelists hold %" PRIu64 " nodes, expected %" PRIu32 "\n",
+			args->name, impl, count, bench->n_nodes);
+		return -1;
+	}
+	for (count = 0, i = 0; i < bench->n_nodes; i++)
+		count += bench->nodes[i].payload;
+	if (count != used) {
+		pr_fail("%s: %s freelist nodes were used %" PRIu64 " times, expected %" PRIu64 "\n",
+			args->name, impl, count, used);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ *  stress_rseq_bench_run()
+ *	run an implementation with a number of threads for a time slice
+ */
+static int stress_rseq_bench_run(
+	stress_args_t *args,
+	stress_rseq_bench_t *bench,
+	stress_rseq_thread_t *threads,
+	stress_rseq_result_t *result,
+	uint64_t *carry)
+{
+	const uint32_t n_threads = result->n_threads;
+	uint32_t i, created;
+	uint64_t ops = 0;
+	double t;
+	int ret = 0;
+
+	bench->method = result->method;
+	bench->impl = result->impl;
+	bench->go = false;
+	bench->stop = false;
+	for (i = 0; i < bench->n_slots; i++) {
+		bench->slots[i].count = 0;
+		bench->slots[i].head = 0;
+	}
+	for (i = 0; i < bench->n_nodes; i++) {
+		stress_rseq_slot_t *slot = &bench->slots[i % bench->n_slots];
+		stress_rseq_node_t *node = &bench->nodes[i];
+
+		node->payload = 0;
+		if (bench->impl == RSEQ_IMPL_ATOMIC) {
+			node->next = RSEQ_TAGGED_IDX(slot->head);
+			slot->head = RSEQ_TAGGED(0, i + 1);
+		} else {
+			node->next = slot->head;
+			slot->head = (uint64_t)(uintptr_t)node;
+		}
+	}
+
+	for (created = 0; created < n_threads; created++) {
+		stress_rseq_thread_t *thread = &threads[created];
+
+		(void)shim_memset(thread, 0, sizeof(*thread));
+		thread->bench = bench;
+		if (pthread_create(&thread->pthread, NULL, stress_rseq_thread, (void *)thread) != 0)
+			break;
+	}
+	if (created < n_threads) {
+		pr_dbg("%s: cannot create %" PRIu32 " threads, skipping %s %s\n",
+			args->name, n_threads, stress_rseq_methods[result->method],
+			stress_rseq_impls[result->impl]);
+		result->skipped = true;
+	}
+
+	t = stress_time_now();
+	__atomic_store_n(&bench->go, true, __ATOMIC_RELEASE);
+	if (!result->skipped)
+		(void)shim_nanosleep_uint64(RSEQ_SLICE_NS);
+	__atomic_store_n(&bench->stop, true, __ATOMIC_RELEASE);
+	t = stress_time_now() - t;
+
+	for (i = 0; i < created; i++)
+		VOID_RET(int, pthread_join(threads[i].pthread, NULL));
+	if (result->skipped)
+		return 0;
+
+	if (stress_rseq_bench_verify(args, bench, threads, n_threads) < 0)
+		ret = -1;
+	for (i = 0; i < n_threads; i++) {
+		ops += threads[i].ops;
+		result->aborts += threads[i].aborts;
+	}
+	result->ops += ops;
+	result->duration += t;
+
+	*carry += ops;
+	stress_bogo_add(args, *carry / RSEQ_OPS_PER_BOGO);
+	*carry %= RSEQ_OPS_PER_BOGO;
+	return ret;
+}
+
+/*
+ *  stress_rseq_bench_metrics()
+ *	operations per second for each method, implementation and
+ *	number of threads
+ */
+static void stress_rseq_bench_metrics(
+	stress_args_t *args,
+	const stress_rseq_result_t *results,
+	const size_t n_results)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_rseq_result_t *r = &results[i];
+		const char *method = stress_rseq_methods[r->method];
+		const char *impl = stress_rseq_impls[r->impl];
+		const double rate = (r->duration > 0.0) ? (double)r->ops / r->duration : 0.0;
+		char msg[64];
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-8s %-11s %4" PRIu32 " threads %12.0f ops/sec, %11.0f per thread, "
+				"%8.2f aborts per million ops\n", args->name, method, impl,
+				r->n_threads, rate, rate / (double)r->n_threads,
+				(r->ops > 0) ? (double)r->aborts * 1000000.0 / (double)r->ops : 0.0);
+
+		(void)snprintf(msg, sizeof(msg), "%s %s %" PRIu32 " threads ops/sec", method, impl, r->n_threads);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+	}
+}
+
+/*
+ *  stress_rseq_bench()
+ *	compare per-CPU counters and freelists using rseq critical
+ *	sections indexed by CPU and by concurrency id (mm_cid) against
+ *	atomic and mutex protected per-CPU equivalents as the number of
+ *	threads is swept in powers of 2
+ */
+static int stress_rseq_bench(stress_args_t *args, const size_t rseq_method)
+{
+	const int32_t n_cpus = stress_get_processors_online();
+	const int32_t n_cpus_configured = stress_get_processors_configured();
+	uint32_t rseq_threads = (uint32_t)STRESS_MINIMUM(STRESS_MAXIMUM(n_cpus, MIN_RSEQ_THREADS), MAX_RSEQ_THREADS);
+	uint32_t levels[16], n_levels = 0, n;
+	size_t method, impl, n_results = 0, i, slots_size, nodes_size;
+	stress_rseq_result_t *results;
+	stress_rseq_thread_t *threads;
+	stress_rseq_bench_t bench;
+	uint64_t carry = 0;
+	bool impl_ok[SIZEOF_ARRAY(stress_rseq_impls)];
+	int rc = EXIT_SUCCESS;
+
+	if (!stress_get_setting("rseq-threads", &rseq_threads)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			rseq_threads = MAX_RSEQ_THREADS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			rseq_threads = MIN_RSEQ_THREADS;
+	}
+	for (n = 1; n < rseq_threads; n <<= 1)
+		levels[n_levels++] = n;
+	levels[n_levels++] = rseq_threads;
+
+	for (impl = 0; impl < SIZEOF_ARRAY(stress_rseq_impls); impl++)
+		impl_ok[impl] = true;
+#if defined(HAVE_RSEQ_BENCH_ASM)
+	/* mm_cid is only valid if the kernel says the rseq area is large enough */
+#if defined(HAVE_GETAUXVAL) &&		\
+    defined(AT_RSEQ_FEATURE_SIZE)
+	impl_ok[RSEQ_IMPL_RSEQ_MM_CID] = (getauxval(AT_RSEQ_FEATURE_SIZE) >= RSEQ_MM_CID_OFFSET + sizeof(uint32_t));
+#else
+	impl_ok[RSEQ_IMPL_RSEQ_MM_CID] = false;
+#endif
+	if (stress_instance_zero(args) && !impl_ok[RSEQ_IMPL_RSEQ_MM_CID])
+		pr_inf("%s: kernel does not provide rseq mm_cid, skipping rseq-mm_cid\n", args->name);
+#else
+	impl_ok[RSEQ_IMPL_RSEQ] = false;
+	impl_ok[RSEQ_IMPL_RSEQ_MM_CID] = false;
+	if (stress_instance_zero(args))
+		pr_inf("%s: rseq critical sections are not implemented for this architecture, "
+			"only comparing atomic and mutex\n", args->name);
+#endif
+
+	(void)shim_memset(&bench, 0, sizeof(bench));
+	bench.n_slots = (uint32_t)STRESS_MAXIMUM(STRESS_MAXIMUM(n_cpus_configured, n_cpus), 1);
+	bench.n_nodes = bench.n_slots * RSEQ_NODES_PER_SLOT;
+
+	slots_size = (size_t)bench.n_slots * sizeof(*bench.slots);
+	bench.slots = (stress_rseq_slot_t *)stress_mmap_populate(NULL, slots_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (bench.slots == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for per-CPU slots%s, skipping stressor\n",
+			args->name, slots_size, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(bench.slots, slots_size, "rseq-percpu");
+	nodes_size = (size_t)bench.n_nodes * sizeof(*bench.nodes);
+	bench.nodes = (stress_rseq_node_t *)stress_mmap_populate(NULL, nodes_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (bench.nodes == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for freelist nodes%s, skipping stressor\n",
+			args->name, nodes_size, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto unmap_slots;
+	}
+	stress_set_vma_anon_name(bench.nodes, nodes_size, "rseq-nodes");
+
+	threads = (stress_rseq_thread_t *)calloc(rseq_threads, sizeof(*threads));
+	results = (stress_rseq_result_t *)calloc(2 * SIZEOF_ARRAY(stress_rseq_impls) * n_levels, sizeof(*results));
+	if (!threads || !results) {
+		pr_inf_skip("%s: cannot allocate thread state and result table%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_state;
+	}
+	for (i = 0; i < bench.n_slots; i++)
+		(void)pthread_mutex_init(&bench.slots[i].mutex, NULL);
+
+	for (method = RSEQ_METHOD_COUNTER; method < SIZEOF_ARRAY(stress_rseq_methods); method++) {
+		if ((rseq_method != RSEQ_METHOD_ALL) && (rseq_method != method))
+			continue;
+		for (impl = 0; impl < SIZEOF_ARRAY(stress_rseq_impls); impl++) {
+			if (!impl_ok[impl])
+				continue;
+			for (n = 0; n < n_levels; n++) {
+				results[n_results].method = method;
+				results[n_results].impl = impl;
+				results[n_results].n_threads = levels[n];
+				n_results++;
+			}
+		}
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		bool runnable = false;
+		size_t j;
+
+		if (!results[i].skipped &&
+		    (stress_rseq_bench_run(args, &bench, threads, &results[i], &carry) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		for (j = 0; j < n_results; j++)
+			runnable |= !results[j].skipped;
+		if (!runnable)
+			break;
+		i = (i + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_rseq_bench_metrics(args, results, n_results);
+
+	for (i = 0; i < bench.n_slots; i++)
+		(void)pthread_mutex_destroy(&bench.slots[i].mutex);
+free_state:
+	free(results);
+	free(threads);
+	(void)munmap((void *)bench.nodes, nodes_size);
+unmap_slots:
+	(void)munmap((void *)bench.slots, slots_size);
+	return rc;
+}
+#endif
+
 static int stress_rseq(stress_args_t *args)
 {
 	int ret;
 	double rate;
+	size_t rseq_method = RSEQ_METHOD_VERIFY;
+
+	(void)stress_get_setting("rseq-method", &rseq_method);
+	if (rseq_method != RSEQ_METHOD_VERIFY) {
+#if defined(HAVE_RSEQ_BENCH)
+		return stress_rseq_bench(args, rseq_method);
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: rseq-method %s requires pthread and atomic support, "
+				"skipping stressor\n", args->name, stress_rseq_methods[rseq_method]);
+		return EXIT_NO_RESOURCE;
+#endif
+	}
 
 	/*
 	 *  rseq_info is in a shared page to avoid losing the
@@ -261,12 +1046,14 @@ const stressor_info_t stress_rseq_info = {
 	.stressor = stress_rseq,
 	.supported = stress_rseq_supported,
 	.classifier = CLASS_CPU,
+	.opts = opts,
 	.help = help
 };
 #else
 const stressor_info_t stress_rseq_info = {
 	.stressor = stress_unimplemented,
 	.classifier = CLASS_CPU,
+	.opts = opts,
 	.help = help,
 	.unimplemented_reason = "built without Linux restartable sequences support"
 };
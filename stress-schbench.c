@@ -0,0 +1,701 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-pthread.h"
+#include "core-put.h"
+#include "core-sched.h"
+
+#if defined(HAVE_LINUX_FUTEX_H)
+#include <linux/futex.h>
+#endif
+
+#define MIN_SCHBENCH_BURST	(0)
+#define MAX_SCHBENCH_BURST	(1000000)
+#define DEFAULT_SCHBENCH_BURST	(50)
+
+#define MIN_SCHBENCH_MSG_THREADS	(1)
+#define MAX_SCHBENCH_MSG_THREADS	(64)
+#define DEFAULT_SCHBENCH_MSG_THREADS	(2)
+
+#define SCHBENCH_MAX_WORKERS	(4096)		/* total worker thread limit */
+#define SCHBENCH_LEVELS		(3)		/* half, equal and twice the CPUs */
+#define SCHBENCH_SLICE_NS	(250000000ULL)	/* 0.25 seconds per configuration */
+#define SCHBENCH_WAIT_NS	(10000000L)	/* message thread futex wait timeout */
+
+/*
+ *  log-linear latency histogram, values below 32 ns have their own
+ *  bucket, above that each power of 2 is split into 32 buckets
+ */
+#define SCHBENCH_HIST_SUB_BITS	(5)
+#define SCHBENCH_HIST_SUB	(1U << SCHBENCH_HIST_SUB_BITS)
+#define SCHBENCH_HIST_BUCKETS	(38 * SCHBENCH_HIST_SUB)
+
+static const stress_help_t help[] = {
+	{ NULL,	"schbench N",		"start N workers measuring scheduler wakeup and request latency" },
+	{ NULL,	"schbench-burst N",	"CPU burst per request in microseconds" },
+	{ NULL,	"schbench-msg-threads N", "number of message threads that wake worker threads" },
+	{ NULL,	"schbench-ops N",	"stop after N requests" },
+	{ NULL,	"schbench-policy P",	"scheduling policy: other, batch, idle, ext" },
+	{ NULL,	NULL,			NULL }
+};
+
+/*
+ *  fair class policies, the ones a sched_ext BPF scheduler can manage
+ */
+typedef struct {
+	const char *name;
+	const int policy;
+} stress_schbench_policy_t;
+
+static const stress_schbench_policy_t stress_schbench_policies[] = {
+#if defined(SCHED_OTHER)
+	{ "other",	SCHED_OTHER },
+#endif
+#if defined(SCHED_BATCH)
+	{ "batch",	SCHED_BATCH },
+#endif
+#if defined(SCHED_IDLE)
+	{ "idle",	SCHED_IDLE },
+#endif
+#if defined(SCHED_EXT)
+	{ "ext",	SCHED_EXT },
+#endif
+};
+
+static const char *stress_schbench_policy(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_schbench_policies)) ? stress_schbench_policies[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_schbench_burst,	    "schbench-burst",	    TYPE_ID_UINT32, MIN_SCHBENCH_BURST, MAX_SCHBENCH_BURST, NULL },
+	{ OPT_schbench_msg_threads, "schbench-msg-threads", TYPE_ID_UINT32, MIN_SCHBENCH_MSG_THREADS, MAX_SCHBENCH_MSG_THREADS, NULL },
+	{ OPT_schbench_policy,	    "schbench-policy",	    TYPE_ID_SIZE_T_METHOD, 0, 0, stress_schbench_policy },
+	END_OPT,
+};
+
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_LINUX_FUTEX_H) &&		\
+    defined(__NR_futex) &&			\
+    defined(HAVE_CLOCK_GETTIME) &&		\
+    defined(CLOCK_MONOTONIC) &&			\
+    defined(HAVE_ATOMIC_ADD_FETCH) &&		\
+    defined(HAVE_ATOMIC_SUB_FETCH) &&		\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+
+typedef struct {
+	uint32_t counts[SCHBENCH_HIST_BUCKETS];
+} stress_schbench_hist_t;
+
+struct stress_schbench_context;
+struct stress_schbench_msg;
+
+/*
+ *  worker thread, woken by its message thread to run a CPU burst
+ */
+typedef struct {
+	uint32_t futex ALIGN64;			/* request sequence number */
+	uint64_t wake_stamp;			/* time the request was posted (ns) */
+	struct stress_schbench_context *ctx;
+	struct stress_schbench_msg *msg;
+	pthread_t pthread;
+	stress_schbench_hist_t *wake_hist;	/* wakeup latencies */
+	stress_schbench_hist_t *req_hist;	/* request latencies */
+	uint64_t requests;			/* requests completed */
+	uint64_t run_delay;			/* schedstat run queue delay (ns) */
+	uint64_t timeslices;			/* schedstat timeslices */
+	uint64_t sink;				/* CPU burst result */
+} stress_schbench_worker_t;
+
+/*
+ *  message thread, wakes its pool of workers and waits for them
+ *  to finish their requests
+ */
+typedef struct stress_schbench_msg {
+	uint32_t pending ALIGN64;		/* workers yet to complete */
+	struct stress_schbench_context *ctx;
+	pthread_t pthread;
+	stress_schbench_worker_t *workers;
+	uint32_t n_workers;
+} stress_schbench_msg_t;
+
+typedef struct stress_schbench_context {
+	uint64_t burst_loops;			/* CPU burst work loops */
+	bool go;				/* start running */
+	bool stop;				/* stop running */
+} stress_schbench_context_t;
+
+/*
+ *  accumulated results for a number of worker threads
+ */
+typedef struct {
+	uint32_t workers_per_msg;
+	uint32_t n_workers;
+	bool skipped;
+	double duration;
+	uint64_t requests;
+	uint64_t run_delay;			/* worker run queue delay (ns) */
+	uint64_t timeslices;			/* worker timeslices */
+	uint64_t sys_run_delay;			/* system wide run queue delay (ns) */
+	uint64_t sys_timeslices;		/* system wide timeslices */
+	uint64_t wake_hist[SCHBENCH_HIST_BUCKETS];
+	uint64_t req_hist[SCHBENCH_HIST_BUCKETS];
+} stress_schbench_result_t;
+
+static inline uint64_t stress_schbench_now(void)
+{
+	struct timespec ts;
+
+	if (UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) < 0))
+		return (uint64_t)(stress_time_now() * STRESS_DBL_NANOSECOND);
+	return ((uint64_t)ts.tv_sec * STRESS_NANOSECOND) + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ *  stress_schbench_hist_idx()
+ *	histogram bucket for a latency in nanoseconds
+ */
+static inline size_t stress_schbench_hist_idx(const uint64_t ns)
+{
+	int msb;
+	size_t idx;
+
+	if (ns < SCHBENCH_HIST_SUB)
+		return (size_t)ns;
+#if defined(HAVE_BUILTIN_CLZLL)
+	msb = 63 - __builtin_clzll(ns);
+#else
+	{
+		uint64_t v = ns;
+
+		for (msb = -1; v; msb++)
+			v >>= 1;
+	}
+#endif
+	idx = ((size_t)(msb - SCHBENCH_HIST_SUB_BITS + 1) * SCHBENCH_HIST_SUB) +
+	      (size_t)((ns >> (msb - SCHBENCH_HIST_SUB_BITS)) & (SCHBENCH_HIST_SUB - 1));
+	return (idx < SCHBENCH_HIST_BUCKETS) ? idx : SCHBENCH_HIST_BUCKETS - 1;
+}
+
+/*
+ *  stress_schbench_hist_value()
+ *	mid point latency in nanoseconds of a histogram bucket
+ */
+static uint64_t stress_schbench_hist_value(const size_t idx)
+{
+	const size_t group = idx / SCHBENCH_HIST_SUB;
+	const uint64_t sub = idx % SCHBENCH_HIST_SUB;
+	int shift;
+
+	if (group == 0)
+		return (uint64_t)idx;
+	shift = (int)group - 1;
+	return ((SCHBENCH_HIST_SUB + sub) << shift) + ((1ULL << shift) >> 1);
+}
+
+/*
+ *  stress_schbench_percentile()
+ *	latency in microseconds at a percentile of a histogram
+ */
+static double stress_schbench_percentile(
+	const uint64_t *hist,
+	const uint64_t total,
+	const double percentile)
+{
+	const uint64_t target = (uint64_t)((double)total * percentile / 100.0) + 1;
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < SCHBENCH_HIST_BUCKETS; i++) {
+		sum += hist[i];
+		if (sum >= target)
+			break;
+	}
+	if (i >= SCHBENCH_HIST_BUCKETS)
+		i = SCHBENCH_HIST_BUCKETS - 1;
+	return (double)stress_schbench_hist_value(i) / 1000.0;
+}
+
+/*
+ *  stress_schbench_work()
+ *	fixed amount of CPU work for a request
+ */
+static uint64_t OPTIMIZE3 stress_schbench_work(const uint64_t loops, uint64_t x)
+{
+	uint64_t i;
+
+	for (i = 0; i < loops; i++) {
+		x = (x * 6364136223846793005ULL) + 1442695040888963407ULL;
+		x ^= x >> 29;
+	}
+	return x;
+}
+
+/*
+ *  stress_schbench_calibrate()
+ *	work loops per microsecond
+ */
+static double stress_schbench_calibrate(void)
+{
+	uint64_t loops = 1024, sink = 0;
+
+	for (;;) {
+		const double t = stress_time_now();
+		double duration;
+
+		sink = stress_schbench_work(loops, sink);
+		duration = stress_time_now() - t;
+		if ((duration >= 0.01) || (loops >= (1ULL << 40))) {
+			stress_uint64_put(sink);
+			return (duration > 0.0) ? (double)loops / (duration * STRESS_DBL_MICROSECOND) : 1000.0;
+		}
+		loops <<= 1;
+	}
+}
+
+/*
+ *  stress_schbench_thread_schedstat()
+ *	fetch the run queue delay and timeslices of the calling thread
+ */
+static void stress_schbench_thread_schedstat(uint64_t *run_delay, uint64_t *timeslices)
+{
+	char path[64], buf[128];
+	uint64_t runtime;
+
+	*run_delay = 0;
+	*timeslices = 0;
+	(void)snprintf(path, sizeof(path), "/proc/self/task/%d/schedstat", shim_gettid());
+	if (stress_system_read(path, buf, sizeof(buf)) <= 0)
+		return;
+	if (sscanf(buf, "%" SCNu64 " %" SCNu64 " %" SCNu64, &runtime, run_delay, timeslices) != 3) {
+		*run_delay = 0;
+		*timeslices = 0;
+	}
+}
+
+/*
+ *  stress_schbench_schedstat()
+ *	sum of the run queue delay and timeslices of all CPUs from
+ *	/proc/schedstat, returns false if it is not available
+ */
+static bool stress_schbench_schedstat(uint64_t *run_delay, uint64_t *timeslices)
+{
+	FILE *fp;
+	char buf[512];
+	bool found = false;
+
+	*run_delay = 0;
+	*timeslices = 0;
+	fp = fopen("/proc/schedstat", "r");
+	if (!fp)
+		return false;
+	while (fgets(buf, sizeof(buf), fp)) {
+		uint64_t f[9];
+
+		if (strncmp(buf, "cpu", 3))
+			continue;
+		if (sscanf(buf, "%*s %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+				" %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+				&f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7], &f[8]) == 9) {
+			*run_delay += f[7];
+			*timeslices += f[8];
+			found = true;
+		}
+	}
+	(void)fclose(fp);
+	return found;
+}
+
+/*
+ *  stress_schbench_worker()
+ *	wait for a request, run the CPU burst and tell the message
+ *	thread when done
+ */
+static void *stress_schbench_worker(void *arg)
+{
+	stress_schbench_worker_t *worker = (stress_schbench_worker_t *)arg;
+	stress_schbench_context_t *ctx = worker->ctx;
+	stress_schbench_msg_t *msg = worker->msg;
+	uint64_t run_delay, timeslices;
+	uint32_t seen = 0;
+
+	stress_schbench_thread_schedstat(&run_delay, &timeslices);
+
+	for (;;) {
+		uint32_t val;
+		uint64_t t_run, t_done;
+
+		while ((val = __atomic_load_n(&worker->futex, __ATOMIC_ACQUIRE)) == seen) {
+			if (__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE))
+				goto done;
+			(void)shim_futex_wait(&worker->futex, (int)seen, NULL);
+		}
+		seen = val;
+		if (__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE))
+			break;
+
+		t_run = stress_schbench_now();
+		worker->wake_hist->counts[stress_schbench_hist_idx(t_run - worker->wake_stamp)]++;
+		worker->sink = stress_schbench_work(ctx->burst_loops, worker->sink);
+		t_done = stress_schbench_now();
+		worker->req_hist->counts[stress_schbench_hist_idx(t_done - worker->wake_stamp)]++;
+		worker->requests++;
+
+		if (__atomic_sub_fetch(&msg->pending, 1, __ATOMIC_ACQ_REL) == 0)
+			(void)shim_futex_wake(&msg->pending, 1);
+	}
+done:
+	stress_schbench_thread_schedstat(&worker->run_delay, &worker->timeslices);
+	worker->run_delay -= run_delay;
+	worker->timeslices -= timeslices;
+	return &g_nowt;
+}
+
+/*
+ *  stress_schbench_msg()
+ *	post a request to every worker in the pool and wait for them all
+ */
+static void *stress_schbench_msg(void *arg)
+{
+	stress_schbench_msg_t *msg = (stress_schbench_msg_t *)arg;
+	stress_schbench_context_t *ctx = msg->ctx;
+
+	while (!__atomic_load_n(&ctx->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE)) {
+		uint32_t i, pending;
+
+		__atomic_store_n(&msg->pending, msg->n_workers, __ATOMIC_RELEASE);
+		for (i = 0; i < msg->n_workers; i++) {
+			stress_schbench_worker_t *worker = &msg->workers[i];
+
+			worker->wake_stamp = stress_schbench_now();
+			(void)__atomic_add_fetch(&worker->futex, 1, __ATOMIC_RELEASE);
+			(void)shim_futex_wake(&worker->futex, 1);
+		}
+		while ((pending = __atomic_load_n(&msg->pending, __ATOMIC_ACQUIRE)) != 0) {
+			struct timespec timeout;
+
+			if (__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE))
+				break;
+			timeout.tv_sec = 0;
+			timeout.tv_nsec = SCHBENCH_WAIT_NS;
+			(void)shim_futex_wait(&msg->pending, (int)pending, &timeout);
+		}
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_schbench_run()
+ *	run the message and worker threads for one configuration
+ */
+static void stress_schbench_run(
+	stress_args_t *args,
+	stress_schbench_context_t *ctx,
+	const uint32_t msg_threads,
+	stress_schbench_result_t *result)
+{
+	const uint32_t n_workers = result->n_workers;
+	stress_schbench_msg_t *msgs;
+	stress_schbench_worker_t *workers;
+	stress_schbench_hist_t *hists;
+	uint32_t i, workers_created = 0, msgs_created = 0;
+	uint64_t sys_run_delay[2], sys_timeslices[2];
+	bool sys_schedstat;
+	double t;
+	size_t j;
+
+	msgs = (stress_schbench_msg_t *)calloc(msg_threads, sizeof(*msgs));
+	workers = (stress_schbench_worker_t *)calloc(n_workers, sizeof(*workers));
+	hists = (stress_schbench_hist_t *)calloc((size_t)n_workers * 2, sizeof(*hists));
+	if (!msgs || !workers || !hists) {
+		pr_dbg("%s: cannot allocate state for %" PRIu32 " workers, skipping it\n",
+			args->name, n_workers);
+		result->skipped = true;
+		goto free_state;
+	}
+
+	ctx->go = false;
+	ctx->stop = false;
+	for (i = 0; i < msg_threads; i++) {
+		msgs[i].ctx = ctx;
+		msgs[i].workers = &workers[i * result->workers_per_msg];
+		msgs[i].n_workers = result->workers_per_msg;
+	}
+	for (i = 0; i < n_workers; i++) {
+		workers[i].ctx = ctx;
+		workers[i].msg = &msgs[i / result->workers_per_msg];
+		workers[i].wake_hist = &hists[i * 2];
+		workers[i].req_hist = &hists[(i * 2) + 1];
+		workers[i].sink = i;
+	}
+
+	for (workers_created = 0; workers_created < n_workers; workers_created++) {
+		if (pthread_create(&workers[workers_created].pthread, NULL,
+				stress_schbench_worker, (void *)&workers[workers_created]) != 0)
+			break;
+	}
+	if (workers_created == n_workers) {
+		for (msgs_created = 0; msgs_created < msg_threads; msgs_created++) {
+			if (pthread_create(&msgs[msgs_created].pthread, NULL,
+					stress_schbench_msg, (void *)&msgs[msgs_created]) != 0)
+				break;
+		}
+	}
+	if ((workers_created < n_workers) || (msgs_created < msg_threads)) {
+		pr_dbg("%s: cannot create %" PRIu32 " threads, skipping %" PRIu32 " workers\n",
+			args->name, n_workers + msg_threads, n_workers);
+		result->skipped = true;
+	}
+
+	sys_schedstat = stress_schbench_schedstat(&sys_run_delay[0], &sys_timeslices[0]);
+	t = stress_time_now();
+	__atomic_store_n(&ctx->go, true, __ATOMIC_RELEASE);
+	if (!result->skipped)
+		(void)shim_nanosleep_uint64(SCHBENCH_SLICE_NS);
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELEASE);
+	t = stress_time_now() - t;
+	if (sys_schedstat)
+		sys_schedstat = stress_schbench_schedstat(&sys_run_delay[1], &sys_timeslices[1]);
+
+	for (i = 0; i < msgs_created; i++)
+		VOID_RET(int, pthread_join(msgs[i].pthread, NULL));
+	for (i = 0; i < workers_created; i++) {
+		(void)__atomic_add_fetch(&workers[i].futex, 1, __ATOMIC_RELEASE);
+		(void)shim_futex_wake(&workers[i].futex, 1);
+	}
+	for (i = 0; i < workers_created; i++)
+		VOID_RET(int, pthread_join(workers[i].pthread, NULL));
+
+	if (!result->skipped) {
+		uint64_t requests = 0;
+
+		for (i = 0; i < n_workers; i++) {
+			for (j = 0; j < SCHBENCH_HIST_BUCKETS; j++) {
+				result->wake_hist[j] += workers[i].wake_hist->counts[j];
+				result->req_hist[j] += workers[i].req_hist->counts[j];
+			}
+			requests += workers[i].requests;
+			result->run_delay += workers[i].run_delay;
+			result->timeslices += workers[i].timeslices;
+		}
+		if (sys_schedstat) {
+			result->sys_run_delay += sys_run_delay[1] - sys_run_delay[0];
+			result->sys_timeslices += sys_timeslices[1] - sys_timeslices[0];
+		}
+		result->requests += requests;
+		result->duration += t;
+		stress_bogo_add(args, requests);
+	}
+
+free_state:
+	free(hists);
+	free(workers);
+	free(msgs);
+}
+
+/*
+ *  stress_schbench_metrics()
+ *	requests/sec, wakeup and request latency percentiles and run
+ *	queue delay for each number of workers
+ */
+static void stress_schbench_metrics(
+	stress_args_t *args,
+	const stress_schbench_result_t *results,
+	const size_t n_results)
+{
+	size_t i, j, idx = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_schbench_result_t *r = &results[i];
+		const uint32_t n = r->n_workers;
+		double wake[3], req[3], rate, run_delay;
+		uint64_t total = 0;
+		char msg[64];
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+		for (j = 0; j < SCHBENCH_HIST_BUCKETS; j++)
+			total += r->wake_hist[j];
+		if (total == 0)
+			continue;
+
+		wake[0] = stress_schbench_percentile(r->wake_hist, total, 50.0);
+		wake[1] = stress_schbench_percentile(r->wake_hist, total, 99.0);
+		wake[2] = stress_schbench_percentile(r->wake_hist, total, 99.9);
+		req[0] = stress_schbench_percentile(r->req_hist, total, 50.0);
+		req[1] = stress_schbench_percentile(r->req_hist, total, 99.0);
+		req[2] = stress_schbench_percentile(r->req_hist, total, 99.9);
+		rate = (double)r->requests / r->duration;
+		run_delay = (r->timeslices > 0) ?
+			((double)r->run_delay / (double)r->timeslices) / 1000.0 : 0.0;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %4" PRIu32 " workers %10.0f requests/sec, wakeup p50 %8.1f "
+				"p99 %8.1f p99.9 %8.1f, request p50 %8.1f p99 %8.1f p99.9 %8.1f usec\n",
+				args->name, n, rate, wake[0], wake[1], wake[2],
+				req[0], req[1], req[2]);
+
+		(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers requests/sec", n);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec p50 wakeup latency", n);
+		stress_metrics_set(args, idx++, msg, wake[0], STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec p99 wakeup latency", n);
+		stress_metrics_set(args, idx++, msg, wake[1], STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec p99.9 wakeup latency", n);
+		stress_metrics_set(args, idx++, msg, wake[2], STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec p50 request latency", n);
+		stress_metrics_set(args, idx++, msg, req[0], STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec p99 request latency", n);
+		stress_metrics_set(args, idx++, msg, req[1], STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec p99.9 request latency", n);
+		stress_metrics_set(args, idx++, msg, req[2], STRESS_METRIC_GEOMETRIC_MEAN);
+		if (r->timeslices > 0) {
+			(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec run delay per timeslice", n);
+			stress_metrics_set(args, idx++, msg, run_delay, STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+		if (r->sys_timeslices > 0) {
+			(void)snprintf(msg, sizeof(msg), "%" PRIu32 " workers usec system run delay per timeslice", n);
+			stress_metrics_set(args, idx++, msg,
+				((double)r->sys_run_delay / (double)r->sys_timeslices) / 1000.0,
+				STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_schbench()
+ *	message threads wake pools of workers that run a CPU burst,
+ *	measure the wakeup and request latencies with the number of
+ *	workers below, at and above the number of CPUs
+ */
+static int stress_schbench(stress_args_t *args)
+{
+	uint32_t schbench_burst = DEFAULT_SCHBENCH_BURST;
+	uint32_t schbench_msg_threads = DEFAULT_SCHBENCH_MSG_THREADS;
+	size_t schbench_policy = 0, n_results = 0, i, j;
+	stress_schbench_result_t *results;
+	stress_schbench_context_t ctx;
+	const int32_t n_cpus = stress_get_processors_online();
+	uint32_t levels[SCHBENCH_LEVELS];
+	double loops_per_usec;
+
+	(void)stress_get_setting("schbench-burst", &schbench_burst);
+	(void)stress_get_setting("schbench-policy", &schbench_policy);
+	if (!stress_get_setting("schbench-msg-threads", &schbench_msg_threads)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			schbench_msg_threads = MAX_SCHBENCH_MSG_THREADS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			schbench_msg_threads = MIN_SCHBENCH_MSG_THREADS;
+	}
+
+	/* worker threads inherit the scheduling policy */
+	if (SIZEOF_ARRAY(stress_schbench_policies) > 0) {
+		const stress_schbench_policy_t *policy = &stress_schbench_policies[schbench_policy];
+
+		if (stress_set_sched(0, policy->policy, UNDEFINED, true) < 0) {
+			if (stress_instance_zero(args))
+				pr_inf("%s: cannot set scheduling policy '%s', using the default policy\n",
+					args->name, policy->name);
+		} else if (stress_instance_zero(args)) {
+			pr_dbg("%s: using scheduling policy '%s'\n", args->name, policy->name);
+		}
+	}
+
+	/* total workers of half, equal to and twice the number of CPUs */
+	levels[0] = (uint32_t)STRESS_MAXIMUM(n_cpus / 2, 1);
+	levels[1] = (uint32_t)STRESS_MAXIMUM(n_cpus, 1);
+	levels[2] = (uint32_t)STRESS_MAXIMUM(n_cpus * 2, 1);
+
+	results = (stress_schbench_result_t *)calloc(SCHBENCH_LEVELS, sizeof(*results));
+	if (!results) {
+		pr_inf_skip("%s: cannot allocate latency histograms%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+	for (i = 0; i < SCHBENCH_LEVELS; i++) {
+		uint32_t workers_per_msg = STRESS_MAXIMUM(levels[i] / schbench_msg_threads, 1);
+		bool dup = false;
+
+		if (workers_per_msg * schbench_msg_threads > SCHBENCH_MAX_WORKERS)
+			workers_per_msg = STRESS_MAXIMUM(SCHBENCH_MAX_WORKERS / schbench_msg_threads, 1);
+		for (j = 0; j < n_results; j++) {
+			if (results[j].workers_per_msg == workers_per_msg)
+				dup = true;
+		}
+		if (dup)
+			continue;
+		results[n_results].workers_per_msg = workers_per_msg;
+		results[n_results].n_workers = workers_per_msg * schbench_msg_threads;
+		n_results++;
+	}
+
+	loops_per_usec = stress_schbench_calibrate();
+	(void)shim_memset(&ctx, 0, sizeof(ctx));
+	ctx.burst_loops = (uint64_t)(loops_per_usec * (double)schbench_burst);
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %" PRIu32 " message threads, %" PRIu32 " usec CPU burst "
+			"(%" PRIu64 " work loops)\n", args->name, schbench_msg_threads,
+			schbench_burst, ctx.burst_loops);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		bool runnable = false;
+
+		if (!results[i].skipped)
+			stress_schbench_run(args, &ctx, schbench_msg_threads, &results[i]);
+		for (j = 0; j < n_results; j++)
+			runnable |= !results[j].skipped;
+		if (!runnable)
+			break;
+		i = (i + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_schbench_metrics(args, results, n_results);
+	free(results);
+
+	return EXIT_SUCCESS;
+}
+
+const stressor_info_t stress_schbench_info = {
+	.stressor = stress_schbench,
+	.classifier = CLASS_SCHEDULER,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_schbench_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_SCHEDULER,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread, futex or clock_gettime() support"
+};
+#endif
@@ -0,0 +1,554 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-capabilities.h"
+#include "core-put.h"
+
+#if defined(HAVE_LINUX_MEMFD_H)
+#include <linux/memfd.h>
+#endif
+
+#if defined(HAVE_SYS_MOUNT_H)
+#include <sys/mount.h>
+#endif
+
+#if defined(HAVE_SYS_STATFS_H)
+#include <sys/statfs.h>
+#endif
+
+#if !defined(TMPFS_MAGIC)
+#define TMPFS_MAGIC			(0x01021994)
+#endif
+
+#define MIN_SHM_BACKING_BYTES		(1 * MB)
+#define MAX_SHM_BACKING_BYTES		(MAX_MEM_LIMIT)
+#define DEFAULT_SHM_BACKING_BYTES	(64 * MB)
+
+#define SHM_BACKING_CHUNK		(64 * KB)	/* read/write I/O size */
+
+static const stress_help_t help[] = {
+	{ NULL,	"shm-backing N",	"start N workers comparing tmpfs, memfd and anonymous shared memory" },
+	{ NULL,	"shm-backing-bytes N",	"size of each shared memory object" },
+	{ NULL,	"shm-backing-huge",	"use a huge=within_size tmpfs mount or huge page advice" },
+	{ NULL,	"shm-backing-method M",	"backing: all, tmpfs, memfd, anon" },
+	{ NULL,	"shm-backing-ops N",	"stop after N shared memory object workloads" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef enum {
+	SHM_BACKING_ALL,
+	SHM_BACKING_TMPFS,
+	SHM_BACKING_MEMFD,
+	SHM_BACKING_ANON,
+} stress_shm_backing_type_t;
+
+#define SHM_BACKING_TYPES	(3)	/* tmpfs, memfd, anon */
+
+static const char * const stress_shm_backing_methods[] = {
+	"all", "tmpfs", "memfd", "anon"
+};
+
+static const char *stress_shm_backing_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_shm_backing_methods)) ? stress_shm_backing_methods[i] : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_shm_backing_bytes,  "shm-backing-bytes",  TYPE_ID_SIZE_T_BYTES_VM, MIN_SHM_BACKING_BYTES, MAX_SHM_BACKING_BYTES, NULL },
+	{ OPT_shm_backing_huge,   "shm-backing-huge",   TYPE_ID_BOOL, 0, 1, NULL },
+	{ OPT_shm_backing_method, "shm-backing-method", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_shm_backing_method },
+	END_OPT,
+};
+
+#if defined(__linux__) &&		\
+    defined(HAVE_MEMFD_CREATE) &&	\
+    defined(HAVE_SYS_STATFS_H) &&	\
+    defined(HAVE_MADVISE) &&		\
+    defined(MADV_REMOVE) &&		\
+    defined(RUSAGE_SELF)
+
+/*
+ *  per backing results
+ */
+typedef struct {
+	double write_bytes;		/* bytes written via write() or memcpy */
+	double write_duration;
+	double read_bytes;		/* bytes read via read() or memcpy */
+	double read_duration;
+	double mmap_bytes;		/* bytes written + read via a mapping */
+	double mmap_duration;
+	double alloc_duration;		/* fallocate or populate time */
+	double truncate_duration;	/* truncate or hole punch time */
+	double allocated;		/* bytes of memory allocated */
+	double requested;		/* bytes of memory requested */
+	uint64_t faults;		/* major and minor page faults */
+	uint64_t count;			/* workloads run */
+} stress_shm_backing_result_t;
+
+typedef struct {
+	stress_args_t *args;
+	uint8_t *buf;			/* I/O buffer */
+	size_t sz;			/* object size */
+	bool huge;			/* use huge pages */
+	char tmpfs_path[PATH_MAX];	/* tmpfs mount, empty if none */
+	bool tmpfs_mounted;		/* private huge tmpfs mounted */
+} stress_shm_backing_context_t;
+
+static const char * const stress_shm_backing_names[SHM_BACKING_TYPES] = {
+	"tmpfs", "memfd", "anon"
+};
+
+/*
+ *  stress_shm_backing_tmpfs_setup()
+ *	find a tmpfs to use; with huge pages try to mount a private
+ *	huge=within_size tmpfs on the temp directory first
+ */
+static void stress_shm_backing_tmpfs_setup(stress_shm_backing_context_t *ctxt)
+{
+	stress_args_t *args = ctxt->args;
+	struct statfs buf;
+
+	*ctxt->tmpfs_path = '\0';
+
+#if defined(HAVE_SYS_MOUNT_H)
+	if (ctxt->huge && stress_check_capability(SHIM_CAP_SYS_ADMIN)) {
+		char path[PATH_MAX], opt[64];
+
+		if (stress_temp_dir_mk_args(args) == 0) {
+			(void)stress_temp_dir_args(args, path, sizeof(path));
+			(void)snprintf(opt, sizeof(opt), "huge=within_size,size=%zu",
+				ctxt->sz + (size_t)(4 * MB));
+			if (mount("tmpfs", path, "tmpfs", 0, opt) == 0) {
+				(void)shim_strscpy(ctxt->tmpfs_path, path, sizeof(ctxt->tmpfs_path));
+				ctxt->tmpfs_mounted = true;
+				return;
+			}
+			pr_dbg("%s: cannot mount tmpfs with %s, errno=%d (%s), "
+				"using /dev/shm with huge page advice\n",
+				args->name, opt, errno, strerror(errno));
+			(void)stress_temp_dir_rm_args(args);
+		}
+	}
+#endif
+	(void)shim_memset(&buf, 0, sizeof(buf));
+	if ((statfs("/dev/shm", &buf) == 0) && (buf.f_type == TMPFS_MAGIC))
+		(void)shim_strscpy(ctxt->tmpfs_path, "/dev/shm", sizeof(ctxt->tmpfs_path));
+	else if (stress_instance_zero(args))
+		pr_inf("%s: no tmpfs /dev/shm, skipping tmpfs backing\n", args->name);
+}
+
+/*
+ *  stress_shm_backing_tmpfs_cleanup()
+ *	umount private tmpfs if it was mounted
+ */
+static void stress_shm_backing_tmpfs_cleanup(stress_shm_backing_context_t *ctxt)
+{
+#if defined(HAVE_SYS_MOUNT_H)
+	if (ctxt->tmpfs_mounted) {
+		if (umount(ctxt->tmpfs_path) < 0)
+			pr_dbg("%s: umount of %s failed, errno=%d (%s)\n",
+				ctxt->args->name, ctxt->tmpfs_path, errno, strerror(errno));
+		(void)stress_temp_dir_rm_args(ctxt->args);
+	}
+#endif
+	ctxt->tmpfs_mounted = false;
+}
+
+/*
+ *  stress_shm_backing_open()
+ *	create a shared memory object of the given backing,
+ *	returns fd, -1 for anon shared memory or -2 on failure
+ */
+static int stress_shm_backing_open(
+	stress_shm_backing_context_t *ctxt,
+	const stress_shm_backing_type_t type)
+{
+	stress_args_t *args = ctxt->args;
+	char path[PATH_MAX];
+	int fd;
+
+	switch (type) {
+	case SHM_BACKING_TMPFS:
+		(void)snprintf(path, sizeof(path), "%s/%s-%" PRIdMAX "-%" PRIu32 "-%" PRIu32,
+			ctxt->tmpfs_path, args->name, (intmax_t)args->pid,
+			args->instance, stress_mwc32());
+		fd = open(path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+		if (fd < 0)
+			break;
+		(void)shim_unlink(path);
+		return fd;
+	case SHM_BACKING_MEMFD:
+		(void)snprintf(path, sizeof(path), "%s-%" PRIdMAX, args->name, (intmax_t)args->pid);
+		fd = shim_memfd_create(path, 0);
+		if (fd < 0)
+			break;
+		return fd;
+	case SHM_BACKING_ANON:
+	default:
+		return -1;
+	}
+	pr_dbg("%s: cannot create %s object, errno=%d (%s)\n",
+		args->name, stress_shm_backing_names[type - 1], errno, strerror(errno));
+	return -2;
+}
+
+/*
+ *  stress_shm_backing_allocated()
+ *	return number of bytes of memory backing the object
+ */
+static double stress_shm_backing_allocated(
+	stress_shm_backing_context_t *ctxt,
+	const int fd,
+	uint8_t *ptr)
+{
+	struct stat statbuf;
+
+	if (fd >= 0) {
+		if (shim_fstat(fd, &statbuf) == 0)
+			return (double)statbuf.st_blocks * 512.0;
+		return 0.0;
+	}
+#if defined(HAVE_MINCORE)
+	{
+		const size_t page_size = ctxt->args->page_size;
+		const size_t n_pages = ctxt->sz / page_size;
+		unsigned char vec[256];
+		size_t i, resident = 0;
+
+		for (i = 0; i < n_pages; i += SIZEOF_ARRAY(vec)) {
+			const size_t n = ((n_pages - i) < SIZEOF_ARRAY(vec)) ?
+				n_pages - i : SIZEOF_ARRAY(vec);
+			size_t j;
+
+			if (shim_mincore((void *)(ptr + (i * page_size)), n * page_size, vec) < 0)
+				return 0.0;
+			for (j = 0; j < n; j++)
+				resident += (vec[j] & 1);
+		}
+		return (double)resident * (double)page_size;
+	}
+#else
+	(void)ctxt;
+	(void)ptr;
+	return 0.0;
+#endif
+}
+
+/*
+ *  stress_shm_backing_workload()
+ *	allocate, write, read, mmap and truncate a shared
+ *	memory object of the given backing
+ */
+static int stress_shm_backing_workload(
+	stress_shm_backing_context_t *ctxt,
+	const stress_shm_backing_type_t type,
+	stress_shm_backing_result_t *result)
+{
+	stress_args_t *args = ctxt->args;
+	const size_t sz = ctxt->sz;
+	struct rusage usage_begin, usage_end;
+	uint8_t *ptr, *buf = ctxt->buf;
+	uint64_t sum = 0;
+	size_t off;
+	double t;
+	int fd;
+
+	fd = stress_shm_backing_open(ctxt, type);
+	if (fd == -2)
+		return -1;
+
+	(void)getrusage(RUSAGE_SELF, &usage_begin);
+
+	/* Allocate backing memory */
+	if (fd >= 0) {
+		t = stress_time_now();
+		if (shim_fallocate(fd, 0, 0, (off_t)sz) < 0) {
+			if (ftruncate(fd, (off_t)sz) < 0) {
+				pr_dbg("%s: cannot size %s object, errno=%d (%s)\n",
+					args->name, stress_shm_backing_names[type - 1],
+					errno, strerror(errno));
+				(void)close(fd);
+				return -1;
+			}
+		}
+		result->alloc_duration += stress_time_now() - t;
+		ptr = NULL;
+	} else {
+		ptr = (uint8_t *)mmap(NULL, sz, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED) {
+			pr_dbg("%s: cannot mmap %zu bytes of anonymous shared memory, errno=%d (%s)\n",
+				args->name, sz, errno, strerror(errno));
+			return -1;
+		}
+#if defined(MADV_HUGEPAGE)
+		if (ctxt->huge)
+			(void)madvise((void *)ptr, sz, MADV_HUGEPAGE);
+#endif
+		t = stress_time_now();
+#if defined(MADV_POPULATE_WRITE)
+		if (madvise((void *)ptr, sz, MADV_POPULATE_WRITE) < 0)
+			(void)shim_memset(ptr, 0, sz);
+#else
+		(void)shim_memset(ptr, 0, sz);
+#endif
+		result->alloc_duration += stress_time_now() - t;
+	}
+
+	/* Write */
+	t = stress_time_now();
+	for (off = 0; off < sz; off += SHM_BACKING_CHUNK) {
+		const size_t n = ((sz - off) < SHM_BACKING_CHUNK) ? sz - off : SHM_BACKING_CHUNK;
+
+		if (fd >= 0) {
+			if (UNLIKELY(pwrite(fd, buf, n, (off_t)off) < 0))
+				break;
+		} else {
+			(void)shim_memcpy(ptr + off, buf, n);
+		}
+		result->write_bytes += (double)n;
+	}
+	result->write_duration += stress_time_now() - t;
+
+	/* Read */
+	t = stress_time_now();
+	for (off = 0; off < sz; off += SHM_BACKING_CHUNK) {
+		const size_t n = ((sz - off) < SHM_BACKING_CHUNK) ? sz - off : SHM_BACKING_CHUNK;
+
+		if (fd >= 0) {
+			if (UNLIKELY(pread(fd, buf, n, (off_t)off) < 0))
+				break;
+		} else {
+			(void)shim_memcpy(buf, ptr + off, n);
+		}
+		result->read_bytes += (double)n;
+	}
+	result->read_duration += stress_time_now() - t;
+
+	/* Access via a mapping, fd backed objects get mapped afresh */
+	if (fd >= 0) {
+		ptr = (uint8_t *)mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (ptr == MAP_FAILED) {
+			pr_dbg("%s: cannot mmap %s object, errno=%d (%s)\n",
+				args->name, stress_shm_backing_names[type - 1],
+				errno, strerror(errno));
+			(void)close(fd);
+			return -1;
+		}
+#if defined(MADV_HUGEPAGE)
+		if (ctxt->huge && !ctxt->tmpfs_mounted)
+			(void)madvise((void *)ptr, sz, MADV_HUGEPAGE);
+#endif
+	}
+	t = stress_time_now();
+	(void)shim_memset(ptr, stress_mwc8(), sz);
+	for (off = 0; off < sz; off += sizeof(uint64_t))
+		sum += *(volatile uint64_t *)(ptr + off);
+	result->mmap_duration += stress_time_now() - t;
+	result->mmap_bytes += 2.0 * (double)sz;
+	stress_uint64_put(sum);
+
+	(void)getrusage(RUSAGE_SELF, &usage_end);
+	result->faults += (uint64_t)((usage_end.ru_minflt - usage_begin.ru_minflt) +
+				     (usage_end.ru_majflt - usage_begin.ru_majflt));
+	result->allocated += stress_shm_backing_allocated(ctxt, fd, ptr);
+	result->requested += (double)sz;
+
+	/* Release the backing memory */
+	t = stress_time_now();
+	if (fd >= 0)
+		VOID_RET(int, ftruncate(fd, 0));
+	else
+		VOID_RET(int, madvise((void *)ptr, sz, MADV_REMOVE));
+	result->truncate_duration += stress_time_now() - t;
+	result->count++;
+
+	(void)munmap((void *)ptr, sz);
+	if (fd >= 0)
+		(void)close(fd);
+
+	return 0;
+}
+
+/*
+ *  stress_shm_backing_metrics()
+ *	report throughput, fault rate and overhead per backing
+ */
+static void stress_shm_backing_metrics(
+	stress_args_t *args,
+	const stress_shm_backing_result_t *results)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < SHM_BACKING_TYPES; i++) {
+		const stress_shm_backing_result_t *r = &results[i];
+		const char *name = stress_shm_backing_names[i];
+		char msg[64];
+
+		if (r->count == 0)
+			continue;
+
+		(void)snprintf(msg, sizeof(msg), "MB/sec write (%s)", name);
+		stress_metrics_set(args, idx++, msg, (r->write_duration > 0.0) ?
+			r->write_bytes / r->write_duration / (double)MB : 0.0,
+			STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "MB/sec read (%s)", name);
+		stress_metrics_set(args, idx++, msg, (r->read_duration > 0.0) ?
+			r->read_bytes / r->read_duration / (double)MB : 0.0,
+			STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "MB/sec mmap write+read (%s)", name);
+		stress_metrics_set(args, idx++, msg, (r->mmap_duration > 0.0) ?
+			r->mmap_bytes / r->mmap_duration / (double)MB : 0.0,
+			STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "page faults per MB (%s)", name);
+		stress_metrics_set(args, idx++, msg,
+			(double)r->faults / (r->requested / (double)MB),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec per MB allocate (%s)", name);
+		stress_metrics_set(args, idx++, msg,
+			r->alloc_duration * STRESS_DBL_MICROSECOND / (r->requested / (double)MB),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec per MB truncate (%s)", name);
+		stress_metrics_set(args, idx++, msg,
+			r->truncate_duration * STRESS_DBL_MICROSECOND / (r->requested / (double)MB),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%% memory allocated vs requested (%s)", name);
+		stress_metrics_set(args, idx++, msg,
+			100.0 * r->allocated / r->requested, STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_shm_backing
+ *	compare tmpfs, memfd and anonymous shared memory backings
+ */
+static int stress_shm_backing(stress_args_t *args)
+{
+	stress_shm_backing_context_t ctxt;
+	stress_shm_backing_result_t results[SHM_BACKING_TYPES];
+	stress_shm_backing_type_t types[SHM_BACKING_TYPES];
+	size_t shm_backing_method = SHM_BACKING_ALL;
+	size_t i, n_types = 0;
+	int rc = EXIT_SUCCESS;
+	bool succeeded = false;
+
+	(void)shim_memset(&ctxt, 0, sizeof(ctxt));
+	(void)shim_memset(results, 0, sizeof(results));
+	ctxt.args = args;
+	ctxt.sz = DEFAULT_SHM_BACKING_BYTES;
+
+	if (!stress_get_setting("shm-backing-bytes", &ctxt.sz)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			ctxt.sz = 512 * MB;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			ctxt.sz = MIN_SHM_BACKING_BYTES;
+	}
+	(void)stress_get_setting("shm-backing-huge", &ctxt.huge);
+	(void)stress_get_setting("shm-backing-method", &shm_backing_method);
+	ctxt.sz &= ~(args->page_size - 1);
+
+	ctxt.buf = (uint8_t *)mmap(NULL, SHM_BACKING_CHUNK, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ctxt.buf == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu byte buffer%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, (size_t)SHM_BACKING_CHUNK,
+			stress_get_memfree_str(), errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	stress_uint8rnd4(ctxt.buf, SHM_BACKING_CHUNK);
+
+	if ((shm_backing_method == SHM_BACKING_ALL) || (shm_backing_method == SHM_BACKING_TMPFS)) {
+		stress_shm_backing_tmpfs_setup(&ctxt);
+		if (*ctxt.tmpfs_path)
+			types[n_types++] = SHM_BACKING_TMPFS;
+	}
+	if ((shm_backing_method == SHM_BACKING_ALL) || (shm_backing_method == SHM_BACKING_MEMFD))
+		types[n_types++] = SHM_BACKING_MEMFD;
+	if ((shm_backing_method == SHM_BACKING_ALL) || (shm_backing_method == SHM_BACKING_ANON))
+		types[n_types++] = SHM_BACKING_ANON;
+
+	if (n_types == 0) {
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: no shared memory backing available, skipping stressor\n",
+				args->name);
+		rc = EXIT_NO_RESOURCE;
+		goto tidy;
+	}
+	if (stress_instance_zero(args) && ctxt.huge)
+		pr_dbg("%s: tmpfs backing %s\n", args->name, ctxt.tmpfs_mounted ?
+			"using huge=within_size mount" : "using MADV_HUGEPAGE advice");
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		const stress_shm_backing_type_t type = types[i];
+
+		if (stress_shm_backing_workload(&ctxt, type, &results[type - 1]) < 0) {
+			/* Out of memory is not a failure, just try the next backing */
+			(void)shim_usleep(10000);
+		} else {
+			succeeded = true;
+			stress_bogo_inc(args);
+		}
+		i++;
+		if (i >= n_types) {
+			/* give up if no backing ever had enough memory */
+			if (!succeeded)
+				break;
+			i = 0;
+		}
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	if (!succeeded) {
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: cannot allocate %zu bytes of shared memory with "
+				"any backing%s, skipping stressor\n", args->name, ctxt.sz,
+				stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto tidy;
+	}
+	stress_shm_backing_metrics(args, results);
+tidy:
+	stress_shm_backing_tmpfs_cleanup(&ctxt);
+	(void)munmap((void *)ctxt.buf, SHM_BACKING_CHUNK);
+
+	return rc;
+}
+
+const stressor_info_t stress_shm_backing_info = {
+	.stressor = stress_shm_backing,
+	.classifier = CLASS_MEMORY | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_shm_backing_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_MEMORY | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without memfd_create(), statfs() or madvise() MADV_REMOVE support"
+};
+#endif
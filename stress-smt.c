@@ -0,0 +1,772 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-affinity.h"
+#include "core-builtin.h"
+#include "core-cpu-cache.h"
+#include "core-pthread.h"
+
+#define SMT_SLICE_NS		(200000000ULL)	/* 0.2 seconds per victim and aggressor */
+#define SMT_SEED		(0x2545f4914f6cdd1dULL)
+#define SMT_INT_LOOPS		(8192)
+#define SMT_FP_LOOPS		(4096)
+#define SMT_SIMD_LOOPS		(4096)
+#define SMT_MEMORY_STEPS	(256)
+#define SMT_BRANCH_LOOPS	(8192)
+#define SMT_MEMORY_MIN		(8 * MB)
+#define SMT_MEMORY_MAX		(64 * MB)
+
+#define MSR_IA32_TSC		(0x00000010)
+#define MSR_IA32_MPERF		(0x000000e7)
+#define MSR_IA32_APERF		(0x000000e8)
+
+static const stress_help_t help[] = {
+	{ NULL,	"smt N",		"start N workers measuring SMT sibling interference" },
+	{ NULL,	"smt-aggressor K",	"select sibling kernel: all, none, int, fp, simd, memory, branch" },
+	{ NULL,	"smt-ops N",		"stop after N victim kernel iterations" },
+	{ NULL,	"smt-victim K",		"select victim kernel: all, int, fp, simd, memory, branch" },
+	{ NULL,	NULL,			NULL }
+};
+
+#define SMT_KERNEL_NONE		(0)
+#define SMT_KERNEL_INT		(1)
+#define SMT_KERNEL_FP		(2)
+#define SMT_KERNEL_SIMD		(3)
+#define SMT_KERNEL_MEMORY	(4)
+#define SMT_KERNEL_BRANCH	(5)
+#define SMT_KERNEL_MAX		(6)
+
+/* victim option index is the kernel index, 0 is all */
+static const char * const stress_smt_victims[] = {
+	"all",
+	"int",
+	"fp",
+	"simd",
+	"memory",
+	"branch",
+};
+
+/* aggressor option index is the kernel index + 1, 0 is all */
+static const char * const stress_smt_aggressors[] = {
+	"all",
+	"none",
+	"int",
+	"fp",
+	"simd",
+	"memory",
+	"branch",
+};
+
+static const char *stress_smt_victim(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_smt_victims)) ? stress_smt_victims[i] : NULL;
+}
+
+static const char *stress_smt_aggressor(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_smt_aggressors)) ? stress_smt_aggressors[i] : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_smt_aggressor, "smt-aggressor", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_smt_aggressor },
+	{ OPT_smt_victim,    "smt-victim",    TYPE_ID_SIZE_T_METHOD, 0, 0, stress_smt_victim },
+	END_OPT,
+};
+
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_SCHED_GETAFFINITY) &&		\
+    defined(HAVE_SCHED_SETAFFINITY) &&		\
+    defined(HAVE_CLOCK_GETTIME) &&		\
+    defined(CLOCK_MONOTONIC) &&			\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+
+#if defined(HAVE_VECMATH)
+typedef double stress_smt_v4df_t __attribute__ ((vector_size(sizeof(double) * 4)));
+#endif
+
+/* one pointer chase node per cache line */
+typedef struct {
+	uint64_t next;
+	uint64_t pad[7];
+} stress_smt_node_t;
+
+/* APERF, MPERF and TSC counts of a CPU */
+typedef struct {
+	uint64_t aperf;
+	uint64_t mperf;
+	uint64_t tsc;
+} stress_smt_perf_t;
+
+struct stress_smt_context;
+
+typedef struct {
+	struct stress_smt_context *ctx;
+	pthread_t pthread;
+	uint32_t cpu;			/* CPU the thread is pinned to */
+	size_t kernel;			/* kernel to run */
+	uint64_t seed;			/* kernel input, read volatile */
+	stress_smt_node_t *nodes;	/* memory kernel pointer chase */
+	uint64_t n_nodes;
+	uint64_t pos;			/* memory kernel position */
+	uint64_t ops;			/* kernel iterations */
+	uint64_t duration;		/* victim run time (ns) */
+	stress_smt_perf_t perf;		/* victim APERF, MPERF and TSC deltas */
+	bool perf_ok;			/* perf deltas are valid */
+	bool failed;			/* kernel result was wrong */
+} stress_smt_thread_t;
+
+typedef struct stress_smt_context {
+	bool ready;			/* aggressor is running */
+	bool stop;			/* victim finished, stop aggressor */
+	bool msr;			/* APERF/MPERF can be read */
+	uint64_t reference[SMT_KERNEL_MAX]; /* expected kernel results */
+	stress_smt_thread_t victim;
+	stress_smt_thread_t aggressor;
+} stress_smt_context_t;
+
+/*
+ *  accumulated results for a victim and aggressor
+ */
+typedef struct {
+	size_t victim;
+	size_t aggressor;
+	bool skipped;
+	uint64_t ops;
+	uint64_t duration;		/* ns */
+	double ghz_total;		/* sum of effective GHz per slice */
+	uint32_t ghz_count;
+} stress_smt_result_t;
+
+typedef uint64_t (*stress_smt_kernel_func_t)(stress_smt_thread_t *thread);
+
+static inline uint64_t stress_smt_now(void)
+{
+	struct timespec ts;
+
+	if (UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) < 0))
+		return (uint64_t)(stress_time_now() * STRESS_DBL_NANOSECOND);
+	return ((uint64_t)ts.tv_sec * STRESS_NANOSECOND) + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t stress_smt_seed(const stress_smt_thread_t *thread)
+{
+	return *(const volatile uint64_t *)&thread->seed;
+}
+
+static inline uint64_t stress_smt_double_bits(const double d)
+{
+	uint64_t bits;
+
+	(void)shim_memcpy((void *)&bits, (const void *)&d, sizeof(bits));
+	return bits;
+}
+
+/*
+ *  stress_smt_int()
+ *	integer multiply, shift and xor chains, cf. the stress-cpu
+ *	int64 and lfsr32 methods
+ */
+static uint64_t OPTIMIZE3 stress_smt_int(stress_smt_thread_t *thread)
+{
+	register uint64_t a = stress_smt_seed(thread);
+	register uint64_t b = ~a;
+	register uint64_t c = 0;
+	register int i;
+
+	for (i = 0; i < SMT_INT_LOOPS; i++) {
+		a = (a * 6364136223846793005ULL) + 1442695040888963407ULL;
+		b ^= b << 13;
+		b ^= b >> 7;
+		b ^= b << 17;
+		c += (a ^ b) + (c >> 5);
+	}
+	return a ^ b ^ c;
+}
+
+/*
+ *  stress_smt_fp()
+ *	scalar double precision multiply, add and divide chains, cf.
+ *	the stress-cpu euler and nsqrt methods
+ */
+static uint64_t OPTIMIZE3 stress_smt_fp(stress_smt_thread_t *thread)
+{
+	const double seed = (double)(stress_smt_seed(thread) & 0xffff) / 65536.0;
+	register double x0 = seed, x1 = seed + 0.25, x2 = seed + 0.5, x3 = seed + 0.75;
+	register int i;
+
+	for (i = 0; i < SMT_FP_LOOPS; i++) {
+		x0 = (x0 * 0.9999999) + 0.0000001;
+		x1 = (x1 * 1.0000001) - (x0 * 0.0000001);
+		x2 = (x2 + x1) / (1.0 + (x2 * 0.000001));
+		x3 = (x3 * x0) + (x1 * 0.5);
+	}
+	return stress_smt_double_bits(x0 + x1 + x2 + x3);
+}
+
+/*
+ *  stress_smt_simd()
+ *	vector double precision multiply and add chains, cf. the
+ *	stress-cpu matrix_prod method
+ */
+static uint64_t OPTIMIZE3 stress_smt_simd(stress_smt_thread_t *thread)
+{
+	const double seed = (double)(stress_smt_seed(thread) & 0xffff) / 65536.0;
+	register int i;
+#if defined(HAVE_VECMATH)
+	stress_smt_v4df_t v0 = { seed, seed + 0.1, seed + 0.2, seed + 0.3 };
+	stress_smt_v4df_t v1 = v0 + 0.5, v2 = v0 + 1.0, v3 = v0 + 1.5;
+	const stress_smt_v4df_t m = { 0.9999999, 0.9999998, 0.9999997, 0.9999996 };
+	const stress_smt_v4df_t a = { 0.0000001, 0.0000002, 0.0000003, 0.0000004 };
+
+	for (i = 0; i < SMT_SIMD_LOOPS; i++) {
+		v0 = (v0 * m) + a;
+		v1 = (v1 * m) + v0 * a;
+		v2 = (v2 * m) + v1 * a;
+		v3 = (v3 * m) + v2 * a;
+	}
+	v0 = v0 + v1 + v2 + v3;
+	return stress_smt_double_bits(v0[0] + v0[1] + v0[2] + v0[3]);
+#else
+	double v[16];
+	int j;
+
+	for (j = 0; j < 16; j++)
+		v[j] = seed + (0.1 * j);
+	for (i = 0; i < SMT_SIMD_LOOPS; i++) {
+		for (j = 0; j < 16; j++)
+			v[j] = (v[j] * 0.9999999) + 0.0000001;
+	}
+	for (j = 1; j < 16; j++)
+		v[0] += v[j];
+	return stress_smt_double_bits(v[0]);
+#endif
+}
+
+/*
+ *  stress_smt_memory()
+ *	dependent loads chasing a random cycle through a buffer larger
+ *	than the last level cache
+ */
+static uint64_t OPTIMIZE3 stress_smt_memory(stress_smt_thread_t *thread)
+{
+	const stress_smt_node_t *nodes = thread->nodes;
+	register uint64_t pos = thread->pos;
+	register int i;
+
+	for (i = 0; i < SMT_MEMORY_STEPS; i++)
+		pos = nodes[pos].next;
+	thread->pos = pos;
+	return pos;
+}
+
+/*
+ *  stress_smt_branch()
+ *	unpredictable multiway branches driven by a lfsr, cf. the
+ *	stress-cpu collatz and lfsr32 methods
+ */
+static uint64_t OPTIMIZE3 stress_smt_branch(stress_smt_thread_t *thread)
+{
+	register uint32_t lfsr = (uint32_t)stress_smt_seed(thread) | 1;
+	register uint64_t sum = 0;
+	register int i;
+
+	for (i = 0; i < SMT_BRANCH_LOOPS; i++) {
+		lfsr = (lfsr >> 1) ^ (uint32_t)(-(lfsr & 1U) & 0xd0000001U);
+		switch (lfsr & 3) {
+		case 0:
+			sum += (uint64_t)i;
+			break;
+		case 1:
+			sum ^= lfsr;
+			break;
+		case 2:
+			sum = (sum << 1) | (sum >> 63);
+			break;
+		default:
+			sum -= (uint64_t)lfsr >> 3;
+			break;
+		}
+		if (lfsr & 0x100)
+			sum++;
+	}
+	return sum;
+}
+
+static const stress_smt_kernel_func_t stress_smt_kernels[SMT_KERNEL_MAX] = {
+	NULL,
+	stress_smt_int,
+	stress_smt_fp,
+	stress_smt_simd,
+	stress_smt_memory,
+	stress_smt_branch,
+};
+
+/*
+ *  stress_smt_kernel_ok()
+ *	check a kernel result, the memory kernel can only check the
+ *	chase stayed in the buffer
+ */
+static inline bool stress_smt_kernel_ok(
+	const stress_smt_context_t *ctx,
+	const stress_smt_thread_t *thread,
+	const uint64_t result)
+{
+	if (thread->kernel == SMT_KERNEL_MEMORY)
+		return result < thread->n_nodes;
+	return result == ctx->reference[thread->kernel];
+}
+
+/*
+ *  stress_smt_perf_read()
+ *	read APERF, MPERF and TSC of a CPU
+ */
+static bool stress_smt_perf_read(const uint32_t cpu, stress_smt_perf_t *perf)
+{
+	return (stress_x86_readmsr64((int)cpu, MSR_IA32_APERF, &perf->aperf) == 0) &&
+	       (stress_x86_readmsr64((int)cpu, MSR_IA32_MPERF, &perf->mperf) == 0) &&
+	       (stress_x86_readmsr64((int)cpu, MSR_IA32_TSC, &perf->tsc) == 0);
+}
+
+static void stress_smt_pin(const uint32_t cpu)
+{
+	cpu_set_t mask;
+
+	CPU_ZERO(&mask);
+	CPU_SET((int)cpu, &mask);
+	VOID_RET(int, sched_setaffinity(0, sizeof(mask), &mask));
+}
+
+static void *stress_smt_aggressor_thread(void *arg)
+{
+	stress_smt_thread_t *thread = (stress_smt_thread_t *)arg;
+	stress_smt_context_t *ctx = thread->ctx;
+	const stress_smt_kernel_func_t func = stress_smt_kernels[thread->kernel];
+
+	stress_smt_pin(thread->cpu);
+	__atomic_store_n(&ctx->ready, true, __ATOMIC_RELEASE);
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)) {
+		if (UNLIKELY(!stress_smt_kernel_ok(ctx, thread, func(thread))))
+			thread->failed = true;
+		thread->ops++;
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_smt_victim_thread()
+ *	run the victim kernel for a time slice once the aggressor is
+ *	running, measuring the effective frequency of the victim CPU
+ */
+static void *stress_smt_victim_thread(void *arg)
+{
+	stress_smt_thread_t *thread = (stress_smt_thread_t *)arg;
+	stress_smt_context_t *ctx = thread->ctx;
+	const stress_smt_kernel_func_t func = stress_smt_kernels[thread->kernel];
+	stress_smt_perf_t perf1, perf2;
+	uint64_t t1, t2, end;
+
+	stress_smt_pin(thread->cpu);
+	while (!__atomic_load_n(&ctx->ready, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+
+	thread->perf_ok = ctx->msr && stress_smt_perf_read(thread->cpu, &perf1);
+	t1 = stress_smt_now();
+	end = t1 + SMT_SLICE_NS;
+	do {
+		if (UNLIKELY(!stress_smt_kernel_ok(ctx, thread, func(thread))))
+			thread->failed = true;
+		thread->ops++;
+		t2 = stress_smt_now();
+	} while (t2 < end);
+	if (thread->perf_ok)
+		thread->perf_ok = stress_smt_perf_read(thread->cpu, &perf2);
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELEASE);
+
+	thread->duration = t2 - t1;
+	if (thread->perf_ok) {
+		thread->perf.aperf = perf2.aperf - perf1.aperf;
+		thread->perf.mperf = perf2.mperf - perf1.mperf;
+		thread->perf.tsc = perf2.tsc - perf1.tsc;
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_smt_cpufreq_ghz()
+ *	current cpufreq frequency of a CPU in GHz, 0.0 if unknown
+ */
+static double stress_smt_cpufreq_ghz(const uint32_t cpu)
+{
+	char path[PATH_MAX], buf[32];
+	double khz;
+
+	(void)snprintf(path, sizeof(path),
+		"/sys/devices/system/cpu/cpu%" PRIu32 "/cpufreq/scaling_cur_freq", cpu);
+	if (stress_system_read(path, buf, sizeof(buf)) <= 0)
+		return 0.0;
+	if (sscanf(buf, "%lf", &khz) != 1)
+		return 0.0;
+	return khz / 1000000.0;
+}
+
+/*
+ *  stress_smt_run()
+ *	run a victim kernel against an aggressor kernel for a time slice
+ */
+static int stress_smt_run(
+	stress_args_t *args,
+	stress_smt_context_t *ctx,
+	stress_smt_result_t *result)
+{
+	stress_smt_thread_t *victim = &ctx->victim;
+	stress_smt_thread_t *aggressor = &ctx->aggressor;
+	const bool has_aggressor = (result->aggressor != SMT_KERNEL_NONE);
+	double ghz = 0.0;
+
+	ctx->stop = false;
+	ctx->ready = !has_aggressor;
+	victim->kernel = result->victim;
+	victim->ops = 0;
+	victim->failed = false;
+	aggressor->kernel = result->aggressor;
+	aggressor->ops = 0;
+	aggressor->failed = false;
+
+	if (has_aggressor &&
+	    (pthread_create(&aggressor->pthread, NULL, stress_smt_aggressor_thread, (void *)aggressor) != 0)) {
+		pr_dbg("%s: cannot create aggressor thread, skipping %s victim with %s aggressor\n",
+			args->name, stress_smt_victims[result->victim],
+			stress_smt_aggressors[result->aggressor + 1]);
+		result->skipped = true;
+		return 0;
+	}
+	if (pthread_create(&victim->pthread, NULL, stress_smt_victim_thread, (void *)victim) != 0) {
+		pr_dbg("%s: cannot create victim thread, skipping %s victim with %s aggressor\n",
+			args->name, stress_smt_victims[result->victim],
+			stress_smt_aggressors[result->aggressor + 1]);
+		result->skipped = true;
+		__atomic_store_n(&ctx->stop, true, __ATOMIC_RELEASE);
+		if (has_aggressor)
+			VOID_RET(int, pthread_join(aggressor->pthread, NULL));
+		return 0;
+	}
+	VOID_RET(int, pthread_join(victim->pthread, NULL));
+	if (has_aggressor)
+		VOID_RET(int, pthread_join(aggressor->pthread, NULL));
+
+	if (victim->failed || aggressor->failed) {
+		pr_fail("%s: %s kernel returned an incorrect result while running %s victim "
+			"with %s aggressor\n", args->name,
+			victim->failed ? stress_smt_victims[result->victim] :
+					 stress_smt_aggressors[result->aggressor + 1],
+			stress_smt_victims[result->victim],
+			stress_smt_aggressors[result->aggressor + 1]);
+		return -1;
+	}
+
+	/* effective frequency is the TSC rate scaled by APERF/MPERF */
+	if (victim->perf_ok && (victim->perf.mperf > 0) && (victim->duration > 0)) {
+		const double tsc_ghz = (double)victim->perf.tsc / (double)victim->duration;
+
+		ghz = tsc_ghz * (double)victim->perf.aperf / (double)victim->perf.mperf;
+	} else if (!ctx->msr) {
+		ghz = stress_smt_cpufreq_ghz(victim->cpu);
+	}
+	if (ghz > 0.0) {
+		result->ghz_total += ghz;
+		result->ghz_count++;
+	}
+	result->ops += victim->ops;
+	result->duration += victim->duration;
+	stress_bogo_add(args, victim->ops);
+	return 0;
+}
+
+/*
+ *  stress_smt_metrics()
+ *	victim kernel rate when running alone, the victim rate with
+ *	each aggressor relative to running alone and the effective
+ *	victim CPU frequency
+ */
+static void stress_smt_metrics(
+	stress_args_t *args,
+	const stress_smt_result_t *results,
+	const size_t n_results)
+{
+	size_t i, j, idx = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_smt_result_t *r = &results[i];
+		const char *victim = stress_smt_victims[r->victim];
+		const char *aggressor = stress_smt_aggressors[r->aggressor + 1];
+		const double rate = (r->duration > 0) ? (double)r->ops * STRESS_DBL_NANOSECOND / (double)r->duration : 0.0;
+		const double ghz = (r->ghz_count > 0) ? r->ghz_total / (double)r->ghz_count : 0.0;
+		double alone = 0.0, relative = 0.0;
+		char msg[64];
+
+		if (r->skipped || (r->duration == 0))
+			continue;
+		for (j = 0; j < n_results; j++) {
+			const stress_smt_result_t *a = &results[j];
+
+			if ((a->victim == r->victim) && (a->aggressor == SMT_KERNEL_NONE) && (a->duration > 0))
+				alone = (double)a->ops * STRESS_DBL_NANOSECOND / (double)a->duration;
+		}
+		if (alone > 0.0)
+			relative = rate / alone;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-6s victim with %-6s aggressor %12.1f ops/sec, %7.2f%% slowdown, %5.2f GHz\n",
+				args->name, victim, aggressor, rate, 100.0 * (1.0 - relative), ghz);
+
+		if (r->aggressor == SMT_KERNEL_NONE) {
+			(void)snprintf(msg, sizeof(msg), "%s victim alone kernel ops/sec", victim);
+			stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+		} else if (relative > 0.0) {
+			(void)snprintf(msg, sizeof(msg), "%s victim vs %s aggressor relative rate", victim, aggressor);
+			stress_metrics_set(args, idx++, msg, relative, STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+		if (ghz > 0.0) {
+			(void)snprintf(msg, sizeof(msg), "%s victim vs %s aggressor GHz", victim, aggressor);
+			stress_metrics_set(args, idx++, msg, ghz, STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_smt_cpus()
+ *	pick a pair of SMT siblings for the victim and aggressor, fall
+ *	back to the closest pair of CPUs or a single CPU
+ */
+static void stress_smt_cpus(
+	stress_args_t *args,
+	uint32_t *victim_cpu,
+	uint32_t *aggressor_cpu)
+{
+	uint32_t *cpus = NULL, n_cpus, i, j, n_pairs = 0, pair;
+	stress_cpu_topology_t *topology;
+	stress_cpu_topology_rel_t best_rel = STRESS_CPU_REL_MAX;
+
+	*victim_cpu = 0;
+	*aggressor_cpu = 0;
+	n_cpus = stress_get_usable_cpus(&cpus, true);
+	if (n_cpus == 0) {
+		*victim_cpu = stress_get_cpu();
+		*aggressor_cpu = *victim_cpu;
+		stress_free_usable_cpus(&cpus);
+		return;
+	}
+	*victim_cpu = cpus[0];
+	*aggressor_cpu = cpus[0];
+	topology = (stress_cpu_topology_t *)calloc(n_cpus, sizeof(*topology));
+	if (!topology) {
+		stress_free_usable_cpus(&cpus);
+		return;
+	}
+	for (i = 0; i < n_cpus; i++)
+		stress_cpu_topology_get(cpus[i], &topology[i]);
+
+	/* count the SMT sibling pairs, each instance uses a different pair */
+	for (i = 0; i < n_cpus; i++)
+		for (j = i + 1; j < n_cpus; j++)
+			if (stress_cpu_topology_rel(&topology[i], &topology[j]) == STRESS_CPU_REL_SMT)
+				n_pairs++;
+	if (n_pairs > 0) {
+		pair = args->instance % n_pairs;
+		for (i = 0; i < n_cpus; i++) {
+			for (j = i + 1; j < n_cpus; j++) {
+				if (stress_cpu_topology_rel(&topology[i], &topology[j]) != STRESS_CPU_REL_SMT)
+					continue;
+				if (pair-- == 0) {
+					*victim_cpu = cpus[i];
+					*aggressor_cpu = cpus[j];
+					best_rel = STRESS_CPU_REL_SMT;
+				}
+			}
+		}
+	} else {
+		const uint32_t v = args->instance % n_cpus;
+
+		*victim_cpu = cpus[v];
+		for (j = 0; j < n_cpus; j++) {
+			const stress_cpu_topology_rel_t rel = stress_cpu_topology_rel(&topology[v], &topology[j]);
+
+			if ((j != v) && (rel < best_rel)) {
+				best_rel = rel;
+				*aggressor_cpu = cpus[j];
+			}
+		}
+		if (stress_instance_zero(args)) {
+			if (best_rel == STRESS_CPU_REL_MAX)
+				pr_inf("%s: no SMT siblings and only 1 usable CPU, victim and aggressor "
+					"will time share CPU %" PRIu32 "\n", args->name, *victim_cpu);
+			else
+				pr_inf("%s: no SMT siblings, using CPUs %" PRIu32 " and %" PRIu32 " (%s)\n",
+					args->name, *victim_cpu, *aggressor_cpu,
+					stress_cpu_topology_rel_name(best_rel));
+		}
+	}
+	free(topology);
+	stress_free_usable_cpus(&cpus);
+}
+
+/*
+ *  stress_smt_chain()
+ *	link the nodes into a single random cycle (Sattolo's algorithm)
+ */
+static void stress_smt_chain(stress_smt_node_t *nodes, const uint64_t n_nodes)
+{
+	uint64_t i;
+
+	for (i = 0; i < n_nodes; i++)
+		nodes[i].next = i;
+	for (i = n_nodes - 1; i > 0; i--) {
+		const uint64_t j = stress_mwc64modn(i);
+		const uint64_t tmp = nodes[i].next;
+
+		nodes[i].next = nodes[j].next;
+		nodes[j].next = tmp;
+	}
+}
+
+/*
+ *  stress_smt()
+ *	run victim kernels on one SMT sibling while aggressor kernels
+ *	run on the other to measure the slowdown and effective frequency
+ */
+static int stress_smt(stress_args_t *args)
+{
+	size_t smt_victim = 0, smt_aggressor = 0, victim, aggressor;
+	size_t llc_size = 0, cache_line_size = 0, buf_size, n_results = 0, i;
+	stress_smt_result_t results[SMT_KERNEL_MAX * SMT_KERNEL_MAX];
+	stress_smt_node_t *buf;
+	stress_smt_context_t *ctx;
+	stress_smt_perf_t perf;
+	uint64_t n_nodes;
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("smt-victim", &smt_victim);
+	(void)stress_get_setting("smt-aggressor", &smt_aggressor);
+
+	ctx = (stress_smt_context_t *)calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		pr_inf_skip("%s: cannot allocate context%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+
+	/* a pointer chase buffer for each thread, twice the last level cache */
+	stress_cpu_cache_get_llc_size(&llc_size, &cache_line_size);
+	buf_size = STRESS_MINIMUM(STRESS_MAXIMUM(llc_size * 2, SMT_MEMORY_MIN), SMT_MEMORY_MAX);
+	n_nodes = buf_size / sizeof(*buf);
+	buf = (stress_smt_node_t *)stress_mmap_populate(NULL, buf_size * 2,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for pointer chasing%s, skipping stressor\n",
+			args->name, buf_size * 2, stress_get_memfree_str());
+		free(ctx);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(buf, buf_size * 2, "smt-memory");
+	stress_smt_chain(buf, n_nodes);
+	stress_smt_chain(buf + n_nodes, n_nodes);
+
+	stress_smt_cpus(args, &ctx->victim.cpu, &ctx->aggressor.cpu);
+	ctx->victim.ctx = ctx;
+	ctx->victim.seed = SMT_SEED;
+	ctx->victim.nodes = buf;
+	ctx->victim.n_nodes = n_nodes;
+	ctx->aggressor.ctx = ctx;
+	ctx->aggressor.seed = SMT_SEED;
+	ctx->aggressor.nodes = buf + n_nodes;
+	ctx->aggressor.n_nodes = n_nodes;
+	for (i = SMT_KERNEL_INT; i < SMT_KERNEL_MAX; i++)
+		ctx->reference[i] = stress_smt_kernels[i](&ctx->victim);
+	ctx->victim.pos = 0;
+
+	ctx->msr = stress_smt_perf_read(ctx->victim.cpu, &perf);
+	if (stress_instance_zero(args))
+		pr_dbg("%s: victim on CPU %" PRIu32 ", aggressor on CPU %" PRIu32 ", %zu KB pointer "
+			"chase buffers, %s\n", args->name, ctx->victim.cpu, ctx->aggressor.cpu,
+			(size_t)(buf_size / KB), ctx->msr ? "effective GHz from APERF/MPERF" :
+			"no APERF/MPERF (msr module not loaded?), GHz from cpufreq");
+
+	(void)shim_memset(results, 0, sizeof(results));
+	for (victim = SMT_KERNEL_INT; victim < SMT_KERNEL_MAX; victim++) {
+		if ((smt_victim != 0) && (smt_victim != victim))
+			continue;
+		for (aggressor = SMT_KERNEL_NONE; aggressor < SMT_KERNEL_MAX; aggressor++) {
+			/* always measure the victim alone for the slowdown */
+			if ((smt_aggressor != 0) && (smt_aggressor != aggressor + 1) &&
+			    (aggressor != SMT_KERNEL_NONE))
+				continue;
+			results[n_results].victim = victim;
+			results[n_results].aggressor = aggressor;
+			n_results++;
+		}
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		bool runnable = false;
+		size_t j;
+
+		if (!results[i].skipped &&
+		    (stress_smt_run(args, ctx, &results[i]) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		for (j = 0; j < n_results; j++)
+			runnable |= !results[j].skipped;
+		if (!runnable)
+			break;
+		i = (i + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_smt_metrics(args, results, n_results);
+
+	(void)munmap((void *)buf, buf_size * 2);
+	free(ctx);
+	return rc;
+}
+
+const stressor_info_t stress_smt_info = {
+	.stressor = stress_smt,
+	.classifier = CLASS_CPU | CLASS_CPU_CACHE,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_smt_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_CPU | CLASS_CPU_CACHE,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread or sched_setaffinity support"
+};
+#endif
@@ -27,6 +27,30 @@
 
 #include <sys/ioctl.h>
 
+#if defined(HAVE_POLL_H)
+#include <poll.h>
+#endif
+
+#if defined(HAVE_LINUX_ERRQUEUE_H)
+#include <linux/errqueue.h>
+#endif
+
+#if defined(HAVE_LINUX_NETLINK_H)
+#include <linux/netlink.h>
+#endif
+
+#if defined(HAVE_LINUX_RTNETLINK_H)
+#include <linux/rtnetlink.h>
+#endif
+
+#if defined(HAVE_LINUX_SOCK_DIAG_H)
+#include <linux/sock_diag.h>
+#endif
+
+#if defined(HAVE_LINUX_INET_DIAG_H)
+#include <linux/inet_diag.h>
+#endif
+
 #if defined(HAVE_LINUX_SOCKIOS_H)
 #include <linux/sockios.h>
 #else
@@ -60,6 +84,40 @@ UNEXPECTED
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#if defined(HAVE_POLL_H) &&		\
+    defined(HAVE_LINUX_ERRQUEUE_H) &&	\
+    defined(MSG_ZEROCOPY) &&		\
+    defined(MSG_ERRQUEUE) &&		\
+    defined(SO_ZEROCOPY) &&		\
+    defined(SO_EE_ORIGIN_ZEROCOPY) &&	\
+    defined(SO_EE_CODE_ZEROCOPY_COPIED) && \
+    defined(SOL_IP) &&			\
+    defined(SOL_IPV6) &&		\
+    defined(IP_RECVERR) &&		\
+    defined(IPV6_RECVERR)
+#define HAVE_SOCK_ZEROCOPY
+#endif
+
+#if defined(HAVE_POLL_H) &&		\
+    defined(SOL_TCP) &&			\
+    defined(TCP_INFO) &&		\
+    defined(TCP_NOTSENT_LOWAT) &&	\
+    defined(SO_SNDBUF) &&		\
+    defined(SO_RCVBUF)
+#define HAVE_SOCK_BUFSIZE
+#endif
+
+#if defined(HAVE_SOCK_BUFSIZE) &&	\
+    defined(__linux__) &&		\
+    defined(HAVE_LINUX_NETLINK_H) &&	\
+    defined(HAVE_LINUX_RTNETLINK_H) &&	\
+    defined(HAVE_LINUX_SOCK_DIAG_H) &&	\
+    defined(HAVE_LINUX_INET_DIAG_H) &&	\
+    defined(SOCK_DIAG_BY_FAMILY) &&	\
+    defined(INET_DIAG_NOCOOKIE)
+#define HAVE_SOCK_BUFSIZE_SKMEM
+#endif
+
 #define DEFAULT_SOCKET_PORT	(2000)
 
 #define MIN_SOCKET_MSGS		(1)
@@ -69,6 +127,34 @@ UNEXPECTED
 #define MMAP_BUF_SIZE		(65536)
 #define MMAP_IO_SIZE		(8192)	/* Must be less or equal to 8192 */
 
+#define MIN_SOCKET_RR_SIZE	(8)
+#define MAX_SOCKET_RR_SIZE	(MMAP_BUF_SIZE / 2)
+#define DEFAULT_SOCKET_RR_SIZE	(64)
+
+#define MIN_SOCKET_RR_CONNS	(1)
+#define MAX_SOCKET_RR_CONNS	(1024)
+#define DEFAULT_SOCKET_RR_CONNS	(1)
+
+#define SOCKET_RR_SAMPLES	(65536)
+#define SOCKET_RR_HDR_SIZE	(2 * sizeof(uint64_t))
+
+#define SOCKET_MODE_STREAM	(0x00)
+#define SOCKET_MODE_RR		(0x01)
+#define SOCKET_MODE_CRR		(0x02)
+#define SOCKET_MODE_ZEROCOPY	(0x03)
+#define SOCKET_MODE_BUFSIZE	(0x04)
+
+#define SOCKET_ZC_MIN_SIZE	(4 * KB)
+#define SOCKET_ZC_SIZES		(9)	/* 4K .. 1M */
+#define SOCKET_ZC_MAX_SIZE	(SOCKET_ZC_MIN_SIZE << (SOCKET_ZC_SIZES - 1))
+#define SOCKET_ZC_RING_SIZE	(8 * SOCKET_ZC_MAX_SIZE)
+#define SOCKET_ZC_MAX_SLOTS	(SOCKET_ZC_RING_SIZE / SOCKET_ZC_MIN_SIZE)
+#define SOCKET_ZC_SLICE		(0.05)	/* seconds per size per send method */
+
+#define SOCKET_BS_CHUNK		(16 * KB)	/* timestamped send size */
+#define SOCKET_BS_SLICE		(0.25)	/* seconds per buffer configuration */
+#define SOCKET_BS_SAMPLE	(0.01)	/* seconds between TCP_INFO and sk_mem samples */
+
 #define SOCKET_OPT_SEND		(0x00)
 #define SOCKET_OPT_SENDMSG	(0x01)
 #define SOCKET_OPT_SENDMMSG	(0x02)
@@ -95,12 +181,15 @@ static const stress_help_t help[] = {
 	{ "S N", "sock N",		"start N workers exercising socket I/O" },
 	{ NULL,	"sock-domain D",	"specify socket domain, default is ipv4" },
 	{ NULL,	"sock-if I",		"use network interface I, e.g. lo, eth0, etc." },
+	{ NULL,	"sock-mode M",		"socket mode (stream, rr, crr, zerocopy, bufsize), default is stream" },
 	{ NULL,	"sock-msgs N",		"number of messages to send per connection" },
 	{ NULL,	"sock-nodelay",		"disable Nagle algorithm, send data immediately" },
 	{ NULL,	"sock-ops N",		"stop after N socket bogo operations" },
 	{ NULL,	"sock-opts option", 	"socket options [send|sendmsg|sendmmsg]" },
 	{ NULL,	"sock-port P",		"use socket ports P to P + number of workers - 1" },
 	{ NULL, "sock-protocol",	"use socket protocol P, default is tcp, can be mptcp" },
+	{ NULL,	"sock-rr-conns N",	"number of concurrent connections in rr and crr modes" },
+	{ NULL,	"sock-rr-size N",	"request and response size in bytes in rr and crr modes" },
 	{ NULL,	"sock-type T",		"socket type (stream, seqpacket)" },
 	{ NULL, "sock-zerocopy",	"enable zero copy sends" },
 	{ NULL,	NULL,			NULL }
@@ -142,6 +231,14 @@ static const stress_sock_options_t sock_options_types[] = {
 #endif
 };
 
+static const stress_sock_options_t sock_options_modes[] = {
+	{ "stream",	SOCKET_MODE_STREAM },
+	{ "rr",		SOCKET_MODE_RR },
+	{ "crr",	SOCKET_MODE_CRR },
+	{ "zerocopy",	SOCKET_MODE_ZEROCOPY },
+	{ "bufsize",	SOCKET_MODE_BUFSIZE },
+};
+
 static const stress_sock_options_t sock_options_protocols[] = {
 	{ "tcp",	IPPROTO_TCP},
 #if defined(IPPROTO_MPTCP)
@@ -466,6 +563,70 @@ static const int sol_socket_so_opts[] = {
 #endif
 };
 
+#if defined(HAVE_SOCK_ZEROCOPY)
+typedef struct {
+	uint32_t id;		/* MSG_ZEROCOPY send id */
+	bool pending;		/* true until send completion is reaped */
+} stress_sock_zc_slot_t;
+
+/*
+ *  stress_sock_zc_reap()
+ *	reap MSG_ZEROCOPY completion notifications from the error
+ *	queue and mark the buffer slots whose sends have completed
+ *	as reusable, returns number of notifications or -1 on error
+ */
+static int stress_sock_zc_reap(
+	const int fd,
+	stress_sock_zc_slot_t *slots,
+	const size_t n_slots,
+	uint64_t *completions,
+	uint64_t *copied)
+{
+	int n = 0;
+
+	for (;;) {
+		char control[128] ALIGN64;
+		struct msghdr msg;
+		struct cmsghdr *cmsg;
+
+		(void)shim_memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				return n;
+			return -1;
+		}
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			const struct sock_extended_err *serr;
+			uint32_t lo, range;
+			size_t i;
+
+			if (!(((cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR)) ||
+			      ((cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR))))
+				continue;
+			serr = (const struct sock_extended_err *)CMSG_DATA(cmsg);
+			if ((serr->ee_errno != 0) || (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+				continue;
+
+			/* ee_info..ee_data is the inclusive range of completed send ids */
+			lo = serr->ee_info;
+			range = serr->ee_data - lo;
+			*completions += (uint64_t)range + 1;
+			if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				*copied += (uint64_t)range + 1;
+			for (i = 0; i < n_slots; i++) {
+				if (slots[i].pending && ((uint32_t)(slots[i].id - lo) <= range))
+					slots[i].pending = false;
+			}
+			n++;
+		}
+	}
+}
+#endif
 
 /*
  *  stress_sock_client()
@@ -487,7 +648,8 @@ static int OPTIMIZE3 stress_sock_client(
 	struct sockaddr *addr;
 	size_t n_ctrls;
 	char **ctrls;
-	int recvflag = 0, rc = EXIT_FAILURE;
+	const int recvflag = 0;
+	int rc = EXIT_FAILURE;
 	uint64_t inq_bytes = 0, inq_samples = 0;
 	uint32_t count = 0;
 
@@ -528,25 +690,8 @@ retry:
 				args->name, errno, strerror(errno));
 			goto free_controls;
 		}
-#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
-		if (sock_zerocopy) {
-			int so_zerocopy = 1;
-			static bool warned = false;
-
-			if (!warned) {
-				if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &so_zerocopy, sizeof(so_zerocopy)) == 0) {
-					recvflag |= MSG_ZEROCOPY;
-				} else {
-					if (stress_instance_zero(args)) {
-						warned = true;
-						pr_inf("%s: cannot enable zerocopy on data being received\n", args->name);
-					}
-				}
-			}
-		}
-#else
+		/* MSG_ZEROCOPY is a transmit only flag, the server does the zero copy sends */
 		(void)sock_zerocopy;
-#endif
 
 		if (UNLIKELY(stress_set_sockaddr_if(args->name, args->instance, mypid,
 						    sock_domain, sock_port, sock_if,
@@ -919,6 +1064,7 @@ static int OPTIMIZE3 stress_sock_server(
 	int sendflag = 0;
 	double t, duration, metric;
 	uint64_t outq_bytes = 0, outq_samples = 0;
+	uint64_t zc_completions = 0, zc_copied = 0;
 	size_t sock_msgs = DEFAULT_SOCKET_MSGS;
 #if defined(SIOCOUTQ)
 	uint32_t count = 0;
@@ -1203,6 +1349,11 @@ retry_sendmmsg:
 					(void)close(sfd);
 					goto die_close;
 				}
+#if defined(HAVE_SOCK_ZEROCOPY)
+				/* reap completions so the error queue does not hit the optmem limit */
+				if (sendflag & MSG_ZEROCOPY)
+					(void)stress_sock_zc_reap(sfd, NULL, 0, &zc_completions, &zc_copied);
+#endif
 				stress_bogo_inc(args);
 			}
 			if (UNLIKELY(getpeername(sfd, &saddr, &len) < 0)) {
@@ -1244,6 +1395,11 @@ retry_sendmmsg:
 	metric = (outq_samples > 0) ? (double)outq_bytes / (double)outq_samples : 0.0;
 	stress_metrics_set(args, 1, "byte average out queue length",
 		metric, STRESS_METRIC_HARMONIC_MEAN);
+	if (zc_completions > 0) {
+		metric = 100.0 * (double)zc_copied / (double)zc_completions;
+		stress_metrics_set(args, 3, "% zerocopy sends copied by the kernel",
+			metric, STRESS_METRIC_MAXIMUM);
+	}
 
 die_close:
 	(void)close(fd);
@@ -1263,6 +1419,1206 @@ die:
 	return rc;
 }
 
+#if defined(HAVE_POLL_H)
+typedef struct {
+	int fd;			/* connection fd, -1 if not connected */
+	size_t got;		/* bytes of request/response received */
+	uint64_t seq;		/* transaction sequence number */
+	uint64_t sum;		/* payload checksum */
+	double t_start;		/* time transaction started */
+	uint8_t hdr[SOCKET_RR_HDR_SIZE];	/* received header bytes */
+} stress_sock_rr_conn_t;
+
+/*
+ *  stress_sock_set_nodelay()
+ *	disable Nagle if --sock-nodelay is enabled
+ */
+static void stress_sock_set_nodelay(const int fd, const int sock_domain)
+{
+#if defined(SOL_TCP) &&	\
+    defined(TCP_NODELAY)
+	if ((g_opt_flags & OPT_FLAGS_SOCKET_NODELAY) &&
+	    (sock_domain != AF_UNIX)) {
+		int one = 1;
+
+		VOID_RET(int, setsockopt(fd, SOL_TCP, TCP_NODELAY, &one, sizeof(one)));
+	}
+#else
+	(void)fd;
+	(void)sock_domain;
+#endif
+}
+
+/*
+ *  stress_sock_rr_accumulate()
+ *	copy header bytes of a partial request/response into the
+ *	connection header and checksum the remaining payload bytes
+ */
+static void OPTIMIZE3 stress_sock_rr_accumulate(
+	stress_sock_rr_conn_t *conn,
+	const uint8_t *buf,
+	const size_t len)
+{
+	register size_t i;
+
+	for (i = 0; (i < len) && (conn->got + i < SOCKET_RR_HDR_SIZE); i++)
+		conn->hdr[conn->got + i] = buf[i];
+	for (; i < len; i++)
+		conn->sum += buf[i];
+	conn->got += len;
+}
+
+/*
+ *  stress_sock_rr_send()
+ *	send all of a request/response, returns 0 on success, -1 on error
+ */
+static int stress_sock_rr_send(const int fd, const char *buf, const size_t len)
+{
+	size_t sent = 0;
+
+	while (sent < len) {
+		const ssize_t ret = send(fd, buf + sent, len - sent, 0);
+
+		if (UNLIKELY(ret < 0)) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		sent += (size_t)ret;
+	}
+	return 0;
+}
+
+/*
+ *  stress_sock_listen()
+ *	create a listening socket for the rr and zerocopy modes,
+ *	returns the fd or -1 with *rc set to the exit status
+ */
+static int stress_sock_listen(
+	stress_args_t *args,
+	const pid_t ppid,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const int sock_port,
+	const char *sock_if,
+	struct sockaddr **addr,
+	int *rc)
+{
+	int fd;
+	int so_reuseaddr = 1;
+	socklen_t addr_len = 0;
+
+	*rc = EXIT_FAILURE;
+	if ((fd = socket(sock_domain, sock_type, sock_protocol)) < 0) {
+		*rc = stress_exit_status(errno);
+		pr_fail("%s: socket failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		return -1;
+	}
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR,
+		&so_reuseaddr, sizeof(so_reuseaddr)) < 0) {
+		pr_fail("%s: setsockopt failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		goto die_close;
+	}
+	if (stress_set_sockaddr_if(args->name, args->instance, ppid,
+			sock_domain, sock_port, sock_if,
+			addr, &addr_len, NET_ADDR_ANY) < 0)
+		goto die_close;
+#if defined(AF_UNIX) &&		\
+    defined(HAVE_SOCKADDR_UN)
+	if (sock_domain == AF_UNIX) {
+		const struct sockaddr_un *addr_un = (struct sockaddr_un *)*addr;
+
+		(void)shim_unlink(addr_un->sun_path);
+	}
+#endif
+	if (bind(fd, *addr, addr_len) < 0) {
+		*rc = stress_exit_status(errno);
+		pr_fail("%s: bind failed on port %d, errno=%d (%s)\n",
+			args->name, sock_port, errno, strerror(errno));
+		goto die_close;
+	}
+	if (listen(fd, SOMAXCONN) < 0) {
+		pr_fail("%s: listen failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		goto die_close;
+	}
+	*rc = EXIT_SUCCESS;
+	return fd;
+
+die_close:
+	(void)close(fd);
+	return -1;
+}
+
+/*
+ *  stress_sock_unlink()
+ *	remove the unix domain socket path
+ */
+static void stress_sock_unlink(const struct sockaddr *addr, const int sock_domain)
+{
+#if defined(AF_UNIX) &&		\
+    defined(HAVE_SOCKADDR_UN)
+	if (addr && (sock_domain == AF_UNIX)) {
+		const struct sockaddr_un *addr_un = (const struct sockaddr_un *)addr;
+
+		(void)shim_unlink(addr_un->sun_path);
+	}
+#else
+	(void)addr;
+	(void)sock_domain;
+#endif
+}
+
+/*
+ *  stress_sock_rr_server()
+ *	server side of rr and crr modes, runs in the child, receives
+ *	fixed sized requests and replies with a response of the same
+ *	size that contains the request sequence number and payload checksum
+ */
+static int stress_sock_rr_server(
+	stress_args_t *args,
+	char *buf,
+	const pid_t ppid,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const int sock_port,
+	const char *sock_if,
+	const size_t rr_size,
+	const size_t rr_conns)
+{
+	int fd, rc = EXIT_FAILURE;
+	struct sockaddr *addr = NULL;
+	const size_t max_conns = rr_conns * 2;
+	size_t i, n_conns = 0;
+	stress_sock_rr_conn_t *conns;
+	struct pollfd *pfds;
+	char *rxbuf = buf + MAX_SOCKET_RR_SIZE;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	conns = (stress_sock_rr_conn_t *)calloc(max_conns, sizeof(*conns));
+	if (!conns)
+		return EXIT_NO_RESOURCE;
+	pfds = (struct pollfd *)calloc(max_conns + 1, sizeof(*pfds));
+	if (!pfds) {
+		free(conns);
+		return EXIT_NO_RESOURCE;
+	}
+
+	fd = stress_sock_listen(args, ppid, sock_domain, sock_type,
+			sock_protocol, sock_port, sock_if, &addr, &rc);
+	if (fd < 0)
+		goto free_conns;
+	rc = EXIT_FAILURE;
+
+	(void)shim_memset(buf, stress_ascii64[args->instance & 63], rr_size);
+
+	while (stress_continue_flag()) {
+		int ret;
+
+		/* stop accepting when the connection table is full */
+		pfds[0].fd = fd;
+		pfds[0].events = (n_conns < max_conns) ? POLLIN : 0;
+		pfds[0].revents = 0;
+		for (i = 0; i < n_conns; i++) {
+			pfds[i + 1].fd = conns[i].fd;
+			pfds[i + 1].events = POLLIN;
+			pfds[i + 1].revents = 0;
+		}
+		ret = poll(pfds, (nfds_t)(n_conns + 1), 1000);
+		if (UNLIKELY(ret < 0)) {
+			if (errno == EINTR)
+				continue;
+			pr_fail("%s: poll failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			goto die_conns;
+		}
+		if (ret == 0)
+			continue;
+
+		/* service connections in reverse so closed ones can be swapped out */
+		for (i = n_conns; i > 0; i--) {
+			stress_sock_rr_conn_t *conn = &conns[i - 1];
+			ssize_t n;
+
+			if (!pfds[i].revents)
+				continue;
+			n = recv(conn->fd, rxbuf, rr_size - conn->got, 0);
+			if (n <= 0) {
+				if ((n < 0) && (errno == EINTR))
+					continue;
+				(void)close(conn->fd);
+				n_conns--;
+				*conn = conns[n_conns];
+				continue;
+			}
+			stress_sock_rr_accumulate(conn, (uint8_t *)rxbuf, (size_t)n);
+			if (conn->got < rr_size)
+				continue;
+
+			/* request complete, reply with sequence number and checksum */
+			(void)shim_memcpy(buf, conn->hdr, sizeof(uint64_t));
+			if (rr_size >= SOCKET_RR_HDR_SIZE)
+				(void)shim_memcpy(buf + sizeof(uint64_t), &conn->sum, sizeof(conn->sum));
+			conn->got = 0;
+			conn->sum = 0;
+			if (UNLIKELY(stress_sock_rr_send(conn->fd, buf, rr_size) < 0)) {
+				(void)close(conn->fd);
+				n_conns--;
+				*conn = conns[n_conns];
+			}
+		}
+
+		if ((pfds[0].revents & POLLIN) && (n_conns < max_conns)) {
+			const int sfd = accept(fd, NULL, NULL);
+
+			if (sfd >= 0) {
+				stress_sock_set_nodelay(sfd, sock_domain);
+				(void)shim_memset(&conns[n_conns], 0, sizeof(conns[n_conns]));
+				conns[n_conns].fd = sfd;
+				n_conns++;
+			}
+		}
+	}
+	rc = EXIT_SUCCESS;
+die_conns:
+	for (i = 0; i < n_conns; i++)
+		(void)close(conns[i].fd);
+	(void)close(fd);
+	stress_sock_unlink(addr, sock_domain);
+free_conns:
+	free(pfds);
+	free(conns);
+	return rc;
+}
+
+/*
+ *  stress_sock_connect()
+ *	connect to the server, retrying while the server starts up
+ *	or while ephemeral ports are in short supply, returns fd or -1
+ */
+static int stress_sock_connect(
+	stress_args_t *args,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const struct sockaddr *addr,
+	const socklen_t addr_len)
+{
+	int retries = 0;
+
+	while (stress_continue_flag()) {
+		int fd;
+
+		fd = socket(sock_domain, sock_type, sock_protocol);
+		if (UNLIKELY(fd < 0)) {
+			pr_fail("%s: socket failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			return -1;
+		}
+		if (LIKELY(connect(fd, addr, addr_len) == 0)) {
+			stress_sock_set_nodelay(fd, sock_domain);
+			return fd;
+		}
+		(void)close(fd);
+		if (errno == EINTR)
+			continue;
+		retries++;
+		if (UNLIKELY(retries > 100)) {
+			pr_fail("%s: connect failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			return -1;
+		}
+		(void)shim_usleep(10000);
+	}
+	return -1;
+}
+
+/*
+ *  stress_sock_rr_request()
+ *	start a transaction on a connection, connecting first
+ *	if not connected, returns 0 on success, -1 on failure
+ */
+static int stress_sock_rr_request(
+	stress_args_t *args,
+	stress_sock_rr_conn_t *conn,
+	char *buf,
+	const size_t rr_size,
+	uint64_t *seq,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const struct sockaddr *addr,
+	const socklen_t addr_len)
+{
+	conn->t_start = stress_time_now();
+	if (conn->fd < 0) {
+		conn->fd = stress_sock_connect(args, sock_domain, sock_type,
+					sock_protocol, addr, addr_len);
+		if (conn->fd < 0)
+			return -1;
+	}
+	conn->got = 0;
+	conn->sum = 0;
+	conn->seq = (*seq)++;
+	(void)shim_memcpy(buf, &conn->seq, sizeof(conn->seq));
+	if (UNLIKELY(stress_sock_rr_send(conn->fd, buf, rr_size) < 0)) {
+		if (stress_continue_flag())
+			pr_fail("%s: send failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ *  stress_sock_rr_client()
+ *	client side of rr and crr modes, runs in the parent, keeps
+ *	rr_conns transactions in flight and measures the latency of
+ *	each request/response round trip. In crr mode each transaction
+ *	also includes the connect and close.
+ */
+static int stress_sock_rr_client(
+	stress_args_t *args,
+	char *buf,
+	const pid_t pid,
+	const pid_t mypid,
+	const int sock_mode,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const int sock_port,
+	const char *sock_if,
+	const size_t rr_size,
+	const size_t rr_conns)
+{
+	socklen_t addr_len = 0;
+	struct sockaddr *addr = NULL;
+	stress_sock_rr_conn_t *conns;
+	struct pollfd *pfds;
+	double *latencies;
+	double t, duration, lat_total = 0.0;
+	uint64_t seq = 0, sum = 0, transactions = 0;
+	size_t i, n_samples;
+	int rc = EXIT_FAILURE;
+	char *rxbuf = buf + MAX_SOCKET_RR_SIZE;
+
+	conns = (stress_sock_rr_conn_t *)calloc(rr_conns, sizeof(*conns));
+	pfds = (struct pollfd *)calloc(rr_conns, sizeof(*pfds));
+	latencies = (double *)calloc(SOCKET_RR_SAMPLES, sizeof(*latencies));
+	if (!conns || !pfds || !latencies) {
+		pr_inf_skip("%s: cannot allocate rr connection state%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_conns;
+	}
+	for (i = 0; i < rr_conns; i++)
+		conns[i].fd = -1;
+
+	if (stress_set_sockaddr_if(args->name, args->instance, mypid,
+			sock_domain, sock_port, sock_if,
+			&addr, &addr_len, NET_ADDR_ANY) < 0)
+		goto free_conns;
+
+	/* constant payload, the first 8 bytes are the sequence number */
+	(void)shim_memset(buf, stress_ascii64[args->instance & 63], rr_size);
+	for (i = SOCKET_RR_HDR_SIZE; i < rr_size; i++)
+		sum += (uint8_t)buf[i];
+
+	t = stress_time_now();
+	for (i = 0; i < rr_conns; i++) {
+		if (stress_sock_rr_request(args, &conns[i], buf, rr_size, &seq,
+				sock_domain, sock_type, sock_protocol, addr, addr_len) < 0)
+			goto close_conns;
+	}
+
+	do {
+		int ret;
+
+		for (i = 0; i < rr_conns; i++) {
+			pfds[i].fd = conns[i].fd;
+			pfds[i].events = POLLIN;
+			pfds[i].revents = 0;
+		}
+		ret = poll(pfds, (nfds_t)rr_conns, 1000);
+		if (UNLIKELY(ret < 0)) {
+			if (errno == EINTR)
+				continue;
+			pr_fail("%s: poll failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			goto close_conns;
+		}
+
+		for (i = 0; i < rr_conns; i++) {
+			stress_sock_rr_conn_t *conn = &conns[i];
+			uint64_t resp_seq, resp_sum;
+			double lat;
+			ssize_t n;
+
+			if (!pfds[i].revents)
+				continue;
+			n = recv(conn->fd, rxbuf, rr_size - conn->got, 0);
+			if (UNLIKELY(n <= 0)) {
+				if ((n < 0) && (errno == EINTR))
+					continue;
+				if (!stress_continue_flag())
+					break;
+				pr_fail("%s: %s on rr connection, errno=%d (%s)\n",
+					args->name, n ? "recv failed" : "unexpected EOF",
+					errno, strerror(errno));
+				goto close_conns;
+			}
+			stress_sock_rr_accumulate(conn, (uint8_t *)rxbuf, (size_t)n);
+			if (conn->got < rr_size)
+				continue;
+
+			lat = stress_time_now() - conn->t_start;
+			latencies[transactions % SOCKET_RR_SAMPLES] = lat;
+			lat_total += lat;
+			transactions++;
+			stress_bogo_inc(args);
+
+			(void)shim_memcpy(&resp_seq, conn->hdr, sizeof(resp_seq));
+			(void)shim_memcpy(&resp_sum, conn->hdr + sizeof(uint64_t), sizeof(resp_sum));
+			if (UNLIKELY(resp_seq != conn->seq)) {
+				pr_fail("%s: response sequence number mismatch, got %" PRIu64
+					", expected %" PRIu64 "\n",
+					args->name, resp_seq, conn->seq);
+				goto close_conns;
+			}
+			if (UNLIKELY((rr_size >= SOCKET_RR_HDR_SIZE) && (resp_sum != sum))) {
+				pr_fail("%s: response checksum mismatch, got 0x%" PRIx64
+					", expected 0x%" PRIx64 "\n",
+					args->name, resp_sum, sum);
+				goto close_conns;
+			}
+
+			if (sock_mode == SOCKET_MODE_CRR) {
+				(void)close(conn->fd);
+				conn->fd = -1;
+			}
+			if (UNLIKELY(!stress_continue(args)))
+				break;
+			if (stress_sock_rr_request(args, conn, buf, rr_size, &seq,
+					sock_domain, sock_type, sock_protocol, addr, addr_len) < 0) {
+				if (!stress_continue_flag())
+					break;
+				goto close_conns;
+			}
+		}
+	} while (stress_continue(args));
+	rc = EXIT_SUCCESS;
+
+close_conns:
+	duration = stress_time_now() - t;
+	for (i = 0; i < rr_conns; i++) {
+		if (conns[i].fd >= 0)
+			(void)close(conns[i].fd);
+	}
+
+	n_samples = (transactions < SOCKET_RR_SAMPLES) ? (size_t)transactions : SOCKET_RR_SAMPLES;
+	stress_metrics_set(args, 0, "transactions per sec",
+		(duration > 0.0) ? (double)transactions / duration : 0.0,
+		STRESS_METRIC_HARMONIC_MEAN);
+	if (n_samples > 0) {
+		stress_percentile_sort(latencies, n_samples);
+		stress_metrics_set(args, 1, "usec mean transaction latency",
+			STRESS_DBL_MICROSECOND * lat_total / (double)transactions,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		stress_metrics_set(args, 2, "usec p50 transaction latency",
+			STRESS_DBL_MICROSECOND * stress_percentile(latencies, n_samples, 50.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		stress_metrics_set(args, 3, "usec p90 transaction latency",
+			STRESS_DBL_MICROSECOND * stress_percentile(latencies, n_samples, 90.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		stress_metrics_set(args, 4, "usec p99 transaction latency",
+			STRESS_DBL_MICROSECOND * stress_percentile(latencies, n_samples, 99.0),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		stress_metrics_set(args, 5, "usec p99.9 transaction latency",
+			STRESS_DBL_MICROSECOND * stress_percentile(latencies, n_samples, 99.9),
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+
+free_conns:
+	(void)stress_kill_pid_wait(pid, NULL);
+	stress_sock_unlink(addr, sock_domain);
+	free(latencies);
+	free(pfds);
+	free(conns);
+	return rc;
+}
+
+#if defined(HAVE_SOCK_ZEROCOPY)
+/*
+ *  stress_sock_zc_wait()
+ *	wait for a buffer slot's zero copy send to complete,
+ *	returns 0 when the slot is reusable, -1 on error or timeout
+ */
+static int stress_sock_zc_wait(
+	const int fd,
+	stress_sock_zc_slot_t *slots,
+	const size_t n_slots,
+	const size_t slot,
+	uint64_t *completions,
+	uint64_t *copied)
+{
+	const double t_end = stress_time_now() + 5.0;
+
+	while (slots[slot].pending) {
+		struct pollfd pfd;
+
+		if (stress_sock_zc_reap(fd, slots, n_slots, completions, copied) < 0)
+			return -1;
+		if (!slots[slot].pending)
+			break;
+		if (stress_time_now() > t_end)
+			return -1;
+		/* error queue notifications are flagged as POLLERR */
+		pfd.fd = fd;
+		pfd.events = 0;
+		pfd.revents = 0;
+		(void)poll(&pfd, 1, 100);
+	}
+	return 0;
+}
+
+/*
+ *  stress_sock_zc_receiver()
+ *	receiver side of the zerocopy mode, runs in the child and
+ *	drains all data sent on the accepted connection
+ */
+static int stress_sock_zc_receiver(
+	stress_args_t *args,
+	char *buf,
+	const pid_t ppid,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const int sock_port,
+	const char *sock_if)
+{
+	int fd, sfd, rc;
+	struct sockaddr *addr = NULL;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	fd = stress_sock_listen(args, ppid, sock_domain, sock_type,
+			sock_protocol, sock_port, sock_if, &addr, &rc);
+	if (fd < 0)
+		return rc;
+	sfd = accept(fd, NULL, NULL);
+	if (sfd >= 0) {
+		while (stress_continue_flag()) {
+			const ssize_t n = recv(sfd, buf, MMAP_BUF_SIZE, 0);
+
+			if ((n == 0) || ((n < 0) && (errno != EINTR)))
+				break;
+		}
+		(void)close(sfd);
+	}
+	(void)close(fd);
+	stress_sock_unlink(addr, sock_domain);
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_sock_zc_sender()
+ *	sender side of the zerocopy mode, runs in the parent. Sweeps the
+ *	message size and for each size sends for a short time slice with
+ *	plain copying sends and then with MSG_ZEROCOPY sends. Sends cycle
+ *	around a fixed size ring divided into message sized slots and for
+ *	zero copy sends a slot is only rewritten and resent once its
+ *	completion has been reaped from the socket error queue.
+ */
+static int stress_sock_zc_sender(
+	stress_args_t *args,
+	const pid_t pid,
+	const pid_t mypid,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const int sock_port,
+	const char *sock_if)
+{
+	socklen_t addr_len = 0;
+	struct sockaddr *addr = NULL;
+	stress_sock_zc_slot_t *slots;
+	uint64_t zc_bytes[2][SOCKET_ZC_SIZES];
+	double zc_cpu[2][SOCKET_ZC_SIZES], zc_duration[2][SOCKET_ZC_SIZES];
+	uint64_t completions = 0, copied = 0, zc_sends = 0;
+	uint32_t zc_id = 0;
+	size_t i, slot = 0, break_even = 0;
+	int fd = -1, rc = EXIT_FAILURE, so_zerocopy = 1, idx;
+	const size_t ring_size = SOCKET_ZC_RING_SIZE;
+	uint8_t *ring;
+
+	(void)shim_memset(zc_bytes, 0, sizeof(zc_bytes));
+	(void)shim_memset(zc_cpu, 0, sizeof(zc_cpu));
+	(void)shim_memset(zc_duration, 0, sizeof(zc_duration));
+
+	ring = (uint8_t *)stress_mmap_populate(NULL, ring_size,
+			PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	if (ring == MAP_FAILED) {
+		pr_inf_skip("%s: failed to mmap %zu byte zerocopy buffer ring%s, "
+			"errno=%d (%s), skipping stressor\n",
+			args->name, ring_size, stress_get_memfree_str(),
+			errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto kill_pid;
+	}
+	slots = (stress_sock_zc_slot_t *)calloc(SOCKET_ZC_MAX_SLOTS, sizeof(*slots));
+	if (!slots) {
+		pr_inf_skip("%s: failed to allocate %zu zerocopy slots%s, skipping stressor\n",
+			args->name, (size_t)SOCKET_ZC_MAX_SLOTS, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto unmap_ring;
+	}
+	stress_set_vma_anon_name(ring, ring_size, "zerocopy-ring");
+	(void)shim_memset(ring, stress_ascii64[args->instance & 63], ring_size);
+
+	if (stress_set_sockaddr_if(args->name, args->instance, mypid,
+			sock_domain, sock_port, sock_if,
+			&addr, &addr_len, NET_ADDR_ANY) < 0)
+		goto free_slots;
+	fd = stress_sock_connect(args, sock_domain, sock_type,
+				sock_protocol, addr, addr_len);
+	if (fd < 0) {
+		if (!stress_continue_flag())
+			rc = EXIT_SUCCESS;
+		goto free_slots;
+	}
+	if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &so_zerocopy, sizeof(so_zerocopy)) < 0) {
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: cannot enable SO_ZEROCOPY, errno=%d (%s), "
+				"skipping stressor\n", args->name, errno, strerror(errno));
+		(void)close(fd);
+		rc = EXIT_NOT_IMPLEMENTED;
+		goto free_slots;
+	}
+
+	do {
+		for (i = 0; LIKELY((i < SOCKET_ZC_SIZES) && stress_continue(args)); i++) {
+			const size_t size = SOCKET_ZC_MIN_SIZE << i;
+			const size_t n_slots = ring_size / size;
+
+			/* idx 0 = copying send, idx 1 = zero copy send */
+			for (idx = 0; LIKELY((idx < 2) && stress_continue(args)); idx++) {
+				const int flag = idx ? MSG_ZEROCOPY : 0;
+				const double t_start = stress_time_now();
+				const double cpu_start = stress_time_cpu_self();
+				double t_now = t_start;
+
+				while ((t_now - t_start < SOCKET_ZC_SLICE) && stress_continue(args)) {
+					uint8_t *ptr = ring + (slot * size);
+					ssize_t ret;
+
+					if (slots[slot].pending &&
+					    (stress_sock_zc_wait(fd, slots, n_slots, slot, &completions, &copied) < 0)) {
+						pr_fail("%s: failed to reap zerocopy completions, errno=%d (%s)\n",
+							args->name, errno, strerror(errno));
+						goto close_fd;
+					}
+					/* safe to modify, the slot is not in flight */
+					ptr[0] = (uint8_t)zc_sends;
+
+					ret = send(fd, ptr, size, flag);
+					if (UNLIKELY(ret < 0)) {
+						if (errno == ENOBUFS) {
+							/* optmem limit reached, reap and retry */
+							(void)stress_sock_zc_reap(fd, slots, n_slots, &completions, &copied);
+							t_now = stress_time_now();
+							continue;
+						}
+						if ((errno == EINTR) || !stress_continue_flag())
+							break;
+						pr_fail("%s: send failed, errno=%d (%s)\n",
+							args->name, errno, strerror(errno));
+						goto close_fd;
+					}
+					if (flag) {
+						slots[slot].id = zc_id++;
+						slots[slot].pending = true;
+						zc_sends++;
+					}
+					zc_bytes[idx][i] += (uint64_t)ret;
+					slot = (slot + 1) % n_slots;
+					stress_bogo_inc(args);
+					t_now = stress_time_now();
+				}
+
+				/* account for reaping all outstanding completions */
+				for (slot = 0; flag && (slot < n_slots); slot++) {
+					if (stress_sock_zc_wait(fd, slots, n_slots, slot, &completions, &copied) < 0)
+						break;
+				}
+				slot = 0;
+				zc_cpu[idx][i] += stress_time_cpu_self() - cpu_start;
+				zc_duration[idx][i] += stress_time_now() - t_start;
+			}
+		}
+	} while (stress_continue(args));
+	rc = EXIT_SUCCESS;
+
+close_fd:
+	(void)close(fd);
+
+	for (i = 0; i < SOCKET_ZC_SIZES; i++) {
+		const size_t size_kb = (SOCKET_ZC_MIN_SIZE << i) / KB;
+		double cpu_per_kb[2];
+		char msg[64];
+
+		for (idx = 0; idx < 2; idx++) {
+			const double kbytes = (double)zc_bytes[idx][i] / (double)KB;
+			const char *how = idx ? "zerocopy" : "copy";
+
+			cpu_per_kb[idx] = (kbytes > 0.0) ?
+				STRESS_DBL_NANOSECOND * zc_cpu[idx][i] / kbytes : 0.0;
+			(void)snprintf(msg, sizeof(msg), "MB/sec %s send %zuK", how, size_kb);
+			stress_metrics_set(args, (4 * i) + (size_t)idx, msg,
+				(zc_duration[idx][i] > 0.0) ?
+					(double)zc_bytes[idx][i] / (zc_duration[idx][i] * (double)MB) : 0.0,
+				STRESS_METRIC_HARMONIC_MEAN);
+			(void)snprintf(msg, sizeof(msg), "CPU nsec per KB %s send %zuK", how, size_kb);
+			stress_metrics_set(args, (4 * i) + 2 + (size_t)idx, msg,
+				cpu_per_kb[idx], STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+		if ((break_even == 0) && (cpu_per_kb[0] > 0.0) &&
+		    (cpu_per_kb[1] > 0.0) && (cpu_per_kb[1] < cpu_per_kb[0]))
+			break_even = size_kb;
+	}
+	stress_metrics_set(args, 4 * SOCKET_ZC_SIZES,
+		"zerocopy CPU break-even size KB (0 = not reached)",
+		(double)break_even, STRESS_METRIC_MAXIMUM);
+	stress_metrics_set(args, (4 * SOCKET_ZC_SIZES) + 1,
+		"% zerocopy sends copied by the kernel",
+		(completions > 0) ? 100.0 * (double)copied / (double)completions : 0.0,
+		STRESS_METRIC_MAXIMUM);
+
+free_slots:
+	free(slots);
+unmap_ring:
+	(void)munmap((void *)ring, ring_size);
+kill_pid:
+	(void)stress_kill_pid_wait(pid, NULL);
+	stress_sock_unlink(addr, sock_domain);
+	return rc;
+}
+#endif
+
+#if defined(HAVE_SOCK_BUFSIZE)
+typedef struct {
+	const char *name;	/* metrics name suffix */
+	const int bufsize;	/* SO_SNDBUF/SO_RCVBUF size, 0 = autotune */
+	const int lowat;	/* TCP_NOTSENT_LOWAT, 0 = not set */
+} stress_sock_bs_config_t;
+
+static const stress_sock_bs_config_t stress_sock_bs_configs[] = {
+	{ "autotune",		0,		0 },
+	{ "buf 64K",		64 * KB,	0 },
+	{ "buf 256K",		256 * KB,	0 },
+	{ "buf 1M",		1 * MB,		0 },
+	{ "buf 4M",		4 * MB,		0 },
+	{ "notsent-lowat 16K",	0,		16 * KB },
+	{ "notsent-lowat 128K",	0,		128 * KB },
+};
+
+/*
+ *  receiver statistics sent back to the sender per configuration
+ */
+typedef struct {
+	double latency;		/* total send to receive latency */
+	uint64_t chunks;	/* number of timestamped chunks received */
+} stress_sock_bs_result_t;
+
+/*
+ *  stress_sock_bs_setbuf()
+ *	set a socket buffer size, the FORCE variants are used if
+ *	permitted so that sizes above the rmem_max/wmem_max sysctls
+ *	are honoured
+ */
+static void stress_sock_bs_setbuf(
+	const int fd,
+	const int optname,
+	const int optname_force,
+	const int size)
+{
+	if ((optname_force >= 0) &&
+	    (setsockopt(fd, SOL_SOCKET, optname_force, &size, sizeof(size)) == 0))
+		return;
+	VOID_RET(int, setsockopt(fd, SOL_SOCKET, optname, &size, sizeof(size)));
+}
+
+/*
+ *  stress_sock_bs_receiver()
+ *	receiver side of the bufsize mode, runs in the child. For each
+ *	configuration requested on ctrl_fd it listens with the configured
+ *	receive buffer, drains the connection and reports the latency
+ *	of the timestamped chunks back to the sender
+ */
+static int stress_sock_bs_receiver(
+	stress_args_t *args,
+	char *buf,
+	const pid_t ppid,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const int sock_port,
+	const char *sock_if,
+	const int ctrl_fd)
+{
+	uint32_t idx;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	while (read(ctrl_fd, &idx, sizeof(idx)) == (ssize_t)sizeof(idx)) {
+		const stress_sock_bs_config_t *cfg = &stress_sock_bs_configs[idx];
+		stress_sock_bs_result_t result;
+		struct sockaddr *addr = NULL;
+		int fd, sfd, rc;
+		uint8_t ready;
+
+		/*
+		 *  a new listener per configuration, setting SO_RCVBUF
+		 *  locks the size and disables receive autotuning
+		 */
+		fd = stress_sock_listen(args, ppid, sock_domain, sock_type,
+				sock_protocol, sock_port, sock_if, &addr, &rc);
+		if (fd < 0)
+			return rc;
+		if (cfg->bufsize) {
+#if defined(SO_RCVBUFFORCE)
+			stress_sock_bs_setbuf(fd, SO_RCVBUF, SO_RCVBUFFORCE, cfg->bufsize);
+#else
+			stress_sock_bs_setbuf(fd, SO_RCVBUF, -1, cfg->bufsize);
+#endif
+		}
+		ready = 1;
+		if (write(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready)) {
+			(void)close(fd);
+			break;
+		}
+
+		result.latency = 0.0;
+		result.chunks = 0;
+		sfd = accept(fd, NULL, NULL);
+		if (sfd >= 0) {
+			while (stress_continue_flag()) {
+				double ts;
+				const ssize_t n = recv(sfd, buf, SOCKET_BS_CHUNK, MSG_WAITALL);
+
+				if (n == (ssize_t)SOCKET_BS_CHUNK) {
+					/* each chunk starts with the time it was sent */
+					(void)shim_memcpy(&ts, buf, sizeof(ts));
+					result.latency += stress_time_now() - ts;
+					result.chunks++;
+					continue;
+				}
+				if ((n < 0) && (errno == EINTR))
+					continue;
+				break;
+			}
+			(void)close(sfd);
+		}
+		(void)close(fd);
+		if (write(ctrl_fd, &result, sizeof(result)) != (ssize_t)sizeof(result))
+			break;
+	}
+	return EXIT_SUCCESS;
+}
+
+#if defined(HAVE_SOCK_BUFSIZE_SKMEM)
+/*
+ *  stress_sock_bs_skmem_query()
+ *	query the memory charged to one end of a TCP connection
+ *	using an exact match sock_diag lookup, returns bytes or 0
+ */
+static uint64_t stress_sock_bs_skmem_query(
+	const int nl_fd,
+	const int sock_domain,
+	const struct sockaddr_storage *src,
+	const struct sockaddr_storage *dst)
+{
+	struct {
+		struct nlmsghdr nlh;
+		struct inet_diag_req_v2 req;
+	} msg;
+	union {
+		struct nlmsghdr nlh;
+		uint8_t buf[1024];
+	} resp;
+	const struct nlmsghdr *nlh;
+	struct rtattr *rta;
+	ssize_t n;
+	int len;
+
+	(void)shim_memset(&msg, 0, sizeof(msg));
+	msg.nlh.nlmsg_len = sizeof(msg);
+	msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+	msg.nlh.nlmsg_flags = NLM_F_REQUEST;
+	msg.req.sdiag_family = (uint8_t)sock_domain;
+	msg.req.sdiag_protocol = IPPROTO_TCP;
+	msg.req.idiag_ext = 1U << (INET_DIAG_SKMEMINFO - 1);
+	msg.req.idiag_states = ~0U;
+	msg.req.id.idiag_cookie[0] = INET_DIAG_NOCOOKIE;
+	msg.req.id.idiag_cookie[1] = INET_DIAG_NOCOOKIE;
+	if (sock_domain == AF_INET) {
+		const struct sockaddr_in *s = (const struct sockaddr_in *)src;
+		const struct sockaddr_in *d = (const struct sockaddr_in *)dst;
+
+		msg.req.id.idiag_sport = s->sin_port;
+		msg.req.id.idiag_dport = d->sin_port;
+		(void)shim_memcpy(msg.req.id.idiag_src, &s->sin_addr, sizeof(s->sin_addr));
+		(void)shim_memcpy(msg.req.id.idiag_dst, &d->sin_addr, sizeof(d->sin_addr));
+	} else {
+		const struct sockaddr_in6 *s = (const struct sockaddr_in6 *)src;
+		const struct sockaddr_in6 *d = (const struct sockaddr_in6 *)dst;
+
+		msg.req.id.idiag_sport = s->sin6_port;
+		msg.req.id.idiag_dport = d->sin6_port;
+		(void)shim_memcpy(msg.req.id.idiag_src, &s->sin6_addr, sizeof(s->sin6_addr));
+		(void)shim_memcpy(msg.req.id.idiag_dst, &d->sin6_addr, sizeof(d->sin6_addr));
+	}
+	if (send(nl_fd, &msg, sizeof(msg), 0) < 0)
+		return 0;
+	n = recv(nl_fd, &resp, sizeof(resp), 0);
+	if (n <= 0)
+		return 0;
+	nlh = &resp.nlh;
+	if (!NLMSG_OK(nlh, (unsigned int)n) || (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY))
+		return 0;
+
+	len = (int)nlh->nlmsg_len - (int)NLMSG_LENGTH(sizeof(struct inet_diag_msg));
+	rta = (struct rtattr *)(((uint8_t *)NLMSG_DATA(nlh)) + NLMSG_ALIGN(sizeof(struct inet_diag_msg)));
+	for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		const uint32_t *mem = (const uint32_t *)RTA_DATA(rta);
+
+		if ((rta->rta_type != INET_DIAG_SKMEMINFO) ||
+		    (RTA_PAYLOAD(rta) < (SK_MEMINFO_WMEM_QUEUED + 1) * sizeof(uint32_t)))
+			continue;
+		return (uint64_t)mem[SK_MEMINFO_RMEM_ALLOC] +
+		       (uint64_t)mem[SK_MEMINFO_WMEM_QUEUED] +
+		       (uint64_t)mem[SK_MEMINFO_FWD_ALLOC];
+	}
+	return 0;
+}
+
+/*
+ *  stress_sock_bs_skmem()
+ *	memory charged to both ends of the connection fd in bytes
+ */
+static uint64_t stress_sock_bs_skmem(const int nl_fd, const int fd, const int sock_domain)
+{
+	struct sockaddr_storage local, peer;
+	socklen_t len;
+
+	if (nl_fd < 0)
+		return 0;
+	len = sizeof(local);
+	if (getsockname(fd, (struct sockaddr *)&local, &len) < 0)
+		return 0;
+	len = sizeof(peer);
+	if (getpeername(fd, (struct sockaddr *)&peer, &len) < 0)
+		return 0;
+	return stress_sock_bs_skmem_query(nl_fd, sock_domain, &local, &peer) +
+	       stress_sock_bs_skmem_query(nl_fd, sock_domain, &peer, &local);
+}
+#endif
+
+/*
+ *  stress_sock_bs_sender()
+ *	sender side of the bufsize mode, runs in the parent. For each
+ *	socket buffer configuration a new connection streams timestamped
+ *	chunks for a time slice while TCP_INFO RTT and the memory charged
+ *	to the connection are sampled
+ */
+static int stress_sock_bs_sender(
+	stress_args_t *args,
+	char *buf,
+	const pid_t pid,
+	const pid_t mypid,
+	const int sock_domain,
+	const int sock_type,
+	const int sock_protocol,
+	const int sock_port,
+	const char *sock_if,
+	const int ctrl_fd)
+{
+	const size_t n_configs = SIZEOF_ARRAY(stress_sock_bs_configs);
+	socklen_t addr_len = 0;
+	struct sockaddr *addr = NULL;
+	double bs_bytes[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_duration[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_latency[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_chunks[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_rtt[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_skmem[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_skmem_max[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_skmem_samples[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	double bs_samples[SIZEOF_ARRAY(stress_sock_bs_configs)];
+	int rc = EXIT_SUCCESS, nl_fd = -1;
+	size_t i;
+
+	(void)shim_memset(bs_bytes, 0, sizeof(bs_bytes));
+	(void)shim_memset(bs_duration, 0, sizeof(bs_duration));
+	(void)shim_memset(bs_latency, 0, sizeof(bs_latency));
+	(void)shim_memset(bs_chunks, 0, sizeof(bs_chunks));
+	(void)shim_memset(bs_rtt, 0, sizeof(bs_rtt));
+	(void)shim_memset(bs_skmem, 0, sizeof(bs_skmem));
+	(void)shim_memset(bs_skmem_max, 0, sizeof(bs_skmem_max));
+	(void)shim_memset(bs_skmem_samples, 0, sizeof(bs_skmem_samples));
+	(void)shim_memset(bs_samples, 0, sizeof(bs_samples));
+
+	if (stress_set_sockaddr_if(args->name, args->instance, mypid,
+			sock_domain, sock_port, sock_if,
+			&addr, &addr_len, NET_ADDR_ANY) < 0) {
+		rc = EXIT_FAILURE;
+		goto kill_pid;
+	}
+#if defined(HAVE_SOCK_BUFSIZE_SKMEM)
+	nl_fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_SOCK_DIAG);
+	if ((nl_fd < 0) && stress_instance_zero(args))
+		pr_inf("%s: cannot open sock_diag netlink socket, errno=%d (%s), "
+			"sk_mem will not be reported\n", args->name, errno, strerror(errno));
+#else
+	if (stress_instance_zero(args))
+		pr_inf("%s: sock_diag support is not available, sk_mem will not be reported\n",
+			args->name);
+#endif
+
+	do {
+		for (i = 0; LIKELY((i < n_configs) && stress_continue(args)); i++) {
+			const stress_sock_bs_config_t *cfg = &stress_sock_bs_configs[i];
+			const uint32_t idx = (uint32_t)i;
+			stress_sock_bs_result_t result;
+			double t_start, t_sample, t_now;
+			uint8_t ready;
+			int fd;
+
+			if (write(ctrl_fd, &idx, sizeof(idx)) != (ssize_t)sizeof(idx))
+				goto close_nl;
+			if (read(ctrl_fd, &ready, sizeof(ready)) != (ssize_t)sizeof(ready))
+				goto close_nl;
+
+			fd = stress_sock_connect(args, sock_domain, sock_type,
+						sock_protocol, addr, addr_len);
+			if (fd < 0) {
+				if (stress_continue_flag())
+					rc = EXIT_FAILURE;
+				goto close_nl;
+			}
+			if (cfg->bufsize) {
+#if defined(SO_SNDBUFFORCE)
+				stress_sock_bs_setbuf(fd, SO_SNDBUF, SO_SNDBUFFORCE, cfg->bufsize);
+#else
+				stress_sock_bs_setbuf(fd, SO_SNDBUF, -1, cfg->bufsize);
+#endif
+			}
+			if (cfg->lowat)
+				VOID_RET(int, setsockopt(fd, SOL_TCP, TCP_NOTSENT_LOWAT,
+					&cfg->lowat, sizeof(cfg->lowat)));
+
+			t_start = stress_time_now();
+			t_sample = t_start;
+			t_now = t_start;
+			while ((t_now - t_start < SOCKET_BS_SLICE) && stress_continue(args)) {
+				size_t sent = 0;
+
+				(void)shim_memcpy(buf, &t_now, sizeof(t_now));
+				while (sent < SOCKET_BS_CHUNK) {
+					const ssize_t ret = send(fd, buf + sent, SOCKET_BS_CHUNK - sent, 0);
+
+					if (UNLIKELY(ret < 0)) {
+						if ((errno == EINTR) && stress_continue_flag())
+							continue;
+						break;
+					}
+					sent += (size_t)ret;
+				}
+				if (UNLIKELY(sent < SOCKET_BS_CHUNK))
+					break;
+				bs_bytes[i] += (double)SOCKET_BS_CHUNK;
+				stress_bogo_inc(args);
+
+				t_now = stress_time_now();
+				if (t_now - t_sample >= SOCKET_BS_SAMPLE) {
+					struct tcp_info info;
+					socklen_t len = sizeof(info);
+
+					if (getsockopt(fd, SOL_TCP, TCP_INFO, &info, &len) == 0) {
+#if defined(HAVE_SOCK_BUFSIZE_SKMEM)
+						const double skmem = (double)stress_sock_bs_skmem(nl_fd, fd, sock_domain);
+
+						/* 0 if sock_diag is not usable or the query failed */
+						if (skmem > 0.0) {
+							bs_skmem[i] += skmem;
+							bs_skmem_samples[i] += 1.0;
+							if (skmem > bs_skmem_max[i])
+								bs_skmem_max[i] = skmem;
+						}
+#endif
+						bs_rtt[i] += (double)info.tcpi_rtt;
+						bs_samples[i] += 1.0;
+					}
+					t_sample = t_now;
+				}
+			}
+			(void)close(fd);
+			bs_duration[i] += stress_time_now() - t_start;
+
+			if (read(ctrl_fd, &result, sizeof(result)) != (ssize_t)sizeof(result))
+				goto close_nl;
+			bs_latency[i] += result.latency;
+			bs_chunks[i] += (double)result.chunks;
+		}
+	} while (stress_continue(args));
+
+close_nl:
+	if (nl_fd >= 0)
+		(void)close(nl_fd);
+
+	for (i = 0; i < n_configs; i++) {
+		const char *name = stress_sock_bs_configs[i].name;
+		const double samples = bs_samples[i];
+		char msg[64];
+
+		(void)snprintf(msg, sizeof(msg), "MB/sec %s", name);
+		stress_metrics_set(args, (5 * i) + 0, msg,
+			(bs_duration[i] > 0.0) ? bs_bytes[i] / (bs_duration[i] * (double)MB) : 0.0,
+			STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec TCP_INFO RTT %s", name);
+		stress_metrics_set(args, (5 * i) + 1, msg,
+			(samples > 0.0) ? bs_rtt[i] / samples : 0.0,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "msec send to receive latency %s", name);
+		stress_metrics_set(args, (5 * i) + 2, msg,
+			(bs_chunks[i] > 0.0) ? STRESS_DBL_MILLISECOND * bs_latency[i] / bs_chunks[i] : 0.0,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		/* sk_mem is only reported if sock_diag could sample it */
+		if (bs_skmem_samples[i] > 0.0) {
+			(void)snprintf(msg, sizeof(msg), "KB sk_mem mean %s", name);
+			stress_metrics_set(args, (5 * i) + 3, msg,
+				bs_skmem[i] / (bs_skmem_samples[i] * (double)KB),
+				STRESS_METRIC_GEOMETRIC_MEAN);
+			(void)snprintf(msg, sizeof(msg), "KB sk_mem peak %s", name);
+			stress_metrics_set(args, (5 * i) + 4, msg,
+				bs_skmem_max[i] / (double)KB, STRESS_METRIC_MAXIMUM);
+		}
+	}
+kill_pid:
+	(void)stress_kill_pid_wait(pid, NULL);
+	stress_sock_unlink(addr, sock_domain);
+	return rc;
+}
+#endif
+#endif
+
 static void stress_sock_sigpipe_handler(int signum)
 {
 	(void)signum;
@@ -1308,10 +2664,14 @@ static int stress_sock(stress_args_t *args)
 	int sock_port = DEFAULT_SOCKET_PORT;
 	int sock_protocol = 0;
 	int sock_zerocopy = false;
+	int sock_mode;
+	size_t sock_rr_size = DEFAULT_SOCKET_RR_SIZE;
+	size_t sock_rr_conns = DEFAULT_SOCKET_RR_CONNS;
 	int rc = EXIT_SUCCESS, reserved_port, parent_cpu;
 	const bool rt = stress_sock_kernel_rt();
 	char *mmap_buffer;
 	char *sock_if = NULL;
+	int bs_ctrl[2] = { -1, -1 };
 
 	if (stress_sigchld_set_handler(args) < 0)
 		return EXIT_NO_RESOURCE;
@@ -1320,6 +2680,10 @@ static int stress_sock(stress_args_t *args)
 	(void)stress_get_setting("sock-domain", &sock_domain);
 	(void)stress_get_setting("sock-port", &sock_port);
 	(void)stress_get_setting("sock-zerocopy", &sock_zerocopy);
+	(void)stress_get_setting("sock-rr-size", &sock_rr_size);
+	(void)stress_get_setting("sock-rr-conns", &sock_rr_conns);
+	sock_mode = stress_get_setting("sock-mode", &idx) ?
+		sock_options_modes[idx].optval : SOCKET_MODE_STREAM;
 	sock_opts = stress_get_setting("sock-opts", &idx) ?
 		sock_options_opts[idx].optval : SOCKET_OPT_SEND;
 #if defined(SOCK_STREAM)
@@ -1331,6 +2695,61 @@ static int stress_sock(stress_args_t *args)
 #endif
 	sock_protocol = stress_get_setting("sock-protocol", &idx) ?
 		sock_options_protocols[idx].optval : IPPROTO_TCP;
+#if defined(AF_UNIX)
+	/* tcp and mptcp are internet protocols, unix sockets use the default */
+	if (sock_domain == AF_UNIX)
+		sock_protocol = 0;
+#endif
+
+	if (sock_mode != SOCKET_MODE_STREAM) {
+#if defined(HAVE_POLL_H)
+#if defined(SOCK_DGRAM)
+		if (sock_type == SOCK_DGRAM) {
+			if (stress_instance_zero(args))
+				pr_inf_skip("%s: sock-mode %s requires a connected socket type, "
+					"dgram is not supported, skipping stressor\n",
+					args->name, sock_options_modes[sock_mode].optname);
+			return EXIT_NOT_IMPLEMENTED;
+		}
+#endif
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: sock-mode %s requires poll(), skipping stressor\n",
+				args->name, sock_options_modes[sock_mode].optname);
+		return EXIT_NOT_IMPLEMENTED;
+#endif
+	}
+	if (sock_mode == SOCKET_MODE_ZEROCOPY) {
+#if defined(HAVE_SOCK_ZEROCOPY)
+		if ((sock_domain != AF_INET) && (sock_domain != AF_INET6)) {
+			if (stress_instance_zero(args))
+				pr_inf_skip("%s: sock-mode zerocopy requires the ipv4 or ipv6 "
+					"domain, skipping stressor\n", args->name);
+			return EXIT_NOT_IMPLEMENTED;
+		}
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: sock-mode zerocopy requires MSG_ZEROCOPY and "
+				"error queue support, skipping stressor\n", args->name);
+		return EXIT_NOT_IMPLEMENTED;
+#endif
+	}
+
+	if (sock_mode == SOCKET_MODE_BUFSIZE) {
+#if defined(HAVE_SOCK_BUFSIZE)
+		if ((sock_domain != AF_INET) && (sock_domain != AF_INET6)) {
+			if (stress_instance_zero(args))
+				pr_inf_skip("%s: sock-mode bufsize requires the ipv4 or ipv6 "
+					"domain, skipping stressor\n", args->name);
+			return EXIT_NOT_IMPLEMENTED;
+		}
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: sock-mode bufsize requires TCP_INFO and "
+				"TCP_NOTSENT_LOWAT support, skipping stressor\n", args->name);
+		return EXIT_NOT_IMPLEMENTED;
+#endif
+	}
 
 #if !defined(MSG_ZEROCOPY)
 	if (sock_zerocopy)
@@ -1377,6 +2796,15 @@ static int stress_sock(stress_args_t *args)
 	}
 	stress_set_vma_anon_name(mmap_buffer, MMAP_BUF_SIZE, "io-buffer");
 
+	/* bufsize mode sender and receiver step through the configurations in lockstep */
+	if ((sock_mode == SOCKET_MODE_BUFSIZE) &&
+	    (socketpair(AF_UNIX, SOCK_STREAM, 0, bs_ctrl) < 0)) {
+		pr_fail("%s: socketpair failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		(void)munmap((void *)mmap_buffer, MMAP_BUF_SIZE);
+		return EXIT_FAILURE;
+	}
+
 	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
 	stress_sync_start_wait(args);
 	stress_set_proc_state(args->name, STRESS_STATE_RUN);
@@ -1398,20 +2826,75 @@ again:
 	} else if (pid == 0) {
 		(void)stress_change_cpu(args, parent_cpu);
 
+#if defined(HAVE_SOCK_BUFSIZE)
+		if (sock_mode == SOCKET_MODE_BUFSIZE) {
+			(void)close(bs_ctrl[1]);
+			rc = stress_sock_bs_receiver(args, mmap_buffer, mypid,
+				sock_domain, sock_type, sock_protocol,
+				sock_port, sock_if, bs_ctrl[0]);
+			(void)munmap((void *)mmap_buffer, MMAP_BUF_SIZE);
+			_exit(rc);
+		}
+#endif
+#if defined(HAVE_SOCK_ZEROCOPY)
+		if (sock_mode == SOCKET_MODE_ZEROCOPY) {
+			rc = stress_sock_zc_receiver(args, mmap_buffer, mypid,
+				sock_domain, sock_type, sock_protocol,
+				sock_port, sock_if);
+			(void)munmap((void *)mmap_buffer, MMAP_BUF_SIZE);
+			_exit(rc);
+		}
+#endif
+#if defined(HAVE_POLL_H)
+		if (sock_mode != SOCKET_MODE_STREAM) {
+			rc = stress_sock_rr_server(args, mmap_buffer, mypid,
+				sock_domain, sock_type, sock_protocol,
+				sock_port, sock_if, sock_rr_size, sock_rr_conns);
+			(void)munmap((void *)mmap_buffer, MMAP_BUF_SIZE);
+			_exit(rc);
+		}
+#endif
 		rc = stress_sock_client(args, mmap_buffer, mypid, sock_opts,
 			sock_domain, sock_type, sock_protocol,
 			sock_port, sock_if, rt, sock_zerocopy);
 		(void)munmap((void *)mmap_buffer, MMAP_BUF_SIZE);
 		_exit(rc);
 	} else {
-		rc = stress_sock_server(args, mmap_buffer, pid, mypid, sock_opts,
-			sock_domain, sock_type, sock_protocol,
-			sock_port, sock_if, rt, sock_zerocopy);
+#if defined(HAVE_SOCK_BUFSIZE)
+		if (sock_mode == SOCKET_MODE_BUFSIZE) {
+			(void)close(bs_ctrl[0]);
+			bs_ctrl[0] = -1;
+			rc = stress_sock_bs_sender(args, mmap_buffer, pid, mypid,
+				sock_domain, sock_type, sock_protocol,
+				sock_port, sock_if, bs_ctrl[1]);
+		} else
+#endif
+#if defined(HAVE_SOCK_ZEROCOPY)
+		if (sock_mode == SOCKET_MODE_ZEROCOPY)
+			rc = stress_sock_zc_sender(args, pid, mypid,
+				sock_domain, sock_type, sock_protocol,
+				sock_port, sock_if);
+		else
+#endif
+#if defined(HAVE_POLL_H)
+		if (sock_mode != SOCKET_MODE_STREAM)
+			rc = stress_sock_rr_client(args, mmap_buffer, pid, mypid,
+				sock_mode, sock_domain, sock_type, sock_protocol,
+				sock_port, sock_if, sock_rr_size, sock_rr_conns);
+		else
+#endif
+			rc = stress_sock_server(args, mmap_buffer, pid, mypid, sock_opts,
+				sock_domain, sock_type, sock_protocol,
+				sock_port, sock_if, rt, sock_zerocopy);
 		(void)munmap((void *)mmap_buffer, MMAP_BUF_SIZE);
 
 	}
 finish:
 	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	if (bs_ctrl[0] >= 0)
+		(void)close(bs_ctrl[0]);
+	if (bs_ctrl[1] >= 0)
+		(void)close(bs_ctrl[1]);
 	stress_net_release_ports(sock_port, sock_port);
 
 	return rc;
@@ -1429,6 +2912,11 @@ static const char *stress_sock_types(const size_t i)
 	return (i < SIZEOF_ARRAY(sock_options_types)) ? sock_options_types[i].optname : NULL;
 }
 
+static const char *stress_sock_modes(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(sock_options_modes)) ? sock_options_modes[i].optname : NULL;
+}
+
 static const char *stress_sock_protocols(const size_t i)
 {
 	return (i < SIZEOF_ARRAY(sock_options_protocols)) ? sock_options_protocols[i].optname : NULL;
@@ -1437,12 +2925,15 @@ static const char *stress_sock_protocols(const size_t i)
 static const stress_opt_t opts[] = {
 	{ OPT_sock_domain,   "sock-domain",   TYPE_ID_INT_DOMAIN, 0, 0, &sock_domain_mask },
 	{ OPT_sock_if,	     "sock-if",       TYPE_ID_STR, 0, 0, NULL },
+	{ OPT_sock_mode,     "sock-mode",     TYPE_ID_SIZE_T_METHOD, 0, 0, stress_sock_modes },
 	{ OPT_sock_msgs,     "sock-msgs",     TYPE_ID_SIZE_T, MIN_SOCKET_MSGS, MAX_SOCKET_MSGS, NULL },
 	{ OPT_sock_nodelay,  "sock-nodelay",  TYPE_ID_BOOL, 0, 1, NULL },
 	{ OPT_sock_opts,     "sock-opts",     TYPE_ID_SIZE_T_METHOD, 0, 0, stress_sock_opts },
 	{ OPT_sock_type,     "sock-type",     TYPE_ID_SIZE_T_METHOD, 0, 0, stress_sock_types },
 	{ OPT_sock_port,     "sock-port",     TYPE_ID_INT_PORT, MIN_PORT, MAX_PORT, NULL },
 	{ OPT_sock_protocol, "sock-protocol", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_sock_protocols },
+	{ OPT_sock_rr_conns, "sock-rr-conns", TYPE_ID_SIZE_T, MIN_SOCKET_RR_CONNS, MAX_SOCKET_RR_CONNS, NULL },
+	{ OPT_sock_rr_size,  "sock-rr-size",  TYPE_ID_SIZE_T_BYTES_VM, MIN_SOCKET_RR_SIZE, MAX_SOCKET_RR_SIZE, NULL },
 	{ OPT_sock_zerocopy, "sock-zerocopy", TYPE_ID_BOOL, 0, 1, NULL },
 	END_OPT,
 };
@@ -50,6 +50,17 @@ UNEXPECTED
 
 #define UDP_BUF			(1024)	/* UDP I/O buffer size */
 
+#define UDP_MODE_SENDTO		(0)	/* sendto/recvfrom of varying sizes */
+#define UDP_MODE_BULK		(1)	/* GSO/GRO and batching sweep */
+
+#define UDP_BULK_SLICE		(0.25)	/* seconds per bulk configuration */
+#define UDP_BULK_BUF_SIZE	(65536)	/* per message buffer size */
+#define UDP_BULK_GSO_PAYLOAD	(65000)	/* maximum GSO super-buffer payload */
+#define UDP_BULK_GSO_SEGS	(64)	/* maximum segments per GSO buffer */
+#define UDP_BULK_MAX_BATCH	(64)
+#define UDP_BULK_RCVBUF		(4 * MB)
+#define UDP_BULK_RCVTIMEO_USEC	(10000)
+
 /* See bugs section of udplite(7) */
 #if !defined(SOL_UDPLITE)
 #define SOL_UDPLITE		(136)
@@ -61,12 +72,49 @@ UNEXPECTED
 #define UDPLITE_RECV_CSCOV	(11)
 #endif
 
+#if defined(HAVE_SENDMMSG) &&	\
+    defined(HAVE_RECVMMSG) &&	\
+    defined(UDP_SEGMENT) &&	\
+    defined(UDP_GRO) &&		\
+    defined(MSG_WAITFORONE)
+#define HAVE_UDP_BULK
+
+static const size_t udp_bulk_seg_sizes[] = { 512, 1200, 1472 };
+static const size_t udp_bulk_batches[] = { 1, 8, UDP_BULK_MAX_BATCH };
+
+#define UDP_BULK_MAX_CONFIGS	(2 * SIZEOF_ARRAY(udp_bulk_seg_sizes) * SIZEOF_ARRAY(udp_bulk_batches))
+
+/*
+ *  per bulk configuration results
+ */
+typedef struct {
+	size_t seg_size;		/* datagram size */
+	size_t batch;			/* messages per sendmmsg/recvmmsg */
+	bool gso;			/* UDP_SEGMENT on send, UDP_GRO on receive */
+	bool unsupported;		/* configuration could not be used */
+	double duration;		/* sender time in this configuration */
+	uint64_t send_calls;		/* sendmmsg calls */
+	uint64_t recv_calls;		/* recvmmsg calls */
+	uint64_t packets;		/* datagrams received */
+	uint64_t bytes;			/* bytes received */
+} stress_udp_bulk_config_t;
+
+/*
+ *  bulk mode state shared between the sender and receiver
+ */
+typedef struct {
+	bool done;			/* sender has finished the time slice */
+	stress_udp_bulk_config_t configs[UDP_BULK_MAX_CONFIGS];
+} stress_udp_bulk_t;
+#endif
+
 static const stress_help_t help[] = {
 	{ NULL,	"udp N",	"start N workers performing UDP send/receives " },
 	{ NULL,	"udp-domain D",	"specify domain, default is ipv4" },
 	{ NULL, "udp-gro",	"enable UDP-GRO" },
 	{ NULL,	"udp-if I",	"use network interface I, e.g. lo, eth0, etc." },
 	{ NULL,	"udp-lite",	"use the UDP-Lite (RFC 3828) protocol" },
+	{ NULL,	"udp-mode M",	"UDP mode (sendto, bulk), default is sendto" },
 	{ NULL,	"udp-ops N",	"stop after N udp bogo operations" },
 	{ NULL,	"udp-port P",	"use ports P to P + number of workers - 1" },
 	{ NULL,	NULL,		NULL }
@@ -398,6 +446,398 @@ die:
 	return rc;
 }
 
+#if defined(HAVE_UDP_BULK)
+/*
+ *  stress_udp_bulk_init()
+ *	fill in the bulk sweep configurations, GSO off then on,
+ *	for each segment size and batch depth
+ */
+static size_t stress_udp_bulk_init(stress_udp_bulk_t *bulk)
+{
+	size_t gso, i, j, n = 0;
+
+	for (gso = 0; gso < 2; gso++) {
+		for (i = 0; i < SIZEOF_ARRAY(udp_bulk_seg_sizes); i++) {
+			for (j = 0; j < SIZEOF_ARRAY(udp_bulk_batches); j++) {
+				stress_udp_bulk_config_t *cfg = &bulk->configs[n++];
+
+				cfg->gso = (gso == 1);
+				cfg->seg_size = udp_bulk_seg_sizes[i];
+				cfg->batch = udp_bulk_batches[j];
+			}
+		}
+	}
+	return n;
+}
+
+/*
+ *  stress_udp_bulk_sender()
+ *	child process, for each configuration requested by the receiver
+ *	send batches of datagrams (or GSO super-buffers of segment sized
+ *	datagrams) with sendmmsg for a time slice
+ */
+static int stress_udp_bulk_sender(
+	stress_args_t *args,
+	const pid_t mypid,
+	const int udp_domain,
+	const int udp_port,
+	const char *udp_if,
+	const int ctrl_fd,
+	stress_udp_bulk_t *bulk)
+{
+	static struct mmsghdr msgs[UDP_BULK_MAX_BATCH];
+	static struct iovec iovs[UDP_BULK_MAX_BATCH];
+	struct sockaddr *addr = NULL;
+	socklen_t len;
+	uint8_t *buf;
+	uint32_t idx;
+	int fd, rc = EXIT_SUCCESS;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	buf = (uint8_t *)malloc(UDP_BULK_GSO_PAYLOAD);
+	if (!buf) {
+		rc = EXIT_NO_RESOURCE;
+		goto free_buf;
+	}
+	(void)shim_memset(buf, stress_mwc8(), UDP_BULK_GSO_PAYLOAD);
+
+	if ((fd = socket(udp_domain, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+		pr_fail("%s: socket failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto free_buf;
+	}
+	if ((stress_set_sockaddr_if(args->name, args->instance, mypid,
+			udp_domain, udp_port, udp_if,
+			&addr, &len, NET_ADDR_ANY) < 0) ||
+	    (connect(fd, addr, len) < 0)) {
+		rc = EXIT_NO_RESOURCE;
+		goto close_fd;
+	}
+
+	while (read(ctrl_fd, &idx, sizeof(idx)) == (ssize_t)sizeof(idx)) {
+		stress_udp_bulk_config_t *cfg = &bulk->configs[idx];
+		const int seg = cfg->gso ? (int)cfg->seg_size : 0;
+		const size_t segs = STRESS_MINIMUM((size_t)UDP_BULK_GSO_SEGS, UDP_BULK_GSO_PAYLOAD / cfg->seg_size);
+		const size_t msg_len = cfg->gso ? segs * cfg->seg_size : cfg->seg_size;
+		uint64_t calls = 0;
+		double t_start, t_end;
+		size_t i;
+
+		/* zero disables segmentation */
+		if (setsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &seg, sizeof(seg)) < 0) {
+			cfg->unsupported = true;
+			bulk->done = true;
+			continue;
+		}
+		for (i = 0; i < cfg->batch; i++) {
+			iovs[i].iov_base = buf;
+			iovs[i].iov_len = msg_len;
+			(void)shim_memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		t_start = stress_time_now();
+		t_end = t_start + UDP_BULK_SLICE;
+		do {
+			calls++;
+			if (UNLIKELY(sendmmsg(fd, msgs, (unsigned int)cfg->batch, 0) < 0)) {
+				/* receiver overrun or transient ICMP errors */
+				if ((errno == EAGAIN) || (errno == ENOBUFS) ||
+				    (errno == ECONNREFUSED) || (errno == EINTR))
+					continue;
+				/* e.g. EIO, GSO without checksum offload */
+				if (calls == 1) {
+					cfg->unsupported = true;
+					break;
+				}
+				pr_fail("%s: sendmmsg on port %d failed, errno=%d (%s)\n",
+					args->name, udp_port, errno, strerror(errno));
+				rc = EXIT_FAILURE;
+				goto close_fd;
+			}
+		} while (stress_continue_flag() && (stress_time_now() < t_end));
+		cfg->duration += stress_time_now() - t_start;
+		cfg->send_calls += calls;
+		bulk->done = true;
+	}
+close_fd:
+	(void)close(fd);
+free_buf:
+	free(buf);
+	/* never leave the receiver waiting on a slice that won't finish */
+	bulk->done = true;
+	return rc;
+}
+
+/*
+ *  stress_udp_bulk_receiver()
+ *	parent process, for each configuration enable or disable GRO,
+ *	tell the sender to start and receive with recvmmsg until the
+ *	sender has finished its time slice
+ */
+static int stress_udp_bulk_receiver(
+	stress_args_t *args,
+	const int fd,
+	const int ctrl_fd,
+	stress_udp_bulk_t *bulk,
+	const size_t n_configs)
+{
+	static struct mmsghdr msgs[UDP_BULK_MAX_BATCH];
+	static struct iovec iovs[UDP_BULK_MAX_BATCH];
+	static uint8_t cmsgs[UDP_BULK_MAX_BATCH][CMSG_SPACE(sizeof(int))];
+	uint8_t *bufs;
+	uint32_t idx = 0;
+	size_t i;
+	int rc = EXIT_SUCCESS;
+
+	bufs = (uint8_t *)stress_mmap_populate(NULL, UDP_BULK_MAX_BATCH * UDP_BULK_BUF_SIZE,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (bufs == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap receive buffers%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, stress_get_memfree_str(),
+			errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(bufs, UDP_BULK_MAX_BATCH * UDP_BULK_BUF_SIZE, "udp-bulk-buffers");
+	for (i = 0; i < UDP_BULK_MAX_BATCH; i++) {
+		iovs[i].iov_base = bufs + (i * UDP_BULK_BUF_SIZE);
+		iovs[i].iov_len = UDP_BULK_BUF_SIZE;
+	}
+
+	while (stress_continue(args)) {
+		stress_udp_bulk_config_t *cfg = &bulk->configs[idx];
+		const int gro = cfg->gso ? 1 : 0;
+		uint64_t calls = 0, packets = 0, bytes = 0;
+
+		if (cfg->unsupported)
+			goto next;
+		bulk->done = false;
+		/* GRO keeps GSO super-buffers intact on receive */
+		if (setsockopt(fd, IPPROTO_UDP, UDP_GRO, &gro, sizeof(gro)) < 0) {
+			cfg->unsupported = true;
+			goto next;
+		}
+		if (write(ctrl_fd, &idx, sizeof(idx)) != (ssize_t)sizeof(idx))
+			break;
+
+		for (;;) {
+			/* sample done before receiving so nothing sent is missed */
+			const bool finished = bulk->done;
+			int n;
+
+			for (i = 0; i < cfg->batch; i++) {
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+				msgs[i].msg_hdr.msg_control = cmsgs[i];
+				msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+				msgs[i].msg_hdr.msg_flags = 0;
+			}
+			n = recvmmsg(fd, msgs, (unsigned int)cfg->batch,
+				finished ? MSG_DONTWAIT : MSG_WAITFORONE, NULL);
+			if (n < 0) {
+				if (finished)
+					break;
+				if ((errno == EAGAIN) || (errno == EINTR)) {
+					if (!stress_continue_flag())
+						break;
+					continue;
+				}
+				pr_fail("%s: recvmmsg failed, errno=%d (%s)\n",
+					args->name, errno, strerror(errno));
+				rc = EXIT_FAILURE;
+				goto unmap;
+			}
+			calls++;
+			for (i = 0; i < (size_t)n; i++) {
+				const size_t msg_len = (size_t)msgs[i].msg_len;
+				struct cmsghdr *cmsg;
+				int gso_size = 0;
+
+				for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg;
+				     cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+					if ((cmsg->cmsg_level == IPPROTO_UDP) &&
+					    (cmsg->cmsg_type == UDP_GRO))
+						(void)shim_memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+				}
+				/* a coalesced buffer holds msg_len / gso_size datagrams */
+				packets += (gso_size > 0) ? (msg_len + (size_t)gso_size - 1) / (size_t)gso_size : 1;
+				bytes += msg_len;
+			}
+		}
+		cfg->recv_calls += calls;
+		cfg->packets += packets;
+		cfg->bytes += bytes;
+		stress_bogo_add(args, packets);
+next:
+		idx = (idx + 1) % (uint32_t)n_configs;
+	}
+unmap:
+	(void)munmap((void *)bufs, UDP_BULK_MAX_BATCH * UDP_BULK_BUF_SIZE);
+	return rc;
+}
+
+/*
+ *  stress_udp_bulk_metrics()
+ *	report packets/sec, MB/sec and syscalls per MB received
+ *	for each configuration
+ */
+static void stress_udp_bulk_metrics(
+	stress_args_t *args,
+	const stress_udp_bulk_t *bulk,
+	const size_t n_configs)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_configs; i++) {
+		const stress_udp_bulk_config_t *cfg = &bulk->configs[i];
+		const char *gso = cfg->gso ? "gso+gro" : "no-gso";
+		const double mb = (double)cfg->bytes / (double)MB;
+		char msg[64];
+
+		if (cfg->unsupported || (cfg->duration <= 0.0) || (cfg->bytes == 0))
+			continue;
+		(void)snprintf(msg, sizeof(msg), "packets/sec %zuB batch %zu %s",
+			cfg->seg_size, cfg->batch, gso);
+		stress_metrics_set(args, idx++, msg,
+			(double)cfg->packets / cfg->duration, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "MB/sec %zuB batch %zu %s",
+			cfg->seg_size, cfg->batch, gso);
+		stress_metrics_set(args, idx++, msg,
+			mb / cfg->duration, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "syscalls per MB %zuB batch %zu %s",
+			cfg->seg_size, cfg->batch, gso);
+		stress_metrics_set(args, idx++, msg,
+			(double)(cfg->send_calls + cfg->recv_calls) / mb,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+#endif
+
+/*
+ *  stress_udp_bulk()
+ *	sweep segment size, sendmmsg/recvmmsg batch depth and
+ *	UDP GSO/GRO on and off
+ */
+static int stress_udp_bulk(
+	stress_args_t *args,
+	const pid_t mypid,
+	const int udp_domain,
+	const int udp_port,
+	const char *udp_if)
+{
+#if defined(HAVE_UDP_BULK)
+	stress_udp_bulk_t *bulk;
+	struct sockaddr *addr = NULL;
+	socklen_t addr_len = 0;
+	struct timeval tv;
+	size_t n_configs;
+	int fd, ctrl[2], val, status = 0, rc = EXIT_FAILURE;
+	pid_t pid;
+
+	bulk = (stress_udp_bulk_t *)stress_mmap_populate(NULL, sizeof(*bulk),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (bulk == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for results%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, sizeof(*bulk),
+			stress_get_memfree_str(), errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(bulk, sizeof(*bulk), "udp-bulk-results");
+	n_configs = stress_udp_bulk_init(bulk);
+
+	if ((fd = socket(udp_domain, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+		pr_fail("%s: socket failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		goto unmap;
+	}
+	if (stress_set_sockaddr_if(args->name, args->instance, mypid,
+			udp_domain, udp_port, udp_if,
+			&addr, &addr_len, NET_ADDR_ANY) < 0)
+		goto close_fd;
+	val = 1;
+	(void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+	val = UDP_BULK_RCVBUF;
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &val, sizeof(val));
+	/* wake up periodically to check if the sender has finished */
+	tv.tv_sec = 0;
+	tv.tv_usec = UDP_BULK_RCVTIMEO_USEC;
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	if (bind(fd, addr, addr_len) < 0) {
+		pr_fail("%s: bind failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		goto close_fd;
+	}
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctrl) < 0) {
+		pr_inf_skip("%s: socketpair failed, errno=%d (%s), skipping stressor\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto close_fd;
+	}
+	/* a dead sender makes the control write fail rather than kill us */
+	if (stress_sighandler(args->name, SIGPIPE, SIG_IGN, NULL) < 0) {
+		rc = EXIT_NO_RESOURCE;
+		goto close_ctrl;
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+again:
+	pid = fork();
+	if (pid < 0) {
+		if (stress_redo_fork(args, errno))
+			goto again;
+		if (!stress_continue(args)) {
+			rc = EXIT_SUCCESS;
+			goto close_ctrl;
+		}
+		pr_fail("%s: fork failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		goto close_ctrl;
+	} else if (pid == 0) {
+		(void)close(fd);
+		(void)close(ctrl[1]);
+		_exit(stress_udp_bulk_sender(args, mypid, udp_domain, udp_port,
+			udp_if, ctrl[0], bulk));
+	}
+	/* only the sender reads, so its exit is seen as EPIPE on write */
+	(void)close(ctrl[0]);
+	ctrl[0] = -1;
+	rc = stress_udp_bulk_receiver(args, fd, ctrl[1], bulk, n_configs);
+	(void)stress_kill_pid_wait(pid, &status);
+	if (WIFEXITED(status) && (WEXITSTATUS(status) != EXIT_SUCCESS) &&
+	    (rc == EXIT_SUCCESS))
+		rc = WEXITSTATUS(status);
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_udp_bulk_metrics(args, bulk, n_configs);
+close_ctrl:
+	if (ctrl[0] >= 0)
+		(void)close(ctrl[0]);
+	(void)close(ctrl[1]);
+close_fd:
+	(void)close(fd);
+unmap:
+	(void)munmap((void *)bulk, sizeof(*bulk));
+	return rc;
+#else
+	(void)mypid;
+	(void)udp_domain;
+	(void)udp_port;
+	(void)udp_if;
+
+	if (stress_instance_zero(args))
+		pr_inf_skip("%s: udp-mode bulk requires sendmmsg, recvmmsg, "
+			"UDP_SEGMENT and UDP_GRO support, skipping stressor\n",
+			args->name);
+	return EXIT_NOT_IMPLEMENTED;
+#endif
+}
+
 /*
  *  stress_udp
  *	stress by heavy udp ops
@@ -414,6 +854,7 @@ static int stress_udp(stress_args_t *args)
 #endif
 	bool udp_gro = false;
 	char *udp_if = NULL;
+	size_t udp_mode = UDP_MODE_SENDTO;
 
 	if (stress_sigchld_set_handler(args) < 0)
 		return EXIT_NO_RESOURCE;
@@ -421,8 +862,17 @@ static int stress_udp(stress_args_t *args)
 	(void)stress_get_setting("udp-if", &udp_if);
 	(void)stress_get_setting("udp-port", &udp_port);
 	(void)stress_get_setting("udp-domain", &udp_domain);
+	(void)stress_get_setting("udp-mode", &udp_mode);
 #if defined(IPPROTO_UDPLITE)
 	(void)stress_get_setting("udp-lite", &udp_lite);
+	if (udp_lite && (udp_mode == UDP_MODE_BULK)) {
+		udp_lite = false;
+		if (stress_instance_zero(args)) {
+			pr_inf("%s: disabling UDP-Lite as it does not "
+				"support UDP GSO/GRO for udp-mode bulk\n",
+				args->name);
+		}
+	}
 
 	udp_proto = udp_lite ? IPPROTO_UDPLITE : IPPROTO_UDP;
 
@@ -463,6 +913,8 @@ static int stress_udp(stress_args_t *args)
 			udp_if = NULL;
 		}
 	}
+	if (udp_mode == UDP_MODE_BULK)
+		return stress_udp_bulk(args, mypid, udp_domain, udp_port, udp_if);
 
 	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
 	stress_sync_start_wait(args);
@@ -494,12 +946,23 @@ again:
 
 static int udp_domain_mask = DOMAIN_INET | DOMAIN_INET6;
 
+static const char *udp_modes[] = {
+	"sendto",	/* UDP_MODE_SENDTO */
+	"bulk",		/* UDP_MODE_BULK */
+};
+
+static const char *stress_udp_modes(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(udp_modes)) ? udp_modes[i] : NULL;
+}
+
 static const stress_opt_t opts[] = {
 	{ OPT_udp_domain, "udp-domain", TYPE_ID_INT_DOMAIN, 0, 0, &udp_domain_mask },
 	{ OPT_udp_port,   "udp-port",   TYPE_ID_INT_PORT, MIN_PORT, MAX_PORT, NULL },
 	{ OPT_udp_lite,   "udp-lite",   TYPE_ID_BOOL, 0, 1, NULL },
-	{ OPT_udp_gro,    "upd-gro",    TYPE_ID_BOOL, 0, 1, NULL },
+	{ OPT_udp_gro,    "udp-gro",    TYPE_ID_BOOL, 0, 1, NULL },
 	{ OPT_udp_if,     "udp-if",     TYPE_ID_STR, 0, 0, NULL },
+	{ OPT_udp_mode,   "udp-mode",   TYPE_ID_SIZE_T_METHOD, 0, 0, stress_udp_modes },
 	END_OPT,
 };
 
@@ -0,0 +1,649 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-killpid.h"
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#if defined(HAVE_SYS_UN_H)
+#include <sys/un.h>
+#endif
+
+#define UNIXIPC_SLICE		(0.25)	/* seconds per configuration */
+#define UNIXIPC_MAX_SIZE	(128 * KB)	/* largest payload */
+#define UNIXIPC_FD_MSG_SIZE	(8)	/* payload of fd passing messages */
+#define UNIXIPC_MAX_FDS		(253)	/* SCM_MAX_FD */
+#define UNIXIPC_SNDBUF		(1 * MB)
+#define UNIXIPC_RCVTIMEO_USEC	(10000)
+
+#define UNIXIPC_PHASE_STREAM	(0)	/* send messages as fast as possible */
+#define UNIXIPC_PHASE_PINGPONG	(1)	/* send a message, wait for an ack */
+
+static const stress_help_t help[] = {
+	{ NULL,	"unixipc N",		"start N workers measuring AF_UNIX message and fd passing costs" },
+	{ NULL,	"unixipc-ops N",	"stop after N messages" },
+	{ NULL,	"unixipc-type T",	"socket type: all, stream, seqpacket, dgram" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef struct {
+	const char *name;
+	const int type;
+} stress_unixipc_type_t;
+
+static const stress_unixipc_type_t stress_unixipc_types[] = {
+	{ "all",	-1 },
+#if defined(SOCK_STREAM)
+	{ "stream",	SOCK_STREAM },
+#endif
+#if defined(SOCK_SEQPACKET)
+	{ "seqpacket",	SOCK_SEQPACKET },
+#endif
+#if defined(SOCK_DGRAM)
+	{ "dgram",	SOCK_DGRAM },
+#endif
+};
+
+static const char *stress_unixipc_type(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_unixipc_types)) ? stress_unixipc_types[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_unixipc_type, "unixipc-type", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_unixipc_type },
+	END_OPT,
+};
+
+#if defined(AF_UNIX) &&		\
+    defined(SCM_RIGHTS) &&	\
+    defined(HAVE_SYS_UN_H)
+
+/* payload sizes and SCM_RIGHTS batches swept for each socket type */
+static const size_t stress_unixipc_sizes[] = { 64, 1 * KB, 16 * KB, UNIXIPC_MAX_SIZE };
+static const size_t stress_unixipc_fds[] = { 1, 8, 64, UNIXIPC_MAX_FDS };
+
+#define UNIXIPC_MAX_CONFIGS	\
+	(SIZEOF_ARRAY(stress_unixipc_types) * \
+	 (SIZEOF_ARRAY(stress_unixipc_sizes) + SIZEOF_ARRAY(stress_unixipc_fds)))
+
+/*
+ *  per configuration results
+ */
+typedef struct {
+	size_t type_idx;		/* index into stress_unixipc_types */
+	size_t size;			/* payload size */
+	size_t n_fds;			/* fds passed per message, 0 for none */
+	bool unsupported;		/* configuration could not be used */
+	double stream_duration;		/* time spent streaming */
+	uint64_t msgs;			/* messages streamed */
+	uint64_t bytes;			/* bytes streamed */
+	double pingpong_duration;	/* time spent in ping-pong */
+	uint64_t round_trips;		/* message + ack round trips */
+} stress_unixipc_config_t;
+
+/*
+ *  state shared between the sender and the receiver
+ */
+typedef struct {
+	uint64_t total;			/* bytes sent in the stream phase */
+	bool done;			/* sender has finished the phase */
+	stress_unixipc_config_t configs[UNIXIPC_MAX_CONFIGS];
+} stress_unixipc_t;
+
+/*
+ *  phase request from the sender to the receiver
+ */
+typedef struct {
+	uint32_t phase;
+	uint32_t config;
+} stress_unixipc_cmd_t;
+
+/*
+ *  message buffers
+ */
+typedef struct {
+	uint8_t *buf;			/* payload, UNIXIPC_MAX_SIZE bytes */
+	int *fds;			/* fds to be sent */
+	uint8_t *cbuf;			/* control message buffer */
+	size_t cbuf_size;
+} stress_unixipc_bufs_t;
+
+/*
+ *  stress_unixipc_send()
+ *	send one message, with n_fds fds if non-zero,
+ *	returns bytes sent or -1 with errno set
+ */
+static ssize_t stress_unixipc_send(
+	const int fd,
+	const stress_unixipc_config_t *cfg,
+	const stress_unixipc_bufs_t *bufs)
+{
+	struct msghdr msg;
+	struct iovec iov;
+
+	iov.iov_base = bufs->buf;
+	iov.iov_len = cfg->size;
+	(void)shim_memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	if (cfg->n_fds > 0) {
+		struct cmsghdr *cmsg;
+
+		msg.msg_control = bufs->cbuf;
+		msg.msg_controllen = CMSG_SPACE(cfg->n_fds * sizeof(int));
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(cfg->n_fds * sizeof(int));
+		(void)shim_memcpy(CMSG_DATA(cmsg), bufs->fds, cfg->n_fds * sizeof(int));
+	}
+	return sendmsg(fd, &msg, 0);
+}
+
+/*
+ *  stress_unixipc_recv()
+ *	receive up to len bytes and close any fds that are passed,
+ *	returns bytes received or -1 with errno set
+ */
+static ssize_t stress_unixipc_recv(
+	const int fd,
+	const size_t len,
+	const stress_unixipc_bufs_t *bufs)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	ssize_t ret;
+
+	iov.iov_base = bufs->buf;
+	iov.iov_len = len;
+	(void)shim_memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = bufs->cbuf;
+	msg.msg_controllen = bufs->cbuf_size;
+
+	ret = recvmsg(fd, &msg, 0);
+	if (ret <= 0)
+		return ret;
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS)) {
+			const size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			const int *fds = (const int *)CMSG_DATA(cmsg);
+			size_t i;
+
+			for (i = 0; i < n; i++)
+				(void)close(fds[i]);
+		}
+	}
+	return ret;
+}
+
+/*
+ *  stress_unixipc_transient()
+ *	true if a send or receive error is a retryable one,
+ *	ETOOMANYREFS occurs when too many passed fds are in flight
+ */
+static inline bool stress_unixipc_transient(const int err)
+{
+	switch (err) {
+	case EAGAIN:
+	case ENOBUFS:
+#if defined(ETOOMANYREFS)
+	case ETOOMANYREFS:
+#endif
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+/*
+ *  stress_unixipc_receiver()
+ *	child process, drain the stream phase messages, or
+ *	acknowledge each ping-pong phase message
+ */
+static int stress_unixipc_receiver(
+	stress_args_t *args,
+	const int *sfds,
+	const int ctrl_fd,
+	stress_unixipc_t *ipc,
+	const stress_unixipc_bufs_t *bufs)
+{
+	stress_unixipc_cmd_t cmd;
+	const char *op = "recvmsg";
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	while (read(ctrl_fd, &cmd, sizeof(cmd)) == (ssize_t)sizeof(cmd)) {
+		const stress_unixipc_config_t *cfg = &ipc->configs[cmd.config];
+		const int fd = sfds[cfg->type_idx];
+
+		if (cmd.phase == UNIXIPC_PHASE_STREAM) {
+			uint64_t received = 0;
+
+			while (stress_continue_flag()) {
+				ssize_t n;
+
+				/* done is sampled first so that total is valid */
+				if (ipc->done) {
+					stress_asm_mb();
+					if (received >= ipc->total)
+						break;
+				}
+				n = stress_unixipc_recv(fd, UNIXIPC_MAX_SIZE, bufs);
+				if (n > 0)
+					received += (uint64_t)n;
+				else if ((n < 0) && (errno != EINTR) && !stress_unixipc_transient(errno))
+					goto err;
+			}
+		} else {
+			const uint8_t ack = 0;
+
+			while (stress_continue_flag()) {
+				size_t got = 0;
+
+				while (got < cfg->size) {
+					const ssize_t n = stress_unixipc_recv(fd, cfg->size - got, bufs);
+
+					if (n > 0) {
+						got += (size_t)n;
+					} else if ((n < 0) && ((errno == EINTR) || stress_unixipc_transient(errno))) {
+						if (ipc->done && (got == 0))
+							goto acked;
+						if (!stress_continue_flag())
+							goto acked;
+					} else if (n == 0) {
+						pr_fail("%s: recvmsg got an unexpected end of file\n",
+							args->name);
+						return EXIT_FAILURE;
+					} else {
+						goto err;
+					}
+				}
+				if (send(fd, &ack, sizeof(ack), 0) < 0) {
+					op = "send";
+					goto err;
+				}
+			}
+		}
+acked:
+		if (write(ctrl_fd, &cmd, sizeof(cmd)) != (ssize_t)sizeof(cmd))
+			break;
+	}
+	return EXIT_SUCCESS;
+err:
+	pr_fail("%s: %s failed, errno=%d (%s)\n",
+		args->name, op, errno, strerror(errno));
+	return EXIT_FAILURE;
+}
+
+/*
+ *  stress_unixipc_sender()
+ *	parent process, for each configuration stream messages for half
+ *	the time slice then send messages and wait for the receiver's
+ *	ack for the other half
+ */
+static int stress_unixipc_sender(
+	stress_args_t *args,
+	const int *cfds,
+	const int ctrl_fd,
+	stress_unixipc_t *ipc,
+	const size_t n_configs,
+	const stress_unixipc_bufs_t *bufs)
+{
+	uint32_t idx = 0;
+
+	while (stress_continue(args)) {
+		stress_unixipc_config_t *cfg = &ipc->configs[idx];
+		const int fd = cfds[cfg->type_idx];
+		stress_unixipc_cmd_t cmd;
+		uint64_t msgs = 0, bytes = 0;
+		double t_start, t_end;
+
+		if (cfg->unsupported)
+			goto next;
+
+		ipc->total = 0;
+		ipc->done = false;
+		cmd.phase = UNIXIPC_PHASE_STREAM;
+		cmd.config = idx;
+		if (write(ctrl_fd, &cmd, sizeof(cmd)) != (ssize_t)sizeof(cmd))
+			return EXIT_FAILURE;
+		t_start = stress_time_now();
+		t_end = t_start + (UNIXIPC_SLICE / 2.0);
+		do {
+			const ssize_t n = stress_unixipc_send(fd, cfg, bufs);
+
+			if (LIKELY(n > 0)) {
+				bytes += (uint64_t)n;
+				msgs++;
+			} else if (n < 0) {
+				if (errno == EINTR)
+					break;
+				if (stress_unixipc_transient(errno)) {
+					/* wait for the receiver to close the passed fds */
+					(void)shim_usleep(100);
+					continue;
+				}
+				if ((errno == EMSGSIZE) && (msgs == 0)) {
+					if (stress_instance_zero(args))
+						pr_inf("%s: %s %zu byte messages are too large, skipping them\n",
+							args->name, stress_unixipc_types[cfg->type_idx].name,
+							cfg->size);
+					cfg->unsupported = true;
+					break;
+				}
+				pr_fail("%s: sendmsg failed, errno=%d (%s)\n",
+					args->name, errno, strerror(errno));
+				ipc->done = true;
+				return EXIT_FAILURE;
+			}
+		} while (stress_continue_flag() && (stress_time_now() < t_end));
+		ipc->total = bytes;
+		stress_asm_mb();
+		ipc->done = true;
+		if (read(ctrl_fd, &cmd, sizeof(cmd)) != (ssize_t)sizeof(cmd))
+			break;
+		cfg->stream_duration += stress_time_now() - t_start;
+		cfg->msgs += msgs;
+		cfg->bytes += bytes;
+		stress_bogo_add(args, msgs);
+		if (cfg->unsupported || !stress_continue(args))
+			goto next;
+
+		ipc->done = false;
+		cmd.phase = UNIXIPC_PHASE_PINGPONG;
+		if (write(ctrl_fd, &cmd, sizeof(cmd)) != (ssize_t)sizeof(cmd))
+			return EXIT_FAILURE;
+		msgs = 0;
+		t_start = stress_time_now();
+		t_end = t_start + (UNIXIPC_SLICE / 2.0);
+		do {
+			uint8_t ack;
+
+			if (stress_unixipc_send(fd, cfg, bufs) < 0) {
+				if (stress_unixipc_transient(errno)) {
+					(void)shim_usleep(100);
+					continue;
+				}
+				break;
+			}
+			if (recv(fd, &ack, sizeof(ack), 0) != (ssize_t)sizeof(ack))
+				break;
+			msgs++;
+		} while (stress_continue_flag() && (stress_time_now() < t_end));
+		cfg->pingpong_duration += stress_time_now() - t_start;
+		cfg->round_trips += msgs;
+		stress_bogo_add(args, msgs);
+		ipc->done = true;
+		if (read(ctrl_fd, &cmd, sizeof(cmd)) != (ssize_t)sizeof(cmd))
+			break;
+next:
+		idx = (idx + 1) % (uint32_t)n_configs;
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_unixipc_metrics()
+ *	report msgs/sec, MB/sec or fds/sec and round trip latency
+ *	for each configuration
+ */
+static void stress_unixipc_metrics(
+	stress_args_t *args,
+	const stress_unixipc_t *ipc,
+	const size_t n_configs)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_configs; i++) {
+		const stress_unixipc_config_t *cfg = &ipc->configs[i];
+		const char *name = stress_unixipc_types[cfg->type_idx].name;
+		char what[32], msg[64];
+
+		if (cfg->unsupported || (cfg->stream_duration <= 0.0) || (cfg->msgs == 0))
+			continue;
+		if (cfg->n_fds > 0)
+			(void)snprintf(what, sizeof(what), "%s %zu fds", name, cfg->n_fds);
+		else
+			(void)snprintf(what, sizeof(what), "%s %zuB", name, cfg->size);
+
+		(void)snprintf(msg, sizeof(msg), "msgs/sec %s", what);
+		stress_metrics_set(args, idx++, msg,
+			(double)cfg->msgs / cfg->stream_duration, STRESS_METRIC_HARMONIC_MEAN);
+		if (cfg->n_fds > 0) {
+			(void)snprintf(msg, sizeof(msg), "fds/sec %s", what);
+			stress_metrics_set(args, idx++, msg,
+				(double)(cfg->msgs * cfg->n_fds) / cfg->stream_duration,
+				STRESS_METRIC_HARMONIC_MEAN);
+		} else {
+			(void)snprintf(msg, sizeof(msg), "MB/sec %s", what);
+			stress_metrics_set(args, idx++, msg,
+				((double)cfg->bytes / (double)MB) / cfg->stream_duration,
+				STRESS_METRIC_HARMONIC_MEAN);
+		}
+		if (cfg->round_trips > 0) {
+			(void)snprintf(msg, sizeof(msg), "usec round trip %s", what);
+			stress_metrics_set(args, idx++, msg,
+				STRESS_DBL_MICROSECOND * cfg->pingpong_duration / (double)cfg->round_trips,
+				STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_unixipc
+ *	stress AF_UNIX stream, seqpacket and dgram messaging with
+ *	a sweep of payload sizes and SCM_RIGHTS fd batches
+ */
+static int stress_unixipc(stress_args_t *args)
+{
+	size_t unixipc_type = 0;
+	size_t i, j, n_configs = 0;
+	int cfds[SIZEOF_ARRAY(stress_unixipc_types)];
+	int sfds[SIZEOF_ARRAY(stress_unixipc_types)];
+	int ctrl[2], null_fd, status = 0, rc = EXIT_NO_RESOURCE;
+	stress_unixipc_bufs_t bufs;
+	stress_unixipc_t *ipc;
+	struct timeval tv;
+	pid_t pid;
+#if defined(RLIMIT_NOFILE)
+	struct rlimit rlim;
+#endif
+
+	(void)stress_get_setting("unixipc-type", &unixipc_type);
+
+#if defined(RLIMIT_NOFILE)
+	/* passed fds in flight count against the file limit */
+	if (getrlimit(RLIMIT_NOFILE, &rlim) == 0) {
+		rlim.rlim_cur = rlim.rlim_max;
+		(void)setrlimit(RLIMIT_NOFILE, &rlim);
+	}
+#endif
+	if (stress_get_max_file_limit() < 4 * UNIXIPC_MAX_FDS) {
+		pr_inf_skip("%s: file descriptor limit of %zu is too low, skipping stressor\n",
+			args->name, stress_get_max_file_limit());
+		return EXIT_NO_RESOURCE;
+	}
+
+	ipc = (stress_unixipc_t *)stress_mmap_populate(NULL, sizeof(*ipc),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (ipc == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for results%s, errno=%d (%s), "
+			"skipping stressor\n", args->name, sizeof(*ipc),
+			stress_get_memfree_str(), errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(ipc, sizeof(*ipc), "unixipc-results");
+
+	bufs.cbuf_size = CMSG_SPACE(UNIXIPC_MAX_FDS * sizeof(int));
+	bufs.buf = (uint8_t *)malloc(UNIXIPC_MAX_SIZE);
+	bufs.fds = (int *)calloc(UNIXIPC_MAX_FDS, sizeof(*bufs.fds));
+	bufs.cbuf = (uint8_t *)calloc(1, bufs.cbuf_size);
+	if (!bufs.buf || !bufs.fds || !bufs.cbuf) {
+		pr_inf_skip("%s: cannot allocate message buffers%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		goto free_bufs;
+	}
+	(void)shim_memset(bufs.buf, stress_mwc8(), UNIXIPC_MAX_SIZE);
+
+	/* the same fd may be passed many times in one message */
+	null_fd = open("/dev/null", O_RDWR);
+	if (null_fd < 0) {
+		pr_inf_skip("%s: cannot open /dev/null, errno=%d (%s), skipping stressor\n",
+			args->name, errno, strerror(errno));
+		goto free_bufs;
+	}
+	for (i = 0; i < UNIXIPC_MAX_FDS; i++)
+		bufs.fds[i] = null_fd;
+
+	tv.tv_sec = 0;
+	tv.tv_usec = UNIXIPC_RCVTIMEO_USEC;
+	for (i = 0; i < SIZEOF_ARRAY(stress_unixipc_types); i++) {
+		int sv[2], val = UNIXIPC_SNDBUF;
+
+		cfds[i] = -1;
+		sfds[i] = -1;
+		if (stress_unixipc_types[i].type < 0)
+			continue;
+		if ((unixipc_type != 0) && (unixipc_type != i))
+			continue;
+		if (socketpair(AF_UNIX, stress_unixipc_types[i].type, 0, sv) < 0) {
+			if (stress_instance_zero(args))
+				pr_inf("%s: cannot create %s socket pair, errno=%d (%s), "
+					"skipping it\n", args->name, stress_unixipc_types[i].name,
+					errno, strerror(errno));
+			continue;
+		}
+		cfds[i] = sv[0];
+		sfds[i] = sv[1];
+		/* allow the largest seqpacket and dgram messages */
+		(void)setsockopt(cfds[i], SOL_SOCKET, SO_SNDBUF, &val, sizeof(val));
+		(void)setsockopt(sfds[i], SOL_SOCKET, SO_RCVBUF, &val, sizeof(val));
+		/* the receiver wakes periodically to check for the phase end */
+		(void)setsockopt(sfds[i], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+		for (j = 0; j < SIZEOF_ARRAY(stress_unixipc_sizes); j++) {
+			stress_unixipc_config_t *cfg = &ipc->configs[n_configs++];
+
+			cfg->type_idx = i;
+			cfg->size = stress_unixipc_sizes[j];
+		}
+		for (j = 0; j < SIZEOF_ARRAY(stress_unixipc_fds); j++) {
+			stress_unixipc_config_t *cfg = &ipc->configs[n_configs++];
+
+			cfg->type_idx = i;
+			cfg->size = UNIXIPC_FD_MSG_SIZE;
+			cfg->n_fds = stress_unixipc_fds[j];
+		}
+	}
+	if (n_configs == 0) {
+		pr_inf_skip("%s: no AF_UNIX socket types can be used, skipping stressor\n",
+			args->name);
+		goto close_fds;
+	}
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctrl) < 0) {
+		pr_inf_skip("%s: socketpair failed, errno=%d (%s), skipping stressor\n",
+			args->name, errno, strerror(errno));
+		goto close_fds;
+	}
+	/* a dead receiver makes sends and writes fail rather than kill us */
+	if (stress_sighandler(args->name, SIGPIPE, SIG_IGN, NULL) < 0)
+		goto close_ctrl;
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+again:
+	pid = fork();
+	if (pid < 0) {
+		if (stress_redo_fork(args, errno))
+			goto again;
+		if (!stress_continue(args)) {
+			rc = EXIT_SUCCESS;
+			goto close_ctrl;
+		}
+		pr_fail("%s: fork failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_FAILURE;
+		goto close_ctrl;
+	} else if (pid == 0) {
+		(void)close(ctrl[1]);
+		_exit(stress_unixipc_receiver(args, sfds, ctrl[0], ipc, &bufs));
+	}
+	/*
+	 *  only the receiver uses these, so if it exits the sender
+	 *  sees EOF or EPIPE instead of blocking forever
+	 */
+	(void)close(ctrl[0]);
+	ctrl[0] = -1;
+	for (i = 0; i < SIZEOF_ARRAY(stress_unixipc_types); i++) {
+		if (sfds[i] >= 0) {
+			(void)close(sfds[i]);
+			sfds[i] = -1;
+		}
+	}
+	rc = stress_unixipc_sender(args, cfds, ctrl[1], ipc, n_configs, &bufs);
+	(void)stress_kill_pid_wait(pid, &status);
+	if (WIFEXITED(status) && (WEXITSTATUS(status) != EXIT_SUCCESS))
+		rc = EXIT_FAILURE;
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_unixipc_metrics(args, ipc, n_configs);
+close_ctrl:
+	if (ctrl[0] >= 0)
+		(void)close(ctrl[0]);
+	(void)close(ctrl[1]);
+close_fds:
+	for (i = 0; i < SIZEOF_ARRAY(stress_unixipc_types); i++) {
+		if (cfds[i] >= 0)
+			(void)close(cfds[i]);
+		if (sfds[i] >= 0)
+			(void)close(sfds[i]);
+	}
+	(void)close(null_fd);
+free_bufs:
+	free(bufs.cbuf);
+	free(bufs.fds);
+	free(bufs.buf);
+	(void)munmap((void *)ipc, sizeof(*ipc));
+
+	return rc;
+}
+
+const stressor_info_t stress_unixipc_info = {
+	.stressor = stress_unixipc,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_unixipc_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_NETWORK | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without AF_UNIX or SCM_RIGHTS support"
+};
+#endif
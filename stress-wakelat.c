@@ -0,0 +1,910 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-affinity.h"
+#include "core-builtin.h"
+#include "core-cpu-cache.h"
+#include "core-io-uring.h"
+#include "core-pthread.h"
+#include "io-uring.h"
+
+#if defined(HAVE_LINUX_FUTEX_H)
+#include <linux/futex.h>
+#endif
+
+#if defined(HAVE_SEMAPHORE_H)
+#include <semaphore.h>
+#endif
+
+#if defined(HAVE_SYS_EVENTFD_H)
+#include <sys/eventfd.h>
+#endif
+
+#define WAKELAT_SLICE_NS	(100000000ULL)	/* 0.1 seconds per configuration */
+#define WAKELAT_SAMPLES		(4096)		/* latency samples per direction */
+#define WAKELAT_RING_ENTRIES	(8)		/* io_uring ring size */
+#define WAKELAT_MSG_TAG		(0x57414b45ULL)	/* msg_ring user_data */
+
+#define WAKELAT_PLACEMENT_ALL		(0)
+#define WAKELAT_PLACEMENT_SAME_CORE	(1)
+#define WAKELAT_PLACEMENT_SIBLING	(2)
+#define WAKELAT_PLACEMENT_SAME_LLC	(3)
+#define WAKELAT_PLACEMENT_CROSS_SOCKET	(4)
+#define WAKELAT_PLACEMENT_UNPINNED	(5)
+
+static const stress_help_t help[] = {
+	{ NULL,	"wakelat N",		"start N workers measuring thread wake-up latency" },
+	{ NULL,	"wakelat-method M",	"wake mechanism: all, futex, eventfd, pipe, sem, yield, msg-ring" },
+	{ NULL,	"wakelat-ops N",	"stop after N wake-ups" },
+	{ NULL,	"wakelat-placement P",	"placement: all, same-core, sibling, same-llc, cross-socket, unpinned" },
+	{ NULL,	NULL,			NULL }
+};
+
+static const char * const stress_wakelat_placements[] = {
+	"all",
+	"same-core",
+	"sibling",
+	"same-llc",
+	"cross-socket",
+	"unpinned",
+};
+
+static const char *stress_wakelat_placement(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_wakelat_placements)) ? stress_wakelat_placements[i] : NULL;
+}
+
+#if defined(HAVE_LIB_PTHREAD) &&	\
+    defined(HAVE_ATOMIC_ADD_FETCH) &&	\
+    defined(HAVE_ATOMIC_LOAD) &&	\
+    defined(HAVE_ATOMIC_STORE)
+
+#define HAVE_WAKELAT
+
+#if defined(HAVE_STRESS_IO_URING_RING) &&	\
+    defined(HAVE_IORING_OP_MSG_RING)
+#define HAVE_WAKELAT_MSG_RING
+#endif
+
+/*
+ *  latency samples for one direction of a configuration, a
+ *  reservoir sample over all the runs of the configuration
+ */
+typedef struct {
+	double samples[WAKELAT_SAMPLES];	/* wake latencies (seconds) */
+	uint64_t seen;				/* number of wake-ups */
+} stress_wakelat_reservoir_t;
+
+struct stress_wakelat_context;
+
+/*
+ *  per thread state, the thread waits on the mechanisms in here
+ *  and the peer stamps the time and signals it
+ */
+typedef struct {
+	uint32_t futex ALIGN64;			/* futex and yield wake word */
+	uint64_t stamp;				/* time the peer signalled (ns) */
+	struct stress_wakelat_context *ctx;
+	stress_wakelat_reservoir_t *reservoir;
+	pthread_t pthread;
+	int side;				/* 0 = pinger, 1 = ponger */
+	int cpu;				/* CPU to pin to, -1 = none */
+	uint32_t rnd;				/* reservoir sampling LCG */
+	uint32_t seen;				/* last futex/yield value seen */
+	int efd;				/* eventfd */
+	int pipefds[2];				/* pipe */
+#if defined(HAVE_SEMAPHORE_H) &&	\
+    defined(HAVE_SEM_POSIX)
+	sem_t sem;				/* POSIX semaphore */
+#endif
+#if defined(HAVE_WAKELAT_MSG_RING)
+	stress_io_uring_ring_t ring;		/* io_uring for msg_ring */
+#endif
+	int err;				/* errno of a failed wait or signal */
+} stress_wakelat_thread_t;
+
+typedef struct {
+	const char *name;
+	int (*init)(stress_wakelat_thread_t *thread);
+	void (*deinit)(stress_wakelat_thread_t *thread);
+	int (*signal)(stress_wakelat_thread_t *self, stress_wakelat_thread_t *peer);
+	int (*wait)(stress_wakelat_thread_t *self);
+} stress_wakelat_method_t;
+
+typedef struct stress_wakelat_context {
+	const stress_wakelat_method_t *method;
+	stress_wakelat_thread_t threads[2];
+	bool go;				/* start ping-pong */
+	bool stop;				/* stop ping-pong */
+} stress_wakelat_context_t;
+
+/*
+ *  results for a method and placement
+ */
+typedef struct {
+	const stress_wakelat_method_t *method;
+	size_t placement;
+	int cpus[2];				/* CPUs for the pinger and ponger */
+	bool skipped;
+	double duration;
+	stress_wakelat_reservoir_t reservoir[2];
+} stress_wakelat_result_t;
+
+#if defined(HAVE_LINUX_FUTEX_H) &&	\
+    defined(__NR_futex)
+/*
+ *  futex, the peer bumps the wake word and wakes the waiter
+ */
+static int stress_wakelat_futex_init(stress_wakelat_thread_t *thread)
+{
+	thread->futex = 0;
+	thread->seen = 0;
+	return 0;
+}
+
+static void stress_wakelat_futex_deinit(stress_wakelat_thread_t *thread)
+{
+	(void)thread;
+}
+
+static int stress_wakelat_futex_signal(
+	stress_wakelat_thread_t *self,
+	stress_wakelat_thread_t *peer)
+{
+	(void)self;
+
+	(void)__atomic_add_fetch(&peer->futex, 1, __ATOMIC_RELEASE);
+	if (shim_futex_wake(&peer->futex, 1) < 0)
+		return -1;
+	return 0;
+}
+
+static int stress_wakelat_futex_wait(stress_wakelat_thread_t *self)
+{
+	for (;;) {
+		const uint32_t val = __atomic_load_n(&self->futex, __ATOMIC_ACQUIRE);
+
+		if (val != self->seen) {
+			self->seen = val;
+			return 0;
+		}
+		if ((shim_futex_wait(&self->futex, (int)val, NULL) < 0) &&
+		    (errno != EAGAIN) && (errno != EINTR))
+			return -1;
+	}
+}
+#endif
+
+#if defined(HAVE_SYS_EVENTFD_H) &&	\
+    defined(HAVE_EVENTFD)
+/*
+ *  eventfd, blocking read until the peer writes a count
+ */
+static int stress_wakelat_eventfd_init(stress_wakelat_thread_t *thread)
+{
+	thread->efd = eventfd(0, 0);
+	return (thread->efd < 0) ? -1 : 0;
+}
+
+static void stress_wakelat_eventfd_deinit(stress_wakelat_thread_t *thread)
+{
+	if (thread->efd >= 0) {
+		(void)close(thread->efd);
+		thread->efd = -1;
+	}
+}
+
+static int stress_wakelat_eventfd_signal(
+	stress_wakelat_thread_t *self,
+	stress_wakelat_thread_t *peer)
+{
+	const uint64_t val = 1;
+
+	(void)self;
+
+	return (write(peer->efd, &val, sizeof(val)) == (ssize_t)sizeof(val)) ? 0 : -1;
+}
+
+static int stress_wakelat_eventfd_wait(stress_wakelat_thread_t *self)
+{
+	uint64_t val;
+
+	for (;;) {
+		if (read(self->efd, &val, sizeof(val)) == (ssize_t)sizeof(val))
+			return 0;
+		if (errno != EINTR)
+			return -1;
+	}
+}
+#endif
+
+/*
+ *  pipe, blocking read of a byte written by the peer
+ */
+static int stress_wakelat_pipe_init(stress_wakelat_thread_t *thread)
+{
+	return pipe(thread->pipefds);
+}
+
+static void stress_wakelat_pipe_deinit(stress_wakelat_thread_t *thread)
+{
+	if (thread->pipefds[0] >= 0) {
+		(void)close(thread->pipefds[0]);
+		(void)close(thread->pipefds[1]);
+		thread->pipefds[0] = -1;
+		thread->pipefds[1] = -1;
+	}
+}
+
+static int stress_wakelat_pipe_signal(
+	stress_wakelat_thread_t *self,
+	stress_wakelat_thread_t *peer)
+{
+	const char ch = 'w';
+
+	(void)self;
+
+	return (write(peer->pipefds[1], &ch, sizeof(ch)) == (ssize_t)sizeof(ch)) ? 0 : -1;
+}
+
+static int stress_wakelat_pipe_wait(stress_wakelat_thread_t *self)
+{
+	char ch;
+
+	for (;;) {
+		if (read(self->pipefds[0], &ch, sizeof(ch)) == (ssize_t)sizeof(ch))
+			return 0;
+		if (errno != EINTR)
+			return -1;
+	}
+}
+
+#if defined(HAVE_SEMAPHORE_H) &&	\
+    defined(HAVE_SEM_POSIX)
+/*
+ *  POSIX semaphore, the peer posts and the waiter waits
+ */
+static int stress_wakelat_sem_init(stress_wakelat_thread_t *thread)
+{
+	return sem_init(&thread->sem, 0, 0);
+}
+
+static void stress_wakelat_sem_deinit(stress_wakelat_thread_t *thread)
+{
+	(void)sem_destroy(&thread->sem);
+}
+
+static int stress_wakelat_sem_signal(
+	stress_wakelat_thread_t *self,
+	stress_wakelat_thread_t *peer)
+{
+	(void)self;
+
+	return sem_post(&peer->sem);
+}
+
+static int stress_wakelat_sem_wait(stress_wakelat_thread_t *self)
+{
+	for (;;) {
+		if (sem_wait(&self->sem) == 0)
+			return 0;
+		if (errno != EINTR)
+			return -1;
+	}
+}
+#endif
+
+/*
+ *  sched_yield, the waiter yields until the peer bumps the wake word
+ */
+static int stress_wakelat_yield_signal(
+	stress_wakelat_thread_t *self,
+	stress_wakelat_thread_t *peer)
+{
+	(void)self;
+
+	(void)__atomic_add_fetch(&peer->futex, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+static int stress_wakelat_yield_wait(stress_wakelat_thread_t *self)
+{
+	for (;;) {
+		const uint32_t val = __atomic_load_n(&self->futex, __ATOMIC_ACQUIRE);
+
+		if (val != self->seen) {
+			self->seen = val;
+			return 0;
+		}
+		(void)shim_sched_yield();
+	}
+}
+
+#if defined(HAVE_WAKELAT_MSG_RING)
+/*
+ *  io_uring msg_ring, the peer submits a IORING_OP_MSG_RING on its own
+ *  ring that posts a completion on the waiter's ring
+ */
+static int stress_wakelat_msg_ring_init(stress_wakelat_thread_t *thread)
+{
+	struct io_uring_params p;
+	int ret;
+
+	(void)shim_memset(&p, 0, sizeof(p));
+	ret = stress_io_uring_ring_setup(&thread->ring, WAKELAT_RING_ENTRIES, &p);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+	return 0;
+}
+
+static void stress_wakelat_msg_ring_deinit(stress_wakelat_thread_t *thread)
+{
+	if (thread->ring.fd >= 0)
+		stress_io_uring_ring_close(&thread->ring);
+}
+
+/*
+ *  stress_wakelat_msg_ring_reap()
+ *	consume the completions, returns true if a message arrived
+ */
+static bool stress_wakelat_msg_ring_reap(stress_io_uring_ring_t *ring)
+{
+	unsigned head = *ring->cq_head;
+	bool got = false;
+
+	while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+		const struct io_uring_cqe *cqe =
+			&ring->cqes[head & *ring->cq_mask];
+
+		if (cqe->user_data == WAKELAT_MSG_TAG)
+			got = true;
+		head++;
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+	return got;
+}
+
+static int stress_wakelat_msg_ring_signal(
+	stress_wakelat_thread_t *self,
+	stress_wakelat_thread_t *peer)
+{
+	stress_io_uring_ring_t *ring = &self->ring;
+	const unsigned tail = *ring->sq_tail;
+	const unsigned idx = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+	/* completions of earlier messages on our ring must not overflow it */
+	(void)stress_wakelat_msg_ring_reap(ring);
+
+	(void)shim_memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_MSG_RING;
+	sqe->fd = peer->ring.fd;
+	sqe->off = WAKELAT_MSG_TAG;		/* user_data of the peer's completion */
+	ring->sq_array[idx] = idx;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	for (;;) {
+		if (stress_io_uring_ring_enter(ring, 1, 0, 0) >= 0)
+			return 0;
+		if (errno != EINTR)
+			return -1;
+	}
+}
+
+static int stress_wakelat_msg_ring_wait(stress_wakelat_thread_t *self)
+{
+	stress_io_uring_ring_t *ring = &self->ring;
+
+	for (;;) {
+		if (stress_wakelat_msg_ring_reap(ring))
+			return 0;
+		if ((stress_io_uring_ring_enter(ring, 0, 1, IORING_ENTER_GETEVENTS) < 0) &&
+		    (errno != EINTR))
+			return -1;
+	}
+}
+#endif
+
+static int stress_wakelat_none_init(stress_wakelat_thread_t *thread)
+{
+	thread->futex = 0;
+	thread->seen = 0;
+	return 0;
+}
+
+static void stress_wakelat_none_deinit(stress_wakelat_thread_t *thread)
+{
+	(void)thread;
+}
+
+static const stress_wakelat_method_t stress_wakelat_methods[] = {
+#if defined(HAVE_LINUX_FUTEX_H) &&	\
+    defined(__NR_futex)
+	{ "futex",	stress_wakelat_futex_init, stress_wakelat_futex_deinit,
+			stress_wakelat_futex_signal, stress_wakelat_futex_wait },
+#endif
+#if defined(HAVE_SYS_EVENTFD_H) &&	\
+    defined(HAVE_EVENTFD)
+	{ "eventfd",	stress_wakelat_eventfd_init, stress_wakelat_eventfd_deinit,
+			stress_wakelat_eventfd_signal, stress_wakelat_eventfd_wait },
+#endif
+	{ "pipe",	stress_wakelat_pipe_init, stress_wakelat_pipe_deinit,
+			stress_wakelat_pipe_signal, stress_wakelat_pipe_wait },
+#if defined(HAVE_SEMAPHORE_H) &&	\
+    defined(HAVE_SEM_POSIX)
+	{ "sem",	stress_wakelat_sem_init, stress_wakelat_sem_deinit,
+			stress_wakelat_sem_signal, stress_wakelat_sem_wait },
+#endif
+	{ "yield",	stress_wakelat_none_init, stress_wakelat_none_deinit,
+			stress_wakelat_yield_signal, stress_wakelat_yield_wait },
+#if defined(HAVE_WAKELAT_MSG_RING)
+	{ "msg-ring",	stress_wakelat_msg_ring_init, stress_wakelat_msg_ring_deinit,
+			stress_wakelat_msg_ring_signal, stress_wakelat_msg_ring_wait },
+#endif
+};
+
+#define WAKELAT_METHODS		SIZEOF_ARRAY(stress_wakelat_methods)
+
+static const char *stress_wakelat_method(const size_t i)
+{
+	if (i == 0)
+		return "all";
+	return (i <= WAKELAT_METHODS) ? stress_wakelat_methods[i - 1].name : NULL;
+}
+#else
+static const char *stress_wakelat_method(const size_t i)
+{
+	return (i == 0) ? "all" : NULL;
+}
+#endif
+
+static const stress_opt_t opts[] = {
+	{ OPT_wakelat_method,	 "wakelat-method",    TYPE_ID_SIZE_T_METHOD, 0, 0, stress_wakelat_method },
+	{ OPT_wakelat_placement, "wakelat-placement", TYPE_ID_SIZE_T_METHOD, 0, 0, stress_wakelat_placement },
+	END_OPT,
+};
+
+#if defined(HAVE_WAKELAT)
+
+/*
+ *  stress_wakelat_now()
+ *	monotonic time in nanoseconds, wall clock time as a double has
+ *	too little precision for sub-microsecond latencies
+ */
+static inline uint64_t stress_wakelat_now(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) &&	\
+    defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	if (LIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) == 0))
+		return ((uint64_t)ts.tv_sec * STRESS_NANOSECOND) + (uint64_t)ts.tv_nsec;
+#endif
+	return (uint64_t)(stress_time_now() * STRESS_DBL_NANOSECOND);
+}
+
+/*
+ *  stress_wakelat_record()
+ *	reservoir sample a wake-up latency
+ */
+static inline void stress_wakelat_record(
+	stress_wakelat_thread_t *thread,
+	const double latency)
+{
+	stress_wakelat_reservoir_t *reservoir = thread->reservoir;
+
+	if (reservoir->seen < WAKELAT_SAMPLES) {
+		reservoir->samples[reservoir->seen] = latency;
+	} else {
+		uint64_t idx;
+
+		thread->rnd = (thread->rnd * 1103515245U) + 12345U;
+		idx = ((uint64_t)thread->rnd * (reservoir->seen + 1)) >> 32;
+		if (idx < WAKELAT_SAMPLES)
+			reservoir->samples[idx] = latency;
+	}
+	reservoir->seen++;
+}
+
+/*
+ *  stress_wakelat_thread()
+ *	ping-pong with the peer thread, each side stamps the time
+ *	before waking the other side and the woken side measures the
+ *	time it took to get running
+ */
+static void *stress_wakelat_thread(void *arg)
+{
+	stress_wakelat_thread_t *self = (stress_wakelat_thread_t *)arg;
+	stress_wakelat_context_t *ctx = self->ctx;
+	stress_wakelat_thread_t *peer = &ctx->threads[self->side ^ 1];
+	const stress_wakelat_method_t *method = ctx->method;
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP)
+	if (self->cpu >= 0) {
+		cpu_set_t cpuset;
+
+		CPU_ZERO(&cpuset);
+		CPU_SET(self->cpu, &cpuset);
+		(void)pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+	}
+#endif
+	while (!__atomic_load_n(&ctx->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+
+	if (self->side == 0) {
+		peer->stamp = stress_wakelat_now();
+		if (method->signal(self, peer) < 0)
+			self->err = errno;
+	}
+
+	while (!self->err && !__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)) {
+		if (method->wait(self) < 0) {
+			self->err = errno;
+			break;
+		}
+		if (__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED))
+			break;
+		stress_wakelat_record(self, (double)(stress_wakelat_now() - self->stamp) / STRESS_DBL_NANOSECOND);
+
+		peer->stamp = stress_wakelat_now();
+		if (method->signal(self, peer) < 0) {
+			self->err = errno;
+			break;
+		}
+	}
+	/* wake the peer in case it is waiting for us */
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELAXED);
+	(void)method->signal(self, peer);
+	return &g_nowt;
+}
+
+/*
+ *  stress_wakelat_run()
+ *	run one method and placement for a time slice
+ */
+static int stress_wakelat_run(
+	stress_args_t *args,
+	stress_wakelat_context_t *ctx,
+	stress_wakelat_result_t *result)
+{
+	const stress_wakelat_method_t *method = result->method;
+	uint64_t seen[2];
+	int i, created, inited;
+	double t;
+
+	(void)shim_memset(ctx, 0, sizeof(*ctx));
+	ctx->method = method;
+	for (i = 0; i < 2; i++) {
+		stress_wakelat_thread_t *thread = &ctx->threads[i];
+
+		thread->ctx = ctx;
+		thread->side = i;
+		thread->cpu = result->cpus[i];
+		thread->reservoir = &result->reservoir[i];
+		thread->rnd = stress_mwc32();
+		thread->efd = -1;
+		thread->pipefds[0] = -1;
+		thread->pipefds[1] = -1;
+#if defined(HAVE_WAKELAT_MSG_RING)
+		thread->ring.fd = -1;
+#endif
+		seen[i] = result->reservoir[i].seen;
+	}
+	for (inited = 0; inited < 2; inited++) {
+		if (method->init(&ctx->threads[inited]) < 0) {
+			if (stress_instance_zero(args))
+				pr_inf("%s: %s not available, errno=%d (%s), skipping it\n",
+					args->name, method->name, errno, strerror(errno));
+			result->skipped = true;
+			goto deinit;
+		}
+	}
+
+	for (created = 0; created < 2; created++) {
+		if (pthread_create(&ctx->threads[created].pthread, NULL,
+				stress_wakelat_thread, (void *)&ctx->threads[created]) != 0)
+			break;
+	}
+	if (created < 2) {
+		pr_dbg("%s: cannot create threads, skipping %s %s\n", args->name,
+			method->name, stress_wakelat_placements[result->placement]);
+		result->skipped = true;
+	}
+
+	t = stress_time_now();
+	__atomic_store_n(&ctx->go, true, __ATOMIC_RELEASE);
+	if (!result->skipped)
+		(void)shim_nanosleep_uint64(WAKELAT_SLICE_NS);
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELAXED);
+	if (created == 1) {
+		/* only the pinger is running, wake it in place of the ponger */
+		(void)method->signal(&ctx->threads[1], &ctx->threads[0]);
+	}
+	for (i = 0; i < created; i++)
+		VOID_RET(int, pthread_join(ctx->threads[i].pthread, NULL));
+	t = stress_time_now() - t;
+
+	if (!result->skipped) {
+		for (i = 0; i < 2; i++) {
+			if (ctx->threads[i].err) {
+				pr_fail("%s: %s wait or wake failed, errno=%d (%s)\n",
+					args->name, method->name, ctx->threads[i].err,
+					strerror(ctx->threads[i].err));
+				result->skipped = true;
+				goto deinit;
+			}
+			stress_bogo_add(args, result->reservoir[i].seen - seen[i]);
+		}
+		result->duration += t;
+	}
+deinit:
+	for (i = 0; i < inited; i++)
+		method->deinit(&ctx->threads[i]);
+	return (result->skipped && (ctx->threads[0].err || ctx->threads[1].err)) ? -1 : 0;
+}
+
+/*
+ *  stress_wakelat_cpus()
+ *	find a pair of CPUs with the topology relationship a placement needs
+ */
+static bool stress_wakelat_cpus(
+	const size_t placement,
+	const uint32_t n_cpus,
+	const stress_cpu_topology_t *topology,
+	int *cpus)
+{
+	uint32_t i, j;
+
+	switch (placement) {
+	case WAKELAT_PLACEMENT_UNPINNED:
+		cpus[0] = -1;
+		cpus[1] = -1;
+		return true;
+	case WAKELAT_PLACEMENT_SAME_CORE:
+		if (n_cpus < 1)
+			return false;
+		cpus[0] = (int)topology[0].cpu;
+		cpus[1] = (int)topology[0].cpu;
+		return true;
+	default:
+		break;
+	}
+
+	for (i = 0; i < n_cpus; i++) {
+		for (j = i + 1; j < n_cpus; j++) {
+			const stress_cpu_topology_rel_t rel = stress_cpu_topology_rel(&topology[i], &topology[j]);
+			bool match;
+
+			switch (placement) {
+			case WAKELAT_PLACEMENT_SIBLING:
+				match = (rel == STRESS_CPU_REL_SMT);
+				break;
+			case WAKELAT_PLACEMENT_SAME_LLC:
+				match = (rel == STRESS_CPU_REL_CLUSTER) || (rel == STRESS_CPU_REL_LLC);
+				break;
+			case WAKELAT_PLACEMENT_CROSS_SOCKET:
+				match = (rel == STRESS_CPU_REL_REMOTE);
+				break;
+			default:
+				match = false;
+				break;
+			}
+			if (match) {
+				cpus[0] = (int)topology[i].cpu;
+				cpus[1] = (int)topology[j].cpu;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+ *  stress_wakelat_metrics()
+ *	wake-up latency percentiles of each method and placement
+ */
+static void stress_wakelat_metrics(
+	stress_args_t *args,
+	stress_wakelat_result_t *results,
+	const size_t n_results)
+{
+	double *samples;
+	size_t i, idx = 0;
+
+	samples = (double *)calloc(2 * WAKELAT_SAMPLES, sizeof(*samples));
+	if (!samples)
+		return;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_wakelat_result_t *r = &results[i];
+		const char *placement = stress_wakelat_placements[r->placement];
+		size_t n_samples = 0;
+		uint64_t wakeups = 0;
+		double p50, p99, p999;
+		char msg[64];
+		int j;
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+		for (j = 0; j < 2; j++) {
+			const size_t n = (size_t)STRESS_MINIMUM(r->reservoir[j].seen, WAKELAT_SAMPLES);
+
+			(void)shim_memcpy(samples + n_samples, r->reservoir[j].samples, n * sizeof(*samples));
+			n_samples += n;
+			wakeups += r->reservoir[j].seen;
+		}
+		if (n_samples == 0)
+			continue;
+		stress_percentile_sort(samples, n_samples);
+		p50 = stress_percentile(samples, n_samples, 50.0) * STRESS_DBL_MICROSECOND;
+		p99 = stress_percentile(samples, n_samples, 99.0) * STRESS_DBL_MICROSECOND;
+		p999 = stress_percentile(samples, n_samples, 99.9) * STRESS_DBL_MICROSECOND;
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-8s %-12s CPUs %3d,%3d %10.0f wakeups/sec, "
+				"p50 %8.2f, p99 %8.2f, p99.9 %8.2f usec\n",
+				args->name, r->method->name, placement, r->cpus[0], r->cpus[1],
+				(double)wakeups / r->duration, p50, p99, p999);
+
+		(void)snprintf(msg, sizeof(msg), "%s %s usec p50 wake latency", r->method->name, placement);
+		stress_metrics_set(args, idx++, msg, p50, STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%s %s usec p99 wake latency", r->method->name, placement);
+		stress_metrics_set(args, idx++, msg, p99, STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "%s %s usec p99.9 wake latency", r->method->name, placement);
+		stress_metrics_set(args, idx++, msg, p999, STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+	free(samples);
+}
+
+/*
+ *  stress_wakelat()
+ *	measure the wake-to-run latency of wake mechanisms across
+ *	CPU placements
+ */
+static int stress_wakelat(stress_args_t *args)
+{
+	size_t wakelat_method = 0, wakelat_placement = WAKELAT_PLACEMENT_ALL;
+	size_t placements[5], n_placements = 0, n_results = 0, i, j, l;
+	uint32_t *cpus = NULL, n_cpus;
+	stress_cpu_topology_t *topology = NULL;
+	stress_wakelat_result_t *results = NULL;
+	stress_wakelat_context_t *ctx = NULL;
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("wakelat-method", &wakelat_method);
+	(void)stress_get_setting("wakelat-placement", &wakelat_placement);
+
+	n_cpus = stress_get_usable_cpus(&cpus, true);
+	if (n_cpus > 0) {
+		topology = (stress_cpu_topology_t *)calloc(n_cpus, sizeof(*topology));
+		if (topology) {
+			for (i = 0; i < n_cpus; i++)
+				stress_cpu_topology_get(cpus[i], &topology[i]);
+		} else {
+			n_cpus = 0;
+		}
+	}
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP)
+	if (wakelat_placement == WAKELAT_PLACEMENT_ALL) {
+		placements[n_placements++] = WAKELAT_PLACEMENT_SAME_CORE;
+		placements[n_placements++] = WAKELAT_PLACEMENT_SIBLING;
+		placements[n_placements++] = WAKELAT_PLACEMENT_SAME_LLC;
+		placements[n_placements++] = WAKELAT_PLACEMENT_CROSS_SOCKET;
+		placements[n_placements++] = WAKELAT_PLACEMENT_UNPINNED;
+	} else {
+		placements[n_placements++] = wakelat_placement;
+	}
+#else
+	if (stress_instance_zero(args) &&
+	    (wakelat_placement != WAKELAT_PLACEMENT_ALL) &&
+	    (wakelat_placement != WAKELAT_PLACEMENT_UNPINNED))
+		pr_inf("%s: cannot pin threads to CPUs, using unpinned placement\n", args->name);
+	placements[n_placements++] = WAKELAT_PLACEMENT_UNPINNED;
+#endif
+
+	results = (stress_wakelat_result_t *)calloc(WAKELAT_METHODS * n_placements, sizeof(*results));
+	ctx = (stress_wakelat_context_t *)calloc(1, sizeof(*ctx));
+	if (!results || !ctx) {
+		pr_inf_skip("%s: cannot allocate latency samples%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_tables;
+	}
+
+	for (j = 0; j < n_placements; j++) {
+		int pair[2];
+
+		if (!stress_wakelat_cpus(placements[j], n_cpus, topology, pair)) {
+			if (stress_instance_zero(args))
+				pr_dbg("%s: no CPU pair for %s placement, skipping it\n",
+					args->name, stress_wakelat_placements[placements[j]]);
+			continue;
+		}
+		for (i = 0; i < WAKELAT_METHODS; i++) {
+			stress_wakelat_result_t *r;
+
+			if (wakelat_method && (wakelat_method - 1 != i))
+				continue;
+			r = &results[n_results++];
+			r->method = &stress_wakelat_methods[i];
+			r->placement = placements[j];
+			r->cpus[0] = pair[0];
+			r->cpus[1] = pair[1];
+		}
+	}
+	if (n_results == 0) {
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: no CPUs available for the %s placement, skipping stressor\n",
+				args->name, stress_wakelat_placements[wakelat_placement]);
+		rc = EXIT_NO_RESOURCE;
+		goto free_tables;
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	l = 0;
+	do {
+		bool runnable = false;
+
+		if (!results[l].skipped &&
+		    (stress_wakelat_run(args, ctx, &results[l]) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		for (i = 0; i < n_results; i++)
+			runnable |= !results[i].skipped;
+		if (!runnable)
+			break;
+		l = (l + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_wakelat_metrics(args, results, n_results);
+
+free_tables:
+	free(ctx);
+	free(results);
+	free(topology);
+	stress_free_usable_cpus(&cpus);
+	return rc;
+}
+
+const stressor_info_t stress_wakelat_info = {
+	.stressor = stress_wakelat,
+	.classifier = CLASS_SCHEDULER | CLASS_OS,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_wakelat_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_SCHEDULER | CLASS_OS,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread or atomic add/load/store support"
+};
+#endif
@@ -0,0 +1,576 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-io-uring.h"
+#include "core-pthread.h"
+#include "io-uring.h"
+
+#define MIN_WAL_WRITERS		(1)
+#define MAX_WAL_WRITERS		(64)
+#define DEFAULT_WAL_WRITERS	(8)
+
+#define MIN_WAL_RECORD_SIZE	(16)
+#define MAX_WAL_RECORD_SIZE	(64 * KB)
+#define DEFAULT_WAL_RECORD_SIZE	(512)
+
+#define MIN_WAL_BYTES		(1 * MB)
+#define MAX_WAL_BYTES		(MAX_FILE_LIMIT)
+#define DEFAULT_WAL_BYTES	(16 * MB)
+
+#define WAL_MAX_STEPS		(8)		/* 1, 2, 4 .. 64 writers */
+#define WAL_MAX_SAMPLES		(4096)		/* latency samples per step */
+#define WAL_STEP_DURATION	(0.5)		/* seconds per sweep step */
+
+static const stress_help_t help[] = {
+	{ NULL,	"wal N",		"start N workers modelling write-ahead log commits" },
+	{ NULL,	"wal-bytes N",		"size of the log file before it wraps around" },
+	{ NULL,	"wal-method M",		"commit method: fdatasync, fsync, odsync, rwf-dsync, io-uring" },
+	{ NULL,	"wal-ops N",		"stop after N log record commits" },
+	{ NULL,	"wal-record-size N",	"size of each log record in bytes" },
+	{ NULL,	"wal-writers N",	"sweep concurrent committers from 1 to N" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef enum {
+	WAL_METHOD_FDATASYNC,
+	WAL_METHOD_FSYNC,
+	WAL_METHOD_ODSYNC,
+	WAL_METHOD_RWF_DSYNC,
+	WAL_METHOD_IO_URING,
+} stress_wal_method_t;
+
+typedef struct {
+	const char *name;
+	const stress_wal_method_t method;
+} stress_wal_method_info_t;
+
+static const stress_wal_method_info_t stress_wal_methods[] = {
+	{ "fdatasync",	WAL_METHOD_FDATASYNC },
+	{ "fsync",	WAL_METHOD_FSYNC },
+	{ "odsync",	WAL_METHOD_ODSYNC },
+	{ "rwf-dsync",	WAL_METHOD_RWF_DSYNC },
+	{ "io-uring",	WAL_METHOD_IO_URING },
+};
+
+static const char *stress_wal_method(const size_t i)
+{
+	return (i < SIZEOF_ARRAY(stress_wal_methods)) ? stress_wal_methods[i].name : NULL;
+}
+
+static const stress_opt_t opts[] = {
+	{ OPT_wal_bytes,	"wal-bytes",	   TYPE_ID_OFF_T, MIN_WAL_BYTES, MAX_WAL_BYTES, NULL },
+	{ OPT_wal_method,	"wal-method",	   TYPE_ID_SIZE_T_METHOD, 0, 0, stress_wal_method },
+	{ OPT_wal_record_size,	"wal-record-size", TYPE_ID_SIZE_T_BYTES_FS, MIN_WAL_RECORD_SIZE, MAX_WAL_RECORD_SIZE, NULL },
+	{ OPT_wal_writers,	"wal-writers",	   TYPE_ID_UINT32, MIN_WAL_WRITERS, MAX_WAL_WRITERS, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_LIB_PTHREAD) &&	\
+    defined(HAVE_ATOMIC_FETCH_ADD)
+
+#if defined(HAVE_STRESS_IO_URING_RING) &&	\
+    defined(IORING_FSYNC_DATASYNC) &&	\
+    defined(IOSQE_IO_LINK) &&		\
+    defined(HAVE_IORING_OP_WRITE) &&	\
+    defined(HAVE_IORING_OP_FSYNC)
+#define HAVE_WAL_IO_URING
+#endif
+
+/*
+ *  per sweep step results, one step per number of writers
+ */
+typedef struct {
+	uint32_t writers;		/* concurrent committers */
+	uint32_t index;			/* next latency sample slot */
+	uint64_t commits;		/* total commits */
+	double duration;		/* total time spent in this step */
+	double samples[WAL_MAX_SAMPLES];/* commit latencies (seconds) */
+} stress_wal_step_t;
+
+/*
+ *  state shared between the writer threads of a step
+ */
+typedef struct {
+	stress_args_t *args;
+	stress_wal_step_t *step;	/* step being run */
+	stress_wal_method_t method;	/* commit method */
+	int fd;				/* log file */
+	off_t wal_bytes;		/* wrap offset of the log */
+	size_t record_size;		/* log record size */
+	uint64_t offset;		/* next log append offset */
+	uint64_t commits;		/* commits in this step */
+	double t_end;			/* end time of the step */
+	bool failed;			/* set on an unexpected error */
+} stress_wal_state_t;
+
+typedef struct {
+	stress_wal_state_t *state;
+	pthread_t pthread;
+	int ret;
+} stress_wal_writer_t;
+
+#if defined(HAVE_WAL_IO_URING)
+/*
+ *  stress_wal_uring_setup()
+ *	setup a small io-uring, returns -errno on failure
+ */
+static int stress_wal_uring_setup(stress_io_uring_ring_t *uring)
+{
+	struct io_uring_params p;
+
+	(void)shim_memset(&p, 0, sizeof(p));
+	return stress_io_uring_ring_setup(uring, 4, &p);
+}
+
+/*
+ *  stress_wal_uring_commit()
+ *	submit a write linked to a fdatasync and wait for both
+ *	to complete, returns bytes written or -errno
+ */
+static ssize_t stress_wal_uring_commit(
+	stress_io_uring_ring_t *uring,
+	const int fd,
+	const void *buf,
+	const size_t len,
+	const off_t offset)
+{
+	unsigned tail = *uring->sq_tail;
+	unsigned head, idx;
+	struct io_uring_sqe *sqe;
+	ssize_t ret = 0;
+	int i;
+
+	idx = tail & *uring->sq_mask;
+	sqe = &uring->sqes[idx];
+	(void)shim_memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)buf;
+	sqe->len = (uint32_t)len;
+	sqe->off = (uint64_t)offset;
+	uring->sq_array[idx] = idx;
+	tail++;
+
+	idx = tail & *uring->sq_mask;
+	sqe = &uring->sqes[idx];
+	(void)shim_memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = fd;
+	sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+	uring->sq_array[idx] = idx;
+	tail++;
+
+	stress_asm_mb();
+	*uring->sq_tail = tail;
+	stress_asm_mb();
+
+	if (UNLIKELY(stress_io_uring_ring_enter(uring, 2, 2, IORING_ENTER_GETEVENTS) < 0))
+		return -errno;
+
+	head = *uring->cq_head;
+	for (i = 0; i < 2; i++) {
+		const struct io_uring_cqe *cqe;
+
+		stress_asm_mb();
+		if (head == *uring->cq_tail)
+			break;
+		cqe = &uring->cqes[head & *uring->cq_mask];
+		if (cqe->res < 0)
+			ret = cqe->res;
+		else if ((i == 0) && (ret == 0))
+			ret = cqe->res;
+		head++;
+	}
+	*uring->cq_head = head;
+	stress_asm_mb();
+
+	return ret;
+}
+#endif
+
+/*
+ *  stress_wal_commit()
+ *	append a record and make it durable with the chosen
+ *	method, returns bytes written or -errno
+ */
+static ssize_t stress_wal_commit(
+	stress_wal_state_t *state,
+	const void *buf,
+	const off_t offset,
+	void *uring)
+{
+	const int fd = state->fd;
+	const size_t len = state->record_size;
+	ssize_t ret;
+
+	(void)uring;
+
+	switch (state->method) {
+#if defined(HAVE_WAL_IO_URING)
+	case WAL_METHOD_IO_URING:
+		return stress_wal_uring_commit((stress_io_uring_ring_t *)uring,
+			fd, buf, len, offset);
+#endif
+#if defined(HAVE_PWRITEV2) &&	\
+    defined(RWF_DSYNC)
+	case WAL_METHOD_RWF_DSYNC: {
+			struct iovec iov;
+
+			iov.iov_base = (void *)buf;
+			iov.iov_len = len;
+			ret = pwritev2(fd, &iov, 1, offset, RWF_DSYNC);
+			return (ret < 0) ? -errno : ret;
+		}
+#endif
+	case WAL_METHOD_ODSYNC:
+		ret = pwrite(fd, buf, len, offset);
+		return (ret < 0) ? -errno : ret;
+	case WAL_METHOD_FSYNC:
+		ret = pwrite(fd, buf, len, offset);
+		if (UNLIKELY(ret < 0))
+			return -errno;
+		return (shim_fsync(fd) < 0) ? -errno : ret;
+	case WAL_METHOD_FDATASYNC:
+	default:
+		ret = pwrite(fd, buf, len, offset);
+		if (UNLIKELY(ret < 0))
+			return -errno;
+		return (shim_fdatasync(fd) < 0) ? -errno : ret;
+	}
+}
+
+/*
+ *  stress_wal_writer()
+ *	append and commit log records until the step ends
+ */
+static void *stress_wal_writer(void *arg)
+{
+	stress_wal_writer_t *writer = (stress_wal_writer_t *)arg;
+	stress_wal_state_t *state = writer->state;
+	stress_wal_step_t *step = state->step;
+	stress_args_t *args = state->args;
+	const uint64_t wal_bytes = (uint64_t)state->wal_bytes;
+	const size_t record_size = state->record_size;
+	uint8_t *buf;
+	void *uring = NULL;
+#if defined(HAVE_WAL_IO_URING)
+	stress_io_uring_ring_t wal_uring;
+#endif
+
+	buf = (uint8_t *)mmap(NULL, record_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED)
+		return &g_nowt;
+	stress_uint8rnd4(buf, record_size);
+
+#if defined(HAVE_WAL_IO_URING)
+	if (state->method == WAL_METHOD_IO_URING) {
+		if (stress_wal_uring_setup(&wal_uring) < 0) {
+			(void)munmap((void *)buf, record_size);
+			return &g_nowt;
+		}
+		uring = (void *)&wal_uring;
+	}
+#endif
+
+	/* stress_continue() check with the commits not yet added to the bogo counter */
+	while (LIKELY(stress_continue_flag() && !state->failed &&
+	       (args->bogo.ci.counter + state->commits < args->bogo.max_ops))) {
+		const uint64_t seq = __atomic_fetch_add(&state->offset, record_size, __ATOMIC_RELAXED);
+		const off_t offset = (off_t)(seq % wal_bytes);
+		uint32_t idx;
+		ssize_t ret;
+		double t1, t2;
+
+		/* tag the record with its sequence number */
+		(void)shim_memcpy(buf, &seq, sizeof(seq) < record_size ? sizeof(seq) : record_size);
+
+		t1 = stress_time_now();
+		ret = stress_wal_commit(state, buf, offset, uring);
+		t2 = stress_time_now();
+		if (UNLIKELY(ret < 0)) {
+			const int err = (int)-ret;
+
+			if ((err == ENOSPC) || (err == EINTR) || (err == EFBIG))
+				break;
+			pr_fail("%s: %s commit failed, errno=%d (%s)\n",
+				args->name, stress_wal_methods[state->method].name,
+				err, strerror(err));
+			state->failed = true;
+			break;
+		}
+		(void)__atomic_fetch_add(&state->commits, 1, __ATOMIC_RELAXED);
+		idx = __atomic_fetch_add(&step->index, 1, __ATOMIC_RELAXED);
+		step->samples[idx % WAL_MAX_SAMPLES] = t2 - t1;
+		if (UNLIKELY(t2 >= state->t_end))
+			break;
+	}
+
+#if defined(HAVE_WAL_IO_URING)
+	if (uring)
+		stress_io_uring_ring_close(&wal_uring);
+#endif
+	(void)munmap((void *)buf, record_size);
+	return &g_nowt;
+}
+
+/*
+ *  stress_wal_run_step()
+ *	run step->writers concurrent committers for a sweep step
+ */
+static void stress_wal_run_step(
+	stress_args_t *args,
+	stress_wal_state_t *state,
+	stress_wal_step_t *step)
+{
+	stress_wal_writer_t writers[MAX_WAL_WRITERS];
+	uint32_t i;
+	double t_start;
+
+	/* start each step with an empty log so commits are appends */
+	if (ftruncate(state->fd, 0) < 0) {
+		pr_fail("%s: ftruncate failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		state->failed = true;
+		return;
+	}
+	(void)shim_fdatasync(state->fd);
+
+	state->step = step;
+	state->offset = 0;
+	state->commits = 0;
+	t_start = stress_time_now();
+	state->t_end = t_start + WAL_STEP_DURATION;
+
+	for (i = 0; i < step->writers; i++) {
+		writers[i].state = state;
+		writers[i].ret = pthread_create(&writers[i].pthread, NULL,
+				stress_wal_writer, (void *)&writers[i]);
+	}
+	for (i = 0; i < step->writers; i++) {
+		if (writers[i].ret)
+			continue;
+		VOID_RET(int, pthread_join(writers[i].pthread, NULL));
+	}
+	step->duration += stress_time_now() - t_start;
+	step->commits += state->commits;
+	stress_bogo_add(args, state->commits);
+}
+
+/*
+ *  stress_wal_metrics()
+ *	report commit rate and latency percentiles for each step
+ */
+static void stress_wal_metrics(
+	stress_args_t *args,
+	stress_wal_step_t *steps,
+	const size_t n_steps)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < n_steps; i++) {
+		stress_wal_step_t *step = &steps[i];
+		const size_t n = (step->index > WAL_MAX_SAMPLES) ? WAL_MAX_SAMPLES : step->index;
+		const double rate = (step->duration > 0.0) ?
+			(double)step->commits / step->duration : 0.0;
+		char msg[64];
+
+		if (n == 0)
+			continue;
+		stress_percentile_sort(step->samples, n);
+
+		(void)snprintf(msg, sizeof(msg), "commits/sec (%" PRIu32 " writers)", step->writers);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p50 commit latency (%" PRIu32 " writers)", step->writers);
+		stress_metrics_set(args, idx++, msg,
+			stress_percentile(step->samples, n, 50.0) * STRESS_DBL_MICROSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99 commit latency (%" PRIu32 " writers)", step->writers);
+		stress_metrics_set(args, idx++, msg,
+			stress_percentile(step->samples, n, 99.0) * STRESS_DBL_MICROSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+
+	/*
+	 *  If the file system batches journal commits then the
+	 *  commit rate scales with writers; no batching gives ~1.0
+	 */
+	if ((n_steps > 1) && (steps[0].commits > 0) && (steps[0].duration > 0.0) &&
+	    (steps[n_steps - 1].duration > 0.0)) {
+		const double rate1 = (double)steps[0].commits / steps[0].duration;
+		const double rateN = (double)steps[n_steps - 1].commits / steps[n_steps - 1].duration;
+
+		stress_metrics_set(args, idx, "group commit scaling (max writers vs 1)",
+			rateN / rate1, STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_wal
+ *	stress write-ahead log style small append + sync commits
+ */
+static int stress_wal(stress_args_t *args)
+{
+	size_t wal_method = 0, n_steps = 0, i;
+	uint32_t wal_writers = DEFAULT_WAL_WRITERS, writers;
+	size_t wal_record_size = DEFAULT_WAL_RECORD_SIZE;
+	off_t wal_bytes = DEFAULT_WAL_BYTES;
+	stress_wal_state_t state;
+	stress_wal_step_t *steps;
+	const size_t steps_size = sizeof(*steps) * WAL_MAX_STEPS;
+	char filename[PATH_MAX];
+	int ret, flags = O_CREAT | O_RDWR;
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("wal-bytes", &wal_bytes);
+	(void)stress_get_setting("wal-method", &wal_method);
+	(void)stress_get_setting("wal-record-size", &wal_record_size);
+	if (!stress_get_setting("wal-writers", &wal_writers)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			wal_writers = MAX_WAL_WRITERS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			wal_writers = MIN_WAL_WRITERS;
+	}
+	wal_bytes = (wal_bytes / (off_t)wal_record_size) * (off_t)wal_record_size;
+
+	switch (stress_wal_methods[wal_method].method) {
+	case WAL_METHOD_ODSYNC:
+#if defined(O_DSYNC)
+		flags |= O_DSYNC;
+		break;
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: O_DSYNC is not available, skipping stressor\n", args->name);
+		return EXIT_NOT_IMPLEMENTED;
+#endif
+	case WAL_METHOD_RWF_DSYNC:
+#if defined(HAVE_PWRITEV2) &&	\
+    defined(RWF_DSYNC)
+		break;
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: pwritev2 RWF_DSYNC is not available, skipping stressor\n", args->name);
+		return EXIT_NOT_IMPLEMENTED;
+#endif
+	case WAL_METHOD_IO_URING:
+#if defined(HAVE_WAL_IO_URING)
+		{
+			stress_io_uring_ring_t uring;
+
+			ret = stress_wal_uring_setup(&uring);
+			if (ret < 0) {
+				if (stress_instance_zero(args))
+					pr_inf_skip("%s: io-uring setup failed, errno=%d (%s), "
+						"skipping stressor\n", args->name, -ret, strerror(-ret));
+				return EXIT_NOT_IMPLEMENTED;
+			}
+			stress_io_uring_ring_close(&uring);
+		}
+		break;
+#else
+		if (stress_instance_zero(args))
+			pr_inf_skip("%s: io-uring linked write and fsync is not available, "
+				"skipping stressor\n", args->name);
+		return EXIT_NOT_IMPLEMENTED;
+#endif
+	default:
+		break;
+	}
+
+	steps = (stress_wal_step_t *)mmap(NULL, steps_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (steps == MAP_FAILED) {
+		pr_inf_skip("%s: failed to mmap %zu bytes for latency samples%s, "
+			"errno=%d (%s), skipping stressor\n",
+			args->name, steps_size, stress_get_memfree_str(),
+			errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(steps, steps_size, "wal-samples");
+
+	/* writer counts 1, 2, 4 .. wal_writers */
+	for (writers = 1; (writers < wal_writers) && (n_steps < WAL_MAX_STEPS - 1); writers <<= 1)
+		steps[n_steps++].writers = writers;
+	steps[n_steps++].writers = wal_writers;
+
+	ret = stress_temp_dir_mk_args(args);
+	if (ret < 0) {
+		(void)munmap((void *)steps, steps_size);
+		return stress_exit_status(-ret);
+	}
+	(void)stress_temp_filename_args(args, filename, sizeof(filename), stress_mwc32());
+
+	(void)shim_memset(&state, 0, sizeof(state));
+	state.args = args;
+	state.method = stress_wal_methods[wal_method].method;
+	state.wal_bytes = wal_bytes;
+	state.record_size = wal_record_size;
+	state.fd = open(filename, flags, S_IRUSR | S_IWUSR);
+	if (state.fd < 0) {
+		ret = errno;
+		pr_inf_skip("%s: cannot create log file %s, errno=%d (%s), skipping stressor\n",
+			args->name, filename, ret, strerror(ret));
+		rc = stress_exit_status(ret);
+		goto tidy_dir;
+	}
+	(void)shim_unlink(filename);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		stress_wal_run_step(args, &state, &steps[i]);
+		i++;
+		if (i >= n_steps)
+			i = 0;
+	} while (!state.failed && stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	if (state.failed)
+		rc = EXIT_FAILURE;
+	stress_wal_metrics(args, steps, n_steps);
+
+	(void)close(state.fd);
+tidy_dir:
+	(void)stress_temp_dir_rm_args(args);
+	(void)munmap((void *)steps, steps_size);
+
+	return rc;
+}
+
+const stressor_info_t stress_wal_info = {
+	.stressor = stress_wal,
+	.classifier = CLASS_IO | CLASS_FILESYSTEM | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_wal_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_IO | CLASS_FILESYSTEM | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread or atomic fetch add support"
+};
+#endif
@@ -0,0 +1,844 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-cpu-relax.h"
+#include "core-pthread.h"
+
+#define MIN_WORKSTEAL_THREADS	(1)
+#define MAX_WORKSTEAL_THREADS	(256)
+
+#define WORKSTEAL_SLICE		(0.2)		/* seconds per configuration */
+#define WORKSTEAL_DEQUE_SIZE	(4096)		/* Chase-Lev deque entries */
+
+#define WORKSTEAL_FIB_N		(24)		/* fib(24), ~150K tasks */
+#define WORKSTEAL_SORT_N	(256 * 1024)	/* quicksort elements */
+#define WORKSTEAL_SORT_CUTOFF	(1024)		/* sort serially below this size */
+#define WORKSTEAL_UTS_B0	(1000)		/* UTS root children */
+#define WORKSTEAL_UTS_M		(4)		/* UTS non-leaf node children */
+#define WORKSTEAL_UTS_Q		(0.2475)	/* UTS non-leaf node probability */
+#define WORKSTEAL_UTS_SEED	(0x5eed5eedULL)	/* UTS root node seed */
+
+static const stress_help_t help[] = {
+	{ NULL,	"worksteal N",		"start N workers running fork-join jobs on a work-stealing thread pool" },
+	{ NULL,	"worksteal-method M",	"select job: all, fib, quicksort, uts" },
+	{ NULL,	"worksteal-ops N",	"stop after N fork-join jobs" },
+	{ NULL,	"worksteal-threads N",	"maximum number of threads in the pool" },
+	{ NULL,	NULL,			NULL }
+};
+
+#if defined(HAVE_LIB_PTHREAD) &&		\
+    defined(HAVE_ATOMIC_COMPARE_EXCHANGE) &&	\
+    defined(HAVE_ATOMIC_ADD_FETCH) &&		\
+    defined(HAVE_ATOMIC_SUB_FETCH) &&		\
+    defined(HAVE_ATOMIC_LOAD) &&		\
+    defined(HAVE_ATOMIC_STORE)
+
+#define HAVE_WORKSTEAL
+
+struct stress_worksteal_worker;
+struct stress_worksteal_context;
+
+/*
+ *  a task lives in the stack frame of the task that spawned it, the
+ *  spawner cannot return until all its children have decremented the
+ *  join counter, so the task is valid for as long as it can be run
+ */
+typedef struct stress_worksteal_task {
+	void (*func)(struct stress_worksteal_worker *worker, struct stress_worksteal_task *task);
+	uint32_t *join;				/* parent's outstanding children */
+	uint64_t *result;			/* fib value, UTS node count */
+	uint64_t arg;				/* fib n, UTS node seed */
+	uint32_t *data;				/* quicksort data */
+	size_t n;				/* quicksort elements */
+} stress_worksteal_task_t;
+
+/* Chase-Lev work stealing deque, fixed size */
+typedef struct {
+	int64_t top ALIGN64;			/* thieves steal from the top */
+	int64_t bottom ALIGN64;			/* owner pushes and pops at the bottom */
+	stress_worksteal_task_t *tasks[WORKSTEAL_DEQUE_SIZE] ALIGN64;
+} stress_worksteal_deque_t;
+
+typedef struct stress_worksteal_worker {
+	stress_worksteal_deque_t deque;
+	struct stress_worksteal_context *ctx;
+	pthread_t pthread;
+	uint32_t index;				/* worker index in the pool */
+	uint32_t rnd;				/* victim selection random state */
+	uint64_t tasks;				/* tasks run */
+	uint64_t steals;			/* tasks stolen */
+	uint64_t steal_attempts;		/* steal attempts */
+} stress_worksteal_worker_t;
+
+typedef struct stress_worksteal_method {
+	const char *name;
+	void (*prepare)(struct stress_worksteal_context *ctx);
+	void (*job)(stress_worksteal_worker_t *worker);
+	bool (*check)(stress_args_t *args, struct stress_worksteal_context *ctx);
+} stress_worksteal_method_t;
+
+typedef struct stress_worksteal_context {
+	stress_worksteal_worker_t *workers;
+	uint32_t n_workers;			/* workers in the pool */
+	bool go;				/* start running */
+	bool stop;				/* stop running */
+	uint64_t result;			/* job result */
+	uint64_t fib;				/* expected fib result */
+	uint32_t *data;				/* quicksort data */
+	uint64_t data_sum;			/* quicksort data checksum */
+	uint64_t uts_nodes;			/* expected UTS tree size */
+	stress_worksteal_task_t *uts_roots;	/* UTS root children */
+	uint64_t *uts_counts;			/* UTS root children sizes */
+} stress_worksteal_context_t;
+
+/*
+ *  accumulated results for a job and pool size
+ */
+typedef struct {
+	const stress_worksteal_method_t *method;
+	uint32_t n_workers;
+	bool skipped;
+	double duration;			/* time spent running jobs */
+	uint64_t jobs;
+	uint64_t tasks;
+	uint64_t steals;
+	uint64_t steal_attempts;
+} stress_worksteal_result_t;
+
+/*
+ *  stress_worksteal_push()
+ *	owner pushes a task on the bottom of its deque, false if full
+ */
+static inline bool stress_worksteal_push(stress_worksteal_deque_t *dq, stress_worksteal_task_t *task)
+{
+	const int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+	const int64_t t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+
+	if (UNLIKELY(b - t >= WORKSTEAL_DEQUE_SIZE))
+		return false;
+	__atomic_store_n(&dq->tasks[b & (WORKSTEAL_DEQUE_SIZE - 1)], task, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+	return true;
+}
+
+/*
+ *  stress_worksteal_pop()
+ *	owner pops the newest task from the bottom of its deque, races
+ *	with thieves for the last task
+ */
+static inline stress_worksteal_task_t *stress_worksteal_pop(stress_worksteal_deque_t *dq)
+{
+	const int64_t b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+	int64_t t;
+
+	__atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+	if (t <= b) {
+		stress_worksteal_task_t *task = __atomic_load_n(&dq->tasks[b & (WORKSTEAL_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+
+		if (t == b) {
+			if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1,
+					false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+				task = NULL;
+			__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+		}
+		return task;
+	}
+	__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+/*
+ *  stress_worksteal_steal()
+ *	steal the oldest task from the top of a randomly chosen
+ *	victim's deque
+ */
+static stress_worksteal_task_t *stress_worksteal_steal(stress_worksteal_worker_t *worker)
+{
+	const stress_worksteal_context_t *ctx = worker->ctx;
+	stress_worksteal_deque_t *dq;
+	stress_worksteal_task_t *task;
+	uint32_t victim;
+	int64_t t, b;
+
+	if (ctx->n_workers < 2)
+		return NULL;
+	worker->rnd = (worker->rnd * 1103515245U) + 12345U;
+	victim = (worker->rnd >> 16) % (ctx->n_workers - 1);
+	if (victim >= worker->index)
+		victim++;
+	dq = &ctx->workers[victim].deque;
+	worker->steal_attempts++;
+
+	t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+	if (t >= b)
+		return NULL;
+	task = __atomic_load_n(&dq->tasks[t & (WORKSTEAL_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1,
+			false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return NULL;	/* lost the race */
+	worker->steals++;
+	return task;
+}
+
+/*
+ *  stress_worksteal_exec()
+ *	run a task, tell the parent when a spawned task has completed,
+ *	the task must not be touched after that
+ */
+static inline void stress_worksteal_exec(stress_worksteal_worker_t *worker, stress_worksteal_task_t *task)
+{
+	uint32_t *join = task->join;
+
+	worker->tasks++;
+	task->func(worker, task);
+	if (join)
+		(void)__atomic_sub_fetch(join, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ *  stress_worksteal_spawn()
+ *	make a child task available to be stolen, run it now if the
+ *	deque is full
+ */
+static inline void stress_worksteal_spawn(
+	stress_worksteal_worker_t *worker,
+	stress_worksteal_task_t *task,
+	uint32_t *join)
+{
+	task->join = join;
+	(void)__atomic_add_fetch(join, 1, __ATOMIC_RELAXED);
+	if (UNLIKELY(!stress_worksteal_push(&worker->deque, task)))
+		stress_worksteal_exec(worker, task);
+}
+
+/*
+ *  stress_worksteal_sync()
+ *	wait for the spawned children to complete, running local tasks
+ *	and stealing tasks from other workers while waiting
+ */
+static void stress_worksteal_sync(stress_worksteal_worker_t *worker, uint32_t *join)
+{
+	uint32_t spins = 0;
+
+	while (__atomic_load_n(join, __ATOMIC_ACQUIRE) > 0) {
+		stress_worksteal_task_t *task = stress_worksteal_pop(&worker->deque);
+
+		if (!task)
+			task = stress_worksteal_steal(worker);
+		if (task)
+			stress_worksteal_exec(worker, task);
+		else
+			(void)stress_cpu_relax_yield(&spins);
+	}
+}
+
+/*
+ *  stress_worksteal_fib_task()
+ *	naive recursive fibonacci, one task per call
+ */
+static void stress_worksteal_fib_task(stress_worksteal_worker_t *worker, stress_worksteal_task_t *task)
+{
+	stress_worksteal_task_t child1, child2;
+	uint64_t fib1, fib2;
+	uint32_t join = 0;
+
+	if (task->arg < 2) {
+		*task->result = task->arg;
+		return;
+	}
+	child1.func = stress_worksteal_fib_task;
+	child1.arg = task->arg - 1;
+	child1.result = &fib1;
+	stress_worksteal_spawn(worker, &child1, &join);
+
+	child2.func = stress_worksteal_fib_task;
+	child2.join = NULL;
+	child2.arg = task->arg - 2;
+	child2.result = &fib2;
+	stress_worksteal_exec(worker, &child2);
+
+	stress_worksteal_sync(worker, &join);
+	*task->result = fib1 + fib2;
+}
+
+static void stress_worksteal_fib_prepare(stress_worksteal_context_t *ctx)
+{
+	uint64_t f0 = 0, f1 = 1;
+	int i;
+
+	for (i = 0; i < WORKSTEAL_FIB_N; i++) {
+		const uint64_t f = f0 + f1;
+
+		f0 = f1;
+		f1 = f;
+	}
+	ctx->fib = f0;
+	ctx->result = 0;
+}
+
+static void stress_worksteal_fib_job(stress_worksteal_worker_t *worker)
+{
+	stress_worksteal_task_t task;
+
+	task.func = stress_worksteal_fib_task;
+	task.join = NULL;
+	task.arg = WORKSTEAL_FIB_N;
+	task.result = &worker->ctx->result;
+	stress_worksteal_exec(worker, &task);
+}
+
+static bool stress_worksteal_fib_check(stress_args_t *args, stress_worksteal_context_t *ctx)
+{
+	if (ctx->result != ctx->fib) {
+		pr_fail("%s: fib(%d) returned %" PRIu64 ", expected %" PRIu64 "\n",
+			args->name, WORKSTEAL_FIB_N, ctx->result, ctx->fib);
+		return false;
+	}
+	return true;
+}
+
+static int stress_worksteal_uint32_cmp(const void *p1, const void *p2)
+{
+	const uint32_t v1 = *(const uint32_t *)p1;
+	const uint32_t v2 = *(const uint32_t *)p2;
+
+	return (v1 < v2) ? -1 : ((v1 > v2) ? 1 : 0);
+}
+
+/*
+ *  stress_worksteal_quicksort_task()
+ *	partition around a median of three pivot, spawn the left
+ *	partition and sort the right partition in this task
+ */
+static void stress_worksteal_quicksort_task(stress_worksteal_worker_t *worker, stress_worksteal_task_t *task)
+{
+	uint32_t *data = task->data;
+	size_t n = task->n;
+	uint32_t join = 0;
+	stress_worksteal_task_t left, right;
+	uint32_t pivot, a, b, c;
+	size_t i, j;
+
+	if (n <= WORKSTEAL_SORT_CUTOFF) {
+		qsort(data, n, sizeof(*data), stress_worksteal_uint32_cmp);
+		return;
+	}
+
+	a = data[0];
+	b = data[n / 2];
+	c = data[n - 1];
+	pivot = (a < b) ? ((b < c) ? b : ((a < c) ? c : a)) :
+			  ((a < c) ? a : ((b < c) ? c : b));
+
+	/* Hoare partition */
+	i = 0;
+	j = n - 1;
+	for (;;) {
+		uint32_t tmp;
+
+		while (data[i] < pivot)
+			i++;
+		while (data[j] > pivot)
+			j--;
+		if (i >= j)
+			break;
+		tmp = data[i];
+		data[i] = data[j];
+		data[j] = tmp;
+		i++;
+		j--;
+	}
+
+	left.func = stress_worksteal_quicksort_task;
+	left.data = data;
+	left.n = j + 1;
+	stress_worksteal_spawn(worker, &left, &join);
+
+	right.func = stress_worksteal_quicksort_task;
+	right.join = NULL;
+	right.data = data + j + 1;
+	right.n = n - (j + 1);
+	stress_worksteal_exec(worker, &right);
+
+	stress_worksteal_sync(worker, &join);
+}
+
+static void stress_worksteal_quicksort_prepare(stress_worksteal_context_t *ctx)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < WORKSTEAL_SORT_N; i++) {
+		const uint32_t v = stress_mwc32();
+
+		ctx->data[i] = v;
+		sum += v;
+	}
+	ctx->data_sum = sum;
+}
+
+static void stress_worksteal_quicksort_job(stress_worksteal_worker_t *worker)
+{
+	stress_worksteal_task_t task;
+
+	task.func = stress_worksteal_quicksort_task;
+	task.join = NULL;
+	task.data = worker->ctx->data;
+	task.n = WORKSTEAL_SORT_N;
+	stress_worksteal_exec(worker, &task);
+}
+
+static bool stress_worksteal_quicksort_check(stress_args_t *args, stress_worksteal_context_t *ctx)
+{
+	uint64_t sum = ctx->data[0];
+	size_t i;
+
+	for (i = 1; i < WORKSTEAL_SORT_N; i++) {
+		if (ctx->data[i - 1] > ctx->data[i]) {
+			pr_fail("%s: quicksort data not sorted at index %zu\n", args->name, i);
+			return false;
+		}
+		sum += ctx->data[i];
+	}
+	if (sum != ctx->data_sum) {
+		pr_fail("%s: quicksort data checksum 0x%" PRIx64 ", expected 0x%" PRIx64 "\n",
+			args->name, sum, ctx->data_sum);
+		return false;
+	}
+	return true;
+}
+
+/*
+ *  stress_worksteal_uts_hash()
+ *	splitmix64, derives child node seeds and child counts
+ */
+static inline uint64_t stress_worksteal_uts_hash(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/*
+ *  stress_worksteal_uts_children()
+ *	binomial unbalanced tree, a node has M children with
+ *	probability Q and none otherwise
+ */
+static inline size_t stress_worksteal_uts_children(const uint64_t seed)
+{
+	const double r = (double)(stress_worksteal_uts_hash(seed) >> 11) * (1.0 / 9007199254740992.0);
+
+	return (r < WORKSTEAL_UTS_Q) ? WORKSTEAL_UTS_M : 0;
+}
+
+static inline uint64_t stress_worksteal_uts_child(const uint64_t seed, const size_t i)
+{
+	return stress_worksteal_uts_hash(seed + (uint64_t)i + 1);
+}
+
+/*
+ *  stress_worksteal_uts_task()
+ *	count the nodes of a subtree, spawning all but the last child
+ */
+static void stress_worksteal_uts_task(stress_worksteal_worker_t *worker, stress_worksteal_task_t *task)
+{
+	stress_worksteal_task_t children[WORKSTEAL_UTS_M];
+	uint64_t counts[WORKSTEAL_UTS_M], nodes = 1;
+	const size_t n = stress_worksteal_uts_children(task->arg);
+	uint32_t join = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		children[i].func = stress_worksteal_uts_task;
+		children[i].arg = stress_worksteal_uts_child(task->arg, i);
+		children[i].result = &counts[i];
+		if (i < n - 1) {
+			stress_worksteal_spawn(worker, &children[i], &join);
+		} else {
+			children[i].join = NULL;
+			stress_worksteal_exec(worker, &children[i]);
+		}
+	}
+	stress_worksteal_sync(worker, &join);
+	for (i = 0; i < n; i++)
+		nodes += counts[i];
+	*task->result = nodes;
+}
+
+/*
+ *  stress_worksteal_uts_count()
+ *	serial node count of a subtree
+ */
+static uint64_t stress_worksteal_uts_count(const uint64_t seed)
+{
+	const size_t n = stress_worksteal_uts_children(seed);
+	uint64_t nodes = 1;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		nodes += stress_worksteal_uts_count(stress_worksteal_uts_child(seed, i));
+	return nodes;
+}
+
+static void stress_worksteal_uts_prepare(stress_worksteal_context_t *ctx)
+{
+	ctx->result = 0;
+}
+
+static void stress_worksteal_uts_job(stress_worksteal_worker_t *worker)
+{
+	stress_worksteal_context_t *ctx = worker->ctx;
+	uint64_t nodes = 1;
+	uint32_t join = 0;
+	size_t i;
+
+	worker->tasks++;
+	for (i = 0; i < WORKSTEAL_UTS_B0; i++) {
+		stress_worksteal_task_t *task = &ctx->uts_roots[i];
+
+		task->func = stress_worksteal_uts_task;
+		task->arg = stress_worksteal_uts_child(WORKSTEAL_UTS_SEED, i);
+		task->result = &ctx->uts_counts[i];
+		stress_worksteal_spawn(worker, task, &join);
+	}
+	stress_worksteal_sync(worker, &join);
+	for (i = 0; i < WORKSTEAL_UTS_B0; i++)
+		nodes += ctx->uts_counts[i];
+	ctx->result = nodes;
+}
+
+static bool stress_worksteal_uts_check(stress_args_t *args, stress_worksteal_context_t *ctx)
+{
+	if (ctx->result != ctx->uts_nodes) {
+		pr_fail("%s: UTS tree search found %" PRIu64 " nodes, expected %" PRIu64 "\n",
+			args->name, ctx->result, ctx->uts_nodes);
+		return false;
+	}
+	return true;
+}
+
+static const stress_worksteal_method_t stress_worksteal_methods[] = {
+	{ "fib",	stress_worksteal_fib_prepare, stress_worksteal_fib_job, stress_worksteal_fib_check },
+	{ "quicksort",	stress_worksteal_quicksort_prepare, stress_worksteal_quicksort_job, stress_worksteal_quicksort_check },
+	{ "uts",	stress_worksteal_uts_prepare, stress_worksteal_uts_job, stress_worksteal_uts_check },
+};
+
+#define WORKSTEAL_METHODS	SIZEOF_ARRAY(stress_worksteal_methods)
+
+static const char *stress_worksteal_method(const size_t i)
+{
+	if (i == 0)
+		return "all";
+	return (i <= WORKSTEAL_METHODS) ? stress_worksteal_methods[i - 1].name : NULL;
+}
+#else
+static const char *stress_worksteal_method(const size_t i)
+{
+	return (i == 0) ? "all" : NULL;
+}
+#endif
+
+static const stress_opt_t opts[] = {
+	{ OPT_worksteal_method,  "worksteal-method",  TYPE_ID_SIZE_T_METHOD, 0, 0, stress_worksteal_method },
+	{ OPT_worksteal_threads, "worksteal-threads", TYPE_ID_UINT32, MIN_WORKSTEAL_THREADS, MAX_WORKSTEAL_THREADS, NULL },
+	END_OPT,
+};
+
+#if defined(HAVE_WORKSTEAL)
+
+/*
+ *  stress_worksteal_thread()
+ *	pool thread, steal and run tasks until told to stop
+ */
+static void *stress_worksteal_thread(void *arg)
+{
+	stress_worksteal_worker_t *worker = (stress_worksteal_worker_t *)arg;
+	stress_worksteal_context_t *ctx = worker->ctx;
+	uint32_t spins = 0;
+
+	while (!__atomic_load_n(&ctx->go, __ATOMIC_ACQUIRE))
+		(void)shim_sched_yield();
+
+	while (!__atomic_load_n(&ctx->stop, __ATOMIC_RELAXED)) {
+		stress_worksteal_task_t *task = stress_worksteal_pop(&worker->deque);
+
+		if (!task)
+			task = stress_worksteal_steal(worker);
+		if (task)
+			stress_worksteal_exec(worker, task);
+		else
+			(void)stress_cpu_relax_yield(&spins);
+	}
+	return &g_nowt;
+}
+
+/*
+ *  stress_worksteal_run()
+ *	run fork-join jobs on a pool for a time slice, the calling
+ *	thread is worker 0 and submits the jobs
+ */
+static int stress_worksteal_run(
+	stress_args_t *args,
+	stress_worksteal_context_t *ctx,
+	stress_worksteal_result_t *result)
+{
+	const stress_worksteal_method_t *method = result->method;
+	const uint32_t n = result->n_workers;
+	uint32_t i, created;
+	double t_end;
+	int rc = 0;
+
+	ctx->n_workers = n;
+	ctx->go = false;
+	ctx->stop = false;
+	for (i = 0; i < n; i++) {
+		stress_worksteal_worker_t *worker = &ctx->workers[i];
+
+		worker->deque.top = 0;
+		worker->deque.bottom = 0;
+		worker->ctx = ctx;
+		worker->index = i;
+		worker->rnd = stress_mwc32();
+		worker->tasks = 0;
+		worker->steals = 0;
+		worker->steal_attempts = 0;
+	}
+	for (created = 1; created < n; created++) {
+		if (pthread_create(&ctx->workers[created].pthread, NULL,
+				stress_worksteal_thread, (void *)&ctx->workers[created]) != 0)
+			break;
+	}
+	if (created < n) {
+		pr_dbg("%s: cannot create %" PRIu32 " threads, skipping %s with %" PRIu32 " threads\n",
+			args->name, n, method->name, n);
+		result->skipped = true;
+	}
+	__atomic_store_n(&ctx->go, true, __ATOMIC_RELEASE);
+
+	t_end = stress_time_now() + WORKSTEAL_SLICE;
+	while (!result->skipped) {
+		double t;
+
+		method->prepare(ctx);
+		t = stress_time_now();
+		method->job(&ctx->workers[0]);
+		result->duration += stress_time_now() - t;
+		result->jobs++;
+		stress_bogo_inc(args);
+		if (!method->check(args, ctx)) {
+			rc = -1;
+			break;
+		}
+		if ((stress_time_now() >= t_end) || !stress_continue(args))
+			break;
+	}
+
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELEASE);
+	for (i = 1; i < created; i++)
+		VOID_RET(int, pthread_join(ctx->workers[i].pthread, NULL));
+	for (i = 0; i < n; i++) {
+		result->tasks += ctx->workers[i].tasks;
+		result->steals += ctx->workers[i].steals;
+		result->steal_attempts += ctx->workers[i].steal_attempts;
+	}
+	return rc;
+}
+
+/*
+ *  stress_worksteal_metrics()
+ *	tasks per second, percentage of tasks stolen and the parallel
+ *	efficiency compared to a single thread for each job and pool size
+ */
+static void stress_worksteal_metrics(
+	stress_args_t *args,
+	const stress_worksteal_result_t *results,
+	const size_t n_results)
+{
+	size_t i, j, idx = 0;
+
+	for (i = 0; i < n_results; i++) {
+		const stress_worksteal_result_t *r = &results[i];
+		const double rate = (r->duration > 0.0) ? (double)r->tasks / r->duration : 0.0;
+		const double stolen = (r->tasks > 0) ? 100.0 * (double)r->steals / (double)r->tasks : 0.0;
+		const double success = (r->steal_attempts > 0) ?
+			100.0 * (double)r->steals / (double)r->steal_attempts : 0.0;
+		double efficiency = 0.0;
+		char msg[64];
+
+		if (r->skipped || (r->duration <= 0.0))
+			continue;
+		for (j = 0; j < n_results; j++) {
+			const stress_worksteal_result_t *r1 = &results[j];
+
+			if ((r1->method == r->method) && (r1->n_workers == 1) &&
+			    !r1->skipped && (r1->duration > 0.0) && (r1->tasks > 0)) {
+				const double rate1 = (double)r1->tasks / r1->duration;
+
+				efficiency = 100.0 * rate / (rate1 * (double)r->n_workers);
+			}
+		}
+
+		if (stress_instance_zero(args))
+			pr_dbg("%s: %-9s %3" PRIu32 " threads %12.0f tasks/sec, %6.2f%% tasks stolen, "
+				"%6.2f%% steals succeeded, %6.1f%% efficiency\n",
+				args->name, r->method->name, r->n_workers, rate, stolen,
+				success, efficiency);
+
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 " threads tasks/sec",
+			r->method->name, r->n_workers);
+		stress_metrics_set(args, idx++, msg, rate, STRESS_METRIC_HARMONIC_MEAN);
+		if (r->n_workers < 2)
+			continue;
+		(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 " threads %% tasks stolen",
+			r->method->name, r->n_workers);
+		stress_metrics_set(args, idx++, msg, stolen, STRESS_METRIC_GEOMETRIC_MEAN);
+		if (efficiency > 0.0) {
+			(void)snprintf(msg, sizeof(msg), "%s %" PRIu32 " threads %% parallel efficiency",
+				r->method->name, r->n_workers);
+			stress_metrics_set(args, idx++, msg, efficiency, STRESS_METRIC_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_worksteal()
+ *	run fork-join jobs on a work-stealing thread pool, sweeping
+ *	the pool size in powers of 2 up to the maximum
+ */
+static int stress_worksteal(stress_args_t *args)
+{
+	const int32_t n_cpus = stress_get_processors_online();
+	uint32_t worksteal_threads = (uint32_t)STRESS_MINIMUM(STRESS_MAXIMUM(n_cpus, MIN_WORKSTEAL_THREADS), MAX_WORKSTEAL_THREADS);
+	size_t worksteal_method = 0, n_results = 0, i, workers_size;
+	uint32_t levels[16], n_levels = 0, n;
+	stress_worksteal_result_t *results = NULL;
+	stress_worksteal_context_t ctx;
+	int rc = EXIT_SUCCESS;
+
+	(void)stress_get_setting("worksteal-method", &worksteal_method);
+	if (!stress_get_setting("worksteal-threads", &worksteal_threads)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			worksteal_threads = MAX_WORKSTEAL_THREADS;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			worksteal_threads = MIN_WORKSTEAL_THREADS;
+	}
+
+	/* 1, 2, 4 .. threads and the maximum */
+	for (n = 1; n < worksteal_threads; n <<= 1)
+		levels[n_levels++] = n;
+	levels[n_levels++] = worksteal_threads;
+
+	(void)shim_memset(&ctx, 0, sizeof(ctx));
+	workers_size = (size_t)worksteal_threads * sizeof(*ctx.workers);
+	ctx.workers = (stress_worksteal_worker_t *)stress_mmap_populate(NULL, workers_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (ctx.workers == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes for %" PRIu32 " work-stealing deques%s, skipping stressor\n",
+			args->name, workers_size, worksteal_threads, stress_get_memfree_str());
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(ctx.workers, workers_size, "worksteal-deques");
+	ctx.data = (uint32_t *)calloc(WORKSTEAL_SORT_N, sizeof(*ctx.data));
+	ctx.uts_roots = (stress_worksteal_task_t *)calloc(WORKSTEAL_UTS_B0, sizeof(*ctx.uts_roots));
+	ctx.uts_counts = (uint64_t *)calloc(WORKSTEAL_UTS_B0, sizeof(*ctx.uts_counts));
+	results = (stress_worksteal_result_t *)calloc(WORKSTEAL_METHODS * n_levels, sizeof(*results));
+	if (!ctx.data || !ctx.uts_roots || !ctx.uts_counts || !results) {
+		pr_inf_skip("%s: cannot allocate job data and result tables%s, skipping stressor\n",
+			args->name, stress_get_memfree_str());
+		rc = EXIT_NO_RESOURCE;
+		goto free_tables;
+	}
+
+	/* the UTS tree is the same each time, count it once */
+	ctx.uts_nodes = 1;
+	for (i = 0; i < WORKSTEAL_UTS_B0; i++)
+		ctx.uts_nodes += stress_worksteal_uts_count(stress_worksteal_uts_child(WORKSTEAL_UTS_SEED, i));
+
+	for (i = 0; i < WORKSTEAL_METHODS; i++) {
+		if (worksteal_method && (worksteal_method - 1 != i))
+			continue;
+		for (n = 0; n < n_levels; n++) {
+			results[n_results].method = &stress_worksteal_methods[i];
+			results[n_results].n_workers = levels[n];
+			n_results++;
+		}
+	}
+
+	if (stress_instance_zero(args))
+		pr_dbg("%s: %zu configurations, up to %" PRIu32 " threads, UTS tree of %" PRIu64 " nodes\n",
+			args->name, n_results, worksteal_threads, ctx.uts_nodes);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	i = 0;
+	do {
+		bool runnable = false;
+		size_t j;
+
+		if (!results[i].skipped &&
+		    (stress_worksteal_run(args, &ctx, &results[i]) < 0)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		for (j = 0; j < n_results; j++)
+			runnable |= !results[j].skipped;
+		if (!runnable)
+			break;
+		i = (i + 1) % n_results;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_worksteal_metrics(args, results, n_results);
+
+free_tables:
+	free(results);
+	free(ctx.uts_counts);
+	free(ctx.uts_roots);
+	free(ctx.data);
+	(void)munmap((void *)ctx.workers, workers_size);
+	return rc;
+}
+
+const stressor_info_t stress_worksteal_info = {
+	.stressor = stress_worksteal,
+	.classifier = CLASS_CPU | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_worksteal_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_CPU | CLASS_SCHEDULER,
+	.verify = VERIFY_ALWAYS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "built without pthread or atomic compare/exchange support"
+};
+#endif
@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2025      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-vmstat.h"
+
+#define MIN_WRITEBACK_BYTES		(1 * MB)
+#define MAX_WRITEBACK_BYTES		(MAX_FILE_LIMIT)
+#define DEFAULT_WRITEBACK_BYTES		(1 * GB)
+
+#define MIN_WRITEBACK_RATE		(0)
+#define MAX_WRITEBACK_RATE		(1000000)	/* MB/sec */
+#define DEFAULT_WRITEBACK_RATE		(0)		/* calibrate */
+
+#define MIN_WRITEBACK_WRITE_SIZE	(512)
+#define MAX_WRITEBACK_WRITE_SIZE	(4 * MB)
+#define DEFAULT_WRITEBACK_WRITE_SIZE	(16 * KB)
+
+#define WRITEBACK_MAX_SAMPLES		(16384)		/* latency samples per step */
+#define WRITEBACK_STEP_DURATION		(1.0)		/* seconds per rate step */
+#define WRITEBACK_SAMPLE_PERIOD		(0.1)		/* /proc/meminfo sample period */
+#define WRITEBACK_CALIBRATE_BYTES	(64 * MB)
+#define WRITEBACK_STALL		(0.01)		/* 10ms is considered a stall */
+
+static const stress_help_t help[] = {
+	{ NULL,	"writeback N",			"start N workers measuring dirty page throttling write stalls" },
+	{ NULL,	"writeback-bytes N",		"size of the file written to" },
+	{ NULL,	"writeback-ops N",		"stop after N buffered writes" },
+	{ NULL,	"writeback-rate N",		"reference write-back rate in MB/sec, 0 = calibrate" },
+	{ NULL,	"writeback-write-size N",	"size of each buffered write" },
+	{ NULL,	NULL,				NULL }
+};
+
+static const stress_opt_t opts[] = {
+	{ OPT_writeback_bytes,      "writeback-bytes",      TYPE_ID_UINT64_BYTES_FS, MIN_WRITEBACK_BYTES, MAX_WRITEBACK_BYTES, NULL },
+	{ OPT_writeback_rate,       "writeback-rate",       TYPE_ID_UINT64, MIN_WRITEBACK_RATE, MAX_WRITEBACK_RATE, NULL },
+	{ OPT_writeback_write_size, "writeback-write-size", TYPE_ID_SIZE_T_BYTES_FS, MIN_WRITEBACK_WRITE_SIZE, MAX_WRITEBACK_WRITE_SIZE, NULL },
+	END_OPT,
+};
+
+#if defined(__linux__)
+
+/*
+ *  write rates as a factor of the reference write-back
+ *  bandwidth, 0.0 is unthrottled
+ */
+static const double stress_writeback_factors[] = {
+	0.25, 0.5, 1.0, 2.0, 4.0, 0.0
+};
+
+#define WRITEBACK_MAX_STEPS	(SIZEOF_ARRAY(stress_writeback_factors))
+
+static const char * const stress_writeback_meminfo[] = {
+	"Dirty",
+	"Writeback",
+};
+
+static const char * const stress_writeback_vmstat[] = {
+	"nr_dirtied",
+	"nr_written",
+};
+
+/*
+ *  per rate step results
+ */
+typedef struct {
+	double factor;			/* rate relative to write-back rate */
+	double bytes;			/* total bytes written */
+	double duration;		/* total time spent in this step */
+	double max_latency;		/* longest write() */
+	uint64_t writes;		/* total write() calls */
+	uint64_t stalls;		/* writes taking longer than a stall */
+	uint64_t dirty_max;		/* peak Dirty, KB */
+	uint64_t writeback_max;		/* peak Writeback, KB */
+	uint64_t nr_dirtied;		/* pages dirtied */
+	uint64_t nr_written;		/* pages written back */
+	uint32_t index;			/* next latency sample slot */
+	double samples[WRITEBACK_MAX_SAMPLES]; /* write() latencies (seconds) */
+} stress_writeback_step_t;
+
+/*
+ *  stress_writeback_calibrate()
+ *	estimate the device write-back bandwidth by writing and
+ *	syncing a chunk of the file, returns bytes per second or
+ *	0.0 on failure
+ */
+static double stress_writeback_calibrate(
+	stress_args_t *args,
+	const int fd,
+	const uint8_t *buf,
+	const size_t buf_size,
+	const uint64_t writeback_bytes)
+{
+	const uint64_t bytes = (writeback_bytes < WRITEBACK_CALIBRATE_BYTES) ?
+		writeback_bytes : WRITEBACK_CALIBRATE_BYTES;
+	uint64_t offset;
+	ssize_t ret = 0;
+	double t, duration;
+
+	t = stress_time_now();
+	for (offset = 0; offset < bytes; offset += (uint64_t)ret) {
+		const size_t len = (size_t)STRESS_MINIMUM((uint64_t)buf_size, bytes - offset);
+
+		if (UNLIKELY(!stress_continue_flag()))
+			return 0.0;
+		ret = pwrite(fd, buf, len, (off_t)offset);
+		if (UNLIKELY(ret < 0)) {
+			pr_dbg("%s: calibration write failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			return 0.0;
+		}
+		if (UNLIKELY(ret == 0))
+			break;
+	}
+	(void)shim_fdatasync(fd);
+	duration = stress_time_now() - t;
+
+	/* rate of what was actually written, short writes included */
+	return (duration > 0.0) ? (double)offset / duration : 0.0;
+}
+
+/*
+ *  stress_writeback_run_step()
+ *	write at the step's rate for a step duration, timing
+ *	each write() and sampling the dirty page state
+ */
+static int stress_writeback_run_step(
+	stress_args_t *args,
+	stress_writeback_step_t *step,
+	const int fd,
+	const uint8_t *buf,
+	const size_t write_size,
+	const uint64_t writeback_bytes,
+	const double rate,
+	uint64_t *offset)
+{
+	uint64_t vm_begin[SIZEOF_ARRAY(stress_writeback_vmstat)] = { 0, 0 };
+	uint64_t vm_end[SIZEOF_ARRAY(stress_writeback_vmstat)] = { 0, 0 };
+	const double step_rate = rate * step->factor;
+	const double t_start = stress_time_now();
+	const double t_end = t_start + WRITEBACK_STEP_DURATION;
+	double t_sample = t_start, bytes = 0.0, t_now = t_start;
+
+	(void)stress_read_proc_fields("/proc/vmstat", stress_writeback_vmstat,
+		vm_begin, SIZEOF_ARRAY(stress_writeback_vmstat));
+
+	while (LIKELY((t_now < t_end) && stress_continue(args))) {
+		double t1, t2, latency;
+		ssize_t ret;
+
+		/* pace writes to the step rate, 0.0 is unthrottled */
+		if (step_rate > 0.0) {
+			const double t_due = t_start + (bytes / step_rate);
+
+			if (t_due > t_now)
+				(void)shim_nanosleep_uint64((uint64_t)((t_due - t_now) * STRESS_DBL_NANOSECOND));
+		}
+
+		t1 = stress_time_now();
+		ret = pwrite(fd, buf, write_size, (off_t)*offset);
+		t2 = stress_time_now();
+		if (UNLIKELY(ret < 0)) {
+			if ((errno == EINTR) || (errno == ENOSPC))
+				break;
+			pr_fail("%s: write failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			return -1;
+		}
+		bytes += (double)ret;
+		*offset += (uint64_t)ret;
+		if (*offset + write_size > writeback_bytes)
+			*offset = 0;
+
+		latency = t2 - t1;
+		step->samples[step->index % WRITEBACK_MAX_SAMPLES] = latency;
+		step->index++;
+		step->writes++;
+		if (latency > step->max_latency)
+			step->max_latency = latency;
+		if (latency > WRITEBACK_STALL)
+			step->stalls++;
+		stress_bogo_inc(args);
+
+		t_now = t2;
+		if (t_now >= t_sample) {
+			uint64_t mem[SIZEOF_ARRAY(stress_writeback_meminfo)] = { 0, 0 };
+
+			(void)stress_read_proc_fields("/proc/meminfo", stress_writeback_meminfo,
+				mem, SIZEOF_ARRAY(stress_writeback_meminfo));
+			if (mem[0] > step->dirty_max)
+				step->dirty_max = mem[0];
+			if (mem[1] > step->writeback_max)
+				step->writeback_max = mem[1];
+			t_sample = t_now + WRITEBACK_SAMPLE_PERIOD;
+		}
+	}
+	step->duration += t_now - t_start;
+	step->bytes += bytes;
+
+	if (stress_read_proc_fields("/proc/vmstat", stress_writeback_vmstat,
+			vm_end, SIZEOF_ARRAY(stress_writeback_vmstat)) > 0) {
+		step->nr_dirtied += (vm_end[0] > vm_begin[0]) ? vm_end[0] - vm_begin[0] : 0;
+		step->nr_written += (vm_end[1] > vm_begin[1]) ? vm_end[1] - vm_begin[1] : 0;
+	}
+	return 0;
+}
+
+/*
+ *  stress_writeback_metrics()
+ *	report write() stall percentiles and dirty page state per step
+ */
+static void stress_writeback_metrics(
+	stress_args_t *args,
+	stress_writeback_step_t *steps,
+	const double rate)
+{
+	size_t i, idx = 0;
+
+	stress_metrics_set(args, idx++, "MB/sec reference write-back rate",
+		rate / (double)MB, STRESS_METRIC_HARMONIC_MEAN);
+
+	for (i = 0; i < WRITEBACK_MAX_STEPS; i++) {
+		stress_writeback_step_t *step = &steps[i];
+		const size_t n = (step->index > WRITEBACK_MAX_SAMPLES) ?
+			WRITEBACK_MAX_SAMPLES : step->index;
+		char label[24], msg[64];
+
+		if ((n == 0) || (step->duration <= 0.0))
+			continue;
+		stress_percentile_sort(step->samples, n);
+
+		if (step->factor > 0.0)
+			(void)snprintf(label, sizeof(label), "%.0f%% rate", step->factor * 100.0);
+		else
+			(void)snprintf(label, sizeof(label), "unthrottled");
+
+		(void)snprintf(msg, sizeof(msg), "MB/sec written (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			step->bytes / step->duration / (double)MB, STRESS_METRIC_HARMONIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p50 write latency (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			stress_percentile(step->samples, n, 50.0) * STRESS_DBL_MICROSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99 write latency (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			stress_percentile(step->samples, n, 99.0) * STRESS_DBL_MICROSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec p99.9 write latency (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			stress_percentile(step->samples, n, 99.9) * STRESS_DBL_MICROSECOND,
+			STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "usec max write latency (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			step->max_latency * STRESS_DBL_MICROSECOND, STRESS_METRIC_MAXIMUM);
+		(void)snprintf(msg, sizeof(msg), "%% writes stalled > 10ms (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			100.0 * (double)step->stalls / (double)step->writes, STRESS_METRIC_MAXIMUM);
+		(void)snprintf(msg, sizeof(msg), "KB peak Dirty (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			(double)step->dirty_max, STRESS_METRIC_MAXIMUM);
+		(void)snprintf(msg, sizeof(msg), "KB peak Writeback (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			(double)step->writeback_max, STRESS_METRIC_MAXIMUM);
+		(void)snprintf(msg, sizeof(msg), "nr_dirtied pages/sec (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			(double)step->nr_dirtied / step->duration, STRESS_METRIC_GEOMETRIC_MEAN);
+		(void)snprintf(msg, sizeof(msg), "nr_written pages/sec (%s)", label);
+		stress_metrics_set(args, idx++, msg,
+			(double)step->nr_written / step->duration, STRESS_METRIC_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_writeback
+ *	stress buffered write-back and measure the write() stalls
+ *	caused by dirty page throttling
+ */
+static int stress_writeback(stress_args_t *args)
+{
+	uint64_t writeback_bytes, writeback_bytes_total = DEFAULT_WRITEBACK_BYTES;
+	uint64_t writeback_rate = DEFAULT_WRITEBACK_RATE, offset = 0;
+	size_t writeback_write_size = DEFAULT_WRITEBACK_WRITE_SIZE, i;
+	stress_writeback_step_t *steps;
+	const size_t steps_size = sizeof(*steps) * WRITEBACK_MAX_STEPS;
+	const size_t buf_size = MAX_WRITEBACK_WRITE_SIZE;
+	uint8_t *buf;
+	double rate;
+	char filename[PATH_MAX];
+	int ret, fd, rc = EXIT_SUCCESS;
+
+	if (!stress_get_setting("writeback-bytes", &writeback_bytes_total)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			writeback_bytes_total = MAXIMIZED_FILE_SIZE;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			writeback_bytes_total = MIN_WRITEBACK_BYTES;
+	}
+	(void)stress_get_setting("writeback-rate", &writeback_rate);
+	(void)stress_get_setting("writeback-write-size", &writeback_write_size);
+
+	writeback_bytes = writeback_bytes_total / args->instances;
+	if (writeback_bytes < MIN_WRITEBACK_BYTES) {
+		writeback_bytes = MIN_WRITEBACK_BYTES;
+		writeback_bytes_total = writeback_bytes * args->instances;
+	}
+	if (stress_instance_zero(args))
+		stress_fs_usage_bytes(args, writeback_bytes, writeback_bytes_total);
+
+	steps = (stress_writeback_step_t *)mmap(NULL, steps_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (steps == MAP_FAILED) {
+		pr_inf_skip("%s: failed to mmap %zu bytes for latency samples%s, "
+			"errno=%d (%s), skipping stressor\n",
+			args->name, steps_size, stress_get_memfree_str(),
+			errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(steps, steps_size, "writeback-samples");
+	for (i = 0; i < WRITEBACK_MAX_STEPS; i++)
+		steps[i].factor = stress_writeback_factors[i];
+
+	buf = (uint8_t *)mmap(NULL, buf_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED) {
+		pr_inf_skip("%s: failed to mmap %zu byte write buffer%s, "
+			"errno=%d (%s), skipping stressor\n",
+			args->name, buf_size, stress_get_memfree_str(),
+			errno, strerror(errno));
+		(void)munmap((void *)steps, steps_size);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_set_vma_anon_name(buf, buf_size, "writeback-buffer");
+	stress_uint8rnd4(buf, buf_size);
+
+	ret = stress_temp_dir_mk_args(args);
+	if (ret < 0) {
+		rc = stress_exit_status(-ret);
+		goto tidy_buf;
+	}
+	(void)stress_temp_filename_args(args, filename, sizeof(filename), stress_mwc32());
+
+	fd = open(filename, O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		ret = errno;
+		pr_inf_skip("%s: cannot create file %s, errno=%d (%s), skipping stressor\n",
+			args->name, filename, ret, strerror(ret));
+		rc = stress_exit_status(ret);
+		goto tidy_dir;
+	}
+	(void)shim_unlink(filename);
+
+	stress_set_proc_state(args->name, STRESS_STATE_SYNC_WAIT);
+	stress_sync_start_wait(args);
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	if (writeback_rate > 0) {
+		rate = (double)writeback_rate * (double)MB;
+	} else {
+		rate = stress_writeback_calibrate(args, fd, buf, buf_size, writeback_bytes);
+		if (rate <= 0.0) {
+			if (stress_continue_flag())
+				pr_inf("%s: cannot calibrate write-back rate, "
+					"assuming 100 MB/sec\n", args->name);
+			rate = 100.0 * (double)MB;
+		}
+	}
+	if (stress_instance_zero(args))
+		pr_dbg("%s: reference write-back rate %.2f MB/sec\n",
+			args->name, rate / (double)MB);
+
+	i = 0;
+	do {
+		if (stress_writeback_run_step(args, &steps[i], fd, buf,
+				writeback_write_size, writeback_bytes, rate, &offset) < 0) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		i++;
+		if (i >= WRITEBACK_MAX_STEPS)
+			i = 0;
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_writeback_metrics(args, steps, rate);
+
+	(void)close(fd);
+tidy_dir:
+	(void)stress_temp_dir_rm_args(args);
+tidy_buf:
+	(void)munmap((void *)buf, buf_size);
+	(void)munmap((void *)steps, steps_size);
+
+	return rc;
+}
+
+const stressor_info_t stress_writeback_info = {
+	.stressor = stress_writeback,
+	.classifier = CLASS_IO | CLASS_FILESYSTEM | CLASS_OS,
+	.opts = opts,
+	.help = help
+};
+#else
+const stressor_info_t stress_writeback_info = {
+	.stressor = stress_unimplemented,
+	.classifier = CLASS_IO | CLASS_FILESYSTEM | CLASS_OS,
+	.opts = opts,
+	.help = help,
+	.unimplemented_reason = "only supported on Linux"
+};
+#endif
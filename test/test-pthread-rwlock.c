@@ -0,0 +1,36 @@
+/*
+ * Copyright (C)      2025 Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <string.h>
+
+int main(void)
+{
+	pthread_rwlock_t rwlock;
+
+	if (pthread_rwlock_init(&rwlock, NULL) != 0)
+		return -1;
+	(void)pthread_rwlock_rdlock(&rwlock);
+	(void)pthread_rwlock_unlock(&rwlock);
+	(void)pthread_rwlock_wrlock(&rwlock);
+	(void)pthread_rwlock_unlock(&rwlock);
+	(void)pthread_rwlock_destroy(&rwlock);
+	return 0;
+}